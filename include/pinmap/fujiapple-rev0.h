@@ -61,6 +61,7 @@
 #define PIN_GPIOX_SDA           GPIO_NUM_21
 #define PIN_GPIOX_SCL           GPIO_NUM_22
 #define PIN_GPIOX_INT           GPIO_NUM_34
+#define PIN_GPIOX_CS            GPIO_NUM_4  // XRA1405, on the SD card SPI bus
 //#define GPIOX_ADDRESS           0x20  // PCF8575
 #define GPIOX_ADDRESS           0x24  // PCA9673
 //#define GPIOX_SPEED             400   // PCF8575 - 400Khz
@@ -8,6 +8,8 @@
 // #include "../../include/debug.h"
 
 
+volatile uint32_t FileSystem::changes = 0;
+
 char * FileSystem::_make_fullpath(const char *path)
 {
     if(path != nullptr)
@@ -1,6 +1,7 @@
 #ifndef _FN_FS_
 #define _FN_FS_
 
+#include <stdint.h>
 #include <time.h>
 
 #include <stdio.h>
@@ -63,6 +64,11 @@ public:
     static long filesize(FILE *);
     static long filesize(const char *filepath);
 
+    // Counts writes, removes and renames on local storage, so a cached
+    // listing can tell it is out of date
+    static volatile uint32_t changes;
+    static void changed() { changes++; };
+
     // Different FS implemenations may require different startup parameters,
     // so each should define its own version of start()
     //virtual bool start()=0;
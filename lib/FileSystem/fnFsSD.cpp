@@ -10,6 +10,7 @@
 #include <soc/sdmmc_periph.h>
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -246,6 +247,8 @@ FILE * FileSystemSDFAT::file_open(const char* path, const char* mode)
     char * fpath = _make_fullpath(path);
     FILE * result = fopen(fpath, mode);
     free(fpath);
+    if (result != nullptr && (mode[0] != 'r' || strchr(mode, '+')))
+        changed();
     //Debug_printf("sdfileopen2: task hwm %u, %p\r\n", uxTaskGetStackHighWaterMark(NULL), pxTaskGetStackStart(NULL));
 #ifdef DEBUG
     Debug_printf("fopen = %s : %s\r\n", path, result == nullptr ? "err" : "ok");
@@ -268,6 +271,7 @@ bool FileSystemSDFAT::remove(const char* path)
 #ifdef DEBUG
     //Debug_printf("sdFileSystem::remove returned %d on \"%s\"\r\n", result, path);
 #endif
+    changed();
     return (result == FR_OK);
 }
 
@@ -332,6 +336,7 @@ bool FileSystemSDFAT::create_path(const char *fullpath)
 bool FileSystemSDFAT::rename(const char* pathFrom, const char* pathTo)
 {
     FRESULT result = f_rename(pathFrom, pathTo);
+    changed();
 #ifdef DEBUG
     Debug_printf("sdFileSystem::rename returned %d on \"%s\" -> \"%s\"\r\n", result, pathFrom, pathTo);
 #endif
@@ -71,6 +71,7 @@ void systemBus::setup()
     Debug_printf("IEC systemBus::setup()\r\n");
 
     flags = CLEAR;
+    Protocol::timing_init();
     protocol = selectProtocol();
     release(PIN_IEC_CLK_OUT);
     release(PIN_IEC_DATA_OUT);
@@ -221,8 +222,8 @@ void IRAM_ATTR systemBus::service()
             bus_state = BUS_IDLE;
             flags = CLEAR;
 
-            // Switch back to standard serial
-            detected_protocol = PROTOCOL_IEC_SERIAL;
+            // Switch back to standard serial, or the uploaded fast loader's protocol
+            detected_protocol = fastloader_protocol;
             protocol = selectProtocol();
         }
 
@@ -435,13 +436,20 @@ void systemBus::read_payload()
             return;
         }
 
-        if (c != 0xFFFFFFFF && c != 0x0D)
+        if (c != 0xFFFFFFFF)
         {
             listen_command += (uint8_t)c;
         }
 
         if (flags & EOI_RECVD)
         {
+            // Only the CR ending a command or filename is dropped, binary
+            // arguments (P record numbers, M-W data) may contain 0x0D.
+            // Data for the other channels is passed on as it came
+            if ((data.secondary == IEC_OPEN || data.channel == CHANNEL_COMMAND) &&
+                listen_command.size() && listen_command.back() == 0x0D)
+                listen_command.pop_back();
+
             data.payload = listen_command;
             break;
         }
@@ -657,6 +665,10 @@ bool systemBus::sendBytes(const char *buf, size_t len, bool eoi)
             success = sendByte(buf[i], true);
         else
             success = sendByte(buf[i], false);
+
+        // ATN or an error, the rest won't get through either
+        if (!success)
+            break;
     }
 #ifdef DATA_STREAM
     Debug_println("}");
@@ -774,6 +786,9 @@ bool IRAM_ATTR systemBus::turnAround()
 void systemBus::reset_all_our_devices()
 {
     // TODO iterate through our bus and send reset to each device.
+
+    // Uploaded drive code is gone
+    fastloader_protocol = PROTOCOL_IEC_SERIAL;
 }
 
 void IRAM_ATTR systemBus::releaseLines(bool wait)
@@ -41,6 +41,7 @@
 #include <driver/gpio.h>
 #include "fnSystem.h"
 #include "protocol/iecProtocolBase.h"
+#include "protocol/iecTiming.h"
 #include "protocol/jiffydos.h"
 #ifdef PARALLEL_BUS
 #include "protocol/dolphindos.h"
@@ -414,6 +415,12 @@ public:
      */
     bus_state_t bus_state;
 
+    /**
+     * @brief protocol of fast loader drive code seen by M-E, used instead of
+     * IEC Serial between commands until reset
+     */
+    bus_protocol_t fastloader_protocol = PROTOCOL_IEC_SERIAL;
+
     /**
      * Toggled by the rate limiting timer to indicate that the SRQ interrupt should
      * be pulsed.
@@ -555,7 +562,7 @@ public:
 
     inline bool IRAM_ATTR status ( uint8_t pin )
     {
-        return gpio_get_level ( ( gpio_num_t ) pin ) ? RELEASED : PULLED;
+        return Protocol::gpio_in ( pin ) ? RELEASED : PULLED;
     }
 };
 
@@ -23,6 +23,9 @@ static void IRAM_ATTR ml_parallel_isr_handler(void* arg)
 {
     // Generic default interrupt handler
     uint32_t gpio_num = (uint32_t) arg;
+
+    // An input changed, the next read has to go to the expander
+    GPIOX.invalidate();
     xQueueSendFromISR(ml_parallel_evt_queue, &gpio_num, NULL);
 }
 
@@ -164,12 +167,15 @@ void parallelBus::setMode(parallel_mode_t mode)
 void parallelBus::handShake()
 {
     // Signal received or sent
+    GPIOX.beginBatch();
     
     // LOW
     GPIOX.digitalWrite( FLAG2, LOW );
     
     // HIGH
     GPIOX.digitalWrite( FLAG2, HIGH );
+
+    GPIOX.endBatch();
 }
 
 uint8_t parallelBus::readByte()
@@ -191,10 +197,13 @@ void parallelBus::writeByte( uint8_t byte )
     this->data = byte;
 
     Debug_printv("flags[%.2x] data[%.2x] byte[%.2x]", this->flags, this->data, byte);
+    // Data and the FLAG2 pulse go out together
+    GPIOX.beginBatch();
     GPIOX.write( USERPORT_DATA, byte);
 
     // Tell receiver byte is ready to read
     this->handShake();
+    GPIOX.endBatch();
 }
 
 bool parallelBus::status( user_port_pin_t pin )
@@ -1,6 +1,7 @@
 #ifdef BUILD_IEC
 
 #include "iecProtocolBase.h"
+#include "iecTiming.h"
 
 #include "bus.h"
 
@@ -9,16 +10,14 @@
 
 using namespace Protocol;
 
-int16_t IecProtocolBase::timeoutWait(uint8_t pin, bool target_status, size_t wait, bool watch_atn)
+int16_t IRAM_ATTR IecProtocolBase::timeoutWait(uint8_t pin, bool target_status, size_t wait, bool watch_atn)
 {
-    uint64_t start, current, elapsed;
+    uint32_t start, elapsed;
+    uint32_t timeout = timing_us_to_cycles(wait);
     bool atn_status = false;
-    start = 0;
-    current = 0;
     elapsed = 0;
 
-    esp_timer_init();
-    start = current = esp_timer_get_time();
+    start = timing_cycles();
 
     if ( pin == PIN_IEC_ATN )
     {
@@ -33,11 +32,9 @@ int16_t IecProtocolBase::timeoutWait(uint8_t pin, bool target_status, size_t wai
     //IEC.pull ( PIN_IEC_SRQ );
     while ( IEC.status ( pin ) != target_status )
     {
-        //fnSystem.delay_microseconds(1);
-        current = esp_timer_get_time();
-        elapsed = ( current - start );
+        elapsed = timing_elapsed(start);
 
-        if ( elapsed >= wait && wait != FOREVER )
+        if ( elapsed >= timeout && wait != FOREVER )
         {
             //IEC.release ( PIN_IEC_SRQ );
             if ( wait == TIMEOUT_DEFAULT )
@@ -60,43 +57,35 @@ int16_t IecProtocolBase::timeoutWait(uint8_t pin, bool target_status, size_t wai
     //IEC.release ( PIN_IEC_SRQ );
 
     // Debug_printv("pin[%d] state[%d] wait[%d] step[%d] t[%d]", pin, target_status, wait, elapsed);
-    return elapsed;
+    return elapsed / timing_cycles_per_us;
 
 }
 
-bool IecProtocolBase::wait(size_t wait, uint64_t start, bool watch_atn)
+bool IRAM_ATTR IecProtocolBase::wait(size_t wait, uint64_t start, bool watch_atn)
 {
-    uint64_t current, elapsed;
-    current = 0;
-    elapsed = 0;
-
     if ( wait == 0 ) return true;
-    wait--; // Shave 1us for overhead
 
-    esp_timer_init();
+    // No overhead to shave off, the deadline is absolute
     if ( start == 0 )
-        start = current = esp_timer_get_time();
-    else
-        current = esp_timer_get_time();
+        start = timing_cycles();
+    uint32_t deadline = (uint32_t)start + timing_us_to_cycles(wait);
 
     // Sample ATN and set flag to indicate SELECT or DATA mode
     bool atn_status = IEC.status ( PIN_IEC_ATN );
 
     //IEC.pull ( PIN_IEC_SRQ );
-    while ( elapsed < wait )
+    while ( !timing_reached(deadline) )
     {
-        //fnSystem.delay_microseconds(1);
-        current = esp_timer_get_time();
-        elapsed = current - start;
-
-        bool atn_check = IEC.status ( PIN_IEC_ATN );
-        if ( atn_check != atn_status )
+        if ( IEC.status ( PIN_IEC_ATN ) != atn_status )
         {
             //IEC.release ( PIN_IEC_SRQ );
             //Debug_printv("wait[%d] elapsed[%d] start[%d] current[%d]", wait, elapsed, start, current);
             return false;
         }
     }
+#ifdef IEC_TIMING_STATS
+    timing_record(timing_elapsed(deadline));
+#endif
 
     //IEC.release ( PIN_IEC_SRQ );
     return true;
@@ -40,9 +40,9 @@ namespace Protocol
         virtual int16_t timeoutWait(uint8_t pin, bool target_status, size_t wait = TIMEOUT_DEFAULT, bool watch_atn = true);
 
         /**
-         * @brief Wait for specified milliseconds, or until ATN status changes
-         * @param wait # of milliseconds to wait
-         * @param start The previously set start millisecond time.
+         * @brief Wait for specified microseconds, or until ATN status changes
+         * @param wait # of microseconds to wait
+         * @param start The previously read cycle counter (timing_cycles()), 0 for now
          * @param watch_atn also abort if ATN status changes? (default is true)
          */
         virtual bool wait(size_t wait, uint64_t start = 0, bool watch_atn = true);
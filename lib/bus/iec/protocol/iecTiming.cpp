@@ -0,0 +1,42 @@
+#ifdef BUILD_IEC
+
+#include "iecTiming.h"
+
+#include <esp_rom_sys.h>
+
+#include "../../../include/debug.h"
+
+namespace Protocol
+{
+    uint32_t timing_cycles_per_us = 240;
+
+    void timing_init()
+    {
+        timing_cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+    }
+
+#ifdef IEC_TIMING_STATS
+    uint32_t timing_histogram[IEC_TIMING_BUCKETS] = { 0 };
+
+    void IRAM_ATTR timing_record(uint32_t late)
+    {
+        uint32_t bucket = (late * 4) / timing_cycles_per_us;
+        if ( bucket >= IEC_TIMING_BUCKETS )
+            bucket = IEC_TIMING_BUCKETS - 1;
+        timing_histogram[bucket]++;
+    }
+
+    void timing_report()
+    {
+        Debug_printf("IEC timing, lateness of deadlines\r\n");
+        for ( uint8_t i = 0; i < IEC_TIMING_BUCKETS; i++ )
+        {
+            if ( timing_histogram[i] )
+                Debug_printf("%s%2d.%02dus %d\r\n", (i == IEC_TIMING_BUCKETS - 1) ? ">=" : "  ", i / 4, (i % 4) * 25, timing_histogram[i]);
+            timing_histogram[i] = 0;
+        }
+    }
+#endif
+};
+
+#endif /* BUILD_IEC */
@@ -0,0 +1,96 @@
+// Meatloaf - A Commodore 64/128 multi-device emulator
+// https://github.com/idolpx/meatloaf
+// Copyright(C) 2020 James Johnston
+//
+// Meatloaf is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Meatloaf is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Meatloaf. If not, see <http://www.gnu.org/licenses/>.
+
+// Bus timing from the CPU cycle counter and line levels straight from
+// the GPIO input registers. A deadline is an absolute cycle count, so
+// time spent between samples doesn't add up the way chained
+// microsecond waits do.
+
+#ifndef IECTIMING_H
+#define IECTIMING_H
+
+#include <cstdint>
+
+#include <esp_attr.h>
+#include <esp_cpu.h>
+#include <soc/gpio_struct.h>
+
+// Collect how late each deadline was met, see timing_report()
+//#define IEC_TIMING_STATS
+
+namespace Protocol
+{
+    extern uint32_t timing_cycles_per_us;
+
+    /**
+     * @brief Read the CPU clock, done once when a protocol is set up
+     */
+    void timing_init();
+
+    static inline uint32_t IRAM_ATTR timing_cycles()
+    {
+        return esp_cpu_get_cycle_count();
+    }
+
+    static inline uint32_t timing_us_to_cycles(uint32_t us)
+    {
+        return us * timing_cycles_per_us;
+    }
+
+    // Cycles since 'start', correct across counter wrap
+    static inline uint32_t IRAM_ATTR timing_elapsed(uint32_t start)
+    {
+        return timing_cycles() - start;
+    }
+
+    static inline bool IRAM_ATTR timing_reached(uint32_t deadline)
+    {
+        return (int32_t)(timing_cycles() - deadline) >= 0;
+    }
+
+#ifdef IEC_TIMING_STATS
+    // Lateness in 1/4us buckets, the last one collects everything above
+    #define IEC_TIMING_BUCKETS 32
+    extern uint32_t timing_histogram[IEC_TIMING_BUCKETS];
+
+    void timing_record(uint32_t late);
+    void timing_report();
+#endif
+
+    static inline void IRAM_ATTR timing_wait_until(uint32_t deadline)
+    {
+        while ( !timing_reached(deadline) );
+#ifdef IEC_TIMING_STATS
+        timing_record(timing_cycles() - deadline);
+#endif
+    }
+
+    // All GPIO inputs in one read, so lines sampled together are not skewed
+    static inline uint64_t IRAM_ATTR gpio_in_all()
+    {
+        return GPIO.in | ((uint64_t)GPIO.in1.val << 32);
+    }
+
+    static inline bool IRAM_ATTR gpio_in(uint8_t pin)
+    {
+        if ( pin < 32 )
+            return (GPIO.in >> pin) & 1;
+        return (GPIO.in1.val >> (pin - 32)) & 1;
+    }
+};
+
+#endif /* IECTIMING_H */
@@ -19,6 +19,7 @@
 
 #include "bus.h"
 #include "iecProtocolBase.h"
+#include "iecTiming.h"
 
 #include "../../../include/debug.h"
 #include "../../../include/pinmap.h"
@@ -56,28 +57,21 @@ int16_t  JiffyDOS::receiveByte ()
 
     // STEP 2: RECEIVING THE BITS
     // As soon as the talker releases the Clock line we are expected to receive the bits
+    // Every pair is sampled at a fixed point from that edge, read from the
+    // cycle counter, and both lines come from the same register read
+    uint32_t start = timing_cycles();
     uint8_t data = 0;
     uint8_t bitmask = 0xFF;
 
-    // get bits 4,5
-    data >>= 1; if ( gpio_get_level ( PIN_IEC_CLK_IN ) ) data |= 0x80;
-    data >>= 1; if ( gpio_get_level ( PIN_IEC_DATA_IN ) ) data |= 0x80;
-    wait( 8 );
-
-    // get bits 6,7
-    data >>= 1; if ( gpio_get_level ( PIN_IEC_CLK_IN ) ) data |= 0x80;
-    data >>= 1; if ( gpio_get_level ( PIN_IEC_DATA_IN ) ) data |= 0x80;
-    wait( 8 );
-
-    // get bits 3,1
-    data >>= 1; if ( gpio_get_level ( PIN_IEC_CLK_IN ) ) data |= 0x80;
-    data >>= 1; if ( gpio_get_level ( PIN_IEC_DATA_IN ) ) data |= 0x80;
-    wait( 8 );
-
-    // get bits 2,0
-    data >>= 1; if ( gpio_get_level ( PIN_IEC_CLK_IN ) ) data |= 0x80;
-    data >>= 1; if ( gpio_get_level ( PIN_IEC_DATA_IN ) ) data |= 0x80;
-    wait( 8 );
+    // get bits 4,5 then 6,7 then 3,1 then 2,0
+    for ( uint8_t i = 0; i < 4; i++ )
+    {
+        timing_wait_until( start + bitpair[i] );
+        uint64_t in = gpio_in_all();
+        data >>= 1; if ( in & (1ULL << PIN_IEC_CLK_IN) ) data |= 0x80;
+        data >>= 1; if ( in & (1ULL << PIN_IEC_DATA_IN) ) data |= 0x80;
+    }
+    timing_wait_until( start + bitpair[4] );
     IEC.release( PIN_IEC_SRQ );
 
     // rearrange bits
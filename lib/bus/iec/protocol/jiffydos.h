@@ -28,14 +28,28 @@
 
 #include "iecProtocolBase.h"
 
-#define TIMING_JIFFY_BITPAIR
+#include "iecTiming.h"
+
+// Bit pair sample points after the talker releases CLK, then the EOI check (us)
+#define TIMING_JIFFY_BITPAIR { 0, 8, 16, 24, 32 }
 #define TIMING_JIFFY_BYTE
 
 namespace Protocol
 {
 	class JiffyDOS : public IecProtocolBase
 	{
+		public:
+			JiffyDOS()
+			{
+				// Sample points in cycles, worked out once per protocol switch
+				const uint8_t bitpair_us[] = TIMING_JIFFY_BITPAIR;
+				for ( uint8_t i = 0; i < 5; i++ )
+					bitpair[i] = timing_us_to_cycles( bitpair_us[i] );
+			};
+
 		protected:
+			uint32_t bitpair[5];
+
 			uint8_t loadmode = 0;
 			uint8_t skipeoi = 0;
 			int16_t receiveByte(void) override;
@@ -2,9 +2,14 @@
 
 #include "drive.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cstring>
+#include <set>
 
-#include <unordered_map>
+#include <esp_timer.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 
 #include "../../include/debug.h"
 #include "../../include/cbm_defines.h"
@@ -40,10 +45,41 @@ void iecDrive::write(bool verify)
     // TODO: IMPLEMENT
 }
 
-// Disk format
+// N[drive]:name[,id], without an id only the directory is cleared
 void iecDrive::format()
 {
-    // TODO IMPLEMENT
+    size_t colon = payload.find(':');
+    if ( colon == std::string::npos )
+    {
+        setStatus(31, "SYNTAX ERROR");
+        return;
+    }
+
+    // Name and id stay in PETSCII, they go on the disk as they are
+    std::string name = payload.substr(colon + 1);
+    std::string id;
+    size_t comma = name.find(',');
+    if ( comma != std::string::npos )
+    {
+        id = name.substr(comma + 1);
+        name.resize(comma);
+    }
+
+    int64_t start = esp_timer_get_time();
+    if ( !_base->format(name, id) )
+        setStatus(26, "WRITE PROTECT ON");
+    _listing.clear();
+    Debug_printv("format name[%s] id[%s] took [%lluus]", name.c_str(), id.c_str(), esp_timer_get_time() - start);
+}
+
+// V[drive], a new BAM from the files that are on the disk
+void iecDrive::validate()
+{
+    int64_t start = esp_timer_get_time();
+    if ( !_base->validate() )
+        setStatus(71, "DIR ERROR");
+    _listing.clear();
+    Debug_printv("validate took [%lluus]", esp_timer_get_time() - start);
 }
 
 /* Mount Disk
@@ -66,6 +102,9 @@ iecDrive::~iecDrive()
 {
     // if (_base != nullptr)
     //     delete _base;
+
+    for ( uint8_t i = 0; i < IEC_CHANNELS; i++ )
+        closeStream( i );
 }
 
 // Unmount disk file
@@ -200,6 +239,8 @@ void iecDrive::iec_open()
 
     Debug_printv("s[%s]", s.c_str());
 
+    _listing_filter.clear();
+
     if ( mstr::startsWith(s, "0:") )
     {
         // Remove media ID from command string
@@ -215,7 +256,13 @@ void iecDrive::iec_open()
     if ( s.length() )
     {
         if ( s[0] == '$' ) 
+        {
+            // $[drive]:pattern lists only what matches
+            size_t colon = s.find(':');
+            if ( colon != std::string::npos )
+                _listing_filter = s.substr(colon + 1);
             s.clear();
+        }
 
         auto n = _base->cd( s );
         if ( n != nullptr )
@@ -290,7 +337,45 @@ void iecDrive::iec_reopen_channel()
 
 void iecDrive::iec_reopen_channel_listen()
 {
-    Debug_printv("here");
+    auto &channel = channels[commanddata.channel & 0x0F];
+    if ( channel.stream == nullptr )
+    {
+        Debug_printv("Stream not found!");
+        return;
+    }
+
+    // Any listing kept from before is stale now
+    _listing.clear();
+
+    // PRINT# data comes as it is, a CR ends REL records
+    std::string data;
+    while ( !(IEC.flags & EOI_RECVD) )
+    {
+        int16_t b = IEC.receiveByte();
+        if ( b < 0 )
+        {
+            Debug_printv("error on receive");
+            return;
+        }
+        data += (char)b;
+    }
+
+    // Files opened for reading are never changed in place
+    if ( !channel.stream->isUpdatable() )
+    {
+        Debug_printv("channel[%d] not writable, dropped[%d]", commanddata.channel, data.size());
+        return;
+    }
+
+    // REL records are written in place, from the position GET# got to
+    channel.lock();
+    channel.sync();
+    uint32_t n = channel.stream->write((const uint8_t *)data.data(), data.size());
+    channel.stream->flush();
+    channel.discard();
+    channel.unlock();
+
+    Debug_printv("channel[%d] written[%d] size[%d]", commanddata.channel, n, data.size());
 }
 
 void iecDrive::iec_reopen_channel_talk()
@@ -310,6 +395,11 @@ void iecDrive::iec_talk_command()
     //Debug_printv("here");
     if (response_queue.empty())
         iec_talk_command_buffer_status();
+    else
+    {
+        IEC.sendBytes(response_queue.front());
+        response_queue.pop();
+    }
 }
 
 void iecDrive::iec_talk_command_buffer_status()
@@ -319,6 +409,26 @@ void iecDrive::iec_talk_command_buffer_status()
     //char reply[80];
     std::string s = "00, OK,00,00\r";
 
+    if ( _copy != nullptr )
+    {
+        if ( !_copy->done() )
+        {
+            s = mstr::format("00, COPYING %d%%,00,00\r", _copy->percent());
+        }
+        else
+        {
+            Debug_printv("copied[%d] failed[%d]", _copy->copied(), _copy->failed());
+            if ( _copy->failed() )
+                s = "25,WRITE ERROR,00,00\r";
+            _copy.reset();
+        }
+    }
+    else if ( _status.size() )
+    {
+        s = _status;
+        _status.clear();
+    }
+
     // snprintf(reply, 80, "%u,\"%s\",%u,%u", iecStatus.error, iecStatus.msg.c_str(), iecStatus.connected, iecStatus.channel);
     // s = string(reply);
     IEC.sendBytes(s);
@@ -340,23 +450,25 @@ void iecDrive::iec_command()
     switch ( payload[0] )
     {
         case 'B':
-            // B-P buffer pointer
             // B-A allocate bit in BAM not implemented
             // B-F free bit in BAM not implemented
             // B-E block execute impossible at this level of emulation!
-            //Error(ERROR_31_SYNTAX_ERROR);
-            Debug_printv( "block/buffer");
+            if ( payload[1] == '-' && (payload[2] == 'R' || payload[2] == 'W' || payload[2] == 'P') )
+                block();
+            else
+                Debug_printv( "block/buffer");
         break;
         case 'C':
-            if ( payload[1] != 'D' && payload[2] == ':')
+            if ( payload[1] != 'D' && payload[1] != 'P' && payload.find(':') != std::string::npos )
             {
-                //Copy(); // Copy File
-                Debug_printv( "copy file");
+                copy(); // Copy File
             }
         break;
         case 'D':
-            Debug_printv( "duplicate disk");
-            //Error(ERROR_31_SYNTAX_ERROR);	// DI, DR, DW not implemented yet
+            if ( payload[1] != 'I' && payload[1] != 'R' && payload[1] != 'W' ) // DI, DR, DW not implemented yet
+            {
+                duplicate();
+            }
         break;
         case 'I':
             // Initialise
@@ -365,13 +477,11 @@ void iecDrive::iec_command()
         case 'M':
             if ( payload[1] == '-' ) // Memory
             {
-                Debug_printv( "memory");
-                //Memory();
+                memory();
             }
         break;
         case 'N':
-            //New();
-            Debug_printv( "new (format)");
+            format(); // New
         break;
         case 'R':
             if ( payload[1] != 'D' && payload[2] == ':' ) // Rename
@@ -390,19 +500,18 @@ void iecDrive::iec_command()
         case 'U':
             Debug_printv( "user 01a2b");
             //User();
-            if (payload[1] == '1') // User 1
+            if (payload[1] == 'J' || payload[1] == ':') // Reset
             {
-                payload = mstr::drop(payload, 3);
-                pti = util_tokenize_uint8(payload);
-                Debug_printv("payload[%s] channel[%d] media[%d] track[%d] sector[%d]", payload.c_str(), pti[0], pti[1], pti[2], pti[3]);
-
-                auto stream = retrieveStream( pti[0] );
-                stream->seekSector( pti[2], pti[3] );
-                stream->reset();
+                drive_code.reset();
+                IEC.fastloader_protocol = PROTOCOL_IEC_SERIAL;
+            }
+            else if (payload[1] == '1' || payload[1] == 'A' || payload[1] == '2' || payload[1] == 'B') // Block read/write
+            {
+                block();
             }
         break;
         case 'V':
-            Debug_printv( "validate bam");
+            validate(); // Validate BAM
         break;
         default:
             //Error(ERROR_31_SYNTAX_ERROR);
@@ -416,8 +525,7 @@ void iecDrive::iec_command()
         case 'C':
             if ( payload[1] == 'P') // Change Partition
             {
-                Debug_printv( "change partition");
-                //ChangeDevice();
+                changePartition();
             }
             else if ( payload[1] == 'D') // Change Directory
             {
@@ -438,17 +546,41 @@ void iecDrive::iec_command()
         case 'M':
             if ( payload[1] == 'D') // Make Directory
             {
-                Debug_printv( "make directory");
+                makeDirectory();
             }
         break;
         case 'P':
-            Debug_printv( "position");
-            //Error(ERROR_31_SYNTAX_ERROR);	// P not implemented yet
+            // P chr$(96+channel) chr$(record lo) chr$(record hi) chr$(offset)
+            if ( payload.size() > 1 )
+            {
+                uint8_t channel = payload[1] & 0x0F;
+                uint16_t record = (payload.size() > 2) ? (uint8_t)payload[2] : 1;
+                if ( payload.size() > 3 )
+                    record |= (uint8_t)payload[3] << 8;
+                uint8_t offset = (payload.size() > 4) ? payload[4] : 1;
+
+                bool found = false;
+                auto &c = channels[channel];
+                if ( c.stream != nullptr )
+                {
+                    c.lock();
+                    found = c.stream->seekRecord( record, offset );
+                    c.discard();
+                    c.unlock();
+                }
+                Debug_printv( "position channel[%d] record[%d] offset[%d] found[%d]", channel, record, offset, found);
+
+                // Programs look for this to find the end of the file
+                if ( c.stream == nullptr )
+                    setStatus(70, "NO CHANNEL");
+                else if ( !found )
+                    setStatus(50, "RECORD NOT PRESENT");
+            }
         break;
         case 'R':
             if ( payload[1] == 'D') // Remove Directory
             {
-                Debug_printv( "remove directory");
+                removeDirectory();
             }
         break;
         case 'S':
@@ -487,7 +619,7 @@ void iecDrive::iec_command()
             //Extended();
         break;
         case '/':
-
+            changePartition(); // 1581 partition
         break;
         default:
             //Error(ERROR_31_SYNTAX_ERROR);
@@ -495,6 +627,343 @@ void iecDrive::iec_command()
     }
 }
 
+void iecDrive::setStatus(uint8_t code, const char *msg, uint8_t track, uint8_t sector)
+{
+    _status = mstr::format("%02d,%s,%02d,%02d\r", code, msg, track, sector);
+}
+
+bool iecDrive::startCopy(std::vector<std::shared_ptr<MStream>> sources, MFile *destination)
+{
+    if ( destination == nullptr || destination->exists() )
+    {
+        setStatus(63, "FILE EXISTS");
+        return false;
+    }
+
+    std::shared_ptr<MStream> ostream(destination->createStream());
+    if ( ostream == nullptr || !ostream->isOpen() )
+    {
+        setStatus(26, "WRITE PROTECT ON");
+        return false;
+    }
+
+    // Listings and cached blocks of the destination are stale from here on
+    _listing.clear();
+    ImageBroker::dispose( destination->url );
+
+    _copy = std::make_unique<MCopy>(sources, ostream);
+    if ( !_copy->start() )
+    {
+        _copy.reset();
+        setStatus(70, "NO CHANNEL");
+        return false;
+    }
+
+    Debug_printv("copying [%d] bytes to [%s]", _copy->total(), destination->url.c_str());
+    return true;
+}
+
+// C[drive]:new=old[,old...], more than one old file are joined
+void iecDrive::copy()
+{
+    if ( _copy != nullptr && !_copy->done() )
+    {
+        setStatus(74, "DRIVE NOT READY");
+        return;
+    }
+
+    std::string s = payload;
+    mstr::toASCII(s);
+
+    size_t colon = s.find(':');
+    size_t equals = s.find('=');
+    if ( equals == std::string::npos || equals < colon )
+    {
+        setStatus(31, "SYNTAX ERROR");
+        return;
+    }
+
+    std::vector<std::shared_ptr<MStream>> sources;
+    for ( auto name : util_tokenize(s.substr(equals + 1), ',') )
+    {
+        if ( name.size() > 1 && name[1] == ':' )
+            name = mstr::drop(name, 2);
+
+        std::unique_ptr<MFile> f(_base->cd(name));
+        std::shared_ptr<MStream> istream;
+        if ( f != nullptr && f->exists() && !f->isDirectory() )
+            istream.reset(f->meatStream());
+
+        if ( istream == nullptr || !istream->isOpen() )
+        {
+            setStatus(62, "FILE NOT FOUND");
+            return;
+        }
+        sources.push_back(istream);
+    }
+
+    if ( sources.empty() )
+    {
+        setStatus(31, "SYNTAX ERROR");
+        return;
+    }
+
+    std::unique_ptr<MFile> destination(_base->cd(s.substr(colon + 1, equals - colon - 1)));
+    startCopy(sources, destination.get());
+}
+
+// D[drive]:new=old, the whole image file is copied as it is, block for
+// block, instead of file by file
+void iecDrive::duplicate()
+{
+    if ( _copy != nullptr && !_copy->done() )
+    {
+        setStatus(74, "DRIVE NOT READY");
+        return;
+    }
+
+    std::string s = payload;
+    mstr::toASCII(s);
+
+    size_t colon = s.find(':');
+    size_t equals = s.find('=');
+    if ( colon == std::string::npos || equals == std::string::npos || equals < colon )
+    {
+        setStatus(31, "SYNTAX ERROR");
+        return;
+    }
+
+    std::string name = s.substr(equals + 1);
+    if ( name.size() > 1 && name[1] == ':' )
+        name = mstr::drop(name, 2);
+
+    // Only the image itself, not a file in it
+    std::unique_ptr<MFile> image(_base->cd(name));
+    std::shared_ptr<MStream> istream;
+    if ( image != nullptr && image->isDirectory() && image->pathInStream.empty() &&
+         image->streamFile != nullptr && !image->streamFile->url.empty() )
+        istream.reset(image->streamFile->meatStream());
+
+    if ( istream == nullptr || !istream->isOpen() )
+    {
+        setStatus(62, "FILE NOT FOUND");
+        return;
+    }
+
+    std::unique_ptr<MFile> destination(_base->cd(s.substr(colon + 1, equals - colon - 1)));
+    startCopy({ istream }, destination.get());
+}
+
+// U1/U2 channel drive track sector, B-R/B-W the same with the length
+// kept in the first byte, B-P channel position. The channel is one
+// opened on "#"
+void iecDrive::block()
+{
+    // A bare U1 or B- has no channel, track or sector
+    if ( payload.size() < 3 )
+    {
+        setStatus(30, "SYNTAX ERROR");
+        return;
+    }
+
+    bool counted = (payload[0] == 'B');
+    char op = counted ? payload[2] : ((payload[1] == '1' || payload[1] == 'A') ? 'R' : 'W');
+
+    // Parameters are split by spaces, commas, colons or cursor right
+    std::vector<uint16_t> p;
+    std::string n;
+    for ( auto c : payload.substr(3) + " " )
+    {
+        if ( isdigit(c) )
+            n += c;
+        else if ( n.size() )
+        {
+            p.push_back( atoi(n.c_str()) );
+            n.clear();
+        }
+    }
+
+    if ( p.size() < ((op == 'P') ? 2 : 4) )
+    {
+        setStatus(30, "SYNTAX ERROR");
+        return;
+    }
+
+    auto &channel = channels[p[0] & 0x0F];
+    if ( channel.stream == nullptr )
+    {
+        setStatus(70, "NO CHANNEL");
+        return;
+    }
+
+    bool success;
+    channel.lock();
+    if ( op == 'P' )
+        success = channel.stream->seek( p[1] );
+    else if ( op == 'R' )
+        success = channel.stream->readSector( p[2], p[3], counted );
+    else
+    {
+        // Counted from where GET# and PRINT# got to, not the read ahead
+        channel.sync();
+        success = channel.stream->writeSector( p[2], p[3], counted );
+    }
+    channel.discard();
+    channel.unlock();
+
+    if ( !success )
+    {
+        if ( op == 'P' )
+            setStatus(30, "SYNTAX ERROR");
+        else
+            setStatus(66, "ILLEGAL TRACK OR SECTOR", p[2], p[3]);
+    }
+    else if ( op == 'W' )
+    {
+        // The listing and free block count may be stale now
+        _listing.clear();
+        if ( _base->streamFile != nullptr )
+            ImageBroker::dispose( _base->streamFile->url );
+    }
+
+    //Debug_printv("block[%c] counted[%d] channel[%d] success[%d]", op, counted, p[0], success);
+}
+
+// MD[drive]:name, a new directory in the current one
+void iecDrive::makeDirectory()
+{
+    size_t colon = payload.find(':');
+    std::string name = (colon == std::string::npos) ? mstr::drop(payload, 2) : payload.substr(colon + 1);
+    mstr::toASCII(name);
+    if ( name.empty() )
+    {
+        setStatus(34, "SYNTAX ERROR");
+        return;
+    }
+
+    std::unique_ptr<MFile> dir( _base->cd( name ) );
+    if ( dir == nullptr )
+        setStatus(39, "PATH NOT FOUND");
+    else if ( dir->isDirectory() )
+        setStatus(63, "FILE EXISTS");
+    else if ( !dir->mkDir() )
+        setStatus(26, "WRITE PROTECT ON");
+    _listing.clear();
+}
+
+// RD[drive]:name, only empty directories are removed
+void iecDrive::removeDirectory()
+{
+    size_t colon = payload.find(':');
+    std::string name = (colon == std::string::npos) ? mstr::drop(payload, 2) : payload.substr(colon + 1);
+    mstr::toASCII(name);
+    if ( name.empty() )
+    {
+        setStatus(34, "SYNTAX ERROR");
+        return;
+    }
+
+    std::unique_ptr<MFile> dir( _base->cd( name ) );
+    if ( dir == nullptr || !dir->isDirectory() )
+        setStatus(62, "FILE NOT FOUND");
+    else if ( !dir->remove() )
+        setStatus(63, "FILE EXISTS");
+    _listing.clear();
+}
+
+// CP n selects the n-th directory in the root of the image, 0 is the
+// root itself. /[drive]:name selects a 1581 partition in the current
+// one, / on its own goes back to the root
+void iecDrive::changePartition()
+{
+    MFile *image = _base->streamFile;
+    if ( image == nullptr || image->url.empty() )
+    {
+        setStatus(77, "SELECTED PARTITION ILLEGAL");
+        return;
+    }
+
+    std::unique_ptr<MFile> selected;
+    if ( payload[0] == 'C' )
+    {
+        std::unique_ptr<MFile> root( MFSOwner::File( image->url ) );
+        uint16_t n = atoi(mstr::drop(payload, 2).c_str());
+        if ( !n )
+            selected = std::move(root);
+        else if ( root->rewindDirectory() )
+        {
+            uint16_t i = 0;
+            for ( MFile *entry; (entry = root->getNextFileInDir()) != nullptr; )
+            {
+                std::unique_ptr<MFile> e( entry );
+                if ( e->isDirectory() && ++i == n )
+                {
+                    selected = std::move(e);
+                    break;
+                }
+            }
+        }
+    }
+    else
+    {
+        size_t colon = payload.find(':');
+        std::string name = (colon == std::string::npos) ? "" : payload.substr(colon + 1);
+        mstr::toASCII(name);
+        selected.reset( name.empty() ? MFSOwner::File( image->url ) : _base->cd( name ) );
+    }
+
+    if ( selected == nullptr || !selected->isDirectory() )
+    {
+        setStatus(77, "SELECTED PARTITION ILLEGAL");
+        return;
+    }
+
+    _base = std::move(selected);
+    Debug_printv("partition [%s]", _base->url.c_str());
+}
+
+// M-W lo hi count data, M-R lo hi [count], M-E lo hi
+void iecDrive::memory()
+{
+    if ( payload.size() < 5 )
+        return;
+
+    uint16_t address = (uint8_t)payload[3] | ((uint8_t)payload[4] << 8);
+    uint8_t count = (payload.size() > 5) ? payload[5] : 1;
+
+    switch ( payload[2] )
+    {
+        case 'W':
+            count = std::min((size_t)count, payload.size() - std::min(payload.size(), (size_t)6));
+            drive_code.write(address, (const uint8_t *)payload.data() + 6, count);
+            Debug_printv("memory write[%.4X] count[%d]", address, count);
+        break;
+        case 'R':
+        {
+            std::string r;
+            for ( uint16_t i = 0; i < (count ? count : 256); i++ )
+                r += (char)drive_code.read(address + i);
+            response_queue.push(r);
+            Debug_printv("memory read[%.4X] count[%d]", address, r.size());
+        }
+        break;
+        case 'E':
+        {
+            auto loader = drive_code.execute(address);
+            if ( loader != nullptr )
+            {
+                // Stays selected after this command, until reset
+                Debug_printv("memory execute[%.4X] loader[%s] protocol[%d]", address, loader->name, loader->protocol);
+                IEC.fastloader_protocol = loader->protocol;
+            }
+            else
+            {
+                Debug_printv("memory execute[%.4X] unknown code, crc[%.8X] length[%d]", address, drive_code.crc, drive_code.length);
+            }
+        }
+        break;
+    }
+}
 
 void iecDrive::set_device_id()
 {
@@ -568,16 +1037,11 @@ std::shared_ptr<MStream> iecDrive::retrieveStream ( uint8_t channel )
 {
     Debug_printv("Stream key[%d]", channel);
 
-    if ( streams.find ( channel ) != streams.end() )
-    {
-        Debug_printv("Stream retrieved. key[%d]", channel);
-        return streams.at ( channel );
-    }
-    else
-    {
+    auto stream = channels[channel & 0x0F].stream;
+    if ( stream == nullptr )
         Debug_printv("Error! Trying to recall not-registered stream!");
-        return nullptr;
-    }
+
+    return stream;
 }
 
 // used to start working with a stream, registering it as underlying stream of some
@@ -600,6 +1064,19 @@ bool iecDrive::registerStream (uint8_t channel)
 
         Debug_printv("LOAD \"%s\"", _base->url.c_str());
         new_stream = std::shared_ptr<MStream>(_base->meatStream());
+
+        // Nobody vouches for what comes from the network
+        _scan.reset();
+#ifdef VIRUS_SCAN
+        if ( new_stream != nullptr &&
+             ( mstr::startsWith(_base->url, "http:", false) ||
+               mstr::startsWith(_base->url, "https:", false) ||
+               mstr::startsWith(_base->url, "ml:", false) ) )
+        {
+            _scan = std::make_shared<MVirusScan>(new_stream);
+            new_stream = _scan;
+        }
+#endif
     }
 
     // SAVE / PUT / PRINT / WRITE
@@ -644,9 +1121,8 @@ bool iecDrive::registerStream (uint8_t channel)
     //     return false;
     // }
 
-    // Add stream to streams 
-    auto newPair = std::make_pair ( channel, new_stream );
-    streams.insert ( newPair );
+    // Add stream to channel table
+    channels[channel & 0x0F].open( new_stream );
 
     Debug_printv("Stream created. key[%d]", channel);
     return true;
@@ -654,83 +1130,265 @@ bool iecDrive::registerStream (uint8_t channel)
 
 bool iecDrive::closeStream ( uint8_t channel, bool close_all )
 {
-    auto found = streams.find(channel);
+    auto &c = channels[channel & 0x0F];
 
-    if ( found != streams.end() )
+    if ( c.stream != nullptr )
     {
         //Debug_printv("Stream closed. key[%d]", key);
-        auto closingStream = (*found).second;
-        closingStream->close();
-        return streams.erase ( channel );
+        c.close();
+        return true;
     }
 
     return false;
 }
 
 
+/********************************************************
+ * Channels
+ ********************************************************/
 
-// send single basic line, including heading basic pointer and terminating zero.
-uint16_t iecDrive::sendLine(uint16_t blocks, const char *format, ...)
+// Channels the worker may still be asked to fill. A queued channel that
+// has gone away since is skipped, the queue only carries its address
+static QueueHandle_t channel_queue = nullptr;
+static SemaphoreHandle_t channel_registry = nullptr;
+
+// Drives can be made before this file's statics are
+static std::set<iecChannel *> &channel_live()
 {
-    // Debug_printv("bus[%d]", IEC.bus_state);
+    static std::set<iecChannel *> live;
+    return live;
+}
 
-    // Exit if ATN is PULLED while sending
-    // Exit if there is an error while sending
-    if ( IEC.bus_state == BUS_ERROR )
+iecChannel::iecChannel()
+{
+    _lock = xSemaphoreCreateMutex();
+
+    if ( channel_registry == nullptr )
+        channel_registry = xSemaphoreCreateMutex();
+    xSemaphoreTake(channel_registry, portMAX_DELAY);
+    channel_live().insert(this);
+    xSemaphoreGive(channel_registry);
+}
+
+iecChannel::~iecChannel()
+{
+    // Waits for a fill of this channel that is under way
+    xSemaphoreTake(channel_registry, portMAX_DELAY);
+    channel_live().erase(this);
+    xSemaphoreGive(channel_registry);
+
+    vSemaphoreDelete(_lock);
+}
+
+void iecChannel::open(std::shared_ptr<MStream> s)
+{
+    lock();
+    stream = s;
+    if ( _buffer == nullptr )
+        _buffer.reset( new uint8_t[IEC_CHANNEL_BUFSZ] );
+    discard();
+    unlock();
+}
+
+void iecChannel::close()
+{
+    lock();
+    if ( stream != nullptr )
+        stream->close();
+    stream.reset();
+    discard();
+    _queued = false;
+    unlock();
+}
+
+// Called with the channel locked. Drop what was read ahead, the stream
+// has been moved underneath us
+void iecChannel::discard()
+{
+    _head = 0;
+    _tail = 0;
+    _position = (stream != nullptr) ? stream->position() : 0;
+    _eof = false;
+    _failed = false;
+}
+
+// Called with the channel locked. Puts a stream that is written to back
+// where the reads handed out got to, before writing. The worker has
+// usually read ahead past it
+void iecChannel::sync()
+{
+    if ( stream != nullptr && stream->isUpdatable() )
+        stream->seek( _position + _head );
+    discard();
+}
+
+// Called with the channel locked. Only the free part of the ring is read
+// into, what is handed out meanwhile isn't touched. The new bytes show
+// once _tail moves past them
+void iecChannel::fill()
+{
+    if ( stream == nullptr || _buffer == nullptr || _eof )
+        return;
+
+    uint32_t tail = _tail;
+    uint32_t space = IEC_CHANNEL_BUFSZ - (tail - _head);
+    if ( !space )
+        return;
+
+    uint32_t at = tail % IEC_CHANNEL_BUFSZ;
+    uint32_t n = stream->read(_buffer.get() + at, std::min(space, (uint32_t)(IEC_CHANNEL_BUFSZ - at)));
+    if ( n == 0 || stream->error() )
     {
-        // Save file pointer position
-        //streamUpdate(basicPtr);
-        //setDeviceStatus(74);
-        return 0;
+        _failed = (stream->error() != 0);
+        _eof = true;
     }
+    _tail = tail + n;
+}
 
-    // Format our string
-    va_list args;
-    va_start(args, format);
-    char text[vsnprintf(NULL, 0, format, args) + 1];
-    vsnprintf(text, sizeof text, format, args);
-    va_end(args);
+void iecChannel::readAhead()
+{
+    if ( _queued || _eof || (_tail - _head) > (IEC_CHANNEL_BUFSZ / 2) )
+        return;
 
-    return sendLine(blocks, text);
+    if ( channel_queue == nullptr )
+    {
+        channel_queue = xQueueCreate(IEC_CHANNELS, sizeof(iecChannel *));
+        xTaskCreatePinnedToCore(task, "iec_channel_task", 4096, NULL, 5, NULL, 0);
+    }
+
+    iecChannel *c = this;
+    _queued = true;
+    if ( xQueueSend(channel_queue, &c, 0) != pdTRUE )
+        _queued = false;
 }
 
-uint16_t iecDrive::sendLine(uint16_t blocks, char *text)
+void iecChannel::task(void *arg)
 {
-    Debug_printf("%d %s ", blocks, text);
+    iecChannel *c;
 
-    // Exit if ATN is PULLED while sending
-    // Exit if there is an error while sending
-    if ( IEC.flags & ERROR ) return 0;
+    while ( true )
+    {
+        if ( xQueueReceive(channel_queue, &c, portMAX_DELAY) != pdTRUE )
+            continue;
 
-    // Get text length
-    uint8_t len = strlen(text);
+        xSemaphoreTake(channel_registry, portMAX_DELAY);
+        if ( channel_live().count(c) )
+        {
+            c->_queued = false;
+            c->lock();
+            c->fill();
+            c->unlock();
+        }
+        xSemaphoreGive(channel_registry);
+    }
+}
 
-    // Send that pointer
-    // No basic line pointer is used in the directory listing set to 0x0101
-    IEC.sendByte(0x01);		// IEC.sendByte(basicPtr bitand 0xFF);
-    IEC.sendByte(0x01);		// IEC.sendByte(basicPtr >> 8);
+bool iecChannel::read(uint8_t *b)
+{
+    uint32_t head = _head;
+    if ( head == _tail )
+    {
+        // The worker didn't get to it in time
+        lock();
+        fill();
+        unlock();
+        if ( head == _tail )
+            return false;
+    }
 
-    // Send blocks
-    IEC.sendByte(blocks bitand 0xFF);
-    IEC.sendByte(blocks >> 8);
+    *b = _buffer[head % IEC_CHANNEL_BUFSZ];
+    _head = head + 1;
+    readAhead();
 
-    // Send line contents
-    for (uint8_t i = 0; i < len; i++)
+    return true;
+}
+
+bool iecChannel::seek(uint32_t pos)
+{
+    bool success = true;
+
+    lock();
+    // What the ring still holds, the worker is held off meanwhile
+    uint32_t tail = _tail;
+    uint32_t first = _position + ((tail > IEC_CHANNEL_BUFSZ) ? tail - IEC_CHANNEL_BUFSZ : 0);
+    if ( pos >= first && pos <= _position + tail )
     {
-        if ( !IEC.sendByte(text[i]) ) return 0;
+        _head = pos - _position;
     }
+    else if ( stream != nullptr )
+    {
+        success = stream->seek(pos);
+        discard();
+    }
+    unlock();
 
-    // Finish line
-    IEC.sendByte(0);
+    return success;
+}
 
-    Debug_println("");
-    
-    return len + 5;
-} // sendLine
+uint32_t iecChannel::position()
+{
+    return _position + _head;
+}
 
-uint16_t iecDrive::sendHeader(std::string header, std::string id)
+uint32_t iecChannel::available()
+{
+    lock();
+    uint32_t avail = (_tail - _head);
+    if ( stream != nullptr )
+        avail += stream->available();
+    unlock();
+
+    return avail;
+}
+
+uint32_t iecChannel::size()
+{
+    lock();
+    uint32_t len = (stream != nullptr) ? stream->size() : 0;
+    unlock();
+
+    return len;
+}
+
+bool iecChannel::error()
+{
+    // Buffered bytes are still good even if the stream has failed since
+    return (stream == nullptr) || (_head == _tail && _failed);
+}
+
+
+
+// Render a basic line: heading basic pointer, blocks, text and terminating zero.
+void iecDrive::renderLine(uint16_t blocks, const char *format, ...)
+{
+    // Format our string
+    va_list args;
+    va_start(args, format);
+    char text[vsnprintf(NULL, 0, format, args) + 1];
+    va_end(args);
+    va_start(args, format);
+    vsnprintf(text, sizeof text, format, args);
+    va_end(args);
+
+    Debug_printf("%d %s \r\n", blocks, text);
+
+    // No basic line pointer is used in the directory listing set to 0x0101
+    _listing.program += (char)0x01;
+    _listing.program += (char)0x01;
+
+    // Blocks
+    _listing.program += (char)(blocks bitand 0xFF);
+    _listing.program += (char)(blocks >> 8);
+
+    // Line contents
+    _listing.program += text;
+
+    // Finish line
+    _listing.program += (char)0x00;
+} // renderLine
+
+void iecDrive::renderHeader(std::string header, std::string id)
 {
-    uint16_t byte_count = 0;
     bool sent_info = false;
 
     PeoplesUrlParser p;
@@ -752,142 +1410,162 @@ uint16_t iecDrive::sendHeader(std::string header, std::string id)
 
     //Debug_printv("header[%s] id[%s] space_cnt[%d]", header.c_str(), id.c_str(), space_cnt);
 
-    byte_count += sendLine(0, CBM_REVERSE_ON "\"%*s%s%*s\" %s", space_cnt, "", header.c_str(), space_cnt, "", id.c_str());
-    if ( IEC.flags & ERROR ) return 0;
+    renderLine(0, CBM_REVERSE_ON "\"%*s%s%*s\" %s", space_cnt, "", header.c_str(), space_cnt, "", id.c_str());
 
-    //byte_count += sendLine(basicPtr, 0, "\x12\"%*s%s%*s\" %.02d 2A", space_cnt, "", PRODUCT_ID, space_cnt, "", device_config.device());
-    //byte_count += sendLine(basicPtr, 0, CBM_REVERSE_ON "%s", header.c_str());
+    //renderLine(0, "\x12\"%*s%s%*s\" %.02d 2A", space_cnt, "", PRODUCT_ID, space_cnt, "", device_config.device());
+    //renderLine(0, CBM_REVERSE_ON "%s", header.c_str());
 
     // Send Extra INFO
     if (url.size())
     {
-        byte_count += sendLine(0, "%*s\"%-*s\" NFO", 0, "", 19, "[URL]");
-        if ( IEC.flags & ERROR ) return 0;
-        byte_count += sendLine(0, "%*s\"%-*s\" NFO", 0, "", 19, url.c_str());
-        if ( IEC.flags & ERROR ) return 0;
+        renderLine(0, "%*s\"%-*s\" NFO", 0, "", 19, "[URL]");
+        renderLine(0, "%*s\"%-*s\" NFO", 0, "", 19, url.c_str());
         sent_info = true;
     }
     if (path.size() > 1)
     {
-        byte_count += sendLine(0, "%*s\"%-*s\" NFO", 0, "", 19, "[PATH]");
-        if ( IEC.flags & ERROR ) return 0;
-        byte_count += sendLine(0, "%*s\"%-*s\" NFO", 0, "", 19, path.c_str());
-        if ( IEC.flags & ERROR ) return 0;
+        renderLine(0, "%*s\"%-*s\" NFO", 0, "", 19, "[PATH]");
+        renderLine(0, "%*s\"%-*s\" NFO", 0, "", 19, path.c_str());
         sent_info = true;
     }
     if (archive.size() > 1)
     {
-        byte_count += sendLine(0, "%*s\"%-*s\" NFO", 0, "", 19, "[ARCHIVE]");
-        if ( IEC.flags & ERROR ) return 0;
-        byte_count += sendLine(0, "%*s\"%-*s\" NFO", 0, "", 19, archive.c_str());
-        if ( IEC.flags & ERROR ) return 0;
+        renderLine(0, "%*s\"%-*s\" NFO", 0, "", 19, "[ARCHIVE]");
+        renderLine(0, "%*s\"%-*s\" NFO", 0, "", 19, archive.c_str());
     }
     if (image.size())
     {
-        byte_count += sendLine(0, "%*s\"%-*s\" NFO", 0, "", 19, "[IMAGE]");
-        if ( IEC.flags & ERROR ) return 0;
-        byte_count += sendLine(0, "%*s\"%-*s\" NFO", 0, "", 19, image.c_str());
-        if ( IEC.flags & ERROR ) return 0;
+        renderLine(0, "%*s\"%-*s\" NFO", 0, "", 19, "[IMAGE]");
+        renderLine(0, "%*s\"%-*s\" NFO", 0, "", 19, image.c_str());
         sent_info = true;
     }
     if (sent_info)
     {
-        byte_count += sendLine(0, "%*s\"-------------------\" NFO", 0, "");
-        if ( IEC.flags & ERROR ) return 0;
+        renderLine(0, "%*s\"-------------------\" NFO", 0, "");
     }
     
 
     // if (path.size() > 2)
     // {
-    //     byte_count += sendLine(0, "%*s\"_\"                DIR", 3, "");
-    //     if ( IEC.flags & ERROR ) return 0;
-    //     byte_count += sendLine(0, "%*s\"\\\"               DIR", 3, "");
-    //     if ( IEC.flags & ERROR ) return 0;
+    //     renderLine(0, "%*s\"_\"                DIR", 3, "");
+    //     renderLine(0, "%*s\"\\\"               DIR", 3, "");
     // }
     if (fnSDFAT.running() && _base->url.size() < 2)
     {
-        byte_count += sendLine(0, "%*s\"SD\"               DIR", 3, "");
-        if ( IEC.flags & ERROR ) return 0;
+        renderLine(0, "%*s\"SD\"               DIR", 3, "");
     }
-
-    return byte_count;
 }
 
-uint16_t iecDrive::sendFooter()
+void iecDrive::renderFooter()
 {
     uint16_t blocks_free;
-    uint16_t byte_count = 0;
     uint64_t bytes_free = _base->getAvailableSpace();
 
     if ( _base->size() )
     {
         blocks_free = _base->media_blocks_free;
-        byte_count = sendLine(blocks_free, "BLOCKS FREE.");
+        renderLine(blocks_free, "BLOCKS FREE.");
     }
     else
     {
         // We are not in a media file so let's show BYTES FREE instead
         blocks_free = 0;
-        byte_count = sendLine(blocks_free, CBM_DELETE CBM_DELETE "%sBYTES FREE.", mstr::formatBytes(bytes_free).c_str() );
+        renderLine(blocks_free, CBM_DELETE CBM_DELETE "%sBYTES FREE.", mstr::formatBytes(bytes_free).c_str() );
+    }
+}
+
+// CBM DOS wildcards, '*' ends the match and '?' is any one character
+static bool listing_match(const std::string &pattern, const std::string &name)
+{
+    size_t i = 0;
+    for ( ; i < pattern.size(); i++ )
+    {
+        if ( pattern[i] == '*' )
+            return true;
+        if ( i >= name.size() )
+            return false;
+        if ( pattern[i] != '?' && std::tolower((unsigned char)pattern[i]) != std::tolower((unsigned char)name[i]) )
+            return false;
     }
 
-    return byte_count;
+    return i == name.size();
 }
 
-void iecDrive::sendListing()
+// "$:pattern[,pattern...][=type]" picks the entries to list
+bool iecDrive::listingWanted(const std::string &name, const std::string &type)
 {
-    Debug_printf("sendListing: [%s]\r\n=================================\r\n", _base->url.c_str());
+    if ( _listing_filter.empty() || type.empty() )
+        return true;
 
-    uint16_t byte_count = 0;
-    std::string extension = "dir";
+    std::string filter = _listing_filter;
+    size_t t = filter.find('=');
+    if ( t != std::string::npos )
+    {
+        if ( t + 1 < filter.size() && std::tolower((unsigned char)filter[t + 1]) != std::tolower((unsigned char)type[0]) )
+            return false;
+        filter = filter.substr(0, t);
+    }
 
-    std::unique_ptr<MFile> entry = std::unique_ptr<MFile>( _base->getNextFileInDir() );
+    auto patterns = util_tokenize(filter, ',');
+    if ( patterns.empty() )
+        return true;
 
-    if(entry == nullptr) {
-        closeStream( commanddata.channel );
+    for ( auto &p : patterns )
+    {
+        if ( listing_match(p, name) )
+            return true;
+    }
 
-        bool isOpen = registerStream(commanddata.channel);
-        if(isOpen) 
-        {
-            sendFile();
-        }
-        else
-        {
-            IEC.senderTimeout(); // File Not Found
-        }
-        
-        return;
+    return false;
+}
+
+// Cut the wanted entries from the full listing
+std::string iecDrive::filterListing()
+{
+    std::string program = _listing.program.substr(0, _listing.header_end);
+    for ( auto &e : _listing.entries )
+    {
+        if ( listingWanted(e.name, e.type) )
+            program.append(_listing.program, e.offset, e.length);
     }
+    program.append(_listing.program, _listing.footer_start, std::string::npos);
 
-    //fnLedStrip.startRainbow(300);
+    return program;
+}
 
-    // Send load address
-    IEC.sendByte(CBM_BASIC_START & 0xff);
-    IEC.sendByte((CBM_BASIC_START >> 8) & 0xff);
-    byte_count += 2;
+// Render the whole listing of _base, false if it has no entries at all.
+// A streamed listing isn't kept, its lines go out as they are rendered
+// and only the wanted entries are rendered. The footer is left to send
+bool iecDrive::renderListing(bool stream)
+{
+    std::string extension = "dir";
 
-    // If there has been a error don't try to send any more bytes
-    if ( IEC.flags & ERROR ) return;
+    std::unique_ptr<MFile> entry = std::unique_ptr<MFile>( _base->getNextFileInDir() );
+    if ( entry == nullptr )
+        return false;
 
-    Debug_println("");
+    // Load address
+    _listing.program += (char)(CBM_BASIC_START & 0xff);
+    _listing.program += (char)((CBM_BASIC_START >> 8) & 0xff);
 
-    // Send Listing Header
+    // Listing Header
     if (_base->media_header.size() == 0)
     {
-        // Send device default listing header
+        // Device default listing header
         char buf[7] = { '\0' };
         sprintf(buf, "%.02d 2A", IEC.data.device);
-        byte_count += sendHeader(PRODUCT_ID, buf);
-        if ( IEC.flags & ERROR ) return;
+        renderHeader(PRODUCT_ID, buf);
     }
     else
     {
-        // Send listing header from media file
-        byte_count += sendHeader(_base->media_header.c_str(), _base->media_id.c_str());
-        if ( IEC.flags & ERROR ) return;
+        // Listing header from media file
+        renderHeader(_base->media_header.c_str(), _base->media_id.c_str());
     }
+    _listing.header_end = _listing.program.size();
+    if ( stream && !sendListingPart() )
+        return true;
 
-    // Send Directory Items
+    // Directory Items
     while(entry != nullptr)
     {
         uint32_t s = entry->size();
@@ -929,23 +1607,27 @@ void iecDrive::sendListing()
         // Don't show hidden folders or files
         //Debug_printv("size[%d] name[%s]", entry->size(), entry->name.c_str());
 
-        std::string name = entry->petsciiName();
-        mstr::toPETSCII(extension);
-
         if (entry->name[0]!='.')
         {
-            // Exit if ATN is PULLED while sending
-            // Exit if there is an error while sending
-            if ( IEC.bus_state == BUS_ERROR )
+            std::string name = entry->petsciiName();
+            std::string type = extension;
+            mstr::toPETSCII(extension);
+
+            if ( stream )
             {
-                // Save file pointer position
-                // streamUpdate(byte_count);
-                //setDeviceStatus(74);
-                return;
+                if ( listingWanted(entry->name, type) )
+                {
+                    renderLine(block_cnt, "%*s\"%s\"%*s %s", block_spc, "", name.c_str(), space_cnt, "", extension.c_str());
+                    if ( !sendListingPart() )
+                        return true;
+                }
+            }
+            else
+            {
+                uint32_t offset = _listing.program.size();
+                renderLine(block_cnt, "%*s\"%s\"%*s %s", block_spc, "", name.c_str(), space_cnt, "", extension.c_str());
+                _listing.entries.push_back({ entry->name, type, offset, (uint16_t)(_listing.program.size() - offset) });
             }
-
-            byte_count += sendLine(block_cnt, "%*s\"%s\"%*s %s", block_spc, "", name.c_str(), space_cnt, "", extension.c_str());
-            if ( IEC.flags & ERROR ) return;
         }
 
         entry.reset(_base->getNextFileInDir());
@@ -953,16 +1635,120 @@ void iecDrive::sendListing()
         //fnLedManager.toggle(eLed::LED_BUS);
     }
 
-    // Send Listing Footer
-    byte_count += sendFooter();
-    if ( IEC.flags & ERROR ) return;
+    // Listing Footer
+    _listing.footer_start = _listing.program.size();
+    renderFooter();
 
-    // End program with two zeros after last line. Last zero goes out as EOI.
-    IEC.sendByte(0);
-    IEC.sendByte(0, true);
-    //closeStream();
+    // End program with two zeros after last line
+    _listing.program += (char)0x00;
+    _listing.program += (char)0x00;
 
-    Debug_printf("\r\n=================================\r\n%d bytes sent\r\n", byte_count);
+    return true;
+}
+
+// Send what is rendered so far, more follows
+bool iecDrive::sendListingPart()
+{
+    bool success = IEC.sendBytes(_listing.program, false);
+    _listing.program.clear();
+    return success && !(IEC.flags & ERROR);
+}
+
+// Listings are only kept for images and archives, checked against the
+// file they are in. Plain directories have no stamp that changes when
+// their content does, neither do remote files without a time. Images
+// of one type all have the same size, that alone says nothing.
+bool iecDrive::listingStamp(time_t &modified, uint32_t &size)
+{
+    MFile *container = _base->streamFile;
+    if ( container == nullptr || container->url.empty() )
+        return false;
+
+    modified = container->getLastWrite();
+    size = container->size();
+
+    return ( modified != 0 );
+}
+
+void iecDrive::sendListing()
+{
+    Debug_printf("sendListing: [%s]\r\n=================================\r\n", _base->url.c_str());
+
+    uint64_t start = esp_timer_get_time();
+
+    time_t modified = 0;
+    uint32_t size = 0;
+    bool cacheable = listingStamp(modified, size);
+    if ( cacheable )
+    {
+        std::string image = _base->streamFile->url;
+        if ( image == _image_url && (modified != _image_modified || size != _image_size) )
+            ImageBroker::dispose( image );
+        _image_url = image;
+        _image_modified = modified;
+        _image_size = size;
+    }
+    else if ( _base->streamFile != nullptr && _base->streamFile->url.size() )
+    {
+        // An image that can't be checked is read again
+        ImageBroker::dispose( _base->streamFile->url );
+        _image_url.clear();
+    }
+    bool cached = cacheable && _listing.url == _base->url && _listing.device == IEC.data.device &&
+                  _listing.modified == modified && _listing.size == size;
+
+    if ( !cached )
+    {
+        _listing.clear();
+
+        if ( !renderListing( !cacheable ) )
+        {
+            _listing.clear();
+            closeStream( commanddata.channel );
+
+            bool isOpen = registerStream(commanddata.channel);
+            if(isOpen) 
+            {
+                sendFile();
+            }
+            else
+            {
+                IEC.senderTimeout(); // File Not Found
+            }
+            
+            return;
+        }
+
+        if ( cacheable )
+        {
+            _listing.url = _base->url;
+            _listing.device = IEC.data.device;
+            _listing.modified = modified;
+            _listing.size = size;
+        }
+    }
+
+    //fnLedStrip.startRainbow(300);
+
+    uint64_t rendered = esp_timer_get_time();
+
+    // The whole program in one pass, or what is left of a streamed one.
+    // Last zero goes out as EOI
+    if ( !cacheable )
+    {
+        if ( !(IEC.flags & ERROR) )
+            IEC.sendBytes(_listing.program);
+    }
+    else if ( _listing_filter.empty() )
+        IEC.sendBytes(_listing.program);
+    else
+        IEC.sendBytes(filterListing());
+
+    Debug_printf("\r\n=================================\r\n%d bytes, cached[%d] streamed[%d] first byte after %lluus, sent after %lluus\r\n", _listing.program.size(), cached, !cacheable, rendered - start, esp_timer_get_time() - start);
+
+    // Nothing to check a plain directory against next time
+    if ( !cacheable )
+        _listing.clear();
 
     //fnLedManager.set(eLed::LED_BUS, false);
     //fnLedStrip.stopRainbow();
@@ -996,6 +1782,7 @@ bool iecDrive::sendFile()
         _base.reset( MFSOwner::File( _base->base() ) );
         return false;
     }
+    auto &channel = channels[commanddata.channel & 0x0F];
 
     if ( !_base->isDirectory() )
     {
@@ -1016,8 +1803,8 @@ bool iecDrive::sendFile()
 
     }
 
-    uint32_t len = istream->size();
-    uint32_t avail = istream->available();
+    uint32_t len = channel.size();
+    uint32_t avail = channel.available();
     if ( !len )
         len = -1;
 
@@ -1027,10 +1814,10 @@ bool iecDrive::sendFile()
     {
         // Get/Send file load address
         count = 2;
-        istream->read(&b, 1);
+        channel.read(&b);
         success_tx = IEC.sendByte(b);
         load_address = b & 0x00FF; // low byte
-        istream->read(&b, 1);
+        channel.read(&b);
         success_tx = IEC.sendByte(b);
         load_address = load_address | b << 8;  // high byte
         sys_address = load_address;
@@ -1040,14 +1827,14 @@ bool iecDrive::sendFile()
     }
 
     // Read byte
-    success_rx = istream->read(&b, 1);
+    success_rx = channel.read(&b);
     //Debug_printv("b[%02X] success[%d]", b, success_rx);
 
     Debug_printf("sendFile: [$%.4X]\r\n=================================\r\n", load_address);
-    while( success_rx && !istream->error() )
+    while( success_rx && !channel.error() )
     {
         // Read next byte
-        success_rx = istream->read(&nb, 1);
+        success_rx = channel.read(&nb);
 
         //Debug_printv("b[%02X] nb[%02X] success_rx[%d] error[%d]", b, nb, success_rx, istream->error());
 #ifdef DATA_STREAM
@@ -1057,6 +1844,11 @@ bool iecDrive::sendFile()
             load_address += 8;
         }
 #endif
+        // A failed read (a virus found) isn't the end of the file, the
+        // last byte is not sent with EOI and the LOAD times out below
+        if ( !success_rx && channel.error() )
+            break;
+
         // Send Byte
         if ( count + 1 == avail || !success_rx )
         {
@@ -1105,7 +1897,7 @@ bool iecDrive::sendFile()
             //Debug_printv("ATN pulled while sending. i[%d]", i);
 
             // Save file pointer position
-            istream->seek(istream->position() - 2);
+            channel.seek(channel.position() - 2);
             //success_rx = true;
             break;
         }
@@ -1134,7 +1926,14 @@ bool iecDrive::sendFile()
     //fnLedManager.set(eLed::LED_BUS, false);
     //fnLedStrip.stopRainbow();
 
-    if ( istream->error() )
+    if ( _scan != nullptr && _scan->detected )
+    {
+        // Not a CBM DOS error, the number is free
+        setStatus(79, mstr::format("VIRUS %s", _scan->detected).c_str());
+        _scan.reset();
+    }
+
+    if ( channel.error() )
     {
         Debug_println("sendFile: Transfer aborted!");
         IEC.senderTimeout();
@@ -1151,6 +1950,9 @@ bool iecDrive::saveFile()
     bool success = true;
     bool done = false;
 
+    // Any listing kept from before is stale now
+    _listing.clear();
+
     size_t bi = 0;
     size_t load_address = 0;
     size_t b_len = 1;
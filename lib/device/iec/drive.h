@@ -1,16 +1,106 @@
 #ifndef DISK_H
 #define DISK_H
 
+#include <atomic>
 #include <string>
-#include <unordered_map>
+#include <memory>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 #include "bus.h"
 #include "../media/media.h"
 #include "../meatloaf/meat_io.h"
 #include "../meatloaf/meat_buffer.h"
+#include "../meatloaf/meat_copy.h"
+#include "../meatloaf/scanners/virus.h"
+
+#include "drivecode.h"
 
 #define PRODUCT_ID "MEATLOAF CBM"
 
+#define IEC_CHANNELS        16
+#define IEC_CHANNEL_BUFSZ   256     // Read-ahead per open channel
+
+// One secondary address. Reads are served from the channel's own ring
+// buffer, which the channel worker task tops up in the background, so
+// switching between open channels doesn't wait on storage or the network.
+// The worker reads the stream with the channel locked, but bytes are
+// handed out of the ring without taking the lock.
+class iecChannel
+{
+public:
+    iecChannel();
+    ~iecChannel();
+
+    std::shared_ptr<MStream> stream;
+
+    void open(std::shared_ptr<MStream> s);
+    void close();
+
+    bool read(uint8_t *b);
+    bool seek(uint32_t pos);
+    uint32_t position();
+    uint32_t available();
+    uint32_t size();
+    bool error();
+
+    // Hold the channel while using the stream directly (U1, B-P...)
+    // and call discard() if it was repositioned
+    void lock() { xSemaphoreTake(_lock, portMAX_DELAY); };
+    void unlock() { xSemaphoreGive(_lock); };
+    void discard();
+    void sync();
+
+private:
+    SemaphoreHandle_t _lock;
+    std::unique_ptr<uint8_t[]> _buffer;
+    std::atomic<uint32_t> _head{0};     // Next byte to hand out, counts up
+    std::atomic<uint32_t> _tail{0};     // End of the bytes read, counts up
+    uint32_t _position = 0;             // Stream position of byte 0
+    std::atomic<bool> _eof{false};
+    std::atomic<bool> _failed{false};   // The stream reported an error
+    std::atomic<bool> _queued{false};   // Waiting for the worker
+
+    void fill();
+    void readAhead();
+
+    static void task(void *arg);
+};
+
+// A directory listing rendered as a BASIC program. Listings of images
+// and archives are kept until the file holding them changes. The line
+// of each entry is noted so filtered listings are cut from the same
+// render.
+struct iecListing
+{
+    std::string url;
+    uint8_t device = 0;
+    time_t modified = 0;        // Of the image or archive file
+    uint32_t size = 0;
+
+    struct Entry
+    {
+        std::string name;
+        std::string type;
+        uint32_t offset;        // Line in program
+        uint16_t length;
+    };
+    std::vector<Entry> entries;
+
+    std::string program;        // Load address, header, entries, footer and end of program
+    uint32_t header_end = 0;
+    uint32_t footer_start = 0;
+
+    void clear()
+    {
+        url.clear();
+        std::vector<Entry>().swap(entries);
+        std::string().swap(program);
+    };
+};
+
 class iecDrive : public virtualDevice
 {
 protected:
@@ -21,15 +111,30 @@ protected:
 
     // Named Channel functions
     //std::shared_ptr<MStream> currentStream;
+    iecChannel channels[IEC_CHANNELS];
     bool registerStream (uint8_t channel);
     std::shared_ptr<MStream> retrieveStream ( uint8_t channel );
     bool closeStream ( uint8_t channel, bool close_all = false );
 
+    // Scanner on the file being loaded from the network
+    std::shared_ptr<MVirusScan> _scan;
+
     // Directory
-	uint16_t sendHeader(std::string header, std::string id);
-	uint16_t sendLine(uint16_t blocks, char *text);
-	uint16_t sendLine(uint16_t blocks, const char *format, ...);
-	uint16_t sendFooter();
+    iecListing _listing;
+    std::string _listing_filter;    // LOAD"$:pattern"
+
+    // Image the broker caches blocks of, it is read again once changed
+    std::string _image_url;
+    time_t _image_modified = 0;
+    uint32_t _image_size = 0;
+	void renderHeader(std::string header, std::string id);
+	void renderLine(uint16_t blocks, const char *format, ...);
+	void renderFooter();
+	bool renderListing(bool stream = false);
+	bool sendListingPart();
+	bool listingWanted(const std::string &name, const std::string &type);
+	bool listingStamp(time_t &modified, uint32_t &size);
+	std::string filterListing();
 	void sendListing();
 
     // File
@@ -47,6 +152,27 @@ protected:
     void read();
     void write(bool verify);
     void format();
+    void validate();
+
+    // M-W/M-R/M-E against a shadow of drive RAM
+    DriveCode drive_code;
+    void memory();
+
+    // U1/U2, B-R/B-W/B-P on "#" channels
+    void block();
+
+    // MD, RD, CP and / in DNP subdirectories and D81 partitions
+    void makeDirectory();
+    void removeDirectory();
+    void changePartition();
+
+    // C: and D run in the background, channel 15 shows how far they got
+    std::unique_ptr<MCopy> _copy;
+    std::string _status;            // Reply to the next status read
+    void setStatus(uint8_t code, const char *msg, uint8_t track = 0, uint8_t sector = 0);
+    bool startCopy(std::vector<std::shared_ptr<MStream>> sources, MFile *destination);
+    void copy();
+    void duplicate();
 
 protected:
     /**
@@ -154,8 +280,6 @@ public:
 
     //mediatype_t disktype() { return _disk == nullptr ? MEDIATYPE_UNKNOWN : _disk->_mediatype; };
 
-    std::unordered_map<uint16_t, std::shared_ptr<MStream>> streams;
-
     ~iecDrive();
 };
 
@@ -0,0 +1,90 @@
+#ifdef BUILD_IEC
+
+#include "drivecode.h"
+
+#include <cstring>
+
+// Add loaders here with the crc and length logged by the M-E handler
+static const DriveLoader loaders[] = {
+    // Stage 1 receiver, M-W $0180-$01CA then M-E $01A9
+    { "EPYX FASTLOAD", 75, 0xE81A93CB, PROTOCOL_EPYXFASTLOAD },
+};
+
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    while ( length-- )
+    {
+        crc ^= *data++;
+        for ( uint8_t i = 0; i < 8; i++ )
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+
+    return ~crc;
+}
+
+void DriveCode::reset()
+{
+    memset(_ram, 0, sizeof(_ram));
+    memset(_written, 0, sizeof(_written));
+    crc = 0;
+    length = 0;
+}
+
+bool DriveCode::write(uint16_t address, const uint8_t *data, uint8_t length)
+{
+    for ( uint8_t i = 0; i < length; i++ )
+    {
+        // RAM is mirrored up to $1800 on a 1541
+        uint16_t a = (address + i) % DRIVE_RAM_SIZE;
+        if ( address + i >= 0x1800 )
+            return false;
+
+        _ram[a] = data[i];
+        _written[a >> 3] |= (1 << (a & 7));
+    }
+
+    return true;
+}
+
+uint8_t DriveCode::read(uint16_t address)
+{
+    if ( address >= 0x1800 )
+        return 0x00;  // No ROM or I/O to show
+
+    return _ram[address % DRIVE_RAM_SIZE];
+}
+
+const DriveLoader *DriveCode::execute(uint16_t address)
+{
+    crc = 0;
+    length = 0;
+
+    address %= DRIVE_RAM_SIZE;
+    if ( !written(address) )
+        return nullptr;
+
+    // Hash the whole run of written bytes around the entry point,
+    // loaders often jump into the middle of what they uploaded
+    uint16_t start = address;
+    while ( start > 0 && written(start - 1) )
+        start--;
+
+    uint16_t end = address;
+    while ( end < DRIVE_RAM_SIZE && written(end) )
+        end++;
+
+    length = end - start;
+    crc = crc32(&_ram[start], length);
+
+    for ( const auto &loader : loaders )
+    {
+        if ( loader.length == length && loader.crc == crc )
+            return &loader;
+    }
+
+    return nullptr;
+}
+
+#endif /* BUILD_IEC */
@@ -0,0 +1,48 @@
+#ifndef DRIVECODE_H
+#define DRIVECODE_H
+
+#include <cstdint>
+
+#include "../../bus/bus.h"
+
+#define DRIVE_RAM_SIZE      0x0800  // 1541 RAM, $0000-$07FF
+
+// A fast loader recognised by the drive code it uploads
+struct DriveLoader
+{
+    const char *name;
+    uint16_t length;            // Bytes in the written run M-E jumps into
+    uint32_t crc;               // CRC32 of that run
+    bus_protocol_t protocol;
+};
+
+// Drive RAM as far as the computer wrote it with M-W. Uploaded code is
+// never run, M-E only fingerprints it against the known loaders.
+class DriveCode
+{
+public:
+    DriveCode() { reset(); };
+
+    void reset();
+
+    bool write(uint16_t address, const uint8_t *data, uint8_t length);
+    uint8_t read(uint16_t address);
+
+    /**
+     * @brief Look up the code M-E jumps to
+     * @return The matching loader, or nullptr if the code is unknown
+     */
+    const DriveLoader *execute(uint16_t address);
+
+    // CRC32 of the last M-E, logged so new loaders can be added to the table
+    uint32_t crc = 0;
+    uint16_t length = 0;
+
+private:
+    uint8_t _ram[DRIVE_RAM_SIZE];
+    uint8_t _written[DRIVE_RAM_SIZE / 8];   // One bit per byte written
+
+    bool written(uint16_t address) { return _written[address >> 3] & (1 << (address & 7)); };
+};
+
+#endif // DRIVECODE_H
@@ -18,34 +18,34 @@ void iecVoice::sam_parameters()
     for (vector<string>::iterator it = tokens.begin(); it != tokens.end(); ++it)
     {
         string t = *it;
+        bool has_value = (it + 1) != tokens.end();
 
         switch (t[0])
         {
         case 0x07: // ^G SING
-            sing = true;
+            voice.sing = true;
             break;
         case 0x09: // ^I PITCH
-            pitch = *(++it);
+            if (has_value)
+                voice.pitch = atoi((++it)->c_str());
             break;
         case 0x0D: // ^M Mouth
-            mouth = *(++it);
+            if (has_value)
+                voice.mouth = atoi((++it)->c_str());
             break;
         case 0x10: // ^P Phonetic
-            phonetic = true;
+            voice.phonetic = true;
             break;
         case 0x12: // ^R RESET
-            sing = false;
-            pitch.clear();
-            mouth.clear();
-            phonetic = false;
-            speed.clear();
-            throat.clear();
+            voice = SamVoice();
             break;
         case 0x13: // ^S Speed
-            speed = *(++it);
+            if (has_value)
+                voice.speed = atoi((++it)->c_str());
             break;
         case 0x14: // ^T Throat
-            throat = *(++it);
+            if (has_value)
+                voice.throat = atoi((++it)->c_str());
             break;
         default:
             if (it != tokens.begin())
@@ -58,57 +58,13 @@ void iecVoice::sam_parameters()
 
 void iecVoice::sam_init()
 {
-    int n = 0;
-    char *a[16];
-    // int i = 0;
-
     memset(samBuffer, 0, sizeof(samBuffer));
-    memset(a, 0, sizeof(a));
-
-    // Construct parameter buffer.
-    a[n++] = (char *)("sam");
-    a[n++] = (char *)("-debug");
 
+    // Settings persist from line to line, they are only reset by ^R
     sam_parameters();
 
-    if (sing == true)
-        a[n++] = (char *)("-sing");
-
-    if (!pitch.empty())
-    {
-        a[n++] = (char *)("-pitch");
-        a[n++] = (char *)(pitch.c_str());
-    }
-
-    if (!mouth.empty())
-    {
-        a[n++] = (char *)("-mouth");
-        a[n++] = (char *)(mouth.c_str());
-    }
-
-    if (phonetic == true)
-        a[n++] = (char *)("-phonetic");
-
-    if (!pitch.empty())
-    {
-        a[n++] = (char *)("-pitch");
-        a[n++] = (char *)(pitch.c_str());
-    }
-
-    if (!speed.empty())
-    {
-        a[n++] = (char *)("-speed");
-        a[n++] = (char *)(speed.c_str());
-    }
-
-    if (!throat.empty())
-    {
-        a[n++] = (char *)("-throat");
-        a[n++] = (char *)(throat.c_str());
-    }
-
-    a[n++] = (char *)samBuffer;
-    sam(n, a);
+    // Speech starts playing while the rest of the line is still being rendered
+    sam_say(voice, (char *)samBuffer);
 };
 
 void iecVoice::write()
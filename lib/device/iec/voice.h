@@ -26,12 +26,7 @@ protected:
     virtual void status();
 
 private:
-    bool sing = false;
-    std::string pitch;
-    std::string mouth;
-    bool phonetic = false;
-    std::string speed;
-    std::string throat;
+    SamVoice voice;
 
     void sam_init();
     void sam_parameters();
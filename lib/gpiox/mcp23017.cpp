@@ -10,7 +10,7 @@
 MCP23017 GPIOX;
 
 MCP23017::MCP23017() :
-		_PIN(0), _PORT(0), _DDR(0), _address(0)
+		PORT0(0), PORT1(0), _PIN(0), _PORT(0), _DDR(0), _address(0)
 {
 }
 
@@ -49,6 +49,24 @@ void MCP23017::pinMode(uint8_t pin, uint8_t mode) {
 	updateGPIO();
 }
 
+void MCP23017::portMode(port_t port, pin_mode_t mode) {
+
+	portMode(port, (uint16_t)((mode == GPIOX_MODE_INPUT) ? 0xFFFF : 0x0000));
+}
+
+void MCP23017::portMode(port_t port, uint16_t mode) {
+
+	if ( port == GPIOX_PORT0 )
+		_DDR = (_DDR & 0xFF00) | (mode & 0x00FF);    // set low byte to mode
+	else if ( port == GPIOX_PORT1 )
+		_DDR = (_DDR & 0x00FF) | (mode & 0xFF00);    // set high byte to mode
+	else
+		_DDR = mode;
+
+	/* Update GPIO values */
+	updateGPIO();
+}
+
 void MCP23017::digitalWrite(uint8_t pin, uint8_t value) {
 
 	/* Set PORT bit value */
@@ -70,6 +88,20 @@ uint8_t MCP23017::digitalRead(uint8_t pin) {
 	return (_PIN & (1 << pin));
 }
 
+void MCP23017::write(port_t port, uint16_t value) {
+
+	/* Store pins values and apply */
+	if ( port == GPIOX_PORT0 )
+		_PORT = (_PORT & 0xFF00) | (value & 0x00FF);
+	else if ( port == GPIOX_PORT1 )
+		_PORT = (_PORT & 0x00FF) | (value << 8 & 0xFF00);
+	else
+		_PORT = value;
+
+	/* Update GPIO values */
+	updateGPIO();
+}
+
 void MCP23017::write(uint16_t value) {
 
 	/* Store pins values and apply */
@@ -79,13 +111,20 @@ void MCP23017::write(uint16_t value) {
 	updateGPIO();
 }
 
-uint16_t MCP23017::read() {
+uint16_t MCP23017::read(port_t port) {
 
 	/* Read GPIO */
 	readGPIO();
+	PORT0 = _PIN & 0x00FF;
+	PORT1 = _PIN >> 8;
 
 	/* Return current pins values */
-	return _PIN;
+	if ( port == GPIOX_PORT0 )
+		return PORT0;
+	else if ( port == GPIOX_PORT1 )
+		return PORT1;
+	else
+		return _PIN;
 }
 
 
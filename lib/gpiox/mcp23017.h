@@ -9,6 +9,7 @@
 
 #include "../../include/pinmap.h"
 
+#include <esp_attr.h>
 #include <I2Cbus.hpp>
 
 #define I2C_SDA      PIN_GPIOX_SDA
@@ -56,6 +57,9 @@ public:
 	 */
 	MCP23017();
 
+	uint8_t PORT0; // PINS 00-07
+	uint8_t PORT1; // PINS 10-17
+
 	/**
 	 * Start the I2C controller and store the MCP23017 chip address
 	 */
@@ -70,6 +74,15 @@ public:
 	 */
 	void pinMode(uint8_t pin, uint8_t mode);
 
+	/**
+	 * Set the direction of all port pins (INPUT, OUTPUT)
+	 * 
+	 * @param port The port to set
+	 * @param mode The new mode of the pins
+	 */
+	void portMode(port_t port, pin_mode_t mode);
+	void portMode(port_t port, uint16_t mode);
+
 	/**
 	 * Set the state of a pin (HIGH or LOW)
 	 * 
@@ -92,6 +105,7 @@ public:
 	 * 
 	 * @param value The new value of all pins (1 bit = 1 pin, '1' = HIGH, '0' = LOW)
 	 */
+	void write(port_t port, uint16_t value);
 	void write(uint16_t value);
 
 	/**
@@ -99,7 +113,7 @@ public:
 	 * 
 	 * @return The current value of all pins (1 bit = 1 pin, '1' = HIGH, '0' = LOW)
 	 */
-	uint16_t read();
+	uint16_t read(port_t port = GPIOX_BOTH);
 
 	/**
 	 * Exactly like write(0x00), set all pins to LOW
@@ -116,6 +130,21 @@ public:
 	 */
 	void toggle(uint8_t pin);
 
+	/**
+	 * Batched writes, as on the other expanders
+	 *
+	 * @remarks Nothing is queued here, every write is still sent right away
+	 */
+	void beginBatch() {}
+	void endBatch() {}
+
+	/**
+	 * Mark the input shadow stale
+	 *
+	 * @remarks Inputs are not shadowed here, every read goes to the chip
+	 */
+	void IRAM_ATTR invalidate() {}
+
 protected:
 
 	I2C_t& myI2C = i2c0;  // i2c0 and i2c1 are the default objects
@@ -10,7 +10,8 @@
 PCF8575 GPIOX;
 
 PCF8575::PCF8575() :
-		_DIN(0), _DIN_LAST(0), _DOUT(0), _DDR(0), _address(0)
+		_DIN(0), _DIN_LAST(0), _DOUT(0), _DDR(0), _DIN_VALID(false), _SENT(0xFFFF),
+		_batch_depth(0), _batch_length(0), _address(0)
 {
 }
 
@@ -25,7 +26,7 @@ void PCF8575::begin(gpio_num_t sda, gpio_num_t scl, uint8_t address, uint16_t sp
     //myI2C.scanner();
 	myI2C.reset();
 
-	readGPIOX();
+	readGPIOX(true);
 }
 
 void PCF8575::pinMode(uint8_t pin, pin_mode_t mode) {
@@ -135,10 +136,10 @@ void PCF8575::write(port_t port, uint16_t value) {
 	/* Store pins values and apply */
 	if ( port == GPIOX_PORT0)
 		// low byte swap
-		_DOUT &= 0xFF00 | (value & 0x00FF);
+		_DOUT = (_DOUT & 0xFF00) | (value & 0x00FF);
 	else if ( port == GPIOX_PORT1 )
 		// hight byte swap
-		_DOUT &= 0x00FF | (value << 8 & 0xFF00);
+		_DOUT = (_DOUT & 0x00FF) | (value << 8 & 0xFF00);
 	else
 		_DOUT = value;
 
@@ -157,13 +158,18 @@ uint16_t PCF8575::read(port_t port) {
 	/* Read GPIOX */
 	readGPIOX();
 
+	/* Inputs from the shadow, outputs as last written */
+	uint16_t value = _DIN | (_SENT & ~_DDR);
+	PORT0 = value & 0x00FF;
+	PORT1 = value >> 8;
+
 	/* Return current pins values */
 	if ( port == GPIOX_PORT0)
 		return PORT0;
 	else if ( port == GPIOX_PORT1)
 		return PORT1;
 	else
-		return _DOUT;
+		return value;
 }
 
 void PCF8575::clear(port_t port) {
@@ -191,9 +197,30 @@ void PCF8575::toggle(uint8_t pin) {
 }
 
 
-void PCF8575::readGPIOX() {
+void PCF8575::beginBatch() {
+
+	_batch_depth++;
+}
+
+void PCF8575::endBatch() {
+
+	if ( !_batch_depth || --_batch_depth )
+		return;
+
+	if ( _batch_length )
+		myI2C.writeBytes(_address, _batch_length, _batch);
+
+	_batch_length = 0;
+}
+
+
+void PCF8575::readGPIOX(bool force) {
+
+	if ( _DIN_VALID && !force )
+		return;
 
 	_DIN_LAST = _DIN;
+	_DIN_VALID = true;
 
 	uint8_t buffer[2];
 
@@ -215,6 +242,23 @@ void PCF8575::writeGPIOX() {
 
 	/* Compute new GPIO states */
 	uint16_t value = _DOUT | _DDR;
+	if ( value == _SENT )
+		return;
+
+	_SENT = value;
+
+	if ( _batch_depth )
+	{
+		if ( _batch_length == sizeof(_batch) )
+		{
+			myI2C.writeBytes(_address, _batch_length, _batch);
+			_batch_length = 0;
+		}
+
+		_batch[_batch_length++] = value & 0x00FF;
+		_batch[_batch_length++] = value >> 8;
+		return;
+	}
 
 	// Write two bytes
 	buffer[0] = value & 0x00FF;  // low byte
@@ -226,13 +270,11 @@ void PCF8575::writeGPIOX() {
 
 void PCF8575::updateGPIOX() {
 
-	uint8_t buffer[2];
+	// Inputs are pins written HIGH, outputs keep their state
+	writeGPIOX();
 
-	// Set input bit mask
-	buffer[0] = _DDR & 0x00FF;  // low byte
-	buffer[1] = _DDR >> 8;      // high byte
-	//Debug_printv("low[%.2X] high[%.2X]", buffer[0], buffer[1]);
-	myI2C.writeBytes(_address, 2, buffer);
+	// Pins that just became inputs were never read
+	invalidate();
 	//Debug_printv("address[%.2X] din[%.2X] dout[%.2X] ddr[%.2X]", _address, _DIN, _DOUT, _DDR);
 }
 
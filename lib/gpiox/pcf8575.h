@@ -10,6 +10,7 @@
 
 #include "../../include/pinmap.h"
 
+#include <esp_attr.h>
 #include <I2Cbus.hpp>
 
 #define I2C_SDA      PIN_GPIOX_SDA
@@ -17,6 +18,9 @@
 #define I2C_ADDRESS  GPIOX_ADDRESS
 #define I2C_SPEED    GPIOX_SPEED
 
+// Port states queued between beginBatch() and endBatch()
+#define GPIOX_BATCH_SIZE  16
+
 /* PCF8575 port bits */
 #define P00  0
 #define P01  1
@@ -131,6 +135,22 @@ public:
 	 */
 	void toggle(uint8_t pin);
 
+	/**
+	 * Queue pin and port writes instead of sending each one
+	 *
+	 * @remarks The chip latches every byte pair of a write transaction in turn,
+	 * so endBatch() sends all queued states, in order, as one I2C burst
+	 */
+	void beginBatch();
+	void endBatch();
+
+	/**
+	 * Mark the input shadow stale, the next read goes to the chip
+	 *
+	 * @remarks Called from the INT pin handler, the chip pulls INT when an input changes
+	 */
+	void IRAM_ATTR invalidate() { _DIN_VALID = false; }
+
 protected:
 
 	I2C_t& myI2C = i2c0;  // i2c0 and i2c1 are the default objects
@@ -145,6 +165,17 @@ protected:
 	/** Pins modes values (OUTPUT or INPUT) */
 	volatile uint16_t _DDR;
 
+	/** Inputs unchanged since the last read, see invalidate() */
+	volatile bool _DIN_VALID;
+
+	/** Last state written to the chip */
+	uint16_t _SENT;
+
+	/** Queued port states, two bytes each */
+	uint8_t _batch_depth;  // Batches nest, the outermost one sends
+	uint8_t _batch_length;
+	uint8_t _batch[GPIOX_BATCH_SIZE * 2];
+
 	/** GPIOX I2C address */
 	uint8_t _address;
 
@@ -152,8 +183,9 @@ protected:
 	 * Read GPIO states and store them in _DIN variable
 	 *
 	 * @remarks Before reading current GPIO states, current _DIN variable value is moved to _DIN_LAST variable
+	 * @remarks Nothing is read while the shadow is valid unless forced
 	 */
-	void readGPIOX();
+	void readGPIOX(bool force = false);
 
 	/** 
 	 * Write value of _DOUT variable to the GPIOX
@@ -1,31 +1,53 @@
 
 #ifdef GPIOX_XRA1405
 
-#include "pcf8575.h"
+#include "xra1405.h"
 
 #include <hal/gpio_types.h>
+#include <freertos/FreeRTOS.h>
 
 #include "../../include/debug.h"
 
 XRA1405 GPIOX;
 
 XRA1405::XRA1405() :
-		_DIN(0), _DIN_LAST(0), _DOUT(0), _DDR(0), _address(0)
+		_DIN(0), _DIN_LAST(0), _DOUT(0), _DDR(0), _DIN_VALID(false), _SENT(0x0000),
+		_batch_depth(0)
 {
 }
 
-void XRA1405::begin(gpio_num_t sda, gpio_num_t scl, uint8_t address, uint16_t speed) {
-
-	/* Store the I2C address and init the Wire library */
-	_address = address;
-    myI2C.begin(sda, scl, (speed * 1000)); // 400Khz Default
-    //myI2C.begin(GPIO_NUM_21, GPIO_NUM_22, 800000); // 800Khz Overclocked
-    //myI2C.begin(GPIO_NUM_21, GPIO_NUM_22, 1000000); // 1Mhz Overclocked
-    //myI2C.setTimeout(10);
-    //myI2C.scanner();
-	myI2C.reset();
-
-	readGPIOX();
+void XRA1405::begin(gpio_num_t cs, uint16_t speed) {
+
+	spi_bus_config_t bus_cfg = {
+		.mosi_io_num = PIN_SD_HOST_MOSI,
+		.miso_io_num = PIN_SD_HOST_MISO,
+		.sclk_io_num = PIN_SD_HOST_SCK,
+		.quadwp_io_num = -1,
+		.quadhd_io_num = -1,
+		.max_transfer_sz = 4000,
+	};
+
+	// Already up when the SD card was mounted first
+	esp_err_t e = spi_bus_initialize(SPI_HOST_GPIOX, &bus_cfg, SPI_DMA_CH_AUTO);
+	if ( e != ESP_OK && e != ESP_ERR_INVALID_STATE )
+		Debug_printv("spi_bus_initialize error[%d]", e);
+
+	spi_device_interface_config_t dev_cfg = {};
+	dev_cfg.mode = 0;
+	dev_cfg.clock_speed_hz = speed * 1000;
+	dev_cfg.spics_io_num = cs;
+	dev_cfg.queue_size = 1;
+
+	e = spi_bus_add_device(SPI_HOST_GPIOX, &dev_cfg, &_spi);
+	if ( e != ESP_OK )
+		Debug_printv("spi_bus_add_device error[%d]", e);
+
+	// Start from a known output state
+	writeRegister(XRA1405_OCR1, _DOUT & 0x00FF);
+	writeRegister(XRA1405_OCR1 + 1, _DOUT >> 8);
+	_SENT = _DOUT;
+
+	readGPIOX(true);
 }
 
 void XRA1405::pinMode(uint8_t pin, pin_mode_t mode) {
@@ -135,10 +157,10 @@ void XRA1405::write(port_t port, uint16_t value) {
 	/* Store pins values and apply */
 	if ( port == GPIOX_PORT0)
 		// low byte swap
-		_DOUT &= 0xFF00 | (value & 0x00FF);
+		_DOUT = (_DOUT & 0xFF00) | (value & 0x00FF);
 	else if ( port == GPIOX_PORT1 )
 		// hight byte swap
-		_DOUT &= 0x00FF | (value << 8 & 0xFF00);
+		_DOUT = (_DOUT & 0x00FF) | (value << 8 & 0xFF00);
 	else
 		_DOUT = value;
 
@@ -157,13 +179,18 @@ uint16_t XRA1405::read(port_t port) {
 	/* Read GPIOX */
 	readGPIOX();
 
+	/* Inputs from the shadow, outputs as last written */
+	uint16_t value = _DIN | (_SENT & ~_DDR);
+	PORT0 = value & 0x00FF;
+	PORT1 = value >> 8;
+
 	/* Return current pins values */
 	if ( port == GPIOX_PORT0)
 		return PORT0;
 	else if ( port == GPIOX_PORT1)
 		return PORT1;
 	else
-		return _DOUT;
+		return value;
 }
 
 void XRA1405::clear(port_t port) {
@@ -191,49 +218,87 @@ void XRA1405::toggle(uint8_t pin) {
 }
 
 
-void XRA1405::readGPIOX() {
+void XRA1405::beginBatch() {
 
-	_DIN_LAST = _DIN;
+	if ( !_batch_depth++ )
+		spi_device_acquire_bus(_spi, portMAX_DELAY);
+}
 
-	uint8_t buffer[2];
+void XRA1405::endBatch() {
 
-	// Read two bytes
-	myI2C.readBytes(_address, 2, buffer);
-	_DIN = buffer[0];										// low byte
-	_DIN = (_DIN & 0x00FF) | ( (buffer[1] << 8) & 0xFF00);  // high byte
-	_DIN &= _DDR;
+	if ( _batch_depth && !--_batch_depth )
+		spi_device_release_bus(_spi);
+}
+
+
+uint8_t XRA1405::readRegister(uint8_t reg) {
+
+	spi_transaction_t t = {};
+	t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+	t.length = 16;
+	t.tx_data[0] = 0x80 | (reg << 1);  // Read command
+	spi_device_polling_transmit(_spi, &t);
+
+	return t.rx_data[1];
+}
+
+void XRA1405::writeRegister(uint8_t reg, uint8_t value) {
+
+	spi_transaction_t t = {};
+	t.flags = SPI_TRANS_USE_TXDATA;
+	t.length = 16;
+	t.tx_data[0] = reg << 1;           // Write command
+	t.tx_data[1] = value;
+	spi_device_polling_transmit(_spi, &t);
+}
+
+
+void XRA1405::readGPIOX(bool force) {
 
-	this->PORT0 = buffer[0];
-	this->PORT1 = buffer[1];
-	//Debug_printv("address[%.2X] port0[%.2X] port1[%.2X] din[%.2X] din_last[%.2X] ddr[%.2X]", _address, PORT0, PORT1, _DIN, _DIN_LAST, _DDR);
+	if ( _DIN_VALID && !force )
+		return;
+
+	_DIN_LAST = _DIN;
+	_DIN_VALID = true;
+
+	// Reading the state registers also clears INT
+	this->PORT0 = readRegister(XRA1405_GSR1);
+	this->PORT1 = readRegister(XRA1405_GSR1 + 1);
+	_DIN = (PORT1 << 8) | PORT0;
+	_DIN &= _DDR;
+	//Debug_printv("port0[%.2X] port1[%.2X] din[%.2X] din_last[%.2X] ddr[%.2X]", PORT0, PORT1, _DIN, _DIN_LAST, _DDR);
 }
 
 
 void XRA1405::writeGPIOX() {
 
-	uint8_t buffer[2];
+	// Input pins ignore the output register, only outputs are compared
+	uint16_t value = _DOUT;
+	uint16_t changed = value ^ _SENT;
 
-	/* Compute new GPIO states */
-	uint16_t value = _DOUT | _DDR;
+	if ( changed & 0x00FF )
+		writeRegister(XRA1405_OCR1, value & 0x00FF);
+	if ( changed & 0xFF00 )
+		writeRegister(XRA1405_OCR1 + 1, value >> 8);
 
-	// Write two bytes
-	buffer[0] = value & 0x00FF;  // low byte
-	buffer[1] = value >> 8;      // high byte
-	//Debug_printv("low[%.2X] high[%.2X]", buffer[0], buffer[1]);
-	myI2C.writeBytes(_address, 2, buffer);
-	//Debug_printv("address[%.2X] din[%.2X] dout[%.2X] ddr[%.2X] value[%.2X]", _address, _DIN, _DOUT, _DDR, value);
+	_SENT = value;
+	//Debug_printv("din[%.2X] dout[%.2X] ddr[%.2X] value[%.2X]", _DIN, _DOUT, _DDR, value);
 }
 
 void XRA1405::updateGPIOX() {
 
-	uint8_t buffer[2];
+	// Outputs take their state before they are driven
+	writeGPIOX();
+
+	// 1 = input, interrupts follow the inputs
+	writeRegister(XRA1405_GCR1, _DDR & 0x00FF);
+	writeRegister(XRA1405_GCR1 + 1, _DDR >> 8);
+	writeRegister(XRA1405_IER1, _DDR & 0x00FF);
+	writeRegister(XRA1405_IER1 + 1, _DDR >> 8);
 
-	// Set input bit mask
-	buffer[0] = _DDR & 0x00FF;  // low byte
-	buffer[1] = _DDR >> 8;      // high byte
-	//Debug_printv("low[%.2X] high[%.2X]", buffer[0], buffer[1]);
-	myI2C.writeBytes(_address, 2, buffer);
-	//Debug_printv("address[%.2X] din[%.2X] dout[%.2X] ddr[%.2X]", _address, _DIN, _DOUT, _DDR);
+	// Pins that just became inputs were never read
+	invalidate();
+	//Debug_printv("din[%.2X] dout[%.2X] ddr[%.2X]", _DIN, _DOUT, _DDR);
 }
 
 #endif // GPIOX_XRA1405
\ No newline at end of file
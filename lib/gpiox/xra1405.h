@@ -9,12 +9,22 @@
 
 #include "../../include/pinmap.h"
 
-#include <I2Cbus.hpp>
+#include <esp_attr.h>
+#include <driver/spi_master.h>
 
-#define I2C_SDA      PIN_GPIOX_SDA
-#define I2C_SCL      PIN_GPIOX_SCL
-#define I2C_ADDRESS  GPIOX_ADDRESS
-#define I2C_SPEED    GPIOX_SPEED
+// The expander sits on the SD card SPI bus with its own chip select
+#ifndef PIN_GPIOX_CS
+#error "XRA1405 needs PIN_GPIOX_CS in the pinmap"
+#endif
+
+#define SPI_HOST_GPIOX  SPI2_HOST
+#define SPI_SPEED       26000  // 26Mhz max
+
+/* XRA1405 registers, one per 8 bit port */
+#define XRA1405_GSR1  0x00  // GPIO State
+#define XRA1405_OCR1  0x02  // Output Control
+#define XRA1405_GCR1  0x06  // GPIO Configuration (1 = input)
+#define XRA1405_IER1  0x0A  // Input Interrupt Enable
 
 /* XRA1405 port bits */
 #define P00  0
@@ -61,9 +71,9 @@ public:
 	uint8_t PORT1; // PINS 10-17
 
 	/**
-	 * Start the I2C controller and store the XRA1405 chip address
+	 * Join the SPI bus, started here if nothing else did yet
 	 */
-	void begin(gpio_num_t sda = I2C_SDA, gpio_num_t scl = I2C_SCL, uint8_t address = I2C_ADDRESS, uint16_t speed = I2C_SPEED);
+	void begin(gpio_num_t cs = PIN_GPIOX_CS, uint16_t speed = SPI_SPEED);
 
 	/**
 	 * Set the direction of a pin (OUTPUT, INPUT)
@@ -87,7 +97,6 @@ public:
 	 * 
 	 * @param pin The pin to set
 	 * @param value The new state of the pin
-	 * @remarks Software pull-up resistors are not available on the XRA1405
 	 */
 	void digitalWrite(uint8_t pin, uint8_t value);
 
@@ -130,9 +139,25 @@ public:
 	 */
 	void toggle(uint8_t pin);
 
+	/**
+	 * Hold the SPI bus for a run of pin and port writes
+	 *
+	 * @remarks Every write is still its own register transfer, the bus is
+	 * only arbitrated once for all of them
+	 */
+	void beginBatch();
+	void endBatch();
+
+	/**
+	 * Mark the input shadow stale, the next read goes to the chip
+	 *
+	 * @remarks Called from the INT pin handler, the chip pulls INT when an input changes
+	 */
+	void IRAM_ATTR invalidate() { _DIN_VALID = false; }
+
 protected:
 
-	I2C_t& myI2C = i2c0;  // i2c0 and i2c1 are the default objects
+	spi_device_handle_t _spi;
 
 	/** Current input pins values */
 	volatile uint16_t _DIN;
@@ -144,21 +169,30 @@ protected:
 	/** Pins modes values (OUTPUT or INPUT) */
 	volatile uint16_t _DDR;
 
-	/** GPIOX I2C address */
-	uint8_t _address;
+	/** Inputs unchanged since the last read, see invalidate() */
+	volatile bool _DIN_VALID;
+
+	/** Last output state written to the chip */
+	uint16_t _SENT;
+
+	uint8_t _batch_depth;  // Batches nest, the outermost one holds the bus
+
+	/** Register access */
+	uint8_t readRegister(uint8_t reg);
+	void writeRegister(uint8_t reg, uint8_t value);
 
 	/** 
 	 * Read GPIO states and store them in _DIN variable
 	 *
 	 * @remarks Before reading current GPIO states, current _DIN variable value is moved to _DIN_LAST variable
+	 * @remarks Nothing is read while the shadow is valid unless forced
 	 */
-	void readGPIOX();
+	void readGPIOX(bool force = false);
 
 	/** 
 	 * Write value of _DOUT variable to the GPIOX
 	 * 
-	 * @remarks Only pin marked as OUTPUT are set, for INPUT pins their value are unchanged
-	 * @warning To work properly (and avoid any states conflicts) readGPIO() MUST be called before call this function !
+	 * @remarks Only the ports that changed are written
 	 */
 	void writeGPIOX();
 
@@ -0,0 +1,318 @@
+#include "lnx.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/********************************************************
+ * Streams
+ ********************************************************/
+
+// The whole directory is parsed once, after that every member is just
+// an offset and a length in the container
+bool LNXIStream::readDirectory()
+{
+    uint8_t buf[LNX_BLOCK_SIZE];
+
+    containerStream->seek(0);
+    uint32_t length = containerStream->read(buf, LNX_BLOCK_SIZE);
+    std::string dir((char *)buf, length);
+    size_t pos = 0;
+
+    // Skip the BASIC stub by following its line links
+    if ( length > 2 && buf[0] == 0x01 && buf[1] == 0x08 )
+    {
+        pos = 2;
+        while ( true )
+        {
+            if ( pos + 2 > length )
+                return false;
+
+            uint16_t link = UINT16_FROM_HILOBYTES(buf[pos + 1], buf[pos]);
+            if ( link == 0 )
+            {
+                pos += 2;
+                break;
+            }
+
+            size_t next = link - 0x0801 + 2;
+            if ( link < 0x0801 || next <= pos )
+                return false;
+
+            pos = next;
+        }
+    }
+
+    if ( pos < dir.size() && dir[pos] == '\r' )
+        pos++;
+
+    auto field = [&dir, &pos]() {
+        size_t end = dir.find('\r', pos);
+        if ( end == std::string::npos )
+            end = dir.size();
+
+        std::string f = dir.substr(pos, end - pos);
+        pos = std::min(end + 1, dir.size());
+        return f;
+    };
+
+    // " 1  *LYNX XVII  BY WILL CORLEY"
+    signature = field();
+    int dir_blocks = atoi(signature.c_str());
+    if ( dir_blocks <= 0 )
+        return false;
+
+    mstr::trim(signature);
+    signature = mstr::drop(signature, signature.find_first_not_of("0123456789"));
+    mstr::trim(signature);
+
+    // Now we know how long the directory is, read the rest of it. The
+    // count is text from the file, a bad one can't make us allocate more
+    // than the file has
+    uint32_t container_size = containerStream->size();
+    if ( (uint32_t)dir_blocks > container_size / LNX_BLOCK_SIZE )
+    {
+        Debug_printv("dir_blocks[%d] larger than the file[%d]", dir_blocks, container_size);
+        return false;
+    }
+    uint32_t dir_size = dir_blocks * LNX_BLOCK_SIZE;
+    if ( dir_size > length )
+    {
+        dir.resize(dir_size);
+        length += containerStream->read((uint8_t *)&dir[length], dir_size - length);
+        dir.resize(length);
+    }
+
+    uint16_t count = atoi(field().c_str());
+    uint32_t offset = dir_size;
+
+    entries.reserve(count);
+    for ( uint16_t i = 0; i < count && pos < dir.size(); i++ )
+    {
+        Entry e;
+        memset(e.filename, 0xA0, sizeof(e.filename));
+
+        std::string name = field();
+        memcpy(e.filename, name.data(), std::min(name.size(), sizeof(e.filename)));
+
+        e.blocks = atoi(field().c_str());
+
+        e.rel_record_length = 0;
+        std::string type = field();
+        mstr::trim(type);
+        switch ( type.empty() ? 'P' : type[0] )
+        {
+            case 'D': e.file_type = 0x80; break;
+            case 'S': e.file_type = 0x81; break;
+            case 'U': e.file_type = 0x83; break;
+            case 'R':
+                // REL files store their record length here, side sectors are not interpreted
+                e.file_type = 0x84;
+                e.rel_record_length = atoi(field().c_str());
+                break;
+            default:  e.file_type = 0x82; break;
+        }
+
+        // Bytes used in the last block, counted like a sector link (+1)
+        uint16_t last = atoi(field().c_str());
+
+        e.data_offset = offset;
+        e.size = e.blocks ? ((e.blocks - 1) * LNX_BLOCK_SIZE) + (last ? last - 1 : LNX_BLOCK_SIZE) : 0;
+
+        // The last file of an archive is often cut short
+        if ( e.data_offset >= container_size )
+            e.size = 0;
+        else if ( e.data_offset + e.size > container_size )
+            e.size = container_size - e.data_offset;
+
+        entries.push_back(e);
+        offset += e.blocks * LNX_BLOCK_SIZE;
+    }
+
+    Debug_printv("signature[%s] dir_blocks[%d] entries[%d]", signature.c_str(), dir_blocks, entries.size());
+    return true;
+}
+
+int LNXIStream::findEntry( std::string filename )
+{
+    mstr::rtrimA0(filename);
+    mstr::replaceAll(filename, "\\", "/");
+
+    if ( filename.empty() )
+        return -1;
+
+    for ( size_t i = 0; i < entries.size(); i++ )
+    {
+        std::string entryFilename = std::string(entries[i].filename, sizeof(entries[i].filename));
+        mstr::rtrimA0(entryFilename);
+        mstr::toASCII(entryFilename);
+
+        if ( filename == "*" || mstr::compare(filename, entryFilename) )
+            return i;
+    }
+
+    return -1;
+}
+
+bool LNXIStream::seekEntry( std::string filename )
+{
+    int index = findEntry(filename);
+    if ( index < 0 )
+    {
+        entry.filename[0] = '\0';
+        return false;
+    }
+
+    return seekEntry( (size_t)index + 1 );
+}
+
+bool LNXIStream::seekEntry( size_t index )
+{
+    if ( index < 1 || index > entries.size() )
+        return false;
+
+    entry = entries[index - 1];
+    entry_index = index;
+
+    return true;
+}
+
+bool LNXIStream::seekPath(std::string path) {
+    // Implement this to skip a queue of file streams to start of file by name
+    // this will cause the next read to return bytes of 'path'
+    seekCalled = true;
+
+    entry_index = 0;
+
+    if ( seekEntry(path) )
+    {
+        std::string type = decodeType(entry.file_type);
+        Debug_printv("filename[%.16s] type[%s] data_offset[%d] size[%d]", entry.filename, type.c_str(), entry.data_offset, entry.size);
+
+        m_length = entry.size;
+        m_bytesAvailable = m_length;
+        m_position = 0;
+
+        return containerStream->seek(entry.data_offset);
+    }
+    else
+    {
+        Debug_printv( "Not found! [%s]", path.c_str());
+    }
+
+    return false;
+};
+
+bool LNXIStream::seek(uint32_t pos)
+{
+    if ( !seekCalled )
+        return CBMImageStream::seek(pos);
+
+    if ( pos > m_length )
+        return false;
+
+    m_position = pos;
+    m_bytesAvailable = m_length - pos;
+
+    return containerStream->seek(entry.data_offset + pos);
+}
+
+size_t LNXIStream::readFile(uint8_t* buf, size_t size) {
+    size_t bytesRead = 0;
+
+    // Files are contiguous, no block links to follow. The container may
+    // have been read elsewhere since, so it is seeked every time
+    size = std::min(size, (size_t)m_bytesAvailable);
+    if ( size && containerStream->seek(entry.data_offset + m_position) )
+        bytesRead = containerStream->read(buf, size);
+
+    m_bytesAvailable -= bytesRead;
+
+    return bytesRead;
+}
+
+
+/********************************************************
+ * File implementations
+ ********************************************************/
+
+MStream* LNXFile::createIStream(std::shared_ptr<MStream> containerIstream) {
+    Debug_printv("[%s]", url.c_str());
+
+    return new LNXIStream(containerIstream);
+}
+
+bool LNXFile::isDirectory() {
+    //Debug_printv("pathInStream[%s]", pathInStream.c_str());
+    if ( pathInStream == "" )
+        return true;
+    else
+        return false;
+};
+
+bool LNXFile::rewindDirectory() {
+    dirIsOpen = true;
+    Debug_printv("streamFile->url[%s]", streamFile->url.c_str());
+    auto image = ImageBroker::obtain<LNXIStream>(streamFile->url);
+    if ( image == nullptr )
+    {
+        Debug_printv("image pointer is null");
+        return false;
+    }
+
+    image->resetEntryCounter();
+
+    // Set Media Info Fields
+    media_header = name;
+    mstr::toUpper(media_header);
+    media_id = " LNX ";
+    media_blocks_free = 0;
+    media_block_size = image->block_size;
+    media_image = name;
+    mstr::toASCII(media_image);
+
+    return true;
+}
+
+MFile* LNXFile::getNextFileInDir() {
+
+    if(!dirIsOpen)
+        rewindDirectory();
+
+    // Get entry pointed to by containerStream
+    auto image = ImageBroker::obtain<LNXIStream>(streamFile->url);
+
+    if ( image->seekNextImageEntry() )
+    {
+        std::string fileName = mstr::format("%.16s", image->entry.filename);
+        mstr::replaceAll(fileName, "/", "\\");
+        mstr::rtrimA0(fileName);
+        //Debug_printv( "entry[%s]", (streamFile->url + "/" + fileName).c_str() );
+        auto file = MFSOwner::File(streamFile->url + "/" + fileName);
+        file->extension = image->decodeType(image->entry.file_type);
+        return file;
+    }
+    else
+    {
+        //Debug_printv( "END OF DIRECTORY");
+        dirIsOpen = false;
+        return nullptr;
+    }
+}
+
+bool LNXFile::exists() {
+    if ( pathInStream == "" )
+        return true;
+
+    auto image = ImageBroker::obtain<LNXIStream>(streamFile->url);
+    return image->findEntry(pathInStream) >= 0;
+}
+
+uint32_t LNXFile::size() {
+    // Debug_printv("[%s]", streamFile->url.c_str());
+    auto image = ImageBroker::obtain<LNXIStream>(streamFile->url);
+    int index = image->findEntry(pathInStream);
+    if ( index < 0 )
+        return 0;
+
+    return image->entries[index].size;
+}
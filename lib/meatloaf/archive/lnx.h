@@ -0,0 +1,135 @@
+// .LNX - Lynx archive format
+// https://ist.uwaterloo.ca/~schepers/formats/LYNX.TXT
+// https://vice-emu.sourceforge.io/vice_17.html#SEC394
+//
+// A BASIC stub, a text directory and then every file stored back to back
+// in 254 byte blocks (the data part of a disk sector), so each file's
+// offset and size are known as soon as the directory is read.
+//
+
+
+#ifndef MEATLOAF_ARCHIVE_LNX
+#define MEATLOAF_ARCHIVE_LNX
+
+#include "meat_io.h"
+#include "cbm_media.h"
+
+#include <vector>
+
+#define LNX_BLOCK_SIZE 254
+
+
+/********************************************************
+ * Streams
+ ********************************************************/
+
+class LNXIStream : public CBMImageStream {
+    // override everything that requires overriding here
+
+public:
+    LNXIStream(std::shared_ptr<MStream> is) : CBMImageStream(is)
+    {
+        if ( !readDirectory() )
+            Debug_printv("Not a valid Lynx archive");
+    };
+
+    bool seek(uint32_t pos) override;
+
+protected:
+    struct Entry {
+        char filename[16];
+        uint8_t file_type;
+        uint8_t rel_record_length;
+        uint16_t blocks;
+        uint32_t data_offset;
+        uint32_t size;
+    };
+
+    void seekHeader() override {};
+    bool seekNextImageEntry() override {
+        return seekEntry(entry_index + 1);
+    }
+
+    bool seekEntry( std::string filename ) override;
+    bool seekEntry( size_t index ) override;
+
+    size_t readFile(uint8_t* buf, size_t size) override;
+    bool seekPath(std::string path) override;
+
+    int findEntry( std::string filename );
+
+    std::string signature;
+    std::vector<Entry> entries;
+    Entry entry;
+
+private:
+    bool readDirectory();
+
+    friend class LNXFile;
+};
+
+
+/********************************************************
+ * File implementations
+ ********************************************************/
+
+class LNXFile: public MFile {
+public:
+
+    LNXFile(std::string path, bool is_dir = true): MFile(path) {
+        isDir = is_dir;
+
+        media_image = name;
+        mstr::toASCII(media_image);
+    };
+
+    ~LNXFile() {
+        // don't close the stream here! It will be used by shared ptr D64Util to keep reading image params
+    }
+
+    MStream* createIStream(std::shared_ptr<MStream> containerIstream) override;
+
+    std::string petsciiName() override {
+        // It's already in PETSCII
+        mstr::replaceAll(name, "\\", "/");
+        return name;
+    }
+
+    bool isDirectory() override;
+    bool rewindDirectory() override;
+    MFile* getNextFileInDir() override;
+    bool mkDir() override { return false; };
+
+    bool exists() override;
+    bool remove() override { return false; };
+    bool rename(std::string dest) { return false; };
+    time_t getLastWrite() override { return 0; };
+    time_t getCreationTime() override { return 0; };
+    uint32_t size() override;
+
+    bool isDir = true;
+    bool dirIsOpen = false;
+};
+
+
+
+/********************************************************
+ * FS
+ ********************************************************/
+
+class LNXFileSystem: public MFileSystem
+{
+public:
+    MFile* getFile(std::string path) override {
+        return new LNXFile(path);
+    }
+
+    bool handles(std::string fileName) {
+        return byExtension(".lnx", fileName);
+    }
+
+    LNXFileSystem(): MFileSystem("lnx") {};
+};
+
+
+#endif /* MEATLOAF_ARCHIVE_LNX */
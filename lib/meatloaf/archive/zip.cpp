@@ -0,0 +1,584 @@
+#include "zip.h"
+
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#include <esp_heap_caps.h>
+
+#define ZIP_LOCAL_HEADER_SIGNATURE   0x04034b50
+#define ZIP_CENTRAL_HEADER_SIGNATURE 0x02014b50
+#define ZIP_END_SIGNATURE            0x06054b50
+
+#define ZIP_LOCAL_HEADER_SIZE        30
+#define ZIP_CENTRAL_HEADER_SIZE      46
+#define ZIP_END_SIZE                 22
+
+#define ZIP_STATE_SIZE (sizeof(tinfl_decompressor) + TINFL_LZ_DICT_SIZE)
+
+static inline uint16_t zip_le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t zip_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+/********************************************************
+ * Streams
+ ********************************************************/
+
+ZipIStream::ZipIStream(std::shared_ptr<MStream> is) : CBMImageStream(is)
+{
+    memset(&entry, 0, sizeof(entry));
+
+    if ( !readCentralDirectory() )
+        Debug_printv("Couldn't read ZIP central directory");
+}
+
+ZipIStream::~ZipIStream()
+{
+    freeCheckpoints();
+    free(inflater.state);
+}
+
+// The central directory is read once into a compact index, the archive
+// is never scanned member by member
+bool ZipIStream::readCentralDirectory()
+{
+    uint32_t size = containerStream->size();
+    if ( size < ZIP_END_SIZE )
+        return false;
+
+    // End of central directory record is the last thing in the file,
+    // followed only by a comment of up to 64K
+    uint32_t limit = size - std::min(size, (uint32_t)(ZIP_END_SIZE + 0xFFFF));
+    uint32_t end = size;
+    uint32_t eocd = 0;
+    bool found = false;
+
+    while ( !found )
+    {
+        uint32_t start = (end - limit > ZIP_READ_BUFFER_SIZE) ? end - ZIP_READ_BUFFER_SIZE : limit;
+
+        containerStream->seek(start);
+        uint32_t length = containerStream->read(in_buffer, end - start);
+        for ( int i = (int)length - 4; i >= 0; i-- )
+        {
+            if ( zip_le32(&in_buffer[i]) == ZIP_END_SIGNATURE && start + i + ZIP_END_SIZE <= size )
+            {
+                eocd = start + i;
+                found = true;
+                break;
+            }
+        }
+
+        if ( start == limit )
+            break;
+
+        // Overlap chunks so a signature split between them is still found
+        end = start + 3;
+    }
+
+    if ( !found )
+        return false;
+
+    uint8_t record[ZIP_CENTRAL_HEADER_SIZE];
+
+    containerStream->seek(eocd);
+    containerStream->read(record, ZIP_END_SIZE);
+    uint16_t count = zip_le16(&record[10]);
+    uint32_t offset = zip_le32(&record[16]);
+
+    if ( offset == 0xFFFFFFFF )
+    {
+        Debug_printv("ZIP64 archives are not supported");
+        return false;
+    }
+
+    entries.reserve(count);
+    for ( uint16_t i = 0; i < count; i++ )
+    {
+        containerStream->seek(offset);
+        if ( containerStream->read(record, ZIP_CENTRAL_HEADER_SIZE) != ZIP_CENTRAL_HEADER_SIZE ||
+             zip_le32(record) != ZIP_CENTRAL_HEADER_SIGNATURE )
+        {
+            Debug_printv("Bad central directory entry [%d]", i);
+            break;
+        }
+
+        Entry e;
+        e.method = zip_le16(&record[10]);
+        e.mod_time = zip_le16(&record[12]);
+        e.mod_date = zip_le16(&record[14]);
+        e.compressed_size = zip_le32(&record[20]);
+        e.size = zip_le32(&record[24]);
+        e.name_length = zip_le16(&record[28]);
+        e.header_offset = zip_le32(&record[42]);
+        e.name_offset = names.size();
+
+        // Encrypted members can't be read
+        if ( zip_le16(&record[8]) & 0x0001 )
+            e.method = 0xFFFF;
+
+        std::string name(e.name_length, '\0');
+        containerStream->read((uint8_t *)&name[0], e.name_length);
+        names += name;
+        entries.push_back(e);
+
+        offset += ZIP_CENTRAL_HEADER_SIZE + e.name_length + zip_le16(&record[30]) + zip_le16(&record[32]);
+    }
+
+    Debug_printv("entries[%d] names[%d]", entries.size(), names.size());
+    return true;
+}
+
+std::string ZipIStream::entryName( size_t index )
+{
+    return names.substr(entries[index].name_offset, entries[index].name_length);
+}
+
+int ZipIStream::findEntry( std::string filename )
+{
+    mstr::replaceAll(filename, "\\", "/");
+
+    for ( size_t i = 0; i < entries.size(); i++ )
+    {
+        std::string name = entryName(i);
+        if ( mstr::equals(filename, name, false) )
+            return i;
+    }
+
+    for ( size_t i = 0; i < entries.size(); i++ )
+    {
+        std::string name = entryName(i);
+        if ( mstr::compare(filename, name, false) )
+            return i;
+    }
+
+    return -1;
+}
+
+bool ZipIStream::seekEntry( std::string filename )
+{
+    int index = findEntry(filename);
+    if ( index < 0 )
+        return false;
+
+    return seekEntry( (size_t)index + 1 );
+}
+
+bool ZipIStream::seekEntry( size_t index )
+{
+    if ( index < 1 || index > entries.size() )
+        return false;
+
+    entry = entries[index - 1];
+    entry_index = index;
+
+    return true;
+}
+
+bool ZipIStream::seekPath(std::string path) {
+    // Implement this to skip a queue of file streams to start of file by name
+    // this will cause the next read to return bytes of 'path'
+    seekCalled = true;
+
+    entry_index = 0;
+
+    if ( seekEntry(path) )
+    {
+        Debug_printv("filename[%s] method[%d] compressed_size[%d] size[%d]", path.c_str(), entry.method, entry.compressed_size, entry.size);
+        return startMember();
+    }
+    else
+    {
+        Debug_printv( "Not found! [%s]", path.c_str());
+    }
+
+    return false;
+};
+
+bool ZipIStream::startMember()
+{
+    uint8_t header[ZIP_LOCAL_HEADER_SIZE];
+
+    containerStream->seek(entry.header_offset);
+    if ( containerStream->read(header, ZIP_LOCAL_HEADER_SIZE) != ZIP_LOCAL_HEADER_SIZE ||
+         zip_le32(header) != ZIP_LOCAL_HEADER_SIGNATURE )
+    {
+        Debug_printv("Bad local header");
+        return false;
+    }
+
+    // The local extra field can differ from the central one
+    data_offset = entry.header_offset + ZIP_LOCAL_HEADER_SIZE + zip_le16(&header[26]) + zip_le16(&header[28]);
+
+    m_length = entry.size;
+    m_bytesAvailable = m_length;
+    m_position = 0;
+
+    freeCheckpoints();
+
+    if ( entry.method == ZIP_METHOD_DEFLATED )
+    {
+        resetInflater();
+        return inflater.state != nullptr;
+    }
+
+    if ( entry.method != ZIP_METHOD_STORED )
+    {
+        Debug_printv("Unsupported compression method[%d]", entry.method);
+        return false;
+    }
+
+    return true;
+}
+
+bool ZipIStream::seek(uint32_t pos)
+{
+    // No member selected, seek in the raw archive
+    if ( !seekCalled )
+        return CBMImageStream::seek(pos);
+
+    if ( pos > m_length )
+        return false;
+
+    if ( entry.method == ZIP_METHOD_DEFLATED )
+    {
+        // Deflate can only go forward, so going back means restarting
+        // from the nearest checkpoint (or the start) and skipping ahead
+        if ( pos < inflater.out_position && !restoreCheckpoint(pos) )
+            resetInflater();
+
+        if ( inflater.state == nullptr )
+            return false;
+
+        if ( pos > inflater.out_position )
+            inflate(nullptr, pos - inflater.out_position);
+
+        if ( inflater.out_position != pos )
+            return false;
+    }
+
+    m_position = pos;
+    m_bytesAvailable = m_length - pos;
+
+    return true;
+}
+
+size_t ZipIStream::readFile(uint8_t* buf, size_t size)
+{
+    size_t bytesRead = 0;
+
+    size = std::min(size, (size_t)m_bytesAvailable);
+    if ( !size )
+        return 0;
+
+    if ( entry.method == ZIP_METHOD_STORED )
+    {
+        containerStream->seek(data_offset + m_position);
+        bytesRead = containerStream->read(buf, size);
+    }
+    else if ( inflater.state != nullptr )
+    {
+        bytesRead = inflate(buf, size);
+    }
+
+    m_bytesAvailable -= bytesRead;
+
+    return bytesRead;
+}
+
+
+/********************************************************
+ * Inflate
+ ********************************************************/
+
+uint8_t *ZipIStream::allocateState(bool psram_only)
+{
+    uint8_t *state = (uint8_t *)heap_caps_malloc(ZIP_STATE_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if ( state == nullptr && !psram_only )
+        state = (uint8_t *)malloc(ZIP_STATE_SIZE);
+
+    return state;
+}
+
+void ZipIStream::resetInflater()
+{
+    if ( inflater.state == nullptr )
+        inflater.state = allocateState(false);
+
+    if ( inflater.state == nullptr )
+    {
+        Debug_printv("Not enough memory to inflate");
+        return;
+    }
+
+    tinfl_init(inflater.decomp());
+    inflater.dict_offset = 0;
+    inflater.pending_offset = 0;
+    inflater.pending_length = 0;
+    inflater.in_consumed = 0;
+    inflater.out_position = 0;
+    inflater.status = TINFL_STATUS_NEEDS_MORE_INPUT;
+
+    in_offset = 0;
+    in_length = 0;
+}
+
+// Inflate the next size bytes of the member into buf (or drop them if buf is null)
+size_t ZipIStream::inflate(uint8_t* buf, size_t size)
+{
+    size_t total = 0;
+
+    while ( total < size )
+    {
+        // Hand out what is already inflated first
+        if ( inflater.pending_length )
+        {
+            size_t count = std::min(size - total, inflater.pending_length);
+            if ( buf != nullptr )
+                memcpy(buf + total, inflater.dict() + inflater.pending_offset, count);
+
+            inflater.pending_offset += count;
+            inflater.pending_length -= count;
+            inflater.out_position += count;
+            total += count;
+
+            if ( inflater.out_position >= next_checkpoint )
+            {
+                saveCheckpoint();
+                next_checkpoint += ZIP_CHECKPOINT_INTERVAL;
+            }
+            continue;
+        }
+
+        if ( inflater.status == TINFL_STATUS_DONE || inflater.status < 0 )
+            break;
+
+        uint32_t in_read = inflater.in_consumed + (in_length - in_offset);
+        if ( in_offset == in_length && in_read < entry.compressed_size )
+        {
+            containerStream->seek(data_offset + in_read);
+            in_length = containerStream->read(in_buffer, std::min((uint32_t)ZIP_READ_BUFFER_SIZE, entry.compressed_size - in_read));
+            in_offset = 0;
+            in_read += in_length;
+        }
+
+        size_t in_bytes = in_length - in_offset;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - inflater.dict_offset;
+        uint32_t flags = (in_read < entry.compressed_size) ? TINFL_FLAG_HAS_MORE_INPUT : 0;
+
+        inflater.status = tinfl_decompress(inflater.decomp(), in_buffer + in_offset, &in_bytes,
+                                           inflater.dict(), inflater.dict() + inflater.dict_offset, &out_bytes, flags);
+
+        in_offset += in_bytes;
+        inflater.in_consumed += in_bytes;
+        inflater.pending_offset = inflater.dict_offset;
+        inflater.pending_length = out_bytes;
+        inflater.dict_offset = (inflater.dict_offset + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if ( inflater.status == TINFL_STATUS_NEEDS_MORE_INPUT && !in_bytes && !out_bytes && in_read >= entry.compressed_size )
+            inflater.status = TINFL_STATUS_FAILED;
+
+        if ( inflater.status < 0 )
+            Debug_printv("inflate failed status[%d] in[%d] out[%d]", inflater.status, inflater.in_consumed, inflater.out_position);
+    }
+
+    return total;
+}
+
+// Snapshots only go to PSRAM, without it seeking back restarts from the beginning
+void ZipIStream::saveCheckpoint()
+{
+    if ( checkpoints.size() >= ZIP_MAX_CHECKPOINTS )
+        return;
+
+    uint8_t *state = allocateState(true);
+    if ( state == nullptr )
+        return;
+
+    memcpy(state, inflater.state, ZIP_STATE_SIZE);
+    checkpoints.push_back(inflater);
+    checkpoints.back().state = state;
+}
+
+bool ZipIStream::restoreCheckpoint(uint32_t pos)
+{
+    for ( auto cp = checkpoints.rbegin(); cp != checkpoints.rend(); ++cp )
+    {
+        if ( cp->out_position > pos )
+            continue;
+
+        uint8_t *state = inflater.state;
+        memcpy(state, cp->state, ZIP_STATE_SIZE);
+        inflater = *cp;
+        inflater.state = state;
+
+        in_offset = 0;
+        in_length = 0;
+        return true;
+    }
+
+    return false;
+}
+
+void ZipIStream::freeCheckpoints()
+{
+    for ( auto &cp : checkpoints )
+        free(cp.state);
+
+    checkpoints.clear();
+    next_checkpoint = ZIP_CHECKPOINT_INTERVAL;
+}
+
+
+/********************************************************
+ * File implementations
+ ********************************************************/
+
+MStream* ZipFile::meatStream()
+{
+    // Inside another container (games.zip/disk1.d64) nobody set up our
+    // stream file, so resolve the archive itself and pick the member from it
+    if ( streamFile == nullptr )
+    {
+        std::vector<std::string> parts = mstr::split(url, '/');
+        auto archive = parts.end();
+        for ( auto part = parts.begin(); part != parts.end(); ++part )
+        {
+            if ( MFileSystem::byExtension(".zip", *part) )
+                archive = part;
+        }
+
+        if ( archive == parts.end() )
+            return nullptr;
+
+        auto begin = parts.begin();
+        auto end = parts.end();
+        auto member = archive + 1;
+        MFile* zip = MFSOwner::File(mstr::joinToString(&begin, &member, "/"));
+        if ( zip == nullptr )
+            return nullptr;
+
+        streamFile = zip->streamFile;
+        zip->streamFile = nullptr;
+        delete zip;
+
+        pathInStream = mstr::joinToString(&member, &end, "/");
+    }
+
+    return MFile::meatStream();
+}
+
+MStream* ZipFile::createIStream(std::shared_ptr<MStream> containerIstream) {
+    Debug_printv("[%s]", url.c_str());
+
+    return new ZipIStream(containerIstream);
+}
+
+bool ZipFile::isDirectory() {
+    //Debug_printv("pathInStream[%s]", pathInStream.c_str());
+    if ( pathInStream == "" )
+        return true;
+    else
+        return false;
+};
+
+bool ZipFile::rewindDirectory() {
+    dirIsOpen = true;
+    Debug_printv("streamFile->url[%s]", streamFile->url.c_str());
+    auto image = ImageBroker::obtain<ZipIStream>(streamFile->url);
+    if ( image == nullptr )
+    {
+        Debug_printv("image pointer is null");
+        return false;
+    }
+
+    image->resetEntryCounter();
+
+    // Set Media Info Fields
+    media_header = name;
+    mstr::toUpper(media_header);
+    media_id = " ZIP ";
+    media_blocks_free = 0;
+    media_block_size = image->block_size;
+    media_image = name;
+
+    return true;
+}
+
+MFile* ZipFile::getNextFileInDir() {
+
+    if(!dirIsOpen)
+        rewindDirectory();
+
+    // Get entry pointed to by containerStream
+    auto image = ImageBroker::obtain<ZipIStream>(streamFile->url);
+
+    while ( image->seekNextImageEntry() )
+    {
+        std::string fileName = image->entryName(image->entry_index - 1);
+
+        // Folders only show up as part of their members' names
+        if ( mstr::endsWith(fileName, "/") )
+            continue;
+
+        mstr::replaceAll(fileName, "/", "\\");
+        return MFSOwner::File(streamFile->url + "/" + fileName);
+    }
+
+    //Debug_printv( "END OF DIRECTORY");
+    dirIsOpen = false;
+    return nullptr;
+}
+
+bool ZipFile::exists() {
+    if ( pathInStream == "" )
+        return true;
+
+    if ( streamFile == nullptr )
+        return false;
+
+    auto image = ImageBroker::obtain<ZipIStream>(streamFile->url);
+    return image->findEntry(pathInStream) >= 0;
+}
+
+uint32_t ZipFile::size() {
+    if ( streamFile == nullptr || pathInStream == "" )
+        return 0;
+
+    auto image = ImageBroker::obtain<ZipIStream>(streamFile->url);
+    int index = image->findEntry(pathInStream);
+    if ( index < 0 )
+        return 0;
+
+    return image->entries[index].size;
+}
+
+time_t ZipFile::getLastWrite() {
+    if ( streamFile == nullptr || pathInStream == "" )
+        return 0;
+
+    auto image = ImageBroker::obtain<ZipIStream>(streamFile->url);
+    int index = image->findEntry(pathInStream);
+    if ( index < 0 )
+        return 0;
+
+    // MS-DOS date and time
+    auto &e = image->entries[index];
+    struct tm tm = { 0 };
+    tm.tm_year = (e.mod_date >> 9) + 80;
+    tm.tm_mon = ((e.mod_date >> 5) & 0x0F) - 1;
+    tm.tm_mday = e.mod_date & 0x1F;
+    tm.tm_hour = e.mod_time >> 11;
+    tm.tm_min = (e.mod_time >> 5) & 0x3F;
+    tm.tm_sec = (e.mod_time & 0x1F) * 2;
+    tm.tm_isdst = -1;
+
+    return mktime(&tm);
+}
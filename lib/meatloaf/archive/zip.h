@@ -0,0 +1,171 @@
+// .ZIP - PKWARE ZIP archive
+// https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+// https://en.wikipedia.org/wiki/ZIP_(file_format)
+//
+// Members can be stored or deflated. Deflated members are inflated on the
+// fly, so a D64 inside a ZIP (games.zip/disk1.d64/FILE) never has to be
+// unpacked anywhere.
+//
+
+
+#ifndef MEATLOAF_ARCHIVE_ZIP
+#define MEATLOAF_ARCHIVE_ZIP
+
+#include "meat_io.h"
+#include "cbm_media.h"
+
+#include <vector>
+
+#include "rom/miniz.h"
+
+#define ZIP_READ_BUFFER_SIZE    512     // Compressed bytes read from the container at a time
+#define ZIP_CHECKPOINT_INTERVAL 32768   // Inflated bytes between seek checkpoints
+#define ZIP_MAX_CHECKPOINTS     6       // Inflater snapshots kept per member (PSRAM only)
+
+#define ZIP_METHOD_STORED       0
+#define ZIP_METHOD_DEFLATED     8
+
+
+/********************************************************
+ * Streams
+ ********************************************************/
+
+class ZipIStream : public CBMImageStream {
+    // override everything that requires overriding here
+
+public:
+    ZipIStream(std::shared_ptr<MStream> is);
+    ~ZipIStream();
+
+    bool seek(uint32_t pos) override;
+
+protected:
+    // Central directory entry, names are kept together in one string
+    struct Entry {
+        uint32_t name_offset;
+        uint16_t name_length;
+        uint16_t method;
+        uint32_t compressed_size;
+        uint32_t size;
+        uint32_t header_offset;
+        uint16_t mod_time;
+        uint16_t mod_date;
+    };
+
+    // Everything needed to carry on inflating from a given point.
+    // The decompressor and its dictionary (which is also the output
+    // buffer) share one allocation, preferably in PSRAM.
+    struct Inflater {
+        uint8_t *state = nullptr;
+        size_t dict_offset = 0;     // Where the next inflated bytes go
+        size_t pending_offset = 0;  // Inflated bytes not handed out yet
+        size_t pending_length = 0;
+        uint32_t in_consumed = 0;   // Compressed bytes used so far
+        uint32_t out_position = 0;  // Inflated bytes handed out so far
+        int status = TINFL_STATUS_NEEDS_MORE_INPUT;
+
+        tinfl_decompressor *decomp() { return (tinfl_decompressor *)state; };
+        uint8_t *dict() { return state + sizeof(tinfl_decompressor); };
+    };
+
+    void seekHeader() override {};
+    bool seekNextImageEntry() override {
+        return seekEntry( entry_index + 1 );
+    }
+
+    bool seekEntry( std::string filename ) override;
+    bool seekEntry( size_t index ) override;
+
+    size_t readFile(uint8_t* buf, size_t size) override;
+    bool seekPath(std::string path) override;
+
+    std::string entryName( size_t index );
+    int findEntry( std::string filename );
+
+    std::vector<Entry> entries;
+    std::string names;
+    Entry entry;
+
+private:
+    bool readCentralDirectory();
+
+    bool startMember();
+    void resetInflater();
+    size_t inflate(uint8_t* buf, size_t size);
+    static uint8_t *allocateState(bool psram_only);
+    void saveCheckpoint();
+    bool restoreCheckpoint(uint32_t pos);
+    void freeCheckpoints();
+
+    uint32_t data_offset = 0;   // Start of the current member's data
+
+    Inflater inflater;
+    std::vector<Inflater> checkpoints;
+    uint32_t next_checkpoint = ZIP_CHECKPOINT_INTERVAL;
+
+    uint8_t in_buffer[ZIP_READ_BUFFER_SIZE];
+    size_t in_offset = 0;
+    size_t in_length = 0;
+
+    friend class ZipFile;
+};
+
+
+/********************************************************
+ * File implementations
+ ********************************************************/
+
+class ZipFile: public MFile {
+public:
+
+    ZipFile(std::string path, bool is_dir = true): MFile(path) {
+        isDir = is_dir;
+
+        media_image = name;
+    };
+
+    ~ZipFile() {
+        // don't close the stream here! It will be used by shared ptr D64Util to keep reading image params
+    }
+
+    MStream* meatStream() override;
+    MStream* createIStream(std::shared_ptr<MStream> containerIstream) override;
+
+    bool isDirectory() override;
+    bool rewindDirectory() override;
+    MFile* getNextFileInDir() override;
+    bool mkDir() override { return false; };
+
+    bool exists() override;
+    bool remove() override { return false; };
+    bool rename(std::string dest) { return false; };
+    time_t getLastWrite() override;
+    time_t getCreationTime() override { return getLastWrite(); };
+    uint32_t size() override;
+
+    bool isDir = true;
+    bool dirIsOpen = false;
+};
+
+
+
+/********************************************************
+ * FS
+ ********************************************************/
+
+class ZipFileSystem: public MFileSystem
+{
+public:
+    MFile* getFile(std::string path) override {
+        return new ZipFile(path);
+    }
+
+    bool handles(std::string fileName) {
+        return byExtension(".zip", fileName);
+    }
+
+    ZipFileSystem(): MFileSystem("zip") {};
+};
+
+
+#endif /* MEATLOAF_ARCHIVE_ZIP */
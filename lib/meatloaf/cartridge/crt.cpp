@@ -0,0 +1,384 @@
+#include "crt.h"
+
+#include <string.h>
+#include <algorithm>
+
+static inline uint16_t crt_be16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static inline uint32_t crt_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+
+/********************************************************
+ * Streams
+ ********************************************************/
+
+// Walk the CHIP packet headers once, nothing is read from the image
+// again to find a bank after this
+bool CRTIStream::readIndex()
+{
+    containerStream->seek(0);
+    if ( containerStream->read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+         strncmp(header.signature, CRT_SIGNATURE, sizeof(header.signature)) != 0 )
+        return false;
+
+    uint32_t size = containerStream->size();
+    uint32_t offset = crt_be32(header.header_length);
+    uint8_t chip[CRT_CHIP_HEADER];
+
+    while ( offset + CRT_CHIP_HEADER <= size )
+    {
+        containerStream->seek(offset);
+        if ( containerStream->read(chip, CRT_CHIP_HEADER) != CRT_CHIP_HEADER || strncmp((char *)chip, "CHIP", 4) != 0 )
+            break;
+
+        uint32_t length = crt_be32(&chip[4]);
+        if ( length < CRT_CHIP_HEADER )
+            break;
+
+        Chip c;
+        c.type = crt_be16(&chip[8]);
+        c.bank = crt_be16(&chip[10]);
+        c.load_address = crt_be16(&chip[12]);
+        c.size = crt_be16(&chip[14]);
+        c.data_offset = offset + CRT_CHIP_HEADER;
+        chips.push_back(c);
+
+        offset += length;
+    }
+
+    // Sorted by bank and address so lookups can bisect
+    std::stable_sort(chips.begin(), chips.end(), [](const Chip &a, const Chip &b) {
+        return (a.bank < b.bank) || (a.bank == b.bank && a.load_address < b.load_address);
+    });
+
+    if ( crt_be16(header.hardware_type) == CRT_TYPE_EASYFLASH )
+        readEasyFS();
+
+    // Anything else (or an EasyFlash without a file system) lists its CHIP packets
+    if ( entries.empty() )
+    {
+        for ( size_t i = 0; i < chips.size(); i++ )
+        {
+            Entry e;
+            memset(e.filename, 0xA0, sizeof(e.filename));
+            std::string name = mstr::format("bank %02d %04x", chips[i].bank, chips[i].load_address);
+            mstr::toPETSCII(name);
+            memcpy(e.filename, name.data(), std::min(name.size(), sizeof(e.filename)));
+            e.file_type = 0x83; // USR
+            e.easyfs = false;
+            e.chip = i;
+            e.bank = 0;
+            e.offset = 0;
+            e.size = chips[i].size;
+            entries.push_back(e);
+        }
+    }
+
+    Debug_printv("name[%.32s] hardware_type[%d] chips[%d] entries[%d]", header.name, crt_be16(header.hardware_type), chips.size(), entries.size());
+    return true;
+}
+
+void CRTIStream::readEasyFS()
+{
+    EasyFSEntry e;
+    uint32_t address = (EASYFS_DIRECTORY_BANK * EASYFS_BANK_SIZE) + EASYFS_DIRECTORY_OFFSET;
+
+    for ( size_t i = 0; i < EASYFS_MAX_ENTRIES; i++, address += sizeof(e) )
+    {
+        if ( readLinear(address, (uint8_t *)&e, sizeof(e)) != sizeof(e) )
+            break;
+
+        uint8_t type = e.flags & EASYFS_TYPE_MASK;
+        if ( type == EASYFS_TYPE_END )
+            break;
+
+        // Carts without EasyFS have code here, it is listed by CHIP
+        bool known = (type == EASYFS_TYPE_PRG || type == EASYFS_TYPE_CRT_8K ||
+                      type == EASYFS_TYPE_CRT_16K || type == EASYFS_TYPE_CRT_ULTIMAX);
+        if ( !known || e.bank >= EASYFS_BANKS || e.bank_high ||
+             (e.offset[0] | (e.offset[1] << 8)) >= EASYFS_BANK_SIZE )
+        {
+            Debug_printv("no EasyFS directory, entry[%d] flags[%02X] bank[%d]", (int)i, e.flags, e.bank);
+            entries.clear();
+            return;
+        }
+
+        if ( e.flags & EASYFS_FLAG_HIDDEN )
+            continue;
+
+        Entry f;
+        memset(f.filename, 0xA0, sizeof(f.filename));
+        for ( size_t j = 0; j < sizeof(e.name) && e.name[j]; j++ )
+            f.filename[j] = e.name[j];
+
+        // PRGs can be LOADed, the cartridge images inside are offered as USR
+        f.file_type = (type == EASYFS_TYPE_PRG) ? 0x82 : 0x83;
+        f.easyfs = true;
+        f.chip = 0;
+        f.bank = e.bank;
+        f.offset = e.offset[0] | (e.offset[1] << 8);
+        f.size = e.size[0] | (e.size[1] << 8) | (e.size[2] << 16);
+        entries.push_back(f);
+    }
+}
+
+const CRTIStream::Chip* CRTIStream::findChip( uint16_t bank, bool romh )
+{
+    // ROMH is at $A000, or at $E000 for Ultimax carts (EasyFlash boot bank)
+    uint16_t load_address = romh ? 0xA000 : 0x8000;
+    auto it = std::lower_bound(chips.begin(), chips.end(), load_address, [bank](const Chip &c, uint16_t address) {
+        return (c.bank < bank) || (c.bank == bank && c.load_address < address);
+    });
+
+    if ( it != chips.end() && it->bank == bank && (it->load_address == load_address || (romh && it->load_address == 0xE000)) )
+        return &(*it);
+
+    // 16K packets hold ROML and ROMH together
+    if ( romh && it != chips.begin() )
+    {
+        auto prev = it - 1;
+        if ( prev->bank == bank && prev->load_address == 0x8000 && prev->size > 0x2000 )
+            return &(*prev);
+    }
+
+    return nullptr;
+}
+
+// Read EasyFlash address space, bank after bank (ROML then ROMH).
+// Banks missing from the image read as erased flash.
+size_t CRTIStream::readLinear( uint32_t address, uint8_t* buf, size_t size )
+{
+    size_t bytesRead = 0;
+
+    while ( bytesRead < size )
+    {
+        uint16_t bank = address / EASYFS_BANK_SIZE;
+        uint16_t offset = address % EASYFS_BANK_SIZE;
+        bool romh = offset >= 0x2000;
+        size_t count = std::min(size - bytesRead, (size_t)(0x2000 - (offset & 0x1FFF)));
+
+        const Chip *c = findChip(bank, romh);
+        if ( c == nullptr && bank >= EASYFS_BANKS )
+            break; // Past the end of the largest EasyFlash
+
+        size_t n = 0;
+        if ( c != nullptr )
+        {
+            // A 16K packet has ROMH right after ROML
+            uint16_t chip_offset = (c->load_address == 0x8000) ? offset : (offset & 0x1FFF);
+            if ( chip_offset < c->size )
+            {
+                n = std::min(count, (size_t)(c->size - chip_offset));
+                containerStream->seek(c->data_offset + chip_offset);
+                if ( containerStream->read(buf + bytesRead, n) != n )
+                    break;
+            }
+        }
+
+        if ( n < count )
+            memset(buf + bytesRead + n, 0xFF, count - n);
+
+        bytesRead += count;
+        address += count;
+    }
+
+    return bytesRead;
+}
+
+int CRTIStream::findEntry( std::string filename )
+{
+    mstr::rtrimA0(filename);
+    mstr::replaceAll(filename, "\\", "/");
+
+    if ( filename.empty() )
+        return -1;
+
+    for ( size_t i = 0; i < entries.size(); i++ )
+    {
+        std::string entryFilename = std::string(entries[i].filename, sizeof(entries[i].filename));
+        mstr::rtrimA0(entryFilename);
+        mstr::toASCII(entryFilename);
+
+        if ( mstr::compare(filename, entryFilename) )
+            return i;
+    }
+
+    return -1;
+}
+
+bool CRTIStream::seekEntry( std::string filename )
+{
+    int index = findEntry(filename);
+    if ( index < 0 )
+    {
+        entry.filename[0] = '\0';
+        return false;
+    }
+
+    return seekEntry( (size_t)index + 1 );
+}
+
+bool CRTIStream::seekEntry( size_t index )
+{
+    if ( index < 1 || index > entries.size() )
+        return false;
+
+    entry = entries[index - 1];
+    entry_index = index;
+
+    return true;
+}
+
+bool CRTIStream::seekPath(std::string path) {
+    // Implement this to skip a queue of file streams to start of file by name
+    // this will cause the next read to return bytes of 'path'
+    seekCalled = true;
+
+    entry_index = 0;
+
+    if ( seekEntry(path) )
+    {
+        Debug_printv("filename[%.16s] easyfs[%d] bank[%d] offset[%d] size[%d]", entry.filename, entry.easyfs, entry.bank, entry.offset, entry.size);
+
+        m_length = entry.size;
+        m_bytesAvailable = m_length;
+        m_position = 0;
+
+        return true;
+    }
+    else
+    {
+        Debug_printv( "Not found! [%s]", path.c_str());
+    }
+
+    return false;
+};
+
+bool CRTIStream::seek(uint32_t pos)
+{
+    if ( !seekCalled )
+        return CBMImageStream::seek(pos);
+
+    if ( pos > m_length )
+        return false;
+
+    m_position = pos;
+    m_bytesAvailable = m_length - pos;
+
+    return true;
+}
+
+size_t CRTIStream::readFile(uint8_t* buf, size_t size) {
+    size_t bytesRead = 0;
+
+    size = std::min(size, (size_t)m_bytesAvailable);
+    if ( !size )
+        return 0;
+
+    if ( entry.easyfs )
+    {
+        bytesRead = readLinear((entry.bank * EASYFS_BANK_SIZE) + entry.offset + m_position, buf, size);
+    }
+    else
+    {
+        containerStream->seek(chips[entry.chip].data_offset + m_position);
+        bytesRead = containerStream->read(buf, size);
+    }
+
+    m_bytesAvailable -= bytesRead;
+
+    return bytesRead;
+}
+
+
+/********************************************************
+ * File implementations
+ ********************************************************/
+
+MStream* CRTFile::createIStream(std::shared_ptr<MStream> containerIstream) {
+    Debug_printv("[%s]", url.c_str());
+
+    return new CRTIStream(containerIstream);
+}
+
+bool CRTFile::isDirectory() {
+    //Debug_printv("pathInStream[%s]", pathInStream.c_str());
+    if ( pathInStream == "" )
+        return true;
+    else
+        return false;
+};
+
+bool CRTFile::rewindDirectory() {
+    dirIsOpen = true;
+    Debug_printv("streamFile->url[%s]", streamFile->url.c_str());
+    auto image = ImageBroker::obtain<CRTIStream>(streamFile->url);
+    if ( image == nullptr )
+    {
+        Debug_printv("image pointer is null");
+        return false;
+    }
+
+    image->resetEntryCounter();
+
+    // Set Media Info Fields
+    media_header = mstr::format("%.16s", image->header.name);
+    mstr::toPETSCII(media_header);
+    media_id = " CRT ";
+    media_blocks_free = 0;
+    media_block_size = image->block_size;
+    media_image = name;
+    mstr::toASCII(media_image);
+
+    return true;
+}
+
+MFile* CRTFile::getNextFileInDir() {
+
+    if(!dirIsOpen)
+        rewindDirectory();
+
+    // Get entry pointed to by containerStream
+    auto image = ImageBroker::obtain<CRTIStream>(streamFile->url);
+
+    if ( image->seekNextImageEntry() )
+    {
+        std::string fileName = mstr::format("%.16s", image->entry.filename);
+        mstr::replaceAll(fileName, "/", "\\");
+        mstr::rtrimA0(fileName);
+        //Debug_printv( "entry[%s]", (streamFile->url + "/" + fileName).c_str() );
+        auto file = MFSOwner::File(streamFile->url + "/" + fileName);
+        file->extension = image->decodeType(image->entry.file_type);
+        return file;
+    }
+    else
+    {
+        //Debug_printv( "END OF DIRECTORY");
+        dirIsOpen = false;
+        return nullptr;
+    }
+}
+
+bool CRTFile::exists() {
+    if ( pathInStream == "" )
+        return true;
+
+    auto image = ImageBroker::obtain<CRTIStream>(streamFile->url);
+    return image->findEntry(pathInStream) >= 0;
+}
+
+uint32_t CRTFile::size() {
+    // Debug_printv("[%s]", streamFile->url.c_str());
+    auto image = ImageBroker::obtain<CRTIStream>(streamFile->url);
+    int index = image->findEntry(pathInStream);
+    if ( index < 0 )
+        return 0;
+
+    return image->entries[index].size;
+}
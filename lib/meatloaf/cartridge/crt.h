@@ -2,3 +2,161 @@
 // https://vice-emu.sourceforge.io/vice_17.html#SEC369
 // https://ist.uwaterloo.ca/~schepers/formats/CRT.TXT
 //
+
+
+#ifndef MEATLOAF_MEDIA_CRT
+#define MEATLOAF_MEDIA_CRT
+
+#include "meat_io.h"
+#include "cbm_media.h"
+
+#include <vector>
+
+#include "crt/easyfs.h"
+
+#define CRT_SIGNATURE       "C64 CARTRIDGE   "
+#define CRT_CHIP_HEADER     16
+#define CRT_TYPE_EASYFLASH  32
+
+
+/********************************************************
+ * Streams
+ ********************************************************/
+
+class CRTIStream : public CBMImageStream {
+    // override everything that requires overriding here
+
+public:
+    CRTIStream(std::shared_ptr<MStream> is) : CBMImageStream(is)
+    {
+        if ( !readIndex() )
+            Debug_printv("Not a valid CRT image");
+    };
+
+    bool seek(uint32_t pos) override;
+
+protected:
+    struct Header {
+        char signature[16];
+        uint8_t header_length[4];   // Big endian
+        uint8_t version[2];
+        uint8_t hardware_type[2];
+        uint8_t exrom;
+        uint8_t game;
+        uint8_t reserved[6];
+        char name[32];
+    };
+
+    // One CHIP packet, the data itself stays in the image
+    struct Chip {
+        uint16_t type;
+        uint16_t bank;
+        uint16_t load_address;
+        uint16_t size;
+        uint32_t data_offset;
+    };
+
+    // A file is either an EasyFS file (linear across banks) or a whole CHIP packet
+    struct Entry {
+        char filename[16];
+        uint8_t file_type;
+        bool easyfs;
+        uint16_t chip;      // CHIP packet index when !easyfs
+        uint8_t bank;       // EasyFS start bank
+        uint16_t offset;    // EasyFS offset in bank
+        uint32_t size;
+    };
+
+    void seekHeader() override {};
+    bool seekNextImageEntry() override {
+        return seekEntry(entry_index + 1);
+    }
+
+    bool seekEntry( std::string filename ) override;
+    bool seekEntry( size_t index ) override;
+
+    size_t readFile(uint8_t* buf, size_t size) override;
+    bool seekPath(std::string path) override;
+
+    int findEntry( std::string filename );
+
+    Header header;
+    std::vector<Chip> chips;
+    std::vector<Entry> entries;
+    Entry entry;
+
+private:
+    bool readIndex();
+    void readEasyFS();
+
+    const Chip* findChip( uint16_t bank, bool romh );
+    size_t readLinear( uint32_t address, uint8_t* buf, size_t size );
+
+    friend class CRTFile;
+};
+
+
+/********************************************************
+ * File implementations
+ ********************************************************/
+
+class CRTFile: public MFile {
+public:
+
+    CRTFile(std::string path, bool is_dir = true): MFile(path) {
+        isDir = is_dir;
+
+        media_image = name;
+        mstr::toASCII(media_image);
+    };
+
+    ~CRTFile() {
+        // don't close the stream here! It will be used by shared ptr D64Util to keep reading image params
+    }
+
+    MStream* createIStream(std::shared_ptr<MStream> containerIstream) override;
+
+    std::string petsciiName() override {
+        // It's already in PETSCII
+        mstr::replaceAll(name, "\\", "/");
+        return name;
+    }
+
+    bool isDirectory() override;
+    bool rewindDirectory() override;
+    MFile* getNextFileInDir() override;
+    bool mkDir() override { return false; };
+
+    bool exists() override;
+    bool remove() override { return false; };
+    bool rename(std::string dest) { return false; };
+    time_t getLastWrite() override { return 0; };
+    time_t getCreationTime() override { return 0; };
+    uint32_t size() override;
+
+    bool isDir = true;
+    bool dirIsOpen = false;
+};
+
+
+
+/********************************************************
+ * FS
+ ********************************************************/
+
+class CRTFileSystem: public MFileSystem
+{
+public:
+    MFile* getFile(std::string path) override {
+        return new CRTFile(path);
+    }
+
+    bool handles(std::string fileName) {
+        return byExtension(".crt", fileName);
+    }
+
+    CRTFileSystem(): MFileSystem("crt") {};
+};
+
+
+#endif /* MEATLOAF_MEDIA_CRT */
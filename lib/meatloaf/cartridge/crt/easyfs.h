@@ -2,3 +2,38 @@
 // https://skoe.de/easyflash/develdocs/
 // https://bitbucket.org/skoe/easyflash/src/master/
 //
+// ROML of bank 0 holds the boot code. The directory is the 6K at the
+// start of ROMH in bank 0 (00:1:0000), right before EAPI at 00:1:1800.
+// An EasyFlash bank is 16K, ROML then ROMH, and files simply continue
+// into the next bank when they cross the end.
+//
+
+#ifndef MEATLOAF_CARTRIDGE_EASYFS
+#define MEATLOAF_CARTRIDGE_EASYFS
+
+#include <stdint.h>
+
+#define EASYFS_DIRECTORY_BANK    0
+#define EASYFS_DIRECTORY_OFFSET  0x2000  // ROMH
+#define EASYFS_MAX_ENTRIES       255
+#define EASYFS_BANK_SIZE         0x4000
+#define EASYFS_BANKS             64
+
+#define EASYFS_TYPE_MASK         0x1F
+#define EASYFS_TYPE_PRG          0x01
+#define EASYFS_TYPE_CRT_8K       0x10
+#define EASYFS_TYPE_CRT_16K      0x11
+#define EASYFS_TYPE_CRT_ULTIMAX  0x13
+#define EASYFS_TYPE_END          0x1F
+#define EASYFS_FLAG_HIDDEN       0x80
+
+struct EasyFSEntry {
+    char name[16];      // 0x00 padded
+    uint8_t flags;      // Type and hidden flag
+    uint8_t bank;
+    uint8_t bank_high;  // Reserved, always 0
+    uint8_t offset[2];  // Offset in the 16K bank, little endian
+    uint8_t size[3];    // Little endian
+};
+
+#endif // MEATLOAF_CARTRIDGE_EASYFS
@@ -1,5 +1,7 @@
 #include "cbm_media.h"
 
+#include <algorithm>
+
 // Utility Functions
 
 std::string CBMImageStream::decodeType(uint8_t file_type, bool show_hidden)
@@ -46,10 +48,11 @@ bool CBMImageStream::open() {
 };
 
 void CBMImageStream::close() {
-
+    // Writes reach the image when the channel is closed
+    containerStream->flush();
 };
 
-uint16_t CBMImageStream::seekFileSize( uint8_t start_track, uint8_t start_sector )
+uint32_t CBMImageStream::seekFileSize( uint8_t start_track, uint8_t start_sector )
 {
     // Calculate file size
     seekSector(start_track, start_sector);
@@ -98,7 +101,9 @@ uint32_t CBMImageStream::read(uint8_t* buf, uint32_t size) {
     if(seekCalled) {
         // if we have the stream set to a specific file already, either via seekNextEntry or seekPath, return bytes of the file here
         // or set the stream to EOF-like state, if whle file is completely read.
-        bytesRead = readFile(buf, size);
+        size = std::min(size, m_bytesAvailable);
+        if ( size )
+            bytesRead = readFile(buf, size);
 
     }
     else {
@@ -3,6 +3,7 @@
 #define MEATLOAF_CBM_MEDIA
 
 #include "meat_io.h"
+#include "meat_cache.h"
 
 #include <map>
 #include <bitset>
@@ -21,7 +22,8 @@ class CBMImageStream: public MStream {
 
 public:
     CBMImageStream(std::shared_ptr<MStream> is) {
-        containerStream = is;
+        // Directory and BAM blocks are read again and again
+        containerStream = std::make_shared<MBlockCache>(is);
         m_isOpen = true;
         has_subdirs = false;
     }
@@ -29,6 +31,7 @@ public:
     // MStream methods
     bool open() override;
     void close() override;
+    bool flush() override { return containerStream->flush(); };
     uint32_t position() override;
     size_t error() override;
 
@@ -80,7 +83,7 @@ public:
     bool seekPath(std::string path) override { return false; };
     std::string seekNextEntry() override { return ""; };
 
-    virtual uint16_t seekFileSize( uint8_t start_track, uint8_t start_sector );
+    virtual uint32_t seekFileSize( uint8_t start_track, uint8_t start_sector );
 
     uint32_t available() override;
     uint32_t size() override;
@@ -155,6 +158,8 @@ private:
     // MEDIA ARCHIVE
     friend class D8BFile;
     friend class DFIFile;
+    friend class ZipFile;
+    friend class LNXFile;
 
     // CASSETTE TAPE
     friend class T64File;
@@ -1,6 +1,7 @@
 #include "flash.h"
 
 #include "../../../include/debug.h"
+#include "fnFS.h"
 
 #include <sys/stat.h>
 #include <unistd.h>
@@ -65,13 +66,25 @@ MStream* FlashFile::createIStream(std::shared_ptr<MStream> is) {
 MStream* FlashFile::meatStream()
 {
     std::string full_path = basepath + path;
-    MStream* istream = new FlashIStream(full_path);
+
+    // Only REL files and disk images are updated in place, by record or
+    // by sector. Everything else is opened read only
+    std::string mode = MFileSystem::byExtension({ ".r00", ".d64", ".d71", ".d80", ".d81", ".d82", ".d8b", ".d90", ".dnp" }, path) ? "r+" : "r";
+    MStream* istream = new FlashIStream(full_path, mode);
     //Debug_printv("FlashFile::meatStream() 3, not null=%d", istream != nullptr);
     istream->open();   
     //Debug_printv("FlashFile::meatStream() 4");
     return istream;
 }
 
+MStream* FlashFile::createStream()
+{
+    std::string full_path = basepath + path;
+    MStream* ostream = new FlashIStream(full_path, "w");
+    ostream->open();
+    return ostream;
+}
+
 time_t FlashFile::getLastWrite()
 {
     struct stat info;
@@ -96,6 +109,7 @@ bool FlashFile::mkDir()
         return false;
     }
     int rc = mkdir(std::string(basepath + path).c_str(), ALLPERMS);
+    FileSystem::changed();
     return (rc==0);
 }
 
@@ -136,6 +150,7 @@ bool FlashFile::remove() {
         return false;
 
     int rc = ::remove( std::string(basepath + path).c_str() );
+    FileSystem::changed();
     if (rc != 0) {
         Debug_printv("remove: rc=%d path=`%s`\r\n", rc, path);
         return false;
@@ -150,6 +165,7 @@ bool FlashFile::rename(std::string pathTo) {
         return false;
 
     int rc = ::rename( std::string(basepath + path).c_str(), std::string(basepath + pathTo).c_str() );
+    FileSystem::changed();
     if (rc != 0) {
         return false;
     }
@@ -308,6 +324,7 @@ uint32_t FlashIStream::write(const uint8_t *buf, uint32_t size) {
     if (result < 0) {
         Debug_printv("write rc=%d\r\n", result);
     }
+    FileSystem::changed();
     return result;
 };
 
@@ -324,7 +341,11 @@ bool FlashIStream::open() {
     //Debug_printv("IStream: trying to open flash fs, calling isOpen");
 
     //Debug_printv("IStream: wasn't open, calling obtain");
-    handle->obtain(localPath, "r");
+    // Files opened for update are read only if the file system
+    // doesn't allow writing
+    handle->obtain(localPath, mode);
+    if(!isOpen() && mode == "r+")
+        handle->obtain(localPath, "r");
 
     if(isOpen()) {
         //Debug_printv("IStream: past obtain");
@@ -420,6 +441,10 @@ void FlashHandle::dispose() {
 
         fclose( file_h );
         file_h = nullptr;
+
+        // What was written has only now reached the file
+        if (writing)
+            FileSystem::changed();
         // rc = -255;
     }
 }
@@ -450,6 +475,9 @@ void FlashHandle::obtain(std::string m_path, std::string mode) {
 
     //Debug_printv("m_path[%s] mode[%s]", m_path.c_str(), mode.c_str());
     file_h = fopen( m_path.c_str(), mode.c_str());
+    writing = (mode[0] != 'r' || mode.find('+') != std::string::npos);
+    if (writing)
+        FileSystem::changed();
     // rc = 1;
 
     //Serial.printf("FSTEST: lfs_file_open file rc:%d\r\n",rc);
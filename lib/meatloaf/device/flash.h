@@ -62,6 +62,7 @@ public:
     //MFile* cd(std::string newDir);
     bool isDirectory() override;
     MStream* meatStream() override ; // has to return OPENED stream
+    MStream* createStream() override ;
     time_t getLastWrite() override ;
     time_t getCreationTime() override ;
     bool rewindDirectory() override ;
@@ -111,6 +112,7 @@ public:
 
 private:
     int flags;
+    bool writing = false;
 };
 
 
@@ -120,8 +122,9 @@ private:
 
 class FlashIStream: public MStream {
 public:
-    FlashIStream(std::string& path) {
+    FlashIStream(std::string& path, std::string mode = "r") {
         localPath = path;
+        this->mode = mode;
         handle = std::make_unique<FlashHandle>();
         url = path;
     }
@@ -159,6 +162,7 @@ public:
 
 protected:
     std::string localPath;
+    std::string mode;       // fopen() mode, "r+" falls back to "r"
 
     std::unique_ptr<FlashHandle> handle;
 
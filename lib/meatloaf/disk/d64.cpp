@@ -6,7 +6,7 @@
 
 bool D64IStream::seekBlock( uint64_t index, uint8_t offset )
 {
-	uint16_t sectorOffset = 0;
+	uint32_t sectorOffset = 0;
     uint8_t track = 0;
 
     // Debug_printv("track[%d] sector[%d] offset[%d]", track, sector, offset);
@@ -15,7 +15,7 @@ bool D64IStream::seekBlock( uint64_t index, uint8_t offset )
     do
 	{
         track++;
-		uint8_t count = sectorsPerTrack[speedZone(track)];
+		uint16_t count = sectorsPerTrack[speedZone(track)];
         if ( sectorOffset + count < index )
             sectorOffset += count;
         else
@@ -36,7 +36,7 @@ bool D64IStream::seekBlock( uint64_t index, uint8_t offset )
 
 bool D64IStream::seekSector( uint8_t track, uint8_t sector, uint8_t offset )
 {
-	uint16_t sectorOffset = 0;
+	uint32_t sectorOffset = 0;
 
     //Debug_printv("track[%d] sector[%d] offset[%d]", track, sector, offset);
 
@@ -52,7 +52,7 @@ bool D64IStream::seekSector( uint8_t track, uint8_t sector, uint8_t offset )
 
     // Is this a valid sector?
     c = sectorsPerTrack[speedZone(track)];
-    if ( sector > c )
+    if ( sector >= c )
     {
         Debug_printv("sector[%d] track[%d] sectorsPerTrack[%d]", sector, track, c);
         return false;
@@ -84,12 +84,20 @@ bool D64IStream::seekSector( std::vector<uint8_t> trackSectorOffset )
 
 std::string D64IStream::readBlock(uint8_t track, uint8_t sector)
 {
-    return "";
+    std::string data(block_size, 0x00);
+    if ( !seekSector( track, sector ) || containerStream->read((uint8_t *)&data[0], block_size) != block_size )
+        return "";
+
+    return data;
 }
 
 bool D64IStream::writeBlock(uint8_t track, uint8_t sector, std::string data)
 {
-    return true;
+    blocks_free = -1;
+    if ( !seekSector( track, sector ) )
+        return false;
+
+    return containerStream->write((const uint8_t *)data.data(), data.size()) == data.size();
 }
 
 bool D64IStream::allocateBlock( uint8_t track, uint8_t sector)
@@ -222,19 +230,19 @@ bool D64IStream::seekEntry( uint32_t index )
 
 uint16_t D64IStream::blocksFree()
 {
+    if ( blocks_free >= 0 )
+        return blocks_free;
+
     uint16_t free_count = 0;
 
     for(uint8_t x = 0; x < partitions[partition].block_allocation_map.size(); x++)
     {
-        uint8_t bam[partitions[partition].block_allocation_map[x].byte_count] = { 0 };
-        //Debug_printv("start_track[%d] end_track[%d]", block_allocation_map[x].start_track, block_allocation_map[x].end_track);
+        auto &map = partitions[partition].block_allocation_map[x];
+        uint8_t bam[map.byte_count] = { 0 };
+        //Debug_printv("start_track[%d] end_track[%d]", map.start_track, map.end_track);
 
-        seekSector(
-            partitions[partition].block_allocation_map[x].track, 
-            partitions[partition].block_allocation_map[x].sector, 
-            partitions[partition].block_allocation_map[x].offset
-        );
-        for(uint8_t i = partitions[partition].block_allocation_map[x].start_track; i <= partitions[partition].block_allocation_map[x].end_track; i++)
+        seekSector( map.track, map.sector, map.offset );
+        for(uint16_t i = map.start_track; i <= bamEndTrack(map); i++)
         {
             containerStream->read((uint8_t *)&bam, sizeof(bam));
             if ( sizeof(bam) > 3 )
@@ -259,38 +267,578 @@ uint16_t D64IStream::blocksFree()
         }
     }
 
+    // Kept until the next write
+    blocks_free = free_count;
     return free_count;
 }
 
-size_t D64IStream::readFile(uint8_t* buf, size_t size) {
-    size_t bytesRead = 0;
 
-    if ( sector_offset % block_size == 0 )
+// BAM rebuild
+
+bool D64IStream::blockIndex( uint8_t track, uint8_t sector, uint32_t &index )
+{
+    auto &map = partitions[partition].block_allocation_map;
+    if ( track < map.front().start_track || track > map.back().end_track )
+        return false;
+    if ( sector >= sectorsPerTrack[speedZone(track)] )
+        return false;
+
+    index = sector;
+    for ( uint16_t t = map.front().start_track; t < track; t++ )
+        index += sectorsPerTrack[speedZone(t)];
+
+    return true;
+}
+
+// 40 and 42 track D64s have no standard place for the BAM of the extra
+// tracks, only the entries in front of the disk name are used
+uint8_t D64IStream::bamEndTrack( const BlockAllocationMap &map )
+{
+    auto &p = partitions[partition];
+    uint16_t end = map.end_track;
+
+    if ( map.track == p.header_track && map.sector == p.header_sector && map.offset < p.header_offset )
+        end = std::min(end, (uint16_t)(map.start_track + ((p.header_offset - map.offset) / map.byte_count) - 1));
+
+    return end;
+}
+
+bool D64IStream::useBlock( BlockBitmap &used, uint8_t track, uint8_t sector )
+{
+    uint32_t index;
+    if ( !blockIndex( track, sector, index ) )
+    {
+        Debug_printv("illegal track[%d] sector[%d]", track, sector);
+        return false;
+    }
+
+    if ( used[index >> 3] & (1 << (index & 7)) )
     {
-        // We are at the beginning of the block
-        // Read track/sector link
-        containerStream->read((uint8_t *)&next_track, 1);
-        containerStream->read((uint8_t *)&next_sector, 1);
-        sector_offset += 2;
-        //Debug_printv("next_track[%d] next_sector[%d] sector_offset[%d]", next_track, next_sector, sector_offset);
+        Debug_printv("track[%d] sector[%d] used twice", track, sector);
+        return false;
     }
 
-    bytesRead += containerStream->read(buf, size);
-    sector_offset += bytesRead;
-    m_bytesAvailable -= bytesRead;
+    used[index >> 3] |= (1 << (index & 7));
+    return true;
+}
+
+bool D64IStream::useChain( BlockBitmap &used, uint8_t track, uint8_t sector )
+{
+    // A loop ends on a block that is already used
+    while ( track )
+    {
+        if ( !useBlock( used, track, sector ) )
+            return false;
+
+        uint8_t link[2];
+        if ( !seekSector( track, sector ) || containerStream->read(link, sizeof(link)) != sizeof(link) )
+            return false;
+
+        track = link[0];
+        sector = link[1];
+    }
+
+    return true;
+}
+
+bool D64IStream::useFile( BlockBitmap &used, const Entry &file )
+{
+    uint8_t type = file.file_type & 0b00000111;
+
+    // 1581 partitions are a run of blocks without links
+    if ( type == 5 )
+    {
+        uint8_t t = file.start_track;
+        uint16_t s = file.start_sector;
+        for ( uint16_t i = 0; i < UINT16_FROM_LE_UINT16(file.blocks); i++ )
+        {
+            if ( !useBlock( used, t, s ) )
+                return false;
+
+            if ( ++s >= sectorsPerTrack[speedZone(t)] )
+            {
+                s = 0;
+                t++;
+            }
+        }
+        return true;
+    }
+
+    if ( !useChain( used, file.start_track, file.start_sector ) )
+        return false;
+
+    if ( file.geos_type )
+    {
+        // GEOS info block, and the record chains of VLIR files. Their
+        // first block is the record index, already used above
+        if ( !useChain( used, file.rel_start_track, file.rel_start_sector ) )
+            return false;
+
+        if ( file.rel_record_length == 1 )
+        {
+            uint8_t index[256];
+            if ( !seekSector( file.start_track, file.start_sector ) || containerStream->read(index, sizeof(index)) != sizeof(index) )
+                return false;
+
+            for ( uint16_t i = 2; i < sizeof(index); i += 2 )
+            {
+                if ( !useChain( used, index[i], index[i + 1] ) )
+                    return false;
+            }
+        }
+    }
+    else if ( type == 4 )
+    {
+        // REL side sectors, with the 1581 super side sector in front
+        if ( !useChain( used, file.rel_start_track, file.rel_start_sector ) )
+            return false;
+    }
+
+    return true;
+}
+
+void D64IStream::useSystemBlocks( BlockBitmap &used )
+{
+    auto &p = partitions[partition];
+
+    useBlock( used, p.header_track, p.header_sector );
+    for ( auto &map : p.block_allocation_map )
+    {
+        if ( map.track != p.header_track || map.sector != p.header_sector )
+            useBlock( used, map.track, map.sector );
+    }
+}
+
+bool D64IStream::validate()
+{
+    auto &p = partitions[partition];
+    auto &maps = p.block_allocation_map;
+
+    // Blocks outside a partition are in use in its BAM, only the whole
+    // disk is rebuilt
+    if ( partition )
+    {
+        Debug_printv("no BAM rebuild in partition [%s]", directory.c_str());
+        return false;
+    }
 
-    if ( sector_offset % block_size == 0 )
+    // A directory that was not closed is scratched below too
+    resetDirectories();
+
+    // Every track has to fit its entry, the DNP bitmap has another layout
+    for ( auto &map : maps )
     {
-        // We are at the end of the block
-        // Follow track/sector link to move to next block
-        seekSector( next_track, next_sector );
-        //Debug_printv("track[%d] sector[%d] sector_offset[%d]", track, sector, sector_offset);
+        uint16_t bits = ((map.byte_count > 3) ? map.byte_count - 1 : map.byte_count) * 8;
+        for ( uint16_t t = map.start_track; t <= bamEndTrack(map); t++ )
+        {
+            if ( sectorsPerTrack[speedZone(t)] > bits )
+            {
+                Debug_printv("no BAM rebuild for this image");
+                return false;
+            }
+        }
     }
 
-    // if ( !bytesRead )
-    // {
-    //     sector_offset = 0;
-    // }
+    uint32_t blocks = 0;
+    for ( uint16_t t = maps.front().start_track; t <= maps.back().end_track; t++ )
+        blocks += sectorsPerTrack[speedZone(t)];
+
+    BlockBitmap used((blocks + 7) / 8, 0);
+    useSystemBlocks( used );
+
+    // Walk the directory and every file once. Files that were never
+    // closed are scratched, like DOS does
+    std::vector<uint32_t> splats;   // Offsets of their file type
+    uint16_t files = 0;
+    uint8_t t = p.directory_track;
+    uint8_t s = p.directory_sector;
+    while ( t )
+    {
+        uint8_t directory[256];
+        if ( !useBlock( used, t, s ) || !seekSector( t, s ) || containerStream->read(directory, sizeof(directory)) != sizeof(directory) )
+            return false;
+
+        for ( uint16_t i = 0; i < sizeof(directory); i += sizeof(Entry) )
+        {
+            Entry file;
+            memcpy(&file, &directory[i], sizeof(file));
+            if ( !(file.file_type & 0b00000111) )
+                continue;
+
+            if ( !(file.file_type & 0b10000000) )
+            {
+                seekSector( t, s, i + 2 );
+                splats.push_back( containerStream->position() );
+                continue;
+            }
+
+            if ( !useFile( used, file ) )
+            {
+                Debug_printv("bad file [%.16s]", file.filename);
+                return false;
+            }
+            files++;
+        }
+
+        t = directory[0];
+        s = directory[1];
+    }
+
+    uint8_t scratched = 0x00;
+    for ( auto offset : splats )
+    {
+        containerStream->seek( offset );
+        containerStream->write( &scratched, 1 );
+    }
+
+    if ( !writeBAM( used ) )
+        return false;
+
+    Debug_printv("files[%d] scratched[%d] blocks free[%d]", files, splats.size(), blocksFree());
+    return true;
+}
+
+bool D64IStream::writeBAM( BlockBitmap &used )
+{
+    for ( auto &map : partitions[partition].block_allocation_map )
+    {
+        std::string bam = readBlock( map.track, map.sector );
+        if ( bam.empty() )
+            return false;
+
+        for ( uint16_t t = map.start_track; t <= bamEndTrack(map); t++ )
+        {
+            // Free count and a bit per sector, 1 is free. The 1571 keeps
+            // only the bits for its second side
+            uint8_t *entry = (uint8_t *)&bam[map.offset + ((t - map.start_track) * map.byte_count)];
+            uint8_t *bits = (map.byte_count > 3) ? entry + 1 : entry;
+            memset(entry, 0, map.byte_count);
+
+            uint32_t index;
+            uint8_t free_count = 0;
+            blockIndex( t, 0, index );
+            for ( uint16_t i = 0; i < sectorsPerTrack[speedZone(t)]; i++, index++ )
+            {
+                if ( !(used[index >> 3] & (1 << (index & 7))) )
+                {
+                    bits[i >> 3] |= (1 << (i & 7));
+                    free_count++;
+                }
+            }
+
+            if ( bits != entry )
+                entry[0] = free_count;
+        }
+
+        if ( !writeBlock( map.track, map.sector, bam ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool D64IStream::writeHeader( std::string name, std::string id )
+{
+    auto &p = partitions[partition];
+
+    std::string header(block_size, 0x00);
+    header[0] = p.directory_track;
+    header[1] = p.directory_sector;
+    header[2] = dos_version;
+
+    // Name, id and DOS type padded with shifted spaces. The 1541 and 1571
+    // pad with four more, later drives with two
+    uint8_t pad = (p.header_offset == 0x90) ? 4 : 2;
+    memset(&header[p.header_offset], 0xA0, sizeof(Header) + pad);
+    memcpy(&header[p.header_offset], name.data(), std::min(name.size(), sizeof(Header::disk_name)));
+    memcpy(&header[p.header_offset + offsetof(Header, id_dos)], id.data(), std::min(id.size(), (size_t)2));
+    memcpy(&header[p.header_offset + offsetof(Header, id_dos) + 3], dos_type.data(), std::min(dos_type.size(), (size_t)2));
+
+    if ( !writeBlock( p.header_track, p.header_sector, header ) )
+        return false;
+
+    // An empty directory, the BAM is rebuilt around it
+    std::string directory(block_size, 0x00);
+    directory[1] = 0xFF;
+    return writeBlock( p.directory_track, p.directory_sector, directory );
+}
+
+// 8050 and 8250 chain the header to the BAM sectors and those on to the
+// directory, each BAM sector names the tracks it covers
+bool D64IStream::writeBAMLinks()
+{
+    auto &p = partitions[partition];
+    auto &maps = p.block_allocation_map;
+
+    std::string header = readBlock( p.header_track, p.header_sector );
+    if ( header.empty() )
+        return false;
+    header[0] = maps.front().track;
+    header[1] = maps.front().sector;
+    if ( !writeBlock( p.header_track, p.header_sector, header ) )
+        return false;
+
+    for ( uint8_t x = 0; x < maps.size(); x++ )
+    {
+        std::string bam(block_size, 0x00);
+        bam[0] = (x + 1 < maps.size()) ? maps[x + 1].track : p.directory_track;
+        bam[1] = (x + 1 < maps.size()) ? maps[x + 1].sector : p.directory_sector;
+        bam[2] = dos_version;
+        bam[4] = maps[x].start_track;
+        bam[5] = maps[x].end_track + 1;
+        if ( !writeBlock( maps[x].track, maps[x].sector, bam ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool D64IStream::format( std::string name, std::string id )
+{
+    auto &p = partitions[partition];
+    auto &maps = p.block_allocation_map;
+
+    if ( partition )
+        return false;
+
+    resetDirectories();
+
+    if ( id.empty() )
+    {
+        // Quick format, only the directory is cleared
+        seekHeader();
+        id = std::string(header.id_dos, 2);
+    }
+    else
+    {
+        uint32_t blocks = 0;
+        for ( uint16_t t = maps.front().start_track; t <= maps.back().end_track; t++ )
+            blocks += sectorsPerTrack[speedZone(t)];
+
+        blocks_free = -1;
+        std::string empty(block_size, 0x00);
+        if ( !seekSector( maps.front().start_track, 0 ) )
+            return false;
+        for ( uint32_t i = 0; i < blocks; i++ )
+        {
+            if ( containerStream->write((const uint8_t *)empty.data(), empty.size()) != empty.size() )
+                return false;
+        }
+
+        // No errors on a new disk
+        if ( error_info )
+        {
+            std::string errors(blocks, 0x01);
+            containerStream->write((const uint8_t *)errors.data(), errors.size());
+        }
+    }
+
+    if ( !writeHeader( name, id ) )
+        return false;
+
+    return validate();
+}
+
+
+// Subdirectories and partitions
+
+std::string D64IStream::directoryKey( std::string path )
+{
+    while ( mstr::startsWith(path, "/") )
+        path.erase(0, 1);
+    while ( mstr::endsWith(path, "/") )
+        path.pop_back();
+    mstr::toLower(path);
+
+    return path;
+}
+
+// The header link points to the first directory block
+D64IStream::Partition D64IStream::directoryPartition( uint8_t track, uint8_t sector )
+{
+    Partition p = partitions[0];
+    p.header_track = track;
+    p.header_sector = sector;
+
+    uint8_t link[2] = { 0 };
+    if ( seekSector( track, sector ) )
+        containerStream->read(link, sizeof(link));
+    p.directory_track = link[0];
+    p.directory_sector = link[1];
+
+    return p;
+}
+
+bool D64IStream::findDirectory( std::string path, uint16_t *header )
+{
+    path = directoryKey( path );
+    if ( path.empty() )
+    {
+        if ( header )
+            *header = (partitions[0].header_track << 8) | partitions[0].header_sector;
+        return true;
+    }
+
+    auto found = directories.find( path );
+    if ( found != directories.end() )
+    {
+        if ( header )
+            *header = found->second;
+        return true;
+    }
+
+    if ( !has_subdirs || notDirectories.count( path ) )
+        return false;
+
+    // Not listed yet, look for it in its parent
+    size_t slash = path.rfind('/');
+    std::string parent = (slash == std::string::npos) ? "" : path.substr(0, slash);
+    std::string name = path.substr(slash + 1);
+    uint16_t parent_header;
+    if ( !findDirectory( parent, &parent_header ) )
+        return false;
+
+    // Leave a listing or a file in progress where it was
+    uint8_t track0 = track;
+    uint8_t sector0 = sector;
+    uint64_t block0 = block;
+    uint32_t position0 = containerStream->position();
+
+    Partition p = parent.empty() ? partitions[0] : directoryPartition( parent_header >> 8, parent_header & 0xFF );
+    uint8_t t = p.directory_track;
+    uint8_t s = p.directory_sector;
+    bool wildcard = name.find_first_of("*?") != std::string::npos;
+    bool r = false;
+    uint16_t match = 0;
+    for ( uint16_t count = 0; t && !r && count < UINT16_MAX; count++ )
+    {
+        uint8_t data[256];
+        if ( !seekSector( t, s ) || containerStream->read(data, sizeof(data)) != sizeof(data) )
+            break;
+
+        for ( uint16_t i = 0; i < sizeof(data); i += sizeof(Entry) )
+        {
+            Entry e;
+            memcpy(&e, &data[i], sizeof(e));
+            if ( !isDirectoryEntry( e ) )
+                continue;
+
+            std::string entryName(e.filename, sizeof(e.filename));
+            mstr::rtrimA0(entryName);
+            mstr::toASCII(entryName);
+            mstr::toLower(entryName);
+            mstr::replaceAll(entryName, "/", "\\");
+            if ( wildcard ? mstr::compare(name, entryName) : name == entryName )
+            {
+                match = (e.start_track << 8) | e.start_sector;
+                r = true;
+                break;
+            }
+        }
+
+        t = data[0];
+        s = data[1];
+    }
+
+    seekSector( track0, sector0 );
+    block = block0;
+    containerStream->seek( position0 );
+
+    // Only whole names, RD doesn't know which patterns matched
+    if ( path.find_first_of("*?") == std::string::npos )
+    {
+        if ( r )
+            directories[path] = match;
+        else if ( !t )
+        {
+            if ( notDirectories.size() >= 64 )
+                notDirectories.clear();
+            notDirectories.insert( path );
+        }
+    }
+
+    if ( r && header )
+        *header = match;
+
+    Debug_printv("path[%s] found[%d]", path.c_str(), r);
+    return r;
+}
+
+// Lists, finds and counts free blocks in a subdirectory or partition
+// from here on, "" goes back to the root
+bool D64IStream::seekDirectory( std::string path )
+{
+    path = directoryKey( path );
+    if ( path == directory )
+        return true;
+
+    uint16_t header;
+    if ( !findDirectory( path, &header ) )
+        return false;
+
+    partitions.resize(1);
+    partition = 0;
+    if ( path.size() )
+    {
+        partitions.push_back( directoryPartition( header >> 8, header & 0xFF ) );
+        partition = 1;
+    }
+
+    directory = path;
+    entry_index = 0;
+    blocks_free = -1;
+
+    return true;
+}
+
+// Forgets the paths looked up and goes back to the root, for when the
+// directory blocks they point to may be gone
+void D64IStream::resetDirectories()
+{
+    directories.clear();
+    notDirectories.clear();
+
+    partitions.resize(1);
+    partition = 0;
+    directory.clear();
+    entry_index = 0;
+    blocks_free = -1;
+}
+
+size_t D64IStream::readFile(uint8_t* buf, size_t size) {
+    size_t bytesRead = 0;
+
+    while ( bytesRead < size )
+    {
+        if ( sector_offset % block_size == 0 )
+        {
+            // We are at the beginning of the block
+            // Read track/sector link
+            containerStream->read((uint8_t *)&next_track, 1);
+            containerStream->read((uint8_t *)&next_sector, 1);
+            sector_offset += 2;
+            //Debug_printv("next_track[%d] next_sector[%d] sector_offset[%d]", next_track, next_sector, sector_offset);
+        }
+
+        // Don't read past the end of this block
+        size_t count = std::min(size - bytesRead, block_size - (sector_offset % block_size));
+        size_t n = containerStream->read(buf + bytesRead, count);
+        bytesRead += n;
+        sector_offset += n;
+
+        if ( sector_offset % block_size == 0 && next_track )
+        {
+            // We are at the end of the block
+            // Follow track/sector link to move to next block
+            seekSector( next_track, next_sector );
+            //Debug_printv("track[%d] sector[%d] sector_offset[%d]", track, sector, sector_offset);
+        }
+
+        if ( n < count )
+            break;
+    }
+
+    m_bytesAvailable -= bytesRead;
 
     return bytesRead;
 }
@@ -308,15 +856,30 @@ bool D64IStream::seekPath(std::string path) {
 
     entry_index = 0;
 
+    // Files in a subdirectory or partition
+    std::string filename = path;
+    size_t slash = path.rfind('/');
+    if ( path[0] != '#' && !seekDirectory( (slash == std::string::npos) ? "" : path.substr(0, slash) ) )
+    {
+        Debug_printv( "Not found! [%s]", path.c_str());
+        return false;
+    }
+    if ( slash != std::string::npos )
+        filename = path.substr(slash + 1);
+
     // call image method to obtain file bytes here, return true on success:
     // return D64Image.seekFile(containerIStream, path);
-    if ( mstr::endsWith(path,"#") ) // Direct Access Mode
+    if ( path[0] == '#' ) // Direct Access Mode
     {
-        Debug_printv("Direct Access Mode track[0] sector[0] path[%s]", path.c_str());
+        Debug_printv("Direct Access Mode path[%s]", path.c_str());
         seekCalled = false;
-        return seekSector(1, 0);
+        direct.reset( new uint8_t[block_size]() );
+        m_position = 0;
+        m_length = block_size;
+        m_bytesAvailable = block_size;
+        return true;
     }
-    else if ( seekEntry(path) )
+    else if ( seekEntry(filename) )
     {
         //auto entry = containerImage->entry;
         auto type = decodeType(entry.file_type).c_str();
@@ -333,6 +896,18 @@ bool D64IStream::seekPath(std::string path) {
 
         Debug_printv("File Size: blocks[%d] size[%d] available[%d] r[%d]", entry.blocks, m_length, m_bytesAvailable, r);
 
+        rel.record_length = 0;
+        rel.blocks.clear();
+        if ( (entry.file_type & 0b00000111) == 4 ) // REL
+        {
+            if ( readSideSectors( entry.rel_start_track, entry.rel_start_sector ) )
+                rel.record_length = entry.rel_record_length;
+
+            // The index may have moved us, go back to the start of the file
+            r = seekSector( t, s );
+            Debug_printv("REL record_length[%d] blocks[%d]", rel.record_length, rel.blocks.size());
+        }
+
         return r;
     }
     else
@@ -344,6 +919,238 @@ bool D64IStream::seekPath(std::string path) {
 };
 
 
+bool D64IStream::readSideSectors( uint8_t track, uint8_t sector )
+{
+    uint8_t ss[256];
+
+    if ( !seekSector( track, sector ) || containerStream->read(ss, sizeof(ss)) != sizeof(ss) )
+        return false;
+
+    // 1581 REL files start with a super side sector, the side sectors of
+    // every group are still chained from the first one
+    if ( ss[2] == 0xFE )
+    {
+        track = ss[3];
+        sector = ss[4];
+        if ( !seekSector( track, sector ) || containerStream->read(ss, sizeof(ss)) != sizeof(ss) )
+            return false;
+    }
+
+    // 126 groups of 6 side sectors at most
+    for ( uint16_t count = 0; count < 126 * 6; count++ )
+    {
+        // 120 data block pointers after the header
+        for ( uint8_t i = 0x10; i != 0; i += 2 )
+        {
+            if ( ss[i] == 0 )
+                break;
+
+            rel.blocks.push_back( (ss[i] << 8) | ss[i + 1] );
+        }
+
+        if ( ss[0] == 0 )
+            return true;
+
+        if ( !seekSector( ss[0], ss[1] ) || containerStream->read(ss, sizeof(ss)) != sizeof(ss) )
+            break;
+    }
+
+    return false;
+}
+
+bool D64IStream::seekRecord( uint16_t record, uint8_t offset )
+{
+    if ( !rel.record_length )
+        return false;
+
+    // Record 0 and offset 0 are taken as 1, like CBM DOS does
+    if ( record ) record--;
+    if ( offset ) offset--;
+    if ( offset >= rel.record_length )
+        return false;
+
+    uint32_t pos = (record * rel.record_length) + offset;
+    uint32_t index = pos / (block_size - 2);
+    if ( index >= rel.blocks.size() || pos >= m_length )
+    {
+        Debug_printv("record[%d] not present", record + 1);
+        return false;
+    }
+
+    // CBM DOS sends a record up to its last non-zero byte
+    uint8_t data[256];
+    uint32_t length = std::min((uint32_t)(rel.record_length - offset), m_length - pos);
+    uint32_t used = 0;
+    while ( used < length )
+    {
+        uint32_t i = (pos + used) / (block_size - 2);
+        uint16_t o = 2 + ((pos + used) % (block_size - 2));
+        uint32_t n = std::min(length - used, (uint32_t)(block_size - o));
+        if ( i >= rel.blocks.size() ||
+             !seekSector( rel.blocks[i] >> 8, rel.blocks[i] & 0xFF, o ) ||
+             containerStream->read(data + used, n) != n )
+            break;
+        used += n;
+    }
+    while ( used > 1 && !data[used - 1] )
+        used--;
+
+    // Pick up the link of the block, then move to the record
+    uint8_t t = rel.blocks[index] >> 8;
+    uint8_t s = rel.blocks[index] & 0xFF;
+    sector_offset = 2 + (pos % (block_size - 2));
+    if ( !seekSector( t, s ) )
+        return false;
+    containerStream->read(&next_track, 1);
+    containerStream->read(&next_sector, 1);
+
+    rel.record = record + 1;
+    rel.left = length;
+    m_position = pos;
+    m_bytesAvailable = used;
+
+    return seekSector( t, s, sector_offset );
+}
+
+// Records are overwritten in place, the rest of the record is cleared
+// and the next record is selected, like PRINT# to a REL file
+uint32_t D64IStream::write(const uint8_t *buf, uint32_t size)
+{
+    if ( direct != nullptr )
+    {
+        // PRINT# fills the buffer from the pointer on
+        uint32_t n = std::min(size, (uint32_t)(block_size - std::min(m_position, (uint32_t)block_size)));
+        memcpy(&direct[m_position], buf, n);
+        m_position += n;
+        m_bytesAvailable = (m_length > m_position) ? m_length - m_position : 0;
+        return n;
+    }
+
+    if ( !seekCalled || !rel.record_length || !rel.left )
+        return 0;
+
+    blocks_free = -1;
+
+    // The whole rest of the record is written, not only what is read of it
+    m_bytesAvailable = rel.left;
+
+    uint32_t bytesWritten = writeRecord( buf, std::min(size, m_bytesAvailable) );
+
+    uint8_t zero[64] = { 0 };
+    while ( m_bytesAvailable )
+    {
+        if ( !writeRecord( zero, std::min((uint32_t)sizeof(zero), m_bytesAvailable) ) )
+            break;
+    }
+
+    if ( !seekRecord( rel.record + 1 ) )
+    {
+        rel.left = 0;
+        m_bytesAvailable = 0;
+    }
+
+    return bytesWritten;
+}
+
+uint32_t D64IStream::read(uint8_t* buf, uint32_t size)
+{
+    if ( direct == nullptr )
+        return CBMImageStream::read(buf, size);
+
+    uint32_t n = std::min(size, m_bytesAvailable);
+    memcpy(buf, &direct[m_position], n);
+    m_position += n;
+    m_bytesAvailable -= n;
+
+    return n;
+}
+
+bool D64IStream::seek(uint32_t offset)
+{
+    if ( direct == nullptr )
+    {
+        // A position in a REL file selects the record holding it
+        if ( seekCalled && rel.record_length )
+            return seekRecord( offset / rel.record_length + 1, offset % rel.record_length + 1 );
+
+        return CBMImageStream::seek(offset);
+    }
+
+    // B-P
+    if ( offset >= block_size )
+        return false;
+
+    m_position = offset;
+    m_bytesAvailable = (m_length > m_position) ? m_length - m_position : 0;
+    return true;
+}
+
+// U1 and B-R, the whole sector lands in the buffer with one read
+bool D64IStream::readSector( uint8_t track, uint8_t sector, bool counted )
+{
+    if ( direct == nullptr )
+        return false;
+
+    if ( !seekSector( track, sector ) || containerStream->read(direct.get(), block_size) != block_size )
+        return false;
+
+    m_position = counted ? 1 : 0;
+    m_length = counted ? direct[0] + 1 : block_size;
+    m_bytesAvailable = (m_length > m_position) ? m_length - m_position : 0;
+
+    return true;
+}
+
+// U2 and B-W, written through to the image right away
+bool D64IStream::writeSector( uint8_t track, uint8_t sector, bool counted )
+{
+    if ( direct == nullptr )
+        return false;
+
+    if ( counted )
+        direct[0] = m_position ? m_position - 1 : 0;
+
+    blocks_free = -1;
+    if ( !seekSector( track, sector ) || containerStream->write(direct.get(), block_size) != block_size )
+        return false;
+
+    return containerStream->flush();
+}
+
+uint32_t D64IStream::writeRecord( const uint8_t *buf, uint32_t size )
+{
+    uint32_t bytesWritten = 0;
+
+    while ( bytesWritten < size )
+    {
+        if ( sector_offset % block_size == 0 )
+        {
+            // Keep the link, write after it
+            containerStream->read(&next_track, 1);
+            containerStream->read(&next_sector, 1);
+            sector_offset += 2;
+            seekSector( track, sector, sector_offset );
+        }
+
+        uint32_t count = std::min(size - bytesWritten, (uint32_t)(block_size - (sector_offset % block_size)));
+        uint32_t n = containerStream->write(buf + bytesWritten, count);
+        bytesWritten += n;
+        sector_offset += n;
+
+        if ( sector_offset % block_size == 0 && next_track )
+            seekSector( next_track, next_sector );
+
+        if ( n < count )
+            break;
+    }
+
+    m_position += bytesWritten;
+    m_bytesAvailable -= bytesWritten;
+
+    return bytesWritten;
+}
+
+
 /********************************************************
  * File implementations
  ********************************************************/
@@ -358,8 +1165,13 @@ bool D64File::isDirectory() {
     //Debug_printv("pathInStream[%s]", pathInStream.c_str());
     if ( pathInStream == "" )
         return true;
-    else
+
+    // Files from a listing know what they are
+    if ( !isDir || !subdirs )
         return false;
+
+    auto image = ImageBroker::obtain<D64IStream>(streamFile->url);
+    return image != nullptr && image->findDirectory(pathInStream);
 };
 
 bool D64File::rewindDirectory() {
@@ -367,7 +1179,13 @@ bool D64File::rewindDirectory() {
     //Debug_printv("streamFile->url[%s]", streamFile->url.c_str());
     auto image = ImageBroker::obtain<D64IStream>(streamFile->url);
     if ( image == nullptr )
+    {
         Debug_printv("image pointer is null");
+        return false;
+    }
+
+    if ( !image->seekDirectory(pathInStream) )
+        return false;
 
     image->resetEntryCounter();
 
@@ -406,8 +1224,20 @@ MFile* D64File::getNextFileInDir() {
         std::string fileName = image->entry.filename;
         mstr::rtrimA0(fileName);
         mstr::replaceAll(fileName, "/", "\\");
-        //Debug_printv( "entry[%s]", (streamFile->url + "/" + fileName).c_str() );
-        auto file = MFSOwner::File(streamFile->url + "/" + fileName);
+
+        // Subdirectories shown here are found without another scan
+        std::string path = (pathInStream.size() ? pathInStream + "/" : "") + fileName;
+        bool is_dir = image->isDirectoryEntry(image->entry);
+        if ( is_dir )
+        {
+            std::string key = path;
+            mstr::toASCII(key);
+            image->directories[D64IStream::directoryKey(key)] = (image->entry.start_track << 8) | image->entry.start_sector;
+        }
+
+        //Debug_printv( "entry[%s]", (streamFile->url + "/" + path).c_str() );
+        auto file = MFSOwner::File(streamFile->url + "/" + path);
+        ((D64File *)file)->isDir = is_dir;
         file->extension = image->decodeType(image->entry.file_type);
         return file;
     }
@@ -435,6 +1265,30 @@ time_t D64File::getCreationTime() {
     return mktime(entry_time);
 }
 
+bool D64File::format(std::string header, std::string id) {
+    if ( !isDirectory() )
+        return false;
+
+    auto image = ImageBroker::obtain<D64IStream>(streamFile->url);
+    if ( image == nullptr )
+        return false;
+
+    bool success = image->format(header, id);
+    return image->flush() && success;
+}
+
+bool D64File::validate() {
+    if ( !isDirectory() )
+        return false;
+
+    auto image = ImageBroker::obtain<D64IStream>(streamFile->url);
+    if ( image == nullptr )
+        return false;
+
+    bool success = image->validate();
+    return image->flush() && success;
+}
+
 bool D64File::exists() {
     // here I'd rather use D64 logic to see if such file name exists in the image!
     //Debug_printv("here");
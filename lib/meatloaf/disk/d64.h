@@ -14,6 +14,7 @@
 #include "meat_io.h"
 
 #include <map>
+#include <unordered_set>
 #include <bitset>
 
 #include "string_utils.h"
@@ -74,10 +75,11 @@ protected:
 
 public:
     std::vector<Partition> partitions;
-    std::vector<uint8_t> sectorsPerTrack = { 17, 18, 19, 21 };
+    std::vector<uint16_t> sectorsPerTrack = { 17, 18, 19, 21 };
     std::vector<uint8_t> interleave = { 3, 10 }; // Directory, File
 
     uint8_t dos_version = 0x41;
+    std::string dos_type = "2A";
     std::string dos_rom = "dos1541";
     std::string dos_name = "";
 
@@ -195,6 +197,24 @@ public:
 
     virtual uint16_t blocksFree();
 
+    // DOS V, rebuilds the BAM from the directory and the file chains
+    virtual bool validate();
+    // DOS N, a new empty directory and BAM. The whole disk is cleared
+    // when an id is given, otherwise the old id is kept
+    virtual bool format(std::string name, std::string id = "");
+
+    // Subdirectories (DNP) and partitions (D81) by their lower case path
+    // in the image, to the track << 8 | sector of their header. Listings
+    // add what they show, other paths are looked up once. Paths found
+    // not to be one are noted too, a LOAD asks twice. Wildcards are not kept
+    std::unordered_map<std::string, uint16_t> directories;
+    std::unordered_set<std::string> notDirectories;
+    std::string directory;      // Path of the selected one, "" is the root
+
+    bool findDirectory( std::string path, uint16_t *header = nullptr );
+    bool seekDirectory( std::string path );
+    void resetDirectories();
+
 	virtual uint8_t speedZone( uint8_t track)
 	{
 		return (track < 18) + (track < 25) + (track < 31);
@@ -220,6 +240,16 @@ public:
     virtual bool seekPath(std::string path) override;
     size_t readFile(uint8_t* buf, size_t size) override;
 
+    bool seekRecord( uint16_t record, uint8_t offset = 1 ) override;
+    uint32_t write(const uint8_t *buf, uint32_t size) override;
+    bool isUpdatable() override { return rel.record_length || direct != nullptr; };
+
+    bool readSector( uint8_t track, uint8_t sector, bool counted = false ) override;
+    bool writeSector( uint8_t track, uint8_t sector, bool counted = false ) override;
+    using CBMImageStream::read;
+    uint32_t read(uint8_t* buf, uint32_t size) override;
+    bool seek(uint32_t offset) override;
+
     Header header;      // Directory header data
     Entry entry;        // Directory entry data
 
@@ -228,21 +258,58 @@ public:
     uint8_t track = 0;
     uint8_t sector = 0;
     uint16_t offset = 0;
-    uint64_t blocks_free = 0;
+    int32_t blocks_free = -1;   // -1 until counted, writes clear it
 
     uint8_t next_track = 0;
     uint8_t next_sector = 0;
     uint8_t sector_offset = 0;
 
+    // REL file data blocks (track << 8 | sector) in order, read from the
+    // side sectors when the file is opened so a record is found without
+    // following the chain
+    struct RelIndex {
+        uint8_t record_length = 0;
+        uint16_t record = 0;
+        uint8_t left = 0;       // From the position to the end of the record
+        std::vector<uint16_t> blocks;
+    } rel;
+
+    // Drive buffer of a direct access channel, position and size are
+    // the buffer pointer and the end of what can be read
+    std::unique_ptr<uint8_t[]> direct;
+
+protected:
+    // One bit per block, set for the blocks in use while validating
+    typedef std::vector<uint8_t> BlockBitmap;
+
+    bool blockIndex( uint8_t track, uint8_t sector, uint32_t &index );
+    uint8_t bamEndTrack( const BlockAllocationMap &map );
+    bool useBlock( BlockBitmap &used, uint8_t track, uint8_t sector );
+    bool useChain( BlockBitmap &used, uint8_t track, uint8_t sector );
+    bool useFile( BlockBitmap &used, const Entry &file );
+
+    virtual void useSystemBlocks( BlockBitmap &used );
+    virtual bool writeHeader( std::string name, std::string id );
+    virtual bool writeBAM( BlockBitmap &used );
+    bool writeBAMLinks();
+
+    static std::string directoryKey( std::string path );
+    virtual bool isDirectoryEntry( const Entry &file ) { return false; };
+    virtual Partition directoryPartition( uint8_t track, uint8_t sector );
+
+    std::string readBlock( uint8_t track, uint8_t sector );
+    bool writeBlock( uint8_t track, uint8_t sector, std::string data );
+
 private:
     void sendListing();
 
     bool seekEntry( std::string filename );
     bool seekEntry( uint32_t index = 0 );
 
+    bool readSideSectors( uint8_t track, uint8_t sector );
+    uint32_t writeRecord( const uint8_t *buf, uint32_t size );
+
 
-    std::string readBlock( uint8_t track, uint8_t sector );
-    bool writeBlock( uint8_t track, uint8_t sector, std::string data );    
     bool allocateBlock( uint8_t track, uint8_t sector );
     bool deallocateBlock( uint8_t track, uint8_t sector );
 
@@ -295,8 +362,12 @@ public:
     time_t getCreationTime() override;
     uint32_t size() override;     
 
+    bool format(std::string header, std::string id = "") override;
+    bool validate() override;
+
     bool isDir = true;
     bool dirIsOpen = false;
+    bool subdirs = false;   // The image can have subdirectories or partitions
 };
 
 
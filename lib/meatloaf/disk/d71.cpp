@@ -1,5 +1,53 @@
 #include "d71.h"
 
+
+// The second side
+
+void D71IStream::useSystemBlocks( BlockBitmap &used )
+{
+    D64IStream::useSystemBlocks( used );
+
+    // Track 53 is kept for the BAM of side two
+    for ( uint8_t s = 1; s < sectorsPerTrack[speedZone(53)]; s++ )
+        useBlock( used, 53, s );
+}
+
+bool D71IStream::writeHeader( std::string name, std::string id )
+{
+    if ( !D64IStream::writeHeader( name, id ) )
+        return false;
+
+    std::string header = readBlock( 18, 0 );
+    if ( header.empty() )
+        return false;
+    header[3] = 0x80;   // Double sided
+    if ( !writeBlock( 18, 0, header ) )
+        return false;
+
+    return writeBlock( 53, 0, std::string(block_size, 0x00) );
+}
+
+bool D71IStream::writeBAM( BlockBitmap &used )
+{
+    if ( !D64IStream::writeBAM( used ) )
+        return false;
+
+    // The free counts of side two are kept in the BAM of side one
+    std::string bam = readBlock( 18, 0 );
+    std::string side = readBlock( 53, 0 );
+    if ( bam.empty() || side.empty() )
+        return false;
+
+    for ( uint8_t t = 36; t <= 70; t++ )
+    {
+        uint8_t *bits = (uint8_t *)&side[(t - 36) * 3];
+        bam[0xDD + t - 36] = std::bitset<8>(bits[0]).count() + std::bitset<8>(bits[1]).count() + std::bitset<8>(bits[2]).count();
+    }
+
+    return writeBlock( 18, 0, bam );
+}
+
+
 /********************************************************
  * File implementations
  ********************************************************/
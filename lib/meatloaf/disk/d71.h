@@ -42,11 +42,11 @@ public:
         };
 
         Partition p = {
-            1,     // track
+            18,    // track
             0,     // sector
-            0x04,  // header_offset
-            1,     // directory_track
-            4,     // directory_sector
+            0x90,  // header_offset
+            18,    // directory_track
+            1,     // directory_sector
             0x00,  // directory_offset
             b      // block_allocation_map
         };
@@ -69,13 +69,16 @@ public:
 
 	virtual uint8_t speedZone( uint8_t track) override
 	{
-        if ( track < 35 )
+        if ( track < 36 )
 		    return (track < 18) + (track < 25) + (track < 31);
         else
             return (track < 53) + (track < 60) + (track < 66);
 	};
 
 protected:
+    void useSystemBlocks( BlockBitmap &used ) override;
+    bool writeHeader( std::string name, std::string id ) override;
+    bool writeBAM( BlockBitmap &used ) override;
 
 private:
     friend class D71File;
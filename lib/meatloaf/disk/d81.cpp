@@ -1,5 +1,44 @@
 #include "d81.h"
 
+
+bool D81IStream::writeHeader( std::string name, std::string id )
+{
+    if ( !D64IStream::writeHeader( name, id ) )
+        return false;
+
+    // Both BAM sectors repeat the DOS version and the id
+    auto &maps = partitions[partition].block_allocation_map;
+    for ( uint8_t x = 0; x < maps.size(); x++ )
+    {
+        std::string bam(block_size, 0x00);
+        bam[0] = (x == 0) ? maps[1].track : 0x00;
+        bam[1] = (x == 0) ? maps[1].sector : 0xFF;
+        bam[2] = dos_version;
+        bam[3] = ~dos_version;
+        bam[4] = id[0];
+        bam[5] = id[1];
+        bam[6] = 0xC0;      // Verify on, check header CRC
+        if ( !writeBlock( maps[x].track, maps[x].sector, bam ) )
+            return false;
+    }
+
+    return true;
+}
+
+// A partition has its own BAM sectors after the header, they cover the
+// whole disk with everything outside the partition in use
+D81IStream::Partition D81IStream::directoryPartition( uint8_t track, uint8_t sector )
+{
+    Partition p = D64IStream::directoryPartition( track, sector );
+    p.block_allocation_map[0].track = track;
+    p.block_allocation_map[0].sector = sector + 1;
+    p.block_allocation_map[1].track = track;
+    p.block_allocation_map[1].sector = sector + 2;
+
+    return p;
+}
+
+
 /********************************************************
  * File implementations
  ********************************************************/
@@ -33,7 +33,7 @@ public:
             },
             {
                 40,     // track
-                0,      // sector
+                2,      // sector
                 0x10,   // offset
                 41,     // start_track
                 80,     // end_track
@@ -54,6 +54,8 @@ public:
         partitions.push_back(p);
         sectorsPerTrack = { 40 };
         dos_rom = "dos1581";
+        dos_version = 0x44;
+        dos_type = "3D";
         has_subdirs = true;
 
         uint32_t size = containerStream->size();
@@ -71,6 +73,14 @@ public:
 	virtual uint8_t speedZone( uint8_t track) override { return 0; };
 
 protected:
+    bool writeHeader( std::string name, std::string id ) override;
+
+    // Partitions of whole tracks, at least three, can hold a directory
+    bool isDirectoryEntry( const Entry &file ) override {
+        uint16_t blocks = UINT16_FROM_LE_UINT16(file.blocks);
+        return (file.file_type & 0b10000111) == 0x85 && file.start_sector == 0 && blocks >= 120 && !(blocks % 40);
+    };
+    Partition directoryPartition( uint8_t track, uint8_t sector ) override;
 
 private:
     friend class D81File;
@@ -83,7 +93,9 @@ private:
 
 class D81File: public D64File {
 public:
-    D81File(std::string path, bool is_dir = true) : D64File(path, is_dir) {};
+    D81File(std::string path, bool is_dir = true) : D64File(path, is_dir) {
+        subdirs = true;
+    };
 
     MStream* createIStream(std::shared_ptr<MStream> containerIstream) override;
 };
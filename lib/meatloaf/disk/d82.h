@@ -69,6 +69,8 @@ public:
         partitions.clear();
         partitions.push_back(p);
         sectorsPerTrack = { 23, 25, 27, 29 };
+        dos_version = 0x43;
+        dos_type = "2C";
     };
 
 	virtual uint8_t speedZone( uint8_t track) override
@@ -80,6 +82,9 @@ public:
 	};
 
 protected:
+    bool writeHeader( std::string name, std::string id ) override {
+        return D64IStream::writeHeader( name, id ) && writeBAMLinks();
+    };
 
 private:
     friend class D82File;
@@ -1,6 +1,286 @@
 
 #include "dnp.h"
 
+
+uint16_t DNPIStream::blocksFree()
+{
+    if ( blocks_free >= 0 )
+        return blocks_free;
+
+    // Subdirectories share the BAM of the partition
+    auto &map = partitions[0].block_allocation_map[0];
+    uint32_t free_count = 0;
+
+    seekSector( map.track, map.sector, map.offset );
+    for ( uint16_t t = map.start_track; t <= map.end_track; t++ )
+    {
+        uint8_t bam[32];
+        if ( containerStream->read(bam, sizeof(bam)) != sizeof(bam) )
+            break;
+
+        for ( uint8_t i = 0; i < sizeof(bam); i++ )
+            free_count += std::bitset<8>(bam[i]).count();
+    }
+
+    blocks_free = std::min(free_count, (uint32_t)UINT16_MAX);
+    return blocks_free;
+}
+
+// Sector 0 is bit 7 of the first byte of its track
+bool DNPIStream::allocateNext( uint8_t &track, uint8_t &sector )
+{
+    auto &map = partitions[0].block_allocation_map[0];
+
+    for ( uint16_t t = map.start_track; t <= map.end_track; t++ )
+    {
+        uint8_t bam[32];
+        if ( !seekSector( map.track, map.sector + (t >> 3), (t & 7) * sizeof(bam) ) ||
+             containerStream->read(bam, sizeof(bam)) != sizeof(bam) )
+            return false;
+
+        for ( uint8_t i = 0; i < sizeof(bam); i++ )
+        {
+            if ( !bam[i] )
+                continue;
+
+            uint8_t bit = 0;
+            while ( !(bam[i] & (0x80 >> bit)) )
+                bit++;
+            bam[i] &= ~(0x80 >> bit);
+
+            blocks_free = -1;
+            if ( !seekSector( map.track, map.sector + (t >> 3), ((t & 7) * sizeof(bam)) + i ) ||
+                 containerStream->write(&bam[i], 1) != 1 )
+                return false;
+
+            track = t;
+            sector = (i * 8) + bit;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool DNPIStream::releaseBlock( uint8_t track, uint8_t sector )
+{
+    auto &map = partitions[0].block_allocation_map[0];
+    uint8_t offset = ((track & 7) * 32) + (sector >> 3);
+    uint8_t bits;
+
+    if ( !seekSector( map.track, map.sector + (track >> 3), offset ) || containerStream->read(&bits, 1) != 1 )
+        return false;
+    bits |= (0x80 >> (sector & 7));
+
+    blocks_free = -1;
+    return seekSector( map.track, map.sector + (track >> 3), offset ) && containerStream->write(&bits, 1) == 1;
+}
+
+// The name goes on the disk in PETSCII
+bool DNPIStream::makeDirectory( std::string path )
+{
+    std::string key = directoryKey( path );
+    if ( key.empty() || findDirectory( key ) )
+        return false;
+
+    // A header and one directory block
+    if ( blocksFree() < 3 )
+        return false;
+
+    while ( mstr::endsWith(path, "/") )
+        path.pop_back();
+    size_t slash = path.rfind('/');
+    std::string name = path.substr(slash + 1);
+    mstr::toPETSCII(name);
+    if ( !seekDirectory( (slash == std::string::npos) ? "" : path.substr(0, slash) ) )
+        return false;
+
+    auto parent = partitions[partition];
+
+    // A free entry in the parent, a full directory grows by a block
+    uint8_t slot_track = 0, slot_sector = 0, slot = 0;
+    uint8_t last_track = 0, last_sector = 0;
+    uint8_t t = parent.directory_track;
+    uint8_t s = parent.directory_sector;
+    for ( uint16_t count = 0; t && !slot_track && count < UINT16_MAX; count++ )
+    {
+        std::string data = readBlock( t, s );
+        if ( data.empty() )
+            return false;
+
+        for ( uint16_t i = 0; i < block_size; i += sizeof(Entry) )
+        {
+            if ( data[i + 2] == 0x00 )
+            {
+                slot_track = t;
+                slot_sector = s;
+                slot = i;
+                break;
+            }
+        }
+
+        last_track = t;
+        last_sector = s;
+        t = data[0];
+        s = data[1];
+    }
+
+    if ( !slot_track )
+    {
+        if ( !allocateNext( slot_track, slot_sector ) )
+            return false;
+
+        std::string directory(block_size, 0x00);
+        directory[1] = 0xFF;
+        std::string last = readBlock( last_track, last_sector );
+        if ( last.empty() || !writeBlock( slot_track, slot_sector, directory ) )
+            return false;
+
+        last[0] = slot_track;
+        last[1] = slot_sector;
+        if ( !writeBlock( last_track, last_sector, last ) )
+            return false;
+    }
+
+    uint8_t header_track, header_sector, directory_track, directory_sector;
+    if ( !allocateNext( header_track, header_sector ) || !allocateNext( directory_track, directory_sector ) )
+        return false;
+
+    // The header names the directory, itself, its parent and where
+    // it is listed there. The id is the one of the partition
+    std::string root = readBlock( partitions[0].header_track, partitions[0].header_sector );
+    if ( root.empty() )
+        return false;
+
+    uint8_t offset = parent.header_offset;
+    std::string header(block_size, 0x00);
+    header[0] = directory_track;
+    header[1] = directory_sector;
+    header[2] = dos_version;
+    memset(&header[offset], 0xA0, sizeof(Header) + 2);
+    memcpy(&header[offset], name.data(), std::min(name.size(), sizeof(Header::disk_name)));
+    memcpy(&header[offset + offsetof(Header, id_dos)], &root[offset + offsetof(Header, id_dos)], 2);
+    memcpy(&header[offset + offsetof(Header, id_dos) + 3], dos_type.data(), std::min(dos_type.size(), (size_t)2));
+    header[0x20] = header_track;
+    header[0x21] = header_sector;
+    header[0x22] = parent.header_track;
+    header[0x23] = parent.header_sector;
+    header[0x24] = slot_track;
+    header[0x25] = slot_sector;
+    header[0x26] = slot + 2;
+
+    std::string directory(block_size, 0x00);
+    directory[1] = 0xFF;
+
+    std::string listed = readBlock( slot_track, slot_sector );
+    if ( listed.empty() )
+        return false;
+
+    Entry e;
+    memcpy(&e, &listed[slot], sizeof(e));
+    memset(&e.file_type, 0x00, sizeof(e) - offsetof(Entry, file_type));
+    e.file_type = 0x86;
+    e.start_track = header_track;
+    e.start_sector = header_sector;
+    memset(e.filename, 0xA0, sizeof(e.filename));
+    memcpy(e.filename, name.data(), std::min(name.size(), sizeof(e.filename)));
+    e.blocks = UINT16_FROM_LE_UINT16(2);
+    memcpy(&listed[slot], &e, sizeof(e));
+
+    if ( !writeBlock( header_track, header_sector, header ) ||
+         !writeBlock( directory_track, directory_sector, directory ) ||
+         !writeBlock( slot_track, slot_sector, listed ) )
+        return false;
+
+    directories[key] = (header_track << 8) | header_sector;
+    notDirectories.erase(key);
+    Debug_printv("path[%s] header track[%d] sector[%d]", key.c_str(), header_track, header_sector);
+    return true;
+}
+
+bool DNPIStream::removeDirectory( std::string path )
+{
+    std::string key = directoryKey( path );
+    uint16_t header;
+    if ( key.empty() || !findDirectory( key, &header ) )
+        return false;
+
+    // Only an empty one goes, with its header and directory blocks
+    std::vector<uint16_t> blocks = { header };
+    Partition d = directoryPartition( header >> 8, header & 0xFF );
+    uint8_t t = d.directory_track;
+    uint8_t s = d.directory_sector;
+    for ( uint16_t count = 0; t && count < UINT16_MAX; count++ )
+    {
+        std::string data = readBlock( t, s );
+        if ( data.empty() )
+            return false;
+
+        for ( uint16_t i = 0; i < block_size; i += sizeof(Entry) )
+        {
+            if ( data[i + 2] != 0x00 )
+            {
+                Debug_printv("path[%s] not empty", key.c_str());
+                return false;
+            }
+        }
+
+        blocks.push_back( (t << 8) | s );
+        t = data[0];
+        s = data[1];
+    }
+
+    // Scratch its entry in the parent
+    size_t slash = key.rfind('/');
+    if ( !seekDirectory( (slash == std::string::npos) ? "" : key.substr(0, slash) ) )
+        return false;
+
+    bool scratched = false;
+    t = partitions[partition].directory_track;
+    s = partitions[partition].directory_sector;
+    for ( uint16_t count = 0; t && !scratched && count < UINT16_MAX; count++ )
+    {
+        std::string data = readBlock( t, s );
+        if ( data.empty() )
+            return false;
+
+        for ( uint16_t i = 0; i < block_size; i += sizeof(Entry) )
+        {
+            Entry e;
+            memcpy(&e, &data[i], sizeof(e));
+            if ( isDirectoryEntry( e ) && ((e.start_track << 8) | e.start_sector) == header )
+            {
+                data[i + 2] = 0x00;
+                if ( !writeBlock( t, s, data ) )
+                    return false;
+                scratched = true;
+                break;
+            }
+        }
+
+        t = data[0];
+        s = data[1];
+    }
+
+    if ( !scratched )
+        return false;
+
+    for ( auto b : blocks )
+        releaseBlock( b >> 8, b & 0xFF );
+
+    // Forget it and whatever was found below it
+    for ( auto i = directories.begin(); i != directories.end(); )
+    {
+        if ( i->first == key || mstr::startsWith(i->first, (key + "/").c_str()) )
+            i = directories.erase(i);
+        else
+            i++;
+    }
+
+    return true;
+}
+
+
 /********************************************************
  * File implementations
  ********************************************************/
@@ -10,3 +290,28 @@ MStream* DNPFile::createIStream(std::shared_ptr<MStream> containerIstream) {
 
     return new DNPIStream(containerIstream);
 }
+
+bool DNPFile::mkDir() {
+    if ( pathInStream.empty() )
+        return false;
+
+    auto image = ImageBroker::obtain<DNPIStream>(streamFile->url);
+    if ( image == nullptr )
+        return false;
+
+    bool success = image->makeDirectory(pathInStream);
+    return image->flush() && success;
+}
+
+bool DNPFile::remove() {
+    // Only empty subdirectories for now
+    if ( pathInStream.empty() || !isDirectory() )
+        return false;
+
+    auto image = ImageBroker::obtain<DNPIStream>(streamFile->url);
+    if ( image == nullptr )
+        return false;
+
+    bool success = image->removeDirectory(pathInStream);
+    return image->flush() && success;
+}
@@ -19,38 +19,56 @@ class DNPIStream : public D64IStream {
 public:
     DNPIStream(std::shared_ptr<MStream> is) : D64IStream(is) 
     {
+        // A track is 256 blocks, the partition size sets how many there are
+        uint32_t tracks = std::max(1U, std::min(255U, (uint32_t)(containerStream->size() / 65536)));
+
         // DNP Partition Info
         std::vector<BlockAllocationMap> b = { 
             {
                 1,      // track
                 2,      // sector
-                0x10,   // offset
+                0x20,   // offset
                 1,      // start_track
-                255,    // end_track
-                8       // byte_count
+                (uint8_t)tracks,    // end_track
+                32      // byte_count
             } 
         };
 
         Partition p = {
             1,     // track
-            0,     // sector
+            1,     // sector
             0x04,  // header_offset
             1,     // directory_track
-            0,     // directory_sector
-            0x20,  // directory_offset
+            34,    // directory_sector
+            0x00,  // directory_offset
             b      // block_allocation_map
         };
         partitions.clear();
         partitions.push_back(p);
-        sectorsPerTrack = { 255 };
+        sectorsPerTrack = { 256 };
+        dos_version = 0x48;
+        dos_type = "1H";
         has_subdirs = true;
     };
 
 	virtual uint8_t speedZone( uint8_t track) override { return 0; };
 
+    uint16_t blocksFree() override;
+
+    // MD and RD, subdirectories are made and removed empty
+    bool makeDirectory( std::string path );
+    bool removeDirectory( std::string path );
+
 protected:
+    bool isDirectoryEntry( const Entry &file ) override {
+        return (file.file_type & 0b10000111) == 0x86;
+    };
 
 private:
+    // One BAM for the whole partition, a bit per block, set when free
+    bool allocateNext( uint8_t &track, uint8_t &sector );
+    bool releaseBlock( uint8_t track, uint8_t sector );
+
     friend class DNPFile;
 };
 
@@ -61,9 +79,14 @@ private:
 
 class DNPFile: public D64File {
 public:
-    DNPFile(std::string path, bool is_dir = true) : D64File(path, is_dir) {};
+    DNPFile(std::string path, bool is_dir = true) : D64File(path, is_dir) {
+        subdirs = true;
+    };
 
     MStream* createIStream(std::shared_ptr<MStream> containerIstream) override;
+
+    bool mkDir() override;
+    bool remove() override;
 };
 
 
@@ -1,5 +1,290 @@
 #include "g64.h"
 
+#include <string.h>
+
+// GCR quintet -> nybble, 0xFF for codes the 1541 never writes
+static const uint8_t gcr_decode[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x08, 0x00, 0x01, 0xFF, 0x0C, 0x04, 0x05,
+    0xFF, 0xFF, 0x02, 0x03, 0xFF, 0x0F, 0x06, 0x07,
+    0xFF, 0x09, 0x0A, 0x0B, 0xFF, 0x0D, 0x0E, 0xFF
+};
+
+
+/********************************************************
+ * GCRSectorStream
+ ********************************************************/
+
+void GCRSectorStream::setGeometry(uint8_t max_track)
+{
+    // Tracks 36+ are only presented if they were actually formatted
+    m_tracks = 35;
+    if ( max_track >= 40 && decodeTrack(36, m_cache[0].data) )
+    {
+        m_tracks = 40;
+        if ( max_track >= 42 && decodeTrack(41, m_cache[0].data) )
+            m_tracks = 42;
+    }
+    m_cache[0].data.clear();
+
+    m_trackStart.resize(m_tracks + 1);
+    m_trackStart[0] = 0;
+    for ( uint8_t t = 1; t <= m_tracks; t++ )
+        m_trackStart[t] = m_trackStart[t - 1] + (sectorsInTrack(t) * 256);
+    m_length = m_trackStart[m_tracks];
+}
+
+bool GCRSectorStream::seek(uint32_t pos)
+{
+    if ( pos > m_length )
+        return false;
+
+    m_position = pos;
+    return true;
+}
+
+uint32_t GCRSectorStream::read(uint8_t* buf, uint32_t size)
+{
+    uint32_t bytesRead = 0;
+    uint8_t track = 1;
+
+    while ( bytesRead < size && m_position < m_length )
+    {
+        while ( m_position >= m_trackStart[track] )
+            track++;
+
+        const uint8_t *data = decodedTrack(track);
+        uint32_t offset = m_position - m_trackStart[track - 1];
+        uint32_t count = std::min(size - bytesRead, m_trackStart[track] - m_position);
+
+        memcpy(buf + bytesRead, data + offset, count);
+        bytesRead += count;
+        m_position += count;
+    }
+
+    return bytesRead;
+}
+
+const uint8_t* GCRSectorStream::decodedTrack(uint8_t track)
+{
+    DecodedTrack *slot = &m_cache[0];
+
+    for ( size_t i = 0; i < GCR_TRACK_CACHE_SIZE; i++ )
+    {
+        if ( m_cache[i].track == track )
+        {
+            m_cache[i].used = ++m_stamp;
+            return m_cache[i].data.data();
+        }
+
+        // Evict the least recently used track
+        if ( m_cache[i].used < slot->used )
+            slot = &m_cache[i];
+    }
+
+    decodeTrack(track, slot->data);
+    slot->track = track;
+    slot->used = ++m_stamp;
+
+    return slot->data.data();
+}
+
+// Decode every sector on a track into data, returns the number of sectors found.
+// Sectors that can't be found or fail their checksum are left zeroed.
+uint8_t GCRSectorStream::decodeTrack(uint8_t track, std::vector<uint8_t> &data)
+{
+    uint8_t sectors = sectorsInTrack(track);
+    uint8_t found = 0;
+    bool have[GCR_MAX_SECTORS] = { false };
+
+    data.assign(sectors * 256, 0x00);
+
+    if ( !readTrack(track) || m_gcrLength == 0 )
+        return 0;
+
+    // A sync can straddle the end of the track, so scan a little past one revolution
+    uint32_t bits = m_gcrLength * 8;
+    uint32_t pos = 0;
+    uint8_t block[260];
+
+    while ( found < sectors && findSync(pos, bits + 400) )
+    {
+        uint8_t header[8];
+        decodeGCR(pos, header, 8);
+        pos += 80;
+
+        if ( header[0] != 0x08 || header[3] != track || header[2] >= sectors || have[header[2]] )
+            continue;
+
+        if ( header[1] != (header[2] ^ header[3] ^ header[4] ^ header[5]) )
+        {
+            Debug_printv("header checksum error track[%d] sector[%d]", track, header[2]);
+            m_error = 1;
+            continue;
+        }
+
+        uint32_t data_pos = pos;
+        if ( !findSync(data_pos, pos + GCR_DATA_SYNC_DISTANCE) )
+            continue;
+
+        if ( !decodeGCR(data_pos, block, 260) || block[0] != 0x07 )
+        {
+            Debug_printv("bad data block track[%d] sector[%d]", track, header[2]);
+            m_error = 1;
+            continue;
+        }
+
+        uint8_t checksum = 0;
+        for ( size_t i = 1; i <= 256; i++ )
+            checksum ^= block[i];
+        if ( checksum != block[257] )
+        {
+            Debug_printv("data checksum error track[%d] sector[%d]", track, header[2]);
+            m_error = 1;
+        }
+
+        memcpy(&data[header[2] * 256], block + 1, 256);
+        have[header[2]] = true;
+        found++;
+
+        pos = data_pos + (325 * 8);
+    }
+
+    // Debug_printv("track[%d] sectors[%d] found[%d]", track, sectors, found);
+    return found;
+}
+
+inline uint8_t GCRSectorStream::gcrBit(uint32_t pos)
+{
+    return (m_gcr[(pos >> 3) % m_gcrLength] >> (7 - (pos & 7))) & 1;
+}
+
+// Move pos to the first bit after the next sync mark found before end
+bool GCRSectorStream::findSync(uint32_t &pos, uint32_t end)
+{
+    uint8_t ones = 0;
+
+    while ( pos < end )
+    {
+        // Whole bytes of sync are the common case
+        if ( (pos & 7) == 0 && m_gcr[(pos >> 3) % m_gcrLength] == 0xFF )
+        {
+            ones = std::min(ones + 8, 255);
+            pos += 8;
+            continue;
+        }
+
+        if ( gcrBit(pos) )
+            ones = std::min(ones + 1, 255);
+        else if ( ones >= GCR_SYNC_BITS )
+            return true;
+        else
+            ones = 0;
+
+        pos++;
+    }
+
+    return false;
+}
+
+// Decode count bytes (a multiple of 4) starting at bit pos, 5 GCR bytes at a time
+bool GCRSectorStream::decodeGCR(uint32_t pos, uint8_t* out, size_t count)
+{
+    bool valid = true;
+
+    for ( size_t n = 0; n < count; n += 4, pos += 40 )
+    {
+        // Load the 40 bit group (plus the bits needed to align it) as one word
+        uint32_t index = pos >> 3;
+        uint8_t shift = pos & 7;
+        uint64_t word = 0;
+
+        if ( index + 6 <= m_gcrLength )
+        {
+            const uint8_t *p = &m_gcr[index];
+            word = ((uint64_t)p[0] << 40) | ((uint64_t)p[1] << 32) | ((uint64_t)p[2] << 24) |
+                   ((uint64_t)p[3] << 16) | ((uint64_t)p[4] << 8) | p[5];
+        }
+        else
+        {
+            for ( uint8_t i = 0; i < 6; i++ )
+                word = (word << 8) | m_gcr[(index + i) % m_gcrLength];
+        }
+        word >>= (8 - shift);
+
+        for ( uint8_t i = 0; i < 4; i++ )
+        {
+            uint8_t hi = gcr_decode[(word >> (35 - (i * 10))) & 0x1F];
+            uint8_t lo = gcr_decode[(word >> (30 - (i * 10))) & 0x1F];
+            if ( (hi | lo) & 0xF0 )
+                valid = false;
+
+            out[n + i] = (hi << 4) | (lo & 0x0F);
+        }
+    }
+
+    return valid;
+}
+
+
+/********************************************************
+ * G64SectorStream
+ ********************************************************/
+
+G64SectorStream::G64SectorStream(std::shared_ptr<MStream> is) : GCRSectorStream(is)
+{
+    if ( !readHeader() )
+        Debug_printv("Not a valid G64 image");
+
+    setGeometry(m_trackOffsets.size());
+
+    // Debug_printv("halfTracks[%d] maxTrackSize[%d] length[%d]", m_halfTracks, m_maxTrackSize, size());
+}
+
+bool G64SectorStream::readHeader()
+{
+    uint8_t header[G64_HEADER_SIZE] = { 0 };
+
+    gcrStream->seek(0);
+    if ( gcrStream->read(header, G64_HEADER_SIZE) != G64_HEADER_SIZE )
+        return false;
+
+    if ( memcmp(header, G64_SIGNATURE, 8) != 0 )
+        return false;
+
+    m_halfTracks = header[9];
+    m_maxTrackSize = header[10] | (header[11] << 8);
+
+    // Offset table has one entry per half track, we only need full tracks
+    std::vector<uint8_t> table(m_halfTracks * 4);
+    if ( gcrStream->read(table.data(), table.size()) != table.size() )
+        return false;
+
+    m_trackOffsets.resize((m_halfTracks + 1) / 2);
+    for ( size_t i = 0; i < m_trackOffsets.size(); i++ )
+    {
+        uint8_t *o = &table[i * 8];
+        m_trackOffsets[i] = o[0] | (o[1] << 8) | (o[2] << 16) | ((uint32_t)o[3] << 24);
+    }
+
+    m_gcr.resize(m_maxTrackSize);
+    return true;
+}
+
+bool G64SectorStream::readTrack(uint8_t track)
+{
+    if ( track < 1 || track > m_trackOffsets.size() || m_trackOffsets[track - 1] == 0 )
+        return false;
+
+    uint8_t len[2] = { 0 };
+    gcrStream->seek(m_trackOffsets[track - 1]);
+    gcrStream->read(len, 2);
+    m_gcrLength = std::min((uint16_t)(len[0] | (len[1] << 8)), m_maxTrackSize);
+
+    return ( m_gcrLength && gcrStream->read(m_gcr.data(), m_gcrLength) == m_gcrLength );
+}
+
+
 /********************************************************
  * File implementations
  ********************************************************/
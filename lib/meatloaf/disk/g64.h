@@ -11,6 +11,9 @@
 #include "meat_io.h"
 #include "d64.h"
 
+#include <memory>
+#include <vector>
+
 // Format codes:
 // ID	Description
 // 0	Unknown format
@@ -43,23 +46,106 @@
 // 11	PirateSlayer
 // 12	CBM DOS, XEMAG
 
+#define G64_SIGNATURE          "GCR-1541"
+#define G64_HEADER_SIZE        12
+
+#define GCR_MAX_SECTORS        21
+#define GCR_TRACK_CACHE_SIZE   3    // Decoded tracks kept per image (directory + file)
+#define GCR_SYNC_BITS          10   // 1541 detects a sync after ten 1 bits
+#define GCR_DATA_SYNC_DISTANCE 1024 // Max bits between a header and its data block sync
+
 /********************************************************
  * Streams
  ********************************************************/
 
-class G64IStream : public D64IStream {
-    // override everything that requires overriding here
+// Presents the GCR tracks of a raw disk image as the sector data of a D64,
+// so all of the D64 directory/BAM/file logic can run on top of it unchanged.
+// Tracks are decoded on first access and kept in a small LRU cache.
+// Image formats only have to provide the raw GCR of a track.
+class GCRSectorStream : public MStream {
 
 public:
-    G64IStream(std::shared_ptr<MStream> is) : D64IStream(is) 
+    GCRSectorStream(std::shared_ptr<MStream> is) : gcrStream(is) {};
+
+    // MStream methods
+    bool open() override { return true; };
+    void close() override {};
+
+    uint32_t available() override { return m_length - m_position; };
+    uint32_t size() override { return m_length; };
+    uint32_t position() override { return m_position; };
+    size_t error() override { return m_error; };
+    bool isOpen() override { return gcrStream->isOpen(); };
+    bool isRandomAccess() override { return true; };
+
+    bool seek(uint32_t pos) override;
+    uint32_t read(uint8_t* buf, uint32_t size) override;
+    uint32_t write(const uint8_t *buf, uint32_t size) override { return 0; };
+
+    static uint8_t sectorsInTrack(uint8_t track)
     {
-        // G64 Offsets
-        //directory_header_offset = {18, 0, 0x90};
-        //directory_list_offset = {18, 1, 0x00};
-        //block_allocation_map = { {18, 0, 0x04, 1, 35, 4}, {53, 0, 0x00, 36, 70, 3} };
-        //sectorsPerTrack = { 17, 18, 19, 21 };
+        return 17 + (track < 31) + (track < 25) + (track < 18) * 2;
     };
 
+protected:
+    // Has to be called by the image format once it can read tracks
+    void setGeometry(uint8_t max_track);
+
+    // Load the raw GCR of a full track into m_gcr/m_gcrLength
+    virtual bool readTrack(uint8_t track) = 0;
+
+    std::shared_ptr<MStream> gcrStream;
+
+    std::vector<uint8_t> m_gcr;             // Raw track being decoded
+    uint32_t m_gcrLength = 0;
+
+    size_t m_error = 0;
+
+private:
+    struct DecodedTrack {
+        uint8_t track = 0;
+        uint32_t used = 0;
+        std::vector<uint8_t> data;
+    };
+
+    const uint8_t* decodedTrack(uint8_t track);
+    uint8_t decodeTrack(uint8_t track, std::vector<uint8_t> &data);
+
+    inline uint8_t gcrBit(uint32_t pos);
+    bool findSync(uint32_t &pos, uint32_t end);
+    bool decodeGCR(uint32_t pos, uint8_t* out, size_t count);
+
+    std::vector<uint32_t> m_trackStart;     // Byte offset of each track in the D64 view
+
+    DecodedTrack m_cache[GCR_TRACK_CACHE_SIZE];
+    uint32_t m_stamp = 0;
+
+    uint8_t m_tracks = 35;
+    uint32_t m_length = 0;
+    uint32_t m_position = 0;
+};
+
+class G64SectorStream : public GCRSectorStream {
+
+public:
+    G64SectorStream(std::shared_ptr<MStream> is);
+
+protected:
+    bool readTrack(uint8_t track) override;
+
+private:
+    bool readHeader();
+
+    uint8_t m_halfTracks = 0;
+    uint16_t m_maxTrackSize = 0;
+    std::vector<uint32_t> m_trackOffsets;   // By full track, 0 if not present
+};
+
+class G64IStream : public D64IStream {
+    // override everything that requires overriding here
+
+public:
+    G64IStream(std::shared_ptr<MStream> is) : D64IStream(std::make_shared<G64SectorStream>(is)) {};
 
 protected:
 
@@ -0,0 +1,85 @@
+#include "nib.h"
+
+#include <string.h>
+
+
+/********************************************************
+ * NIBSectorStream
+ ********************************************************/
+
+NIBSectorStream::NIBSectorStream(std::shared_ptr<MStream> is) : GCRSectorStream(is)
+{
+    if ( !readHeader() )
+        Debug_printv("Not a valid NIB image");
+
+    setGeometry(m_trackIndex.size());
+}
+
+bool NIBSectorStream::readHeader()
+{
+    uint8_t header[NIB_HEADER_SIZE] = { 0 };
+
+    gcrStream->seek(0);
+    if ( gcrStream->read(header, NIB_HEADER_SIZE) != NIB_HEADER_SIZE )
+        return false;
+
+    if ( memcmp(header, NIB_SIGNATURE, strlen(NIB_SIGNATURE)) != 0 )
+        return false;
+
+    // Captures are stored in table order, a halftrack of 0 ends the table.
+    // Full track t is halftrack t*2, the odd halftracks are only used if
+    // the full track itself wasn't captured.
+    std::vector<int16_t> halftracks(NIB_MAX_HALFTRACKS + 2, -1);
+    uint32_t captures = (gcrStream->size() - NIB_HEADER_SIZE) / NIB_TRACK_SIZE;
+    uint8_t max_track = 0;
+
+    for ( size_t i = 0; i < NIB_MAX_HALFTRACKS && i < captures; i++ )
+    {
+        uint8_t halftrack = header[NIB_TRACK_TABLE + (i * 2)];
+        if ( halftrack == 0 )
+            break;
+
+        // Nothing past the table, whatever a corrupt header says
+        if ( halftrack >= halftracks.size() )
+            continue;
+
+        if ( halftracks[halftrack] < 0 )
+            halftracks[halftrack] = i;
+
+        max_track = std::max(max_track, (uint8_t)(halftrack / 2));
+    }
+
+    // Track t needs halftracks t*2 and t*2+1
+    max_track = std::min(max_track, (uint8_t)((halftracks.size() - 2) / 2));
+
+    m_trackIndex.assign(max_track, -1);
+    for ( uint8_t t = 1; t <= max_track; t++ )
+        m_trackIndex[t - 1] = (halftracks[t * 2] >= 0) ? halftracks[t * 2] : halftracks[(t * 2) + 1];
+
+    m_gcr.resize(NIB_TRACK_SIZE);
+    return ( max_track > 0 );
+}
+
+// A capture is a little more than one revolution, the decoder skips the
+// sectors it has already seen when it wraps around
+bool NIBSectorStream::readTrack(uint8_t track)
+{
+    if ( track < 1 || track > m_trackIndex.size() || m_trackIndex[track - 1] < 0 )
+        return false;
+
+    gcrStream->seek(NIB_HEADER_SIZE + (m_trackIndex[track - 1] * NIB_TRACK_SIZE));
+    m_gcrLength = gcrStream->read(m_gcr.data(), NIB_TRACK_SIZE);
+
+    return ( m_gcrLength == NIB_TRACK_SIZE );
+}
+
+
+/********************************************************
+ * File implementations
+ ********************************************************/
+
+MStream* NIBFile::createIStream(std::shared_ptr<MStream> containerIstream) {
+    Debug_printv("[%s]", url.c_str());
+
+    return new NIBIStream(containerIstream);
+}
@@ -1,3 +1,86 @@
 // .NIB - Commodore 1541/1571 nibbler disk image
 // https://github.com/markusC64/nibtools
 // 
+// A 256 byte header with a (halftrack, density) table followed by one
+// raw 8K GCR capture per halftrack, read straight from the drive's
+// shift register. Only the tracks that are accessed get decoded.
+//
+
+
+#ifndef MEATLOAF_MEDIA_NIB
+#define MEATLOAF_MEDIA_NIB
+
+#include "meat_io.h"
+#include "g64.h"
+
+#define NIB_SIGNATURE       "MNIB-1541-RAW"
+#define NIB_HEADER_SIZE     0x100
+#define NIB_TRACK_TABLE     0x10
+#define NIB_TRACK_SIZE      0x2000
+#define NIB_MAX_HALFTRACKS  84
+
+
+/********************************************************
+ * Streams
+ ********************************************************/
+
+class NIBSectorStream : public GCRSectorStream {
+
+public:
+    NIBSectorStream(std::shared_ptr<MStream> is);
+
+protected:
+    bool readTrack(uint8_t track) override;
+
+private:
+    bool readHeader();
+
+    std::vector<int16_t> m_trackIndex;      // By full track, capture number or -1
+};
+
+class NIBIStream : public D64IStream {
+    // override everything that requires overriding here
+
+public:
+    NIBIStream(std::shared_ptr<MStream> is) : D64IStream(std::make_shared<NIBSectorStream>(is)) {};
+
+protected:
+
+private:
+    friend class NIBFile;
+};
+
+
+/********************************************************
+ * File implementations
+ ********************************************************/
+
+class NIBFile: public D64File {
+public:
+    NIBFile(std::string path, bool is_dir = true) : D64File(path, is_dir) {};
+
+    MStream* createIStream(std::shared_ptr<MStream> containerIstream) override;
+};
+
+
+
+/********************************************************
+ * FS
+ ********************************************************/
+
+class NIBFileSystem: public MFileSystem
+{
+public:
+    MFile* getFile(std::string path) override {
+        return new NIBFile(path);
+    }
+
+    bool handles(std::string fileName) {
+        return byExtension(".nib", fileName);
+    }
+
+    NIBFileSystem(): MFileSystem("nib") {};
+};
+
+
+#endif /* MEATLOAF_MEDIA_NIB */
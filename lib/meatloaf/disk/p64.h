@@ -0,0 +1,9 @@
+// .P64 - Flux pulse level disk image
+// https://github.com/BeRo1985/p64
+// https://vice-emu.sourceforge.io/vice_17.html#SEC345
+//
+// "P64-1541" chunks (HTPx per halftrack) hold the flux pulse positions
+// range coded. Decoding those pulses into GCR would let a P64 sit on
+// top of GCRSectorStream (see g64.h) like G64 and NIB do, but the
+// range decoder isn't implemented yet, so .P64 isn't registered.
+//
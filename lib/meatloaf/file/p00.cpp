@@ -13,6 +13,74 @@ size_t P00IStream::readFile(uint8_t* buf, size_t size) {
     return bytesRead;
 }
 
+bool P00IStream::seekRecord( uint16_t record, uint8_t offset )
+{
+    uint8_t record_length = header.rel_flag;
+    if ( !record_length )
+        return false;
+
+    // Record 0 and offset 0 are taken as 1, like CBM DOS does
+    if ( record ) record--;
+    if ( offset ) offset--;
+    if ( offset >= record_length )
+        return false;
+
+    uint32_t pos = (record * record_length) + offset;
+    if ( pos >= m_length )
+    {
+        Debug_printv("record[%d] not present", record + 1);
+        return false;
+    }
+
+    // CBM DOS sends a record up to its last non-zero byte
+    uint8_t data[256];
+    uint32_t length = std::min((uint32_t)(record_length - offset), m_length - pos);
+    if ( !containerStream->seek( sizeof(header) + pos ) )
+        return false;
+    uint32_t used = containerStream->read(data, length);
+    while ( used > 1 && !data[used - 1] )
+        used--;
+
+    this->record = record + 1;
+    left = length;
+    m_position = pos;
+    m_bytesAvailable = used;
+
+    return containerStream->seek( sizeof(header) + pos );
+}
+
+// Overwrite the record in place, clear the rest of it and select the next one
+uint32_t P00IStream::write(const uint8_t *buf, uint32_t size)
+{
+    if ( !header.rel_flag || !left )
+        return 0;
+
+    // The whole rest of the record is written, not only what is read of it
+    m_bytesAvailable = left;
+
+    uint32_t bytesWritten = containerStream->write(buf, std::min(size, m_bytesAvailable));
+    m_position += bytesWritten;
+    m_bytesAvailable -= bytesWritten;
+
+    uint8_t zero[64] = { 0 };
+    while ( m_bytesAvailable )
+    {
+        uint32_t n = containerStream->write(zero, std::min((uint32_t)sizeof(zero), m_bytesAvailable));
+        if ( !n )
+            break;
+        m_position += n;
+        m_bytesAvailable -= n;
+    }
+
+    if ( !seekRecord( record + 1 ) )
+    {
+        left = 0;
+        m_bytesAvailable = 0;
+    }
+
+    return bytesWritten;
+}
+
 
 
 /********************************************************
@@ -1,4 +1,5 @@
 // .P00/P** - P00/S00/U00/R00 (Container files for the PC64 emulator)
+// R00 (REL) files on flash/SD are accessed by record with the P command
 // https://ist.uwaterloo.ca/~schepers/formats/PC64.TXT
 //
 
@@ -59,7 +60,23 @@ protected:
 
     size_t readFile(uint8_t* buf, size_t size) override;
 
+public:
+    // R00 files keep the record length in the header
+    bool seekRecord( uint16_t record, uint8_t offset = 1 ) override;
+    uint32_t write(const uint8_t *buf, uint32_t size) override;
+    bool isUpdatable() override { return header.rel_flag; };
+
+    // A position in a REL file selects the record holding it
+    bool seek(uint32_t offset) override {
+        if ( header.rel_flag )
+            return seekRecord( offset / header.rel_flag + 1, offset % header.rel_flag + 1 );
+        return CBMImageStream::seek(offset);
+    }
+
+protected:
     Header header;
+    uint16_t record = 0;
+    uint8_t left = 0;       // From the position to the end of the record
 
 private:
     friend class P00File;
@@ -119,7 +136,7 @@ public:
     }
 
     bool handles(std::string fileName) {
-        return byExtension(".p00", fileName);
+        return byExtension({ ".p00", ".s00", ".u00", ".r00" }, fileName);
     }
 
     P00FileSystem(): MFileSystem("p00") {};
@@ -0,0 +1,298 @@
+#include "meat_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <esp_heap_caps.h>
+
+#include "../../include/debug.h"
+
+MBlockCache::Pool::Pool()
+{
+    lock = xSemaphoreCreateRecursiveMutex();
+
+    // PSRAM if there is some, a few blocks of internal RAM otherwise.
+    // Without either every call goes straight to the source
+    uint16_t blocks = CACHE_BLOCKS_PSRAM;
+    data = (uint8_t *)heap_caps_malloc(blocks * CACHE_BLOCK_SIZE, MALLOC_CAP_SPIRAM);
+    if ( data == nullptr )
+    {
+        blocks = CACHE_BLOCKS;
+        data = (uint8_t *)heap_caps_malloc(blocks * CACHE_BLOCK_SIZE, MALLOC_CAP_8BIT);
+    }
+    if ( data == nullptr || lock == nullptr )
+        return;
+
+    sets = std::max(1, blocks / CACHE_WAYS);
+    lines.assign(sets * CACHE_WAYS, { nullptr, 0, 0, 0, false });
+}
+
+MBlockCache::Pool &MBlockCache::pool()
+{
+    static Pool p;
+    return p;
+}
+
+MBlockCache::MBlockCache(std::shared_ptr<MStream> source)
+    : _source(source), _pool(pool())
+{
+    _size = _source->size();
+    _position = _source->position();
+}
+
+MBlockCache::~MBlockCache()
+{
+    flush();
+    drop();
+    if ( hits || misses )
+        Debug_printv("hits[%d] misses[%d] write backs[%d]", hits, misses, writeBacks);
+}
+
+void MBlockCache::close()
+{
+    flush();
+    _source->close();
+}
+
+bool MBlockCache::seek(uint32_t pos)
+{
+    if ( !_pool.sets )
+    {
+        if ( !_source->seek(pos) )
+            return false;
+    }
+
+    // The source is only moved when a block has to be read or written
+    _position = pos;
+    return true;
+}
+
+uint32_t MBlockCache::read(uint8_t* buf, uint32_t size)
+{
+    if ( !_pool.sets )
+    {
+        uint32_t n = _source->read(buf, size);
+        _position += n;
+        return n;
+    }
+
+    uint32_t bytesRead = 0;
+    lock();
+    while ( bytesRead < size )
+    {
+        uint16_t offset = _position % CACHE_BLOCK_SIZE;
+        Line *line = fetch( _position / CACHE_BLOCK_SIZE );
+        if ( line == nullptr || line->length <= offset )
+            break;
+
+        uint32_t n = std::min(size - bytesRead, (uint32_t)(line->length - offset));
+        memcpy(buf + bytesRead, data(*line) + offset, n);
+        bytesRead += n;
+        _position += n;
+    }
+    unlock();
+
+    return bytesRead;
+}
+
+uint32_t MBlockCache::write(const uint8_t *buf, uint32_t size)
+{
+    if ( !_pool.sets )
+    {
+        uint32_t n = _source->write(buf, size);
+        _position += n;
+        _size = std::max(_size, _position);
+        return n;
+    }
+
+    uint32_t bytesWritten = 0;
+    lock();
+    while ( bytesWritten < size )
+    {
+        // A whole block is not read first
+        uint16_t offset = _position % CACHE_BLOCK_SIZE;
+        uint32_t n = std::min(size - bytesWritten, (uint32_t)(CACHE_BLOCK_SIZE - offset));
+        claim( _position / CACHE_BLOCK_SIZE );
+        Line *line = fetch( _position / CACHE_BLOCK_SIZE, n < CACHE_BLOCK_SIZE );
+        if ( line == nullptr )
+            break;
+
+        memcpy(data(*line) + offset, buf + bytesWritten, n);
+        line->length = std::max(line->length, (uint16_t)(offset + n));
+        line->dirty = true;
+        _written = true;
+        bytesWritten += n;
+        _position += n;
+    }
+    unlock();
+
+    _size = std::max(_size, _position);
+    return bytesWritten;
+}
+
+bool MBlockCache::flush()
+{
+    if ( !_pool.sets )
+        return _source->seek( _source->position() );
+
+    lock();
+    bool success = true;
+    if ( _written )
+    {
+        // Other streams of the file hand on their writes first and
+        // read the blocks again after ours
+        for ( auto &line : _pool.lines )
+        {
+            MBlockCache *other = line.owner;
+            if ( other == nullptr || other == this || _source->url.empty() || other->_source->url != _source->url )
+                continue;
+
+            if ( line.dirty )
+                other->writeBack( line );
+            line.owner = nullptr;
+            line.dirty = false;
+            line.used = 0;
+        }
+
+        for ( auto &line : _pool.lines )
+        {
+            if ( line.owner == this && line.dirty && !writeBack( line ) )
+                success = false;
+        }
+        _written = !success;
+    }
+    unlock();
+
+    return success;
+}
+
+// Called with the pool locked
+MBlockCache::Line *MBlockCache::fetch( uint32_t block, bool fill )
+{
+    uint32_t set_index = (((uintptr_t)this / sizeof(MBlockCache)) + block) % _pool.sets;
+    Line *set = &_pool.lines[set_index * CACHE_WAYS];
+    Line *oldest = set;
+
+    for ( uint8_t i = 0; i < CACHE_WAYS; i++ )
+    {
+        if ( set[i].owner == this && set[i].block == block )
+        {
+            hits++;
+            set[i].used = ++_pool.clock;
+            return &set[i];
+        }
+
+        if ( set[i].used < oldest->used )
+            oldest = &set[i];
+    }
+
+    // A line of another stream is written back through that stream
+    misses++;
+    if ( oldest->dirty && !oldest->owner->writeBack( *oldest ) )
+        return nullptr;
+
+    // Taken and most recent before the source is read, a nested
+    // image reading its container doesn't pick the same line
+    Line &line = *oldest;
+    line.owner = this;
+    line.block = block;
+    line.used = ++_pool.clock;
+    line.length = 0;
+    line.dirty = false;
+
+    if ( fill )
+    {
+        if ( !_source->seek(block * CACHE_BLOCK_SIZE) )
+        {
+            line.owner = nullptr;
+            return nullptr;
+        }
+
+        // Network sources hand out what they have, fill the whole block
+        while ( line.length < CACHE_BLOCK_SIZE )
+        {
+            uint32_t n = _source->read(data(line) + line.length, CACHE_BLOCK_SIZE - line.length);
+            if ( !n )
+                break;
+            line.length += n;
+        }
+    }
+
+    // Past the end of the source, written bytes follow zeros
+    memset(data(line) + line.length, 0, CACHE_BLOCK_SIZE - line.length);
+
+    return &line;
+}
+
+bool MBlockCache::writeBack( Line &line )
+{
+    // Always seeked, files can't switch from reading to writing without
+    if ( !_source->seek(line.block * CACHE_BLOCK_SIZE) )
+        return false;
+
+    if ( _source->write(data(line), line.length) != line.length )
+    {
+        Debug_printv("write failed block[%d]", line.block);
+        return false;
+    }
+
+    // Seeking hands buffered output on to the file
+    writeBacks++;
+    line.dirty = false;
+    return _source->seek( _source->position() );
+}
+
+// Called with the pool locked. Copies other streams of the file hold of
+// a block about to be written are handed on and dropped. Ours is read
+// again if they had changed it, so both writes end up in the block
+void MBlockCache::claim( uint32_t block )
+{
+    if ( _source->url.empty() )
+        return;
+
+    bool changed = false;
+    for ( auto &line : _pool.lines )
+    {
+        MBlockCache *other = line.owner;
+        if ( other == nullptr || other == this || line.block != block || other->_source->url != _source->url )
+            continue;
+
+        if ( line.dirty )
+            changed |= other->writeBack( line );
+        line.owner = nullptr;
+        line.dirty = false;
+        line.used = 0;
+    }
+
+    if ( !changed )
+        return;
+
+    for ( auto &line : _pool.lines )
+    {
+        if ( line.owner == this && line.block == block )
+        {
+            if ( line.dirty )
+                writeBack( line );
+            line.owner = nullptr;
+            line.used = 0;
+        }
+    }
+}
+
+// The lines of a stream that goes away are free for others
+void MBlockCache::drop()
+{
+    if ( !_pool.sets )
+        return;
+
+    lock();
+    for ( auto &line : _pool.lines )
+    {
+        if ( line.owner == this )
+        {
+            line.owner = nullptr;
+            line.dirty = false;
+            line.used = 0;
+        }
+    }
+    unlock();
+}
@@ -0,0 +1,100 @@
+#ifndef MEATLOAF_CACHE
+#define MEATLOAF_CACHE
+
+#include <memory>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "meat_stream.h"
+
+// Blocks shared by all streams, build flags can change them
+#ifndef CACHE_BLOCKS
+#define CACHE_BLOCKS        16      // 4K of internal RAM
+#endif
+#ifndef CACHE_BLOCKS_PSRAM
+#define CACHE_BLOCKS_PSRAM  256     // 64K when there is PSRAM
+#endif
+#define CACHE_WAYS          4
+#define CACHE_BLOCK_SIZE    256
+
+
+/********************************************************
+ * Block cache
+ ********************************************************/
+
+// Sits between an image stream and the file it reads, so the directory
+// and BAM blocks that are read over and over come from RAM. All caches
+// take their blocks from one pool of CACHE_BLOCKS_PSRAM (or CACHE_BLOCKS)
+// lines, however many images are open. A block goes into one of
+// CACHE_WAYS lines picked by its stream and number, the least recently
+// used one is replaced. Writes stay in the pool until the line is
+// replaced, flush() or close(). Flushing drops the blocks other streams
+// hold of the same file, so they read what was written.
+class MBlockCache : public MStream
+{
+public:
+    MBlockCache(std::shared_ptr<MStream> source);
+    ~MBlockCache();
+
+    uint32_t available() override { return (_size > _position) ? _size - _position : 0; };
+    uint32_t size() override { return _size; };
+    uint32_t position() override { return _position; };
+    size_t error() override { return _source->error(); };
+
+    bool isOpen() override { return _source->isOpen(); };
+    bool isBrowsable() override { return _source->isBrowsable(); };
+    bool isRandomAccess() override { return _source->isRandomAccess(); };
+
+    bool open() override { return _source->open(); };
+    void close() override;
+
+    uint32_t read(uint8_t* buf, uint32_t size) override;
+    uint32_t write(const uint8_t *buf, uint32_t size) override;
+    bool seek(uint32_t pos) override;
+    bool flush() override;
+
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t writeBacks = 0;
+
+private:
+    struct Line
+    {
+        MBlockCache *owner;     // nullptr when empty
+        uint32_t block;
+        uint32_t used;          // Last use, lower is older
+        uint16_t length;        // Bytes of the block in the source
+        bool dirty;
+    };
+
+    // The lines of all caches, allocated when the first cache is made
+    struct Pool
+    {
+        Pool();
+
+        SemaphoreHandle_t lock;
+        uint8_t *data = nullptr;
+        std::vector<Line> lines;
+        uint16_t sets = 0;
+        uint32_t clock = 0;
+    };
+    static Pool &pool();
+
+    std::shared_ptr<MStream> _source;
+    uint32_t _size = 0;
+    uint32_t _position = 0;
+    Pool &_pool;
+    bool _written = false;      // Since the last flush
+
+    Line *fetch( uint32_t block, bool fill = true );
+    uint8_t *data( const Line &line ) { return &_pool.data[(&line - &_pool.lines[0]) * CACHE_BLOCK_SIZE]; };
+    bool writeBack( Line &line );
+    void claim( uint32_t block );
+    void drop();
+    void lock() { xSemaphoreTakeRecursive(_pool.lock, portMAX_DELAY); };
+    void unlock() { xSemaphoreGiveRecursive(_pool.lock); };
+};
+
+#endif // MEATLOAF_CACHE
@@ -0,0 +1,169 @@
+#include "meat_copy.h"
+
+#include "../../include/debug.h"
+
+// How often blocked tasks look for an abort
+#define COPY_POLL   pdMS_TO_TICKS(100)
+
+MCopy::MCopy(std::vector<std::shared_ptr<MStream>> sources, std::shared_ptr<MStream> destination)
+    : _state(std::make_shared<State>())
+{
+    _state->sources = sources;
+    _state->destination = destination;
+    for ( auto &s : sources )
+        _state->total += s->size();
+}
+
+MCopy::~MCopy()
+{
+    // A task can be stuck in a read from the network, it isn't waited
+    // for. Each holds the state and stops at its next buffer
+    _state->abort = true;
+}
+
+MCopy::State::~State()
+{
+    if ( free != nullptr )
+        vQueueDelete(free);
+    if ( full != nullptr )
+        vQueueDelete(full);
+}
+
+bool MCopy::start()
+{
+    auto &c = *_state;
+    c.buffers.reset(new (std::nothrow) uint8_t[COPY_BUFFERS * COPY_BUFFER_SIZE]);
+    c.free = xQueueCreate(COPY_BUFFERS, sizeof(uint8_t));
+    c.full = xQueueCreate(COPY_BUFFERS + 1, sizeof(Block));
+    if ( c.buffers == nullptr || c.free == nullptr || c.full == nullptr )
+    {
+        c.failed = c.done = true;
+        return false;
+    }
+
+    for ( uint8_t i = 0; i < COPY_BUFFERS; i++ )
+        xQueueSend(c.free, &i, 0);
+
+    // Without a reader the writer is stopped again
+    if ( !startTask(writer, "ml_copy_writer") || !startTask(reader, "ml_copy_reader") )
+    {
+        c.abort = true;
+        c.failed = c.done = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool MCopy::startTask(TaskFunction_t task, const char *name)
+{
+    // The task deletes its reference to the state when it ends
+    auto *state = new (std::nothrow) std::shared_ptr<State>(_state);
+    if ( state == nullptr )
+        return false;
+
+    if ( xTaskCreatePinnedToCore(task, name, 4096, state, 5, NULL, 0) != pdPASS )
+    {
+        delete state;
+        return false;
+    }
+
+    return true;
+}
+
+uint8_t MCopy::percent()
+{
+    auto &c = *_state;
+    if ( !c.total )
+        return c.done ? 100 : 0;
+
+    uint32_t p = ((uint64_t)c.copied * 100) / c.total;
+    return (p > 100) ? 100 : p;
+}
+
+void MCopy::reader(void *arg)
+{
+    std::shared_ptr<State> *state = (std::shared_ptr<State> *)arg;
+    State *c = state->get();
+    Block b = { COPY_BUFFERS, 0 };
+
+    for ( auto &s : c->sources )
+    {
+        while ( !c->abort )
+        {
+            uint8_t index;
+            if ( xQueueReceive(c->free, &index, COPY_POLL) != pdTRUE )
+                continue;
+
+            // Network streams hand out a segment at a time, fill the whole
+            // buffer so the destination sees few large writes
+            uint8_t *buffer = &c->buffers[index * COPY_BUFFER_SIZE];
+            uint32_t length = 0;
+            while ( length < COPY_BUFFER_SIZE && !c->abort )
+            {
+                uint32_t n = s->read(buffer + length, COPY_BUFFER_SIZE - length);
+                if ( !n )
+                    break;
+                length += n;
+            }
+
+            // There is room for every buffer and the end marker
+            if ( length )
+            {
+                Block f = { index, (uint16_t)length };
+                xQueueSend(c->full, &f, 0);
+            }
+            else
+                xQueueSend(c->free, &index, 0);
+
+            if ( length < COPY_BUFFER_SIZE )
+            {
+                if ( s->error() )
+                    c->failed = true;
+                break;
+            }
+        }
+
+        if ( c->failed || c->abort )
+            break;
+    }
+
+    // End marker, the writer finishes up
+    xQueueSend(c->full, &b, 0);
+
+    delete state;
+    vTaskDelete(NULL);
+}
+
+void MCopy::writer(void *arg)
+{
+    std::shared_ptr<State> *state = (std::shared_ptr<State> *)arg;
+    State *c = state->get();
+
+    while ( !c->abort )
+    {
+        Block b;
+        if ( xQueueReceive(c->full, &b, COPY_POLL) != pdTRUE )
+            continue;
+
+        if ( b.index == COPY_BUFFERS )
+            break;
+
+        if ( c->destination->write(&c->buffers[b.index * COPY_BUFFER_SIZE], b.length) != b.length )
+        {
+            Debug_printv("write failed at [%d]", c->copied);
+            c->failed = true;
+            c->abort = true;
+            break;
+        }
+
+        c->copied += b.length;
+        xQueueSend(c->free, &b.index, 0);
+    }
+
+    c->destination->close();
+    c->done = true;
+
+    delete state;
+    vTaskDelete(NULL);
+}
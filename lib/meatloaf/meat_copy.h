@@ -0,0 +1,73 @@
+#ifndef MEATLOAF_COPY
+#define MEATLOAF_COPY
+
+#include <memory>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include "meat_stream.h"
+
+#define COPY_BUFFERS        4
+#define COPY_BUFFER_SIZE    8192
+
+
+/********************************************************
+ * Stream to stream copy
+ ********************************************************/
+
+// One task reads the sources, one after the other, into a ring of
+// buffers while a second one writes the filled buffers out, so a slow
+// source and a slow destination are busy at the same time. start()
+// returns right away, done() and the counters tell how far it got.
+// Destroying an MCopy doesn't wait, the tasks stop at their next buffer
+// and the last one frees what they share.
+class MCopy
+{
+public:
+    MCopy(std::vector<std::shared_ptr<MStream>> sources, std::shared_ptr<MStream> destination);
+    ~MCopy();
+
+    bool start();
+
+    bool done() { return _state->done; };
+    bool failed() { return _state->failed; };
+    uint32_t copied() { return _state->copied; };
+    uint32_t total() { return _state->total; };
+    uint8_t percent();
+
+private:
+    struct Block
+    {
+        uint8_t index;          // COPY_BUFFERS marks the end
+        uint16_t length;
+    };
+
+    // Held by the MCopy and by each task
+    struct State
+    {
+        ~State();
+
+        std::vector<std::shared_ptr<MStream>> sources;
+        std::shared_ptr<MStream> destination;
+
+        std::unique_ptr<uint8_t[]> buffers;
+        QueueHandle_t free = nullptr;       // Buffers to read into
+        QueueHandle_t full = nullptr;       // Buffers to write out
+
+        volatile bool abort = false;
+        volatile bool done = false;
+        volatile bool failed = false;
+        volatile uint32_t copied = 0;
+        uint32_t total = 0;
+    };
+    std::shared_ptr<State> _state;
+
+    bool startTask(TaskFunction_t task, const char *name);
+    static void reader(void *arg);
+    static void writer(void *arg);
+};
+
+#endif // MEATLOAF_COPY
@@ -16,8 +16,11 @@
 //#include "wrappers/directory_stream.h"
 
 // Archive
+#include "archive/lnx.h"
+#include "archive/zip.h"
 
 // Cartridge
+#include "cartridge/crt.h"
 
 // Device
 #include "device/flash.h"
@@ -25,6 +28,8 @@
 
 // Disk
 #include "disk/d64.h"
+#include "disk/g64.h"
+#include "disk/nib.h"
 #include "disk/d71.h"
 #include "disk/d80.h"
 #include "disk/d81.h"
@@ -41,10 +46,10 @@
 #include "network/http.h"
 #include "network/ml.h"
 #include "network/tnfs.h"
+#include "network/cs.h"
 // #include "network/ipfs.h"
 // #include "network/tnfs.h"
 // #include "network/smb.h"
-// #include "network/cs.h"
 // #include "network/ws.h"
 
 // Tape
@@ -65,9 +70,9 @@ SDFileSystem sdFS;
 HttpFileSystem httpFS;
 MLFileSystem mlFS;
 TNFSFileSystem tnfsFS;
+CServerFileSystem csFS;
 // IPFSFileSystem ipfsFS;
 // TNFSFileSystem tnfsFS;
-// CServerFileSystem csFS;
 // TcpFileSystem tcpFS;
 
 //WSFileSystem wsFS;
@@ -77,6 +82,8 @@ P00FileSystem p00FS;
 
 // Disk
 D64FileSystem d64FS;
+G64FileSystem g64FS;
+NIBFileSystem nibFS;
 D71FileSystem d71FS;
 D80FileSystem d80FS;
 D81FileSystem d81FS;
@@ -86,12 +93,16 @@ DNPFileSystem dnpFS;
 D8BFileSystem d8bFS;
 DFIFileSystem dfiFS;
 
+// Archive
+LNXFileSystem lnxFS;
+ZipFileSystem zipFS;
+
 // Tape
 T64FileSystem t64FS;
 TCRTFileSystem tcrtFS;
 
 // Cartridge
-
+CRTFileSystem crtFS;
 
 
 // put all available filesystems in this array - first matching system gets the file!
@@ -102,10 +113,12 @@ std::vector<MFileSystem*> MFSOwner::availableFS {
     &sdFS,
 #endif
     &p00FS,
-    &d64FS, &d71FS, &d80FS, &d81FS, &d82FS, &dnpFS,
+    &d64FS, &g64FS, &nibFS, &d71FS, &d80FS, &d81FS, &d82FS, &dnpFS,
     &d8bFS, &dfiFS,
+    &lnxFS, &zipFS,
     &t64FS, &tcrtFS,
-    &httpFS, &mlFS, &tnfsFS
+    &crtFS,
+    &httpFS, &mlFS, &tnfsFS, &csFS
 //    &ipfsFS, &tcpFS,
 //    &tnfsFS
 };
@@ -158,10 +171,14 @@ MFile* MFSOwner::File(std::shared_ptr<MFile> file) {
 MFile* MFSOwner::File(std::string path) {
     //Debug_printv("in File\r\n");
 
-    // if(mstr::startsWith(path,"cs:", false)) {
-    //     //Serial.printf("CServer path found!\r\n");
-    //     return csFS.getFile(path);
-    // }
+    if(mstr::startsWith(path,"cs:", false)) {
+        // CommodoreServer mounts and lists images server side, so the
+        // whole path (images included) belongs to the cs: session
+        //Debug_printv("CServer path found!");
+        auto newFile = csFS.getFile(path);
+        newFile->streamFile = csFS.getFile(path);
+        return newFile;
+    }
 
     // // If it's a local file wildcard match and return full path
     // if ( device_config.image().empty() )
@@ -64,6 +64,10 @@ public:
     // has to return OPENED stream
     virtual MStream* meatStream();
 
+    // OPENED stream to write a new file, created or emptied.
+    // Only file systems that can create files have one
+    virtual MStream* createStream() { return nullptr; };
+
     virtual MFile* cd(std::string newDir);
     virtual bool isDirectory() = 0;
     virtual bool rewindDirectory() = 0 ;
@@ -78,6 +82,10 @@ public:
     virtual uint32_t size() = 0;
     virtual uint64_t getAvailableSpace();
 
+    // DOS N and V on the disk image this file is the root of
+    virtual bool format(std::string header, std::string id = "") { return false; };
+    virtual bool validate() { return false; };
+
     virtual bool isText() {
         return mstr::isText(extension);
     }
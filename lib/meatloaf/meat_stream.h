@@ -44,6 +44,8 @@ public:
     virtual bool isOpen() = 0;
     virtual bool isBrowsable() { return false; };
     virtual bool isRandomAccess() { return false; };
+    // PRINT# data can be written in place (REL records, "#" buffers)
+    virtual bool isUpdatable() { return false; };
 
     virtual void close() = 0;
     virtual bool open() = 0;
@@ -51,6 +53,9 @@ public:
     virtual uint32_t write(const uint8_t *buf, uint32_t size) = 0;
     virtual uint32_t read(uint8_t* buf, uint32_t size) = 0;
 
+    // Hands on writes that are held back
+    virtual bool flush() { return true; };
+
     uint8_t secondaryAddress = 0;
     std::string url = "";
 
@@ -84,6 +89,15 @@ public:
     virtual bool seekBlock( uint64_t index, uint8_t offset = 0 ) { return false; };
     virtual bool seekSector( uint8_t track, uint8_t sector, uint8_t offset = 0 ) { return false; };
     virtual bool seekSector( std::vector<uint8_t> trackSectorOffset ) { return false; };
+
+    // For REL files, record and offset are 1 based like the DOS P command
+    virtual bool seekRecord( uint16_t record, uint8_t offset = 1 ) { return false; };
+
+    // Direct access ("#" channels) holds one block, reads and writes go to
+    // it at the buffer pointer that seek() sets. Counted blocks keep their
+    // length in the first byte, like B-R and B-W
+    virtual bool readSector( uint8_t track, uint8_t sector, bool counted = false ) { return false; };
+    virtual bool writeSector( uint8_t track, uint8_t sector, bool counted = false ) { return false; };
 };
 
 
@@ -1,5 +1,7 @@
 #include "cs.h"
 
+#include <algorithm>
+
 #include "make_unique.h"
 
 /********************************************************
@@ -11,119 +13,318 @@
 CServerSessionMgr CServerFileSystem::session;
 
 bool CServerSessionMgr::establishSession() {
-    if(!buf.is_open()) {
-        currentDir = "cs:/";
-        buf.open();
+    if(!m_socket.isOpen()) {
+        currentDir = "";
+        m_rxpos = m_rxlen = 0;
+        bool ok = m_socket.open(CSERVER_HOST, CSERVER_PORT);
+        Debug_printv("connect to cserver returned: %d", ok);
+        if(!ok)
+            m_socket.close();
     }
-    
-    return buf.is_open();
+
+    return m_socket.isOpen();
+}
+
+bool CServerSessionMgr::reconnect() {
+    // Drop the dead connection and get back to where we were, so the
+    // caller can retry its command as if nothing happened
+    if(m_reconnecting)
+        return false;
+
+    std::string resumeDir = currentDir;
+
+    Debug_printv("reconnecting, resume in [%s]", resumeDir.c_str());
+    m_socket.close();
+    if(!establishSession())
+        return false;
+
+    if(resumeDir.empty())
+        return true;
+
+    m_reconnecting = true;
+    auto dir = std::make_unique<CServerFile>(resumeDir);
+    bool ok = traversePath(dir.get());
+    m_reconnecting = false;
+
+    return ok;
+}
+
+// Refill the receive buffer, waiting up to CSERVER_READ_TIMEOUT for data
+bool CServerSessionMgr::fill() {
+    if(m_rxpos < m_rxlen)
+        return true;
+
+    m_rxpos = m_rxlen = 0;
+
+    uint32_t waited = 0;
+    while(m_socket.isOpen()) {
+        int rc = m_socket.read(m_rxbuf, CSERVER_RX_BUFFER_SIZE);
+        if(rc > 0) {
+            m_rxlen = rc;
+            return true;
+        }
+        if(rc == 0) {
+            // orderly shutdown from the server
+            Debug_printv("connection closed by server");
+            m_socket.close();
+            break;
+        }
+        if(waited >= CSERVER_READ_TIMEOUT)
+            break;
+
+        fnSystem.delay(CSERVER_POLL_DELAY);
+        waited += CSERVER_POLL_DELAY;
+    }
+
+    return false;
+}
+
+// Throw away anything left over from a previous reply
+void CServerSessionMgr::discardInput() {
+    m_rxpos = m_rxlen = 0;
+    while(m_socket.isOpen() && m_socket.read(m_rxbuf, CSERVER_RX_BUFFER_SIZE) > 0);
+}
+
+size_t CServerSessionMgr::receive(uint8_t* buffer, size_t size) {
+    size_t total = 0;
+
+    while(total < size) {
+        if(!fill())
+            break;
+
+        size_t n = std::min(size - total, m_rxlen - m_rxpos);
+        memcpy(buffer + total, m_rxbuf + m_rxpos, n);
+        m_rxpos += n;
+        total += n;
+    }
+
+    return total;
 }
 
 std::string CServerSessionMgr::readLn() {
-    char buffer[80];
-    // telnet line ends with 10;
-    getline(buffer, 80, 10);
-    Debug_printv("Inside readln got: '%s'", buffer);
-    return std::string((char *)buffer);
+    // telnet line ends with 10, listings end with 4
+    std::string line;
+
+    while(fill()) {
+        uint8_t* start = m_rxbuf + m_rxpos;
+        size_t len = m_rxlen - m_rxpos;
+
+        uint8_t* eol = (uint8_t*)memchr(start, 10, len);
+        uint8_t* eot = (uint8_t*)memchr(start, 4, len);
+        if(eot != nullptr && (eol == nullptr || eot < eol)) {
+            line.append((char *)start, eot - start + 1);
+            m_rxpos += eot - start + 1;
+            break;
+        }
+        if(eol != nullptr) {
+            line.append((char *)start, eol - start);
+            m_rxpos += eol - start + 1;
+            break;
+        }
+
+        line.append((char *)start, len);
+        m_rxpos = m_rxlen;
+    }
+
+    //Debug_printv("Inside readln got: '%s'", line.c_str());
+    return line;
 }
 
 bool CServerSessionMgr::sendCommand(std::string command) {
-    // 13 (CR) sends the command
-    if(establishSession()) {
-        Serial.printf("CServer: send command: %s\r\n", command.c_str());
-        (*this) << (command+'\r');
-        (*this).flush();
-        return true;
+    return sendCommands({ command });
+}
+
+bool CServerSessionMgr::sendCommands(const std::vector<std::string> &commands) {
+    // 13 (CR) sends a command; all of them go out in one write and the
+    // replies are read back in order by the caller
+    std::string batch;
+    for(auto &c : commands) {
+        Debug_printv("send command: %s", c.c_str());
+        batch += c + '\r';
     }
-    else
-        return false;
+
+    for(int attempt = 0; attempt < 2; attempt++) {
+        if(!establishSession())
+            return false;
+
+        discardInput();
+        if(m_socket.write(batch.data(), batch.size()) == batch.size())
+            return true;
+
+        if(attempt == 0 && !reconnect())
+            return false;
+    }
+
+    return false;
 }
 
 bool CServerSessionMgr::isOK() {
-    // auto a = readLn();
-
     auto reply = readLn();
     // for(int i = 0 ; i<reply.length(); i++)
     //     Debug_printv("'%d'", reply[i]);
 
-    bool equals = strncmp("00 - OK\x0d", reply.c_str(), 7);
+    bool ok = (reply.find("00 - OK") != std::string::npos);
 
-    //Debug_printv("Testing of OK, got:'%s', %d", reply.c_str(), equals);
+    //Debug_printv("Testing of OK, got:'%s', %d", reply.c_str(), ok);
 
-    return equals;
+    return ok;
 }
 
 bool CServerSessionMgr::traversePath(MFile* path) {
-    // tricky. First we have to
-    // CF / - to go back to root
-
     //Debug_printv("Traversing path: [%s]", path->path.c_str());
 
-    if(buf.is_open()) {
-        // if we are still connected we can smart change dir by just going up or down
-        // but for time being, we stick to traversing from root
-        if(!sendCommand("cf /"))
-            return false;
+    // Only the directories up to (and including) a disk image matter,
+    // anything after that is a file inside the image
+    std::vector<std::string> target;
+    for(auto &part : mstr::split(path->path, '/')) {
+        if(part.empty())
+            continue;
+        target.push_back(part);
+        if(mstr::endsWith(part, ".d64", false))
+            break;
     }
-    else {
-        // if we aren't, change dir to root (alos connects the session);
-        if(!sendCommand("cf /"))
-            return false;
+    std::string targetDir = "cs:/" + mstr::joinToString(target, "/");
+
+    if(!establishSession())
+        return false;
+
+    if(currentDir == targetDir)
+        return true;
+
+    // If we're in a plain directory above the target we can just walk
+    // down from there, otherwise start over from the root
+    std::vector<std::string> commands;
+    size_t start = 0;
+    if(!currentDir.empty() && !mstr::endsWith(currentDir, ".d64", false)) {
+        std::vector<std::string> here;
+        for(auto &part : mstr::split(mstr::drop(currentDir, 4), '/'))
+            if(!part.empty())
+                here.push_back(part);
+
+        if(here.size() <= target.size() && std::equal(here.begin(), here.end(), target.begin()))
+            start = here.size();
     }
+    if(start == 0)
+        commands.push_back("cf /");
 
-    Debug_printv("here");
-    if(isOK()) {
-        Debug_printv("path[%s]", path->path.c_str());
-        if(path->path.compare("/") == 0) {
-            currentDir = path->url;
-            return true;
+    for(size_t i = start; i < target.size(); i++) {
+        if(mstr::endsWith(target[i], ".d64", false))
+            // THEN we have to mount the image INSERT image_name
+            commands.push_back("insert " + target[i]);
+        else
+            // CF xxx - to browse into subsequent dirs
+            commands.push_back("cf " + target[i]);
+    }
+
+    if(!sendCommands(commands))
+        return false;
+
+    // Read every reply even after a failure so the session stays in step
+    // or: ?500 - CANNOT CHANGE TO dupa
+    // or: ?500 - DISK NOT FOUND.
+    bool ok = true;
+    for(size_t i = 0; i < commands.size(); i++)
+        ok = isOK() && ok;
+
+    // Where the server ended up is anyone's guess after a failure
+    currentDir = ok ? targetDir : "";
+    return ok;
+}
+
+const CServerSessionMgr::DirListing* CServerSessionMgr::listDirectory(CServerFile* dir) {
+    auto cached = dirCache.find(dir->url);
+    if(cached != dirCache.end())
+        return &cached->second;
+
+    if(!traversePath(dir))
+        return nullptr;
+
+    DirListing listing;
+
+    if(mstr::endsWith(dir->path, ".d64", false))
+    {
+        // to list image contents we have to run
+        Debug_printv("cserver: this is a d64 img, sending $ command!");
+        if(!sendCommand("$"))
+            return nullptr;
+
+        auto line = readLn(); // mounted image name
+        if(!is_open())
+            return nullptr;
+        if(line.size() > 5)
+            listing.media_image = line.substr(5);
+
+        line = readLn(); // dir header
+        auto quote = line.find_last_of("\"");
+        if(quote != std::string::npos && quote > 2) {
+            listing.media_header = line.substr(2, quote);
+            listing.media_id = line.substr(std::min(quote + 2, line.size()));
         }
 
-        std::vector<std::string> chopped = mstr::split(path->path, '/');
-
-        //MFile::parsePath(&chopped, path->path); - nope this doessn't work and crases in the loop!
-
-        Debug_printv("Before loop");
-        //Debug_printv("Chopped size:%d\r\n", chopped.size());
-        fnSystem.delay(500);
-
-        for(size_t i = 1; i < chopped.size(); i++) {
-            //Debug_printv("Before chopped deref");
-
-            auto part = chopped[i];
-            
-            //Debug_printv("traverse path part: [%s]\r\n", part.c_str());
-            if(mstr::endsWith(part, ".d64", false)) 
-            {
-                // THEN we have to mount the image INSERT image_name
-                sendCommand("insert "+part);
-
-                // disk image is the end, so return
-                if(isOK()) {
-                    currentDir = path->url;
-                    return true;
-                }
-                else {
-                    // or: ?500 - DISK NOT FOUND.
-                    return false;
-                }
-            }
-            else 
-            {
-                // CF xxx - to browse into subsequent dirs
-                sendCommand("cf "+part);
-                if(!isOK()) {
-                    // or: ?500 - CANNOT CHANGE TO dupa
-                    return false;
-                }
+        // 'ot line:'2   "CIE+SERIAL      " PRG   2049
+        // 'ot line:'658 BLOCKS FREE.
+        while(is_open()) {
+            line = readLn();
+            if(line.empty() || line.find('\x04') != std::string::npos)
+                break;
+            if(line.find("BLOCKS FREE.") != std::string::npos) {
+                listing.media_blocks_free = atoi(line.substr(0, line.find_first_of(" ")).c_str());
+                break;
             }
+            if(line.size() <= 5)
+                continue;
+
+            DirEntry entry;
+            entry.name = line.substr(5, 15);
+            entry.size = atoi(line.substr(0, line.find_first_of(" ")).c_str());
+            mstr::rtrim(entry.name);
+            listing.entries.push_back(entry);
         }
-        
-        currentDir = path->url;
-        return true;
     }
     else
-        return false; // shouldn't really happen, right?
+    {
+        // to list directory contents we use
+        if(!sendCommand("disks"))
+            return nullptr;
+
+        auto line = readLn(); // dir header
+        if(!is_open())
+            return nullptr;
+        auto bracket = line.find_last_of("]");
+        if(line.size() > 2 && bracket != std::string::npos)
+            listing.media_header = line.substr(2, bracket - 1);
+        listing.media_id = "C=SVR";
+
+        // 'ot line:'EMPTY.D64
+        // 32 62 91 68 73 83 75 32 84 79 79 76 83 93 13 No more! = > [DISK TOOLS]
+        while(is_open()) {
+            line = readLn();
+            if(line.empty() || line.find('\x04') != std::string::npos)
+                break;
+
+            DirEntry entry;
+            if((*line.begin())=='[') {
+                entry.name = line.substr(1, line.length() > 3 ? line.length()-3 : 0);
+                entry.size = 0;
+            }
+            else {
+                entry.name = line.substr(0, line.length()-1);
+                entry.size = 683;
+            }
+
+            if(entry.name.size() > 0)
+                listing.entries.push_back(entry);
+        }
+    }
+
+    // Keep a handful of listings, dropping the oldest
+    if(dirCacheOrder.size() >= CSERVER_CACHE_DIRS) {
+        dirCache.erase(dirCacheOrder.front());
+        dirCacheOrder.erase(dirCacheOrder.begin());
+    }
+    dirCacheOrder.push_back(dir->url);
+
+    return &(dirCache[dir->url] = listing);
 }
 
 /********************************************************
@@ -149,10 +350,12 @@ bool CServerIStream::open() {
         // trim spaces from right of name too
         mstr::rtrimA0(file->name);
         mstr::toPETSCII(file->name);
-        CServerFileSystem::session.sendCommand("load "+file->name);
+        if(!CServerFileSystem::session.sendCommand("load "+file->name))
+            return false;
+
         // read first 2 bytes with size, low first, but may also reply with: ?500 - ERROR
         uint8_t buffer[2] = { 0, 0 };
-        read(buffer, 2);
+        CServerFileSystem::session.receive(buffer, 2);
         // hmmm... should we check if they're "?5" for error?!
         if(buffer[0]=='?' && buffer[1]=='5') {
             Debug_printv("CServer: open file failed");
@@ -160,9 +363,11 @@ bool CServerIStream::open() {
             m_isOpen = false;
         }
         else {
-            m_bytesAvailable = buffer[0] + buffer[1]*256; // put len here
+            m_length = buffer[0] + buffer[1]*256; // put len here
+            m_bytesAvailable = m_length;
+            m_position = 0;
             // if everything was ok
-            Serial.printf("CServer: file open, size: %d\r\n", m_bytesAvailable);
+            Debug_printv("CServer: file open, size: %d", m_length);
             m_isOpen = true;
         }
     }
@@ -170,13 +375,34 @@ bool CServerIStream::open() {
     return m_isOpen;
 };
 
+// Connection dropped mid-transfer: load the file again and skip what
+// we've already handed out
+bool CServerIStream::resume() {
+    uint32_t position = m_position;
+
+    Debug_printv("CServer: resuming at %d", position);
+    if(!CServerFileSystem::session.reconnect() || !open())
+        return false;
+
+    uint8_t skip[64];
+    while(m_position < position) {
+        uint32_t n = CServerFileSystem::session.receive(skip, std::min((uint32_t)sizeof(skip), position - m_position));
+        if(n == 0)
+            return false;
+        m_position += n;
+        m_bytesAvailable -= n;
+    }
+
+    return true;
+}
+
 // MStream methods
 uint32_t CServerIStream::available() {
     return m_bytesAvailable;
 };
 
 uint32_t CServerIStream::size() {
-    return m_bytesAvailable;
+    return m_length;
 };
 
 uint32_t CServerIStream::position() {
@@ -193,7 +419,18 @@ uint32_t CServerIStream::write(const uint8_t *buf, uint32_t size) {
 
 uint32_t CServerIStream::read(uint8_t* buf, uint32_t size)  {
     //Debug_printv("CServerIStream::read");
+    if(size > m_bytesAvailable)
+        size = m_bytesAvailable;
+
     auto bytesRead = CServerFileSystem::session.receive(buf, size);
+    if(bytesRead < size && !CServerFileSystem::session.is_open()) {
+        m_bytesAvailable-=bytesRead;
+        m_position+=bytesRead;
+        if(!resume())
+            return bytesRead;
+        return bytesRead + read(buf + bytesRead, size - bytesRead);
+    }
+
     m_bytesAvailable-=bytesRead;
     m_position+=bytesRead;
     //ledTogg(true);
@@ -343,151 +580,51 @@ MStream* CServerFile::meatStream() {
     return istream;
 }; 
 
-bool CServerFile::rewindDirectory() {    
+bool CServerFile::rewindDirectory() {
     dirIsOpen = false;
 
     if(!isDirectory())
         return false;
 
+    // Listings are fetched once per session and replayed from the cache
+    auto listing = CServerFileSystem::session.listDirectory(this);
+    if(listing == nullptr)
+        return false;
 
-    Debug_printv("pre traverse path");
-
-    if(!CServerFileSystem::session.traversePath(this)) return false;
-
-    Debug_printv("post traverse path");
+    dirIsImage = mstr::endsWith(path, ".d64", false);
+    media_image = listing->media_image;
+    media_header = listing->media_header;
+    media_id = listing->media_id;
+    dirIndex = 0;
+    dirIsOpen = true;
 
-    if(mstr::endsWith(path, ".d64", false))
-    {
-        dirIsImage = true;
-        // to list image contents we have to run
-        Debug_printv("cserver: this is a d64 img, sending $ command!");
-        CServerFileSystem::session.sendCommand("$");
-        auto line = CServerFileSystem::session.readLn(); // mounted image name
-        if(CServerFileSystem::session.is_open()) {
-            dirIsOpen = true;
-            media_image = line.substr(5);
-            line = CServerFileSystem::session.readLn(); // dir header
-            media_header = line.substr(2, line.find_last_of("\""));
-            media_id = line.substr(line.find_last_of("\"")+2);
-            return true;
-        }
-        else
-            return false;
-    }
-    else 
-    {
-        dirIsImage = false;
-        // to list directory contents we use
-        //Debug_printv("cserver: this is a directory!");
-        CServerFileSystem::session.sendCommand("disks");
-        auto line = CServerFileSystem::session.readLn(); // dir header
-        if(CServerFileSystem::session.is_open()) {
-            media_header = line.substr(2, line.find_last_of("]")-1);
-            media_id = "C=SVR";
-            dirIsOpen = true;
-
-            return true;
-        }
-        else 
-            return false;
-    }
+    return true;
 };
 
 MFile* CServerFile::getNextFileInDir() {
 
-    Debug_printv("pre rewind");
-
     if(!dirIsOpen)
         rewindDirectory();
 
-    Debug_printv("pre dir is open");
-
     if(!dirIsOpen)
         return nullptr;
 
-    std::string name;
-    size_t size;
-    std::string new_url = url;
+    auto listing = CServerFileSystem::session.listDirectory(this);
+    if(listing == nullptr || dirIndex >= listing->entries.size()) {
+        if(listing != nullptr && dirIsImage)
+            media_blocks_free = listing->media_blocks_free;
+        dirIsOpen = false;
+        return nullptr;
+    }
 
+    auto &entry = listing->entries[dirIndex++];
+
+    std::string new_url = url;
     if(url.size()>4) // If we are not at root then add additional "/"
         new_url += "/";
+    new_url += entry.name;
 
-    Debug_printv("pre dir is image");
-
-    if(dirIsImage) {
-        auto line = CServerFileSystem::session.readLn();
-        Debug_printv("next file in dir got %s", line.c_str());
-        // 'ot line:'0 ␒"CIE�������������" 00�2A�
-        // 'ot line:'2   "CIE+SERIAL      " PRG   2049
-        // 'ot line:'1   "CIE-SYS31801    " PRG   2049
-        // 'ot line:'1   "CIE-SYS31801S   " PRG   2049
-        // 'ot line:'1   "CIE-SYS52281    " PRG   2049
-        // 'ot line:'1   "CIE-SYS52281S   " PRG   2049
-        // 'ot line:'658 BLOCKS FREE.
-
-        if(line.find('\x04')!=std::string::npos) {
-            Debug_printv("No more!");
-            dirIsOpen = false;
-            return nullptr;
-        }
-        if(line.find("BLOCKS FREE.")!=std::string::npos) {
-            media_blocks_free = atoi(line.substr(0, line.find_first_of(" ")).c_str());
-            dirIsOpen = false;
-            return nullptr;
-        }
-        else {
-            name = line.substr(5,15);
-            size = atoi(line.substr(0, line.find_first_of(" ")).c_str());
-            mstr::rtrim(name);
-            Debug_printv("xx: %s -- %s %d", line.c_str(), name.c_str(), size);
-            //return new CServerFile(path() +"/"+ name);
-            new_url += name;
-            return new CServerFile(new_url, size);
-        }
-    } else {
-        auto line = CServerFileSystem::session.readLn();
-        // Got line:''
-        // Got line:''
-        // 'ot line:'FAST-TESTER DELUXE EXCESS.D64
-        // 'ot line:'EMPTY.D64
-        // 'ot line:'CMD UTILITIES D1.D64
-        // 'ot line:'CBMCMD22.D64
-        // 'ot line:'NAV96.D64
-        // 'ot line:'NAV92.D64
-        // 'ot line:'SINGLE DISKCOPY 64 (1983)(KEVIN PICKELL).D64
-        // 'ot line:'LYNX (19XX)(-).D64
-        // 'ot line:'GEOS DISK EDITOR (1990)(GREG BADROS).D64
-        // 'ot line:'FLOPPY REPAIR KIT (1984)(ORCHID SOFTWARE LABORATOR
-        // 'ot line:'1541 DEMO DISK (19XX)(-).D64
-
-        // 32 62 91 68 73 83 75 32 84 79 79 76 83 93 13 No more! = > [DISK TOOLS]
-
-        if(line.find('\x04')!=std::string::npos) {
-            Debug_printv("No more!");
-            dirIsOpen = false;
-            return nullptr;
-        }
-        else {
-
-            if((*line.begin())=='[') {
-                name = line.substr(1,line.length()-3);
-                size = 0;
-            }
-            else {
-                name = line.substr(0, line.length()-1);
-                size = 683;
-            }
-
-            // Debug_printv("\nurl[%s] name[%s] size[%d]\r\n", url.c_str(), name.c_str(), size);
-            if(name.size() > 0)
-            {
-                new_url += name;
-                return new CServerFile(new_url, size);                
-            }
-            else
-                return nullptr;
-        }
-    }
+    return new CServerFile(new_url, entry.size);
 };
 
 bool CServerFile::exists() {
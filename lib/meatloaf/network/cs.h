@@ -9,194 +9,108 @@
 #include "tcp.h"
 
 #include "fnSystem.h"
-#include "fnTcpClient.h"
 
 #include "utils.h"
 #include "string_utils.h"
 
-#include <streambuf>
-#include <istream>
+#include <map>
+#include <vector>
 
-/********************************************************
- * Telnet buffer
- ********************************************************/
-
-class csstreambuf : public std::streambuf {
-    char* gbuf;
-    char* pbuf;
-
-protected:
-    MeatSocket m_wifi;
-
-public:
-    csstreambuf() {}
-
-    ~csstreambuf() {
-        close();
-    }      
-
-    bool is_open() {
-        return (m_wifi.isOpen());
-    }
-
-    bool open() {
-        if(m_wifi.isOpen())
-            return true;
-
-        int rc = m_wifi.open("commodoreserver.com", 1541);
-        Serial.printf("csstreambuf: connect to cserver returned: %d\r\n", rc);
-
-        if(rc == 1) {
-            if(gbuf == nullptr)
-                gbuf = new char[512];
-            if(pbuf == nullptr)
-                pbuf = new char[512];
-        }
+#define CSERVER_HOST "commodoreserver.com"
+#define CSERVER_PORT 1541
 
-        setp(pbuf, pbuf+512);
+#define CSERVER_RX_BUFFER_SIZE 512  // Receive buffer shared by line reader and file reads
+#define CSERVER_READ_TIMEOUT   5000 // ms to wait for the server to answer
+#define CSERVER_POLL_DELAY     10   // ms between polls of the (non-blocking) socket
+#define CSERVER_CACHE_DIRS     8    // Directory listings kept per session
 
-        return rc == 1;
-    }
-
-    void close() {
-        Serial.printf("csstreambuf: closing\r\n");
-        if(m_wifi.isOpen()) {
-            m_wifi.close();
-        }
-        if(gbuf != nullptr)
-            delete[] gbuf;
-        if(pbuf != nullptr)
-            delete[] pbuf;
-    }
 
-    int underflow() override {
-        Debug_printv("In underflow");
-        if (!m_wifi.isOpen()) {
-            Debug_printv("In connection closed");
-            close();
-            return std::char_traits<char>::eof();
-        }
-        else if (this->gptr() == this->egptr()) {
-            int readCount = 0;
-            int attempts = 5;
-            int wait = 500;
-            
-            readCount = m_wifi.read((uint8_t*)gbuf, 512);
-
-            while( readCount <= 0 && (attempts--)>0 && m_wifi.isOpen()) {
-                Debug_printv("got rc: %d, retrying", readCount);
-                fnSystem.delay(wait);
-                wait+=100;
-                readCount = m_wifi.read((uint8_t*)gbuf, 512);
-            } 
-            Debug_printv("read success: %d", readCount);
-            this->setg(gbuf, gbuf, gbuf + readCount);
-        }
-        else {
-            Debug_printv("else: %d - %d, (%d)", this->gptr(), this->egptr(), this->gbuf);
-        }
+/********************************************************
+ * Session manager
+ ********************************************************/
 
-        return this->gptr() == this->egptr()
-            ? std::char_traits<char>::eof()
-            : std::char_traits<char>::to_int_type(*this->gptr());
-    };
+class CServerFile;
 
+class CServerSessionMgr {
+    std::string m_user;
+    std::string m_pass;
+    MeatSocket m_socket;
 
-    int overflow(int ch  = traits_type::eof()) override
-    {
-        //Debug_printv("in overflow");
+    // Everything received goes through this buffer, so line reads and
+    // binary reads never lose bytes to each other
+    uint8_t m_rxbuf[CSERVER_RX_BUFFER_SIZE];
+    size_t m_rxpos = 0;
+    size_t m_rxlen = 0;
 
-        if (!m_wifi.isOpen()) {
-            close();
-            return EOF;
-        }
+    bool m_reconnecting = false;
 
-        char* end = pptr();
-        if ( ch != EOF ) {
-            *end ++ = ch;
-        }
+    bool fill();
+    void discardInput();
 
-        uint8_t* pBase = (uint8_t*)pbase();
-
-        if ( m_wifi.write( pBase, end - pbase() ) == 0 ) {
-            ch = EOF;
-        } else if ( ch == EOF ) {
-            ch = 0;
-        }
-        setp(pbuf, pbuf+512);
-        
-        return ch;
+protected:
+    struct DirEntry {
+        std::string name;
+        size_t size;
     };
 
-    int sync() { 
-
-        if (!m_wifi.isOpen()) {
-            close();
-            return 0;
-        }
-        if(pptr() == pbase()) {
-            return 0;
-        }
-        else {
-            //Debug_printv("in sync, written %d", pptr()-pbase());
-            uint8_t* buffer = (uint8_t*)pbase();
-            auto result = m_wifi.write(buffer, pptr()-pbase()); 
-            setp(pbuf, pbuf+512);
-            return (result != 0) ? 0 : -1;  
-        }  
+    struct DirListing {
+        std::string media_image;
+        std::string media_header;
+        std::string media_id;
+        uint16_t media_blocks_free = 65535;
+        std::vector<DirEntry> entries;
     };
 
-    friend class CServerSessionMgr;
-};
-
-/********************************************************
- * Session manager
- ********************************************************/
+    // Listings already read in this session, by url
+    std::map<std::string, DirListing> dirCache;
+    std::vector<std::string> dirCacheOrder;
 
-class CServerSessionMgr : public std::iostream {
-    std::string m_user;
-    std::string m_pass;
-    csstreambuf buf;
-
-protected:
+    // Directory or disk image the server is currently in ("" if unknown)
     std::string currentDir;
 
     bool establishSession();
+    bool reconnect();
 
     bool sendCommand(std::string);
-    
+    bool sendCommands(const std::vector<std::string> &commands);
+
     bool traversePath(MFile* path);
 
     bool isOK();
 
     std::string readLn();
 
+    const DirListing* listDirectory(CServerFile* dir);
+
 public:
-    CServerSessionMgr(std::string user = "", std::string pass = "") : std::iostream(&buf), m_user(user), m_pass(pass)
+    CServerSessionMgr(std::string user = "", std::string pass = "") : m_user(user), m_pass(pass)
     {};
 
     ~CServerSessionMgr() {
-        sendCommand("quit");
+        if(is_open()) {
+            sendCommand("quit");
+            m_socket.close();
+        }
     };
 
     // read/write are used only by MStream
-    size_t receive(uint8_t* buffer, size_t size) {
-        if(buf.is_open())
-            return buf.m_wifi.read(buffer, size);
-        else
-            return 0;
-    }
+    size_t receive(uint8_t* buffer, size_t size);
 
     // read/write are used only by MStream
     size_t send(const uint8_t* buffer, size_t size) {
-        if(buf.is_open())
-            return buf.m_wifi.write(buffer, size);
+        if(is_open())
+            return m_socket.write(buffer, size);
         else
             return 0;
     }
 
     bool is_open() {
-        return buf.is_open();
+        return m_socket.isOpen();
+    }
+
+    void invalidateCache() {
+        dirCache.clear();
+        dirCacheOrder.clear();
     }
 
     friend class CServerFile;
@@ -210,7 +124,7 @@ public:
 class CServerFile: public MFile {
 
 public:
-    CServerFile(std::string path, size_t size = 0): MFile(path), m_size(size) 
+    CServerFile(std::string path, size_t size = 0): MFile(path), m_size(size)
     {
         media_blocks_free = 65535;
         media_block_size = 1; // blocks are already calculated
@@ -236,14 +150,17 @@ public:
     bool rename(std::string dest) { return false; };
     time_t getLastWrite() override { return 0; };
     time_t getCreationTime() override { return 0; };
-    uint32_t size() override;     
+    uint32_t size() override;
 
     bool isDir = true;
     bool dirIsOpen = false;
 
 private:
     bool dirIsImage = false;
+    size_t dirIndex = 0;
     size_t m_size;
+
+    friend class CServerSessionMgr;
 };
 
 /********************************************************
@@ -278,9 +195,11 @@ public:
     bool isOpen() override;
 
 protected:
+    bool resume();
+
     std::string url;
-    bool m_isOpen;
-    uint32_t m_length;
+    bool m_isOpen = false;
+    uint32_t m_length = 0;
     uint32_t m_bytesAvailable = 0;
     uint32_t m_position = 0;
 };
@@ -291,12 +210,12 @@ protected:
  * FS
  ********************************************************/
 
-class CServerFileSystem: public MFileSystem 
+class CServerFileSystem: public MFileSystem
 {
     bool handles(std::string name) {
         return name == "cs:";
     }
-    
+
 public:
     CServerFileSystem(): MFileSystem("c=server") {};
     static CServerSessionMgr session;
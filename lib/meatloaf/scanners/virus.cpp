@@ -0,0 +1,44 @@
+#include "virus.h"
+
+#include "../../../include/debug.h"
+
+MVirusScan::MVirusScan(std::shared_ptr<MStream> source, bool block)
+    : block(block), _source(source)
+{
+    url = _source->url;
+    has_subdirs = _source->has_subdirs;
+}
+
+uint32_t MVirusScan::read(uint8_t* buf, uint32_t size)
+{
+    if ( block && detected )
+        return 0;
+
+    uint32_t n = _source->read(buf, size);
+
+    const auto &a = virus::automaton;
+    uint16_t s = _state;
+    for ( uint32_t i = 0; i < n; i++ )
+    {
+        s = s ? a.next(s, buf[i]) : a.root[buf[i]];
+        if ( a.state[s].match != virus::NONE && !detected )
+        {
+            detected = virus_signatures[a.state[s].match].name;
+            Debug_printv("url[%s] virus[%s] offset[%d]", url.c_str(), detected, position() - n + i);
+
+            // Nothing of the block with it goes out
+            if ( block )
+                return 0;
+        }
+    }
+    _state = s;
+
+    return n;
+}
+
+bool MVirusScan::seek(uint32_t pos)
+{
+    // What was before the new position isn't known
+    _state = 0;
+    return _source->seek(pos);
+}
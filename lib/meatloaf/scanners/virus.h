@@ -2,4 +2,206 @@
 // https://codebase64.org/doku.php?id=base:viruslist
 // https://www.c64-wiki.com/wiki/BHP-Virus
 // http://hitmen.c02.at/files/docs/c64/C64_Virus_List.txt
-// 
\ No newline at end of file
+// virus.h
+
+#ifndef MEATLOAF_SCANNER_VIRUS
+#define MEATLOAF_SCANNER_VIRUS
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../meat_stream.h"
+
+// Files from the network are scanned while they load. A match either
+// stops the LOAD or is only reported on the status channel. There are
+// no C64 signatures yet, so LOADs are only scanned when built with
+// VIRUS_SCAN defined
+#ifndef VIRUS_SCAN_BLOCK
+#define VIRUS_SCAN_BLOCK    true
+#endif
+
+
+/********************************************************
+ * Signatures
+ ********************************************************/
+
+struct VirusSignature
+{
+    const char *name;
+    const char *bytes;
+    uint8_t length;
+};
+
+#define VIRUS_SIGNATURE(name, bytes) { name, bytes, sizeof(bytes) - 1 }
+
+// Bytes that are in every copy of the virus, "\xNN" escapes for code.
+// EICAR is not a virus, it is there to test the scanner with. Add a
+// C64 virus only with bytes taken from a sample of it
+inline constexpr VirusSignature virus_signatures[] = {
+    VIRUS_SIGNATURE( "EICAR", "X5O!P%@AP[4\\PZX54(P^)7CC)7}$EICAR-STANDARD-ANTIVIRUS-TEST-FILE!$H+H*" ),
+};
+
+
+/********************************************************
+ * Automaton
+ ********************************************************/
+
+// An Aho-Corasick automaton built from the signatures by the compiler,
+// it lives in flash. The root has a table with the state for every
+// byte, the rest keep their children in a list. Most bytes of a clean
+// file don't start a signature and cost one lookup in the table.
+namespace virus
+{
+    constexpr uint16_t NONE = UINT16_MAX;
+
+    constexpr uint32_t states()
+    {
+        uint32_t count = 1;
+        for ( auto &s : virus_signatures )
+            count += s.length;
+        return count;
+    }
+
+    static_assert( states() < NONE, "Too many signature bytes" );
+
+    struct State
+    {
+        uint16_t child = 0;         // First child, 0 for none
+        uint16_t sibling = 0;       // Next child of the parent
+        uint16_t fail = 0;          // Longest suffix that is also a prefix
+        uint16_t match = NONE;      // Signature ending here
+        uint8_t byte = 0;
+    };
+
+    struct Automaton
+    {
+        uint16_t root[256] = {};
+        State state[states()] = {};
+        uint16_t count = 1;
+
+        constexpr uint16_t child( uint16_t s, uint8_t b ) const
+        {
+            if ( s == 0 )
+                return root[b];
+
+            for ( uint16_t c = state[s].child; c; c = state[c].sibling )
+            {
+                if ( state[c].byte == b )
+                    return c;
+            }
+            return 0;
+        }
+
+        constexpr uint16_t next( uint16_t s, uint8_t b ) const
+        {
+            for ( ; s; s = state[s].fail )
+            {
+                uint16_t c = child( s, b );
+                if ( c )
+                    return c;
+            }
+            return root[b];
+        }
+    };
+
+    constexpr Automaton compile()
+    {
+        Automaton a;
+
+        // Trie of all signatures
+        for ( uint16_t i = 0; i < sizeof(virus_signatures) / sizeof(VirusSignature); i++ )
+        {
+            auto &sig = virus_signatures[i];
+            uint16_t s = 0;
+            for ( uint8_t j = 0; j < sig.length; j++ )
+            {
+                uint8_t b = sig.bytes[j];
+                uint16_t c = a.child( s, b );
+                if ( !c )
+                {
+                    c = a.count++;
+                    a.state[c].byte = b;
+                    if ( s == 0 )
+                    {
+                        a.root[b] = c;
+                    }
+                    else
+                    {
+                        a.state[c].sibling = a.state[s].child;
+                        a.state[s].child = c;
+                    }
+                }
+                s = c;
+            }
+            a.state[s].match = i;
+        }
+
+        // Fail links breadth first, so a state finds those of shorter
+        // prefixes done. Matches of a suffix are matches here too
+        uint16_t queue[states()] = {};
+        uint16_t head = 0, tail = 0;
+        for ( uint16_t b = 0; b < 256; b++ )
+        {
+            if ( a.root[b] )
+                queue[tail++] = a.root[b];
+        }
+
+        while ( head < tail )
+        {
+            uint16_t s = queue[head++];
+            for ( uint16_t c = a.state[s].child; c; c = a.state[c].sibling )
+            {
+                a.state[c].fail = a.next( a.state[s].fail, a.state[c].byte );
+                if ( a.state[c].match == NONE )
+                    a.state[c].match = a.state[a.state[c].fail].match;
+                queue[tail++] = c;
+            }
+        }
+
+        return a;
+    }
+
+    inline constexpr Automaton automaton = compile();
+}
+
+
+/********************************************************
+ * Scanning stream
+ ********************************************************/
+
+// Passes the stream through the automaton as it is read, nothing is
+// buffered or read ahead. After a match reads return nothing and
+// error() is set if blocking, otherwise the match is only noted.
+class MVirusScan : public MStream
+{
+public:
+    MVirusScan(std::shared_ptr<MStream> source, bool block = VIRUS_SCAN_BLOCK);
+
+    uint32_t available() override { return _source->available(); };
+    uint32_t size() override { return _source->size(); };
+    uint32_t position() override { return _source->position(); };
+    size_t error() override { return (block && detected) ? 1 : _source->error(); };
+
+    bool isOpen() override { return _source->isOpen(); };
+    bool isBrowsable() override { return _source->isBrowsable(); };
+    bool isRandomAccess() override { return _source->isRandomAccess(); };
+
+    bool open() override { return _source->open(); };
+    void close() override { _source->close(); };
+
+    uint32_t read(uint8_t* buf, uint32_t size) override;
+    uint32_t write(const uint8_t *buf, uint32_t size) override { return _source->write(buf, size); };
+    bool seek(uint32_t pos) override;
+    bool flush() override { return _source->flush(); };
+
+    bool block;
+    const char *detected = nullptr;     // Name of the first signature found
+
+private:
+    std::shared_ptr<MStream> _source;
+    uint16_t _state = 0;
+};
+
+#endif // MEATLOAF_SCANNER_VIRUS
@@ -1,5 +1,8 @@
 #include "pdf_printer.h"
 
+#include <map>
+#include <vector>
+
 #include "../../include/global_defines.h"
 #include "../../include/debug.h"
 
@@ -58,115 +61,141 @@ void pdfPrinter::pdf_font_resource()
     fprintf(_file, ">>>>\nendobj\n");
 }
 
+// Font file layout, per LUT line: seven offsets marking where each "%d" object
+// number placeholder ends. Between placeholders the file is copied verbatim.
+// For each placeholder we store which object number to print (relative to the
+// current counter) and whether that placeholder opens a new object.
+static const struct
+{
+    int8_t objDelta;   // number to print = pdf_objCtr + objDelta (after increment)
+    bool newObject;    // increment pdf_objCtr and record its xref location first
+} pdfFontPlaceholders[7] = {
+    {0, true},  // font dictionary object number
+    {1, false}, // reference to font descriptor
+    {3, false}, // reference to font widths
+    {0, true},  // font descriptor object number
+    {1, false}, // reference to font file
+    {0, true},  // font widths object number
+    {0, true},  // font file object number
+};
+
+// LUT tables never change at runtime, so keep them parsed across documents
+// instead of re-reading the LUT file from flash for every printout
+static std::map<std::string, std::vector<pdfFontLUT_t>> pdfFontLUTCache;
+
+const std::vector<pdfFontLUT_t> &pdfPrinter::pdf_font_lut()
+{
+    auto found = pdfFontLUTCache.find(shortname);
+    if (found != pdfFontLUTCache.end())
+        return found->second;
+
+    static const std::vector<pdfFontLUT_t> none;
+    std::vector<pdfFontLUT_t> table;
+
+    char fname[30]; // filename: /f/shortname/LUT
+    sprintf(fname, SYSTEM_DIR "/font/%s/LUT", shortname.c_str());
+    FILE *lut = fsFlash.file_open(fname);
+    if (lut != nullptr)
+    {
+        int maxFonts = util_parseInt(lut);
+        for (int i = 0; i < maxFonts && i < MAXFONTS; i++)
+        {
+            pdfFontLUT_t entry;
+            for (int j = 0; j < 7; j++)
+                entry.pos[j] = util_parseInt(lut);
+            table.push_back(entry);
+        }
+        fclose(lut);
+    }
+#ifdef DEBUG
+    else
+    {
+        Debug_printf("Failed to open font LUT: '%s'\r\n", fname);
+    }
+#endif
+
+    // Tried again next time, flash may not have been mounted yet
+    if (table.empty())
+        return none;
+
+    return pdfFontLUTCache.emplace(shortname, table).first->second;
+}
+
+// Copy len bytes from the font file to the output in large blocks
+size_t pdfPrinter::pdf_copy_font_bytes(FILE *src, size_t len, uint8_t *buf, size_t buflen)
+{
+    size_t total = 0;
+    while (total < len)
+    {
+        size_t chunk = len - total;
+        if (chunk > buflen)
+            chunk = buflen;
+        size_t count = fread(buf, 1, chunk, src);
+        if (count == 0)
+            break;
+        fwrite(buf, 1, count, _file);
+        total += count;
+    }
+    return total;
+}
+
 void pdfPrinter::pdf_add_fonts() // pdfFont_t *fonts[],
 {
 #ifdef DEBUG
     Debug_print("pdf add fonts: ");
 #endif
 
-    // OPEN LUT FILE
-    char fname[30]; // filename: /f/shortname/Fi
-    sprintf(fname, SYSTEM_DIR "/font/%s/LUT", shortname.c_str());
-    FILE *lut = fsFlash.file_open(fname);
-    int maxFonts = util_parseInt(lut);
+    const std::vector<pdfFontLUT_t> &lut = pdf_font_lut();
+    uint8_t *buf = nullptr;
+    uint8_t small[64]; // used when the copy buffer can't be had
+    size_t buflen = PDF_FONT_COPY_BUFLEN;
 
     // font dictionary
-    for (int i = 0; i < maxFonts; i++)
+    for (size_t i = 0; i < lut.size(); i++)
     {
 #ifdef DEBUG
-        Debug_printf("font %d - ", i + 1);
+        Debug_printf("font %d - ", (int)i + 1);
 #endif
-        // READ LINE IN LUT FILE
-        size_t fontObjPos[7];
-        for (int j = 0; j < 7; j++)
-            fontObjPos[j] = util_parseInt(lut);
-
-        // assign fontObjPos[] matrix
         if (fontUsed[i])
         {
-            size_t fp = 0;
             char fname[30];                                        // filename: /f/shortname/Fi
-            sprintf(fname, SYSTEM_DIR "/font/%s/F%d", shortname.c_str(), i + 1); // e.g. /f/a820/F2
+            sprintf(fname, SYSTEM_DIR "/font/%s/F%d", shortname.c_str(), (int)i + 1); // e.g. /f/a820/F2
             FILE *fff = fsFlash.file_open(fname);                 // Font File File - fff
-
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            pdf_objCtr++; // = 6;
-            objLocations[pdf_objCtr] = ftell(_file);
-            fprintf(_file, "%d", pdf_objCtr); // 6
-            while (fp < fontObjPos[0])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            fprintf(_file, "%d", pdf_objCtr + 1); // 7
-            while (fp < fontObjPos[1])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            fprintf(_file, "%d", pdf_objCtr + 3); // 9
-            while (fp < fontObjPos[2])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            pdf_objCtr++; // = 7;
-            objLocations[pdf_objCtr] = ftell(_file);
-            fprintf(_file, "%d", pdf_objCtr); // 7
-            while (fp < fontObjPos[3])
-            {
-                fputc(fgetc(fff), _file);
-                fp++;
-            }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            fprintf(_file, "%d", pdf_objCtr + 1); // 8
-            while (fp < fontObjPos[4])
+            if (fff == nullptr)
             {
-                fputc(fgetc(fff), _file);
-                fp++;
+#ifdef DEBUG
+                Debug_printf("Failed to open font file: '%s'\r\n", fname);
+#endif
+                continue;
             }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            pdf_objCtr++; // = 8;
-            objLocations[pdf_objCtr] = ftell(_file);
-            fprintf(_file, "%d", pdf_objCtr); // 8
-            while (fp < fontObjPos[5])
+
+            if (buf == nullptr)
             {
-                fputc(fgetc(fff), _file);
-                fp++;
+                buf = (uint8_t *)malloc(PDF_FONT_COPY_BUFLEN);
+                if (buf == nullptr)
+                {
+                    buf = small;
+                    buflen = sizeof(small);
+                }
             }
-            fgetc(fff); // '%'
-            fp++;
-            fgetc(fff); // 'd'
-            fp++;
-            pdf_objCtr++; // = 9;
-            objLocations[pdf_objCtr] = ftell(_file);
-            fprintf(_file, "%d", pdf_objCtr); // 9
-            // insert rest of file
-            while (fp < fontObjPos[6]) //(fff.available())
+
+            size_t fp = 0;
+            for (int j = 0; j < 7; j++)
             {
-                fputc(fgetc(fff), _file);
-                fp++;
+                // skip the "%d" placeholder in the font file
+                fseek(fff, 2, SEEK_CUR);
+                fp += 2;
+
+                if (pdfFontPlaceholders[j].newObject)
+                {
+                    pdf_objCtr++;
+                    objLocations[pdf_objCtr] = ftell(_file);
+                }
+                fprintf(_file, "%d", pdf_objCtr + pdfFontPlaceholders[j].objDelta);
+
+                // copy everything up to the next placeholder (or end of file)
+                if (lut[i].pos[j] > fp)
+                    fp += pdf_copy_font_bytes(fff, lut[i].pos[j] - fp, buf, buflen);
             }
             fclose(fff);
             fputc('\n', _file); // make sure there's a seperator
@@ -179,7 +208,8 @@ void pdfPrinter::pdf_add_fonts() // pdfFont_t *fonts[],
 #endif
     }
 
-    fclose(lut);
+    if (buf != small)
+        free(buf);
 #ifdef DEBUG
     Debug_println("done.");
 #endif
@@ -293,10 +323,22 @@ void pdfPrinter::pdf_xref()
     fprintf(_file, "xref\n");
     fprintf(_file, "0 %u\n", pdf_objCtr);
     fprintf(_file, "0000000000 65535 f\n");
+
+    // xref entries are fixed 20-byte records; format them into a block and
+    // write the block in one go instead of one fprintf per object
+    char entries[PDF_XREF_BATCH * 20 + 1];
+    int n = 0;
     for (int i = 1; i < pdf_objCtr; i++)
     {
-        fprintf(_file, "%010u 00000 n\n", objLocations[i]);
+        snprintf(entries + n * 20, 21, "%010u 00000 n\n", objLocations[i]);
+        if (++n == PDF_XREF_BATCH)
+        {
+            fwrite(entries, 20, n, _file);
+            n = 0;
+        }
     }
+    if (n)
+        fwrite(entries, 20, n, _file);
     fprintf(_file, "trailer <</Size %u/Root 1 0 R>>\n", pdf_objCtr);
     fprintf(_file, "startxref\n");
     fprintf(_file, "%u\n", xref);
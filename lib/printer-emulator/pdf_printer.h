@@ -5,6 +5,7 @@
  inherited from by other, full-fledged printer classes (e.g. Atari 820/822)
 */
 #include <string>
+#include <vector>
 
 #include "../../include/atascii.h"
 
@@ -12,6 +13,14 @@
 
 
 #define MAXFONTS 33 // maximum number of fonts can use
+#define PDF_FONT_COPY_BUFLEN 1024 // block size used when embedding font files
+#define PDF_XREF_BATCH 32 // xref entries formatted per write
+
+// placeholder offsets for one font file, as listed in the font LUT
+struct pdfFontLUT_t
+{
+    size_t pos[7];
+};
 
 enum class colorMode_t
 {
@@ -54,6 +63,8 @@ protected:
 
     void pdf_header();
     void pdf_add_fonts(); // pdfFont_t *fonts[],
+    const std::vector<pdfFontLUT_t> &pdf_font_lut();
+    size_t pdf_copy_font_bytes(FILE *src, size_t len, uint8_t *buf, size_t buflen);
     void pdf_new_page();
     void pdf_begin_text(double Y);
     void pdf_new_line();
@@ -22,6 +22,7 @@
 //#include "fuji.h"
 
 #define HostOS 0x07 // FUJINET
+#define USE_FILECACHE // Keep host files open between record transfers (see _sys_cacheopen)
 
 using namespace std;
 
@@ -66,8 +67,133 @@ char *full_path(char *fn)
 
 /* Memory abstraction functions */
 /*===============================================================================*/
+bool _RamLoad(char *fn, uint16_t address);
+
+/* filesystem (disk) abstraction fuctions */
+/*===============================================================================*/
+FILE *rootdir;
+FILE *userdir;
+
+/*
+ * Open file cache
+ *
+ * Every record transfer used to open the host file, seek, move 128 bytes
+ * and close it again. The last few files are kept open instead, with a
+ * stdio buffer big enough to read ahead several records. Entries are
+ * closed on BDOS close, delete, rename and make, and all of them on a
+ * disk reset, so the SD card is always up to date at those points.
+ */
+#define FILECACHE_SIZE 4
+#define FILECACHE_BUFSZ (BlkSZ * 8)
+
+typedef struct
+{
+	char path[128];
+	FILE *f;
+	bool rw;		// Opened "r+"
+	bool writing;	// Last transfer was a write
+	long pos;		// Host file position, -1 if unknown
+	long size;		// Host file size, -1 until extending needs it
+	uint32_t used;
+} FILECACHE_ENTRY;
+
+FILECACHE_ENTRY fileCache[FILECACHE_SIZE];
+uint32_t fileCacheStamp = 0;
+
+void _sys_cacheclose(FILECACHE_ENTRY *e)
+{
+	if (e->f)
+		fclose(e->f);
+	e->f = NULL;
+	e->path[0] = 0;
+	e->used = 0;
+}
+
+FILECACHE_ENTRY *_sys_cachefind(const char *path)
+{
+	for (int i = 0; i < FILECACHE_SIZE; i++)
+	{
+		if (fileCache[i].f && !strcmp(fileCache[i].path, path))
+			return &fileCache[i];
+	}
+	return NULL;
+}
+
+// Returns the open host file for fn, reusing a cached handle when possible
+FILECACHE_ENTRY *_sys_cacheopen(uint8_t *fn, bool rw)
+{
+	char *path = full_path((char *)fn);
+	FILECACHE_ENTRY *e = _sys_cachefind(path);
+
+	if (e && rw && !e->rw)
+		_sys_cacheclose(e); // Reopen read/write
+	else if (e)
+	{
+		e->used = ++fileCacheStamp;
+		return e;
+	}
+
+	// Reuse a free slot or the least recently used one
+	e = &fileCache[0];
+	for (int i = 1; i < FILECACHE_SIZE && e->f; i++)
+	{
+		if (!fileCache[i].f || fileCache[i].used < e->used)
+			e = &fileCache[i];
+	}
+	_sys_cacheclose(e);
+
+	e->f = fnSDFAT.file_open(path, rw ? "r+" : "r");
+	if (!e->f && rw)
+		e->f = fnSDFAT.file_open(path, "w+");
+	if (!e->f)
+		return NULL;
+
+	setvbuf(e->f, NULL, _IOFBF, FILECACHE_BUFSZ);
+	strlcpy(e->path, path, sizeof(e->path));
+	e->rw = rw;
+	e->writing = false;
+	e->pos = 0;
+	e->size = -1;
+	e->used = ++fileCacheStamp;
+	return e;
+}
+
+// Seeks only when needed so sequential transfers stay inside the stdio buffer.
+// Switching between reading and writing always needs a seek.
+bool _sys_cacheseek(FILECACHE_ENTRY *e, long fpos, bool writing)
+{
+	if (e->pos == fpos && e->writing == writing)
+		return true;
+
+	e->writing = writing;
+	if (fseek(e->f, fpos, SEEK_SET) != 0)
+	{
+		e->pos = -1;
+		return false;
+	}
+	e->pos = fpos;
+	return true;
+}
+
+// Called by the BDOS when a file is closed, deleted, renamed or recreated
+void _sys_closefile(uint8_t *fn)
+{
+	FILECACHE_ENTRY *e = _sys_cachefind(full_path((char *)fn));
+	if (e)
+		_sys_cacheclose(e);
+}
+
+// Called by the BDOS on a disk reset
+void _sys_flushfiles(void)
+{
+	for (int i = 0; i < FILECACHE_SIZE; i++)
+		_sys_cacheclose(&fileCache[i]);
+}
+
 bool _RamLoad(char *fn, uint16_t address)
 {
+	_sys_closefile((uint8_t *)fn);
+
 	FILE *f = fnSDFAT.file_open(full_path(fn), "r");
 	bool result = false;
 	uint8_t b;
@@ -101,11 +227,6 @@ uint32 _HardwareIn(const uint32 Port) {
 	return 0;
 }
 
-/* filesystem (disk) abstraction fuctions */
-/*===============================================================================*/
-FILE *rootdir;
-FILE *userdir;
-
 bool _sys_exists(uint8* filename)
 {
 	return fnSDFAT.exists(full_path((char *)filename));
@@ -134,6 +255,11 @@ int _sys_select(uint8_t *disk)
 long _sys_filesize(uint8_t *fn)
 {
 	unsigned long fs = -1;
+	FILECACHE_ENTRY *e = _sys_cachefind(full_path((char *)fn));
+
+	if (e && e->writing)
+		fflush(e->f);
+
 	FILE *fp = fnSDFAT.file_open(full_path((char *)fn), "r");
 
 	if (fp)
@@ -160,6 +286,8 @@ int _sys_openfile(uint8_t *fn)
 
 int _sys_makefile(uint8_t *fn)
 {
+	_sys_closefile(fn);
+
 	FILE *fp = fnSDFAT.file_open(full_path((char *)fn), "w");
 	if (fp)
 	{
@@ -172,6 +300,7 @@ int _sys_makefile(uint8_t *fn)
 
 int _sys_deletefile(uint8_t *fn)
 {
+	_sys_closefile(fn);
 	return fnSDFAT.remove(full_path((char *)fn));
 }
 
@@ -179,6 +308,9 @@ int _sys_renamefile(uint8_t *fn, uint8_t *newname)
 {
 	std::string from, to;
 
+	_sys_closefile(fn);
+	_sys_closefile(newname);
+
 	from = std::string(full_path((char *)fn));
 	to = std::string(full_path((char *)newname));
 
@@ -192,87 +324,97 @@ void _sys_logbuffer(uint8_t *buffer)
 
 bool _sys_extendfile(char *fn, unsigned long fpos)
 {
-	FILE *fp = fnSDFAT.file_open(full_path((char *)fn), "a");
+	FILECACHE_ENTRY *e = _sys_cacheopen((uint8_t *)fn, true);
 
-	if (!fp)
+	if (!e)
 		return false;
 
-	long origSize = fnSDFAT.filesize(full_path(fn));
-
-	// This was patterned after the arduino abstraction, and I do not like how this works.
+	// The size is only looked up once per open, seeking to the end would
+	// flush the write buffer on every record
+	if (e->size < 0)
+	{
+		e->writing = true;
+		e->pos = -1;
+		if (fseek(e->f, 0L, SEEK_END) != 0)
+			return false;
+		e->size = e->pos = ftell(e->f);
+	}
 
-	if (fpos > origSize)
+	// Fill the gap up to the record being written
+	if ((long)fpos > e->size)
 	{
-		for (long i = 0; i < (origSize - fpos); ++i)
+		if (!_sys_cacheseek(e, e->size, true))
+			return false;
+
+		for (; e->size < (long)fpos; e->size++, e->pos++)
 		{
-			if (fwrite("\0", sizeof(uint8_t), 1, fp) != 1)
+			if (fputc(0, e->f) == EOF)
 			{
-				fclose(fp);
+				e->pos = e->size = -1;
 				return false;
 			}
 		}
 	}
-	fclose(fp);
 	return true;
 }
 
 uint8_t _sys_readseq(uint8_t *fn, long fpos)
 {
 	uint8_t result = 0xff;
-	FILE *f;
+	FILECACHE_ENTRY *e;
 	uint8_t bytesread;
 	uint8_t dmabuf[BlkSZ];
-	int seekErr;
 
-	f = fnSDFAT.file_open(full_path((char *)fn), "r");
-	if (!f)
+	e = _sys_cacheopen(fn, false);
+	if (!e)
 	{
 		result = 0x10;
 		return result;
 	}
-
-	seekErr = fseek(f, fpos, SEEK_SET);
-	if (f)
+	if (!_sys_cacheseek(e, fpos, false))
 	{
-		if (fpos > 0 && seekErr != 0)
-		{
-			// EOF
-			result = 0x01;
-		}
-		else
-		{
-			// set DMA buffer to EOF
-			memset(dmabuf, 0x1a, BlkSZ);
-			bytesread = fread(&dmabuf[0], BlkSZ, sizeof(uint8_t), f);
-			if (bytesread)
-				memcpy((uint8_t *)&RAM[dmaAddr], dmabuf, BlkSZ);
-			result = bytesread ? 0x00 : 0x01;
-		}
+		// EOF
+		result = 0x01;
 	}
 	else
 	{
-		result = 0x10;
+		// set DMA buffer to EOF
+		memset(dmabuf, 0x1a, BlkSZ);
+		bytesread = fread(&dmabuf[0], BlkSZ, sizeof(uint8_t), e->f);
+		if (bytesread)
+		{
+			memcpy((uint8_t *)&RAM[dmaAddr], dmabuf, BlkSZ);
+			e->pos += BlkSZ;
+		}
+		else
+			e->pos = -1; // Partial record, position unknown
+		result = bytesread ? 0x00 : 0x01;
 	}
-	fclose(f);
 	return (result);
 }
 
 uint8_t _sys_writeseq(uint8_t *fn, long fpos)
 {
 	uint8_t result = 0xff;
-	FILE *f;
+	FILECACHE_ENTRY *e;
 
-	if (_sys_extendfile((char *)fn, fpos))
-		f = fnSDFAT.file_open(full_path((char *)fn), "r+");
-	else
+	if (!_sys_extendfile((char *)fn, fpos))
 		return result;
 
-	if (f)
+	e = _sys_cacheopen(fn, true);
+	if (e)
 	{
-		if (fseek(f, fpos, SEEK_SET) == 0)
+		if (_sys_cacheseek(e, fpos, true))
 		{
-			if (fwrite(_RamSysAddr(dmaAddr), BlkSZ, sizeof(uint8_t), f))
+			if (fwrite(_RamSysAddr(dmaAddr), BlkSZ, sizeof(uint8_t), e->f))
+			{
+				e->pos += BlkSZ;
+				if (e->pos > e->size)
+					e->size = e->pos;
 				result = 0x00;
+			}
+			else
+				e->pos = -1;
 		}
 		else
 		{
@@ -283,27 +425,31 @@ uint8_t _sys_writeseq(uint8_t *fn, long fpos)
 	{
 		result = 0x10;
 	}
-	fclose(f);
 	return (result);
 }
 
 uint8_t _sys_readrand(uint8_t *fn, long fpos)
 {
 	uint8 result = 0xff;
-	FILE *f;
+	FILECACHE_ENTRY *e;
 	uint8 bytesread;
 	uint8 dmabuf[BlkSZ];
 	long extSize;
 
-	f = fnSDFAT.file_open(full_path((char *)fn), "r+");
-	if (f)
+	e = _sys_cacheopen(fn, false);
+	if (e)
 	{
-		if (fseek(f, fpos, SEEK_SET) == 0)
+		if (_sys_cacheseek(e, fpos, false))
 		{
 			memset(dmabuf, 0x1A, BlkSZ);
-			bytesread = fread(&dmabuf[0], BlkSZ, sizeof(uint8_t), f);
+			bytesread = fread(&dmabuf[0], BlkSZ, sizeof(uint8_t), e->f);
 			if (bytesread)
+			{
 				memcpy((uint8_t *)&RAM[dmaAddr], dmabuf, BlkSZ);
+				e->pos += BlkSZ;
+			}
+			else
+				e->pos = -1;
 			result = bytesread ? 0x00 : 0x01;
 		}
 		else
@@ -314,7 +460,7 @@ uint8_t _sys_readrand(uint8_t *fn, long fpos)
 			}
 			else
 			{
-				extSize = _sys_filesize((uint8_t *)full_path((char *)fn));
+				extSize = _sys_filesize(fn);
 
 				// round file size up to next full logical extent
 				extSize = ExtSZ * ((extSize / ExtSZ) + ((extSize % ExtSZ) ? 1 : 0));
@@ -329,28 +475,31 @@ uint8_t _sys_readrand(uint8_t *fn, long fpos)
 	{
 		result = 0x10;
 	}
-	fclose(f);
 	return (result);
 }
 
 uint8_t _sys_writerand(uint8_t *fn, long fpos)
 {
 	uint8 result = 0xff;
-	FILE *f;
+	FILECACHE_ENTRY *e;
 
-	if (_sys_extendfile((char *)fn, fpos))
-	{
-		f = fnSDFAT.file_open(full_path((char *)fn), "r+");
-	}
-	else
+	if (!_sys_extendfile((char *)fn, fpos))
 		return result;
 
-	if (f)
+	e = _sys_cacheopen(fn, true);
+	if (e)
 	{
-		if (fseek(f, fpos, SEEK_SET) == 0)
+		if (_sys_cacheseek(e, fpos, true))
 		{
-			if (fwrite(_RamSysAddr(dmaAddr), BlkSZ, sizeof(uint8_t), f))
+			if (fwrite(_RamSysAddr(dmaAddr), BlkSZ, sizeof(uint8_t), e->f))
+			{
+				e->pos += BlkSZ;
+				if (e->pos > e->size)
+					e->size = e->pos;
 				result = 0x00;
+			}
+			else
+				e->pos = -1;
 		}
 		else
 		{
@@ -361,7 +510,6 @@ uint8_t _sys_writerand(uint8_t *fn, long fpos)
 	{
 		result = 0x10;
 	}
-	fclose(f);
 	return (result);
 }
 
@@ -428,6 +576,13 @@ uint8_t _findnext(uint8_t isdir)
 
 uint8_t _findfirst(uint8_t isdir)
 {
+	// Directory sizes come from the card, push out pending writes
+	for (int i = 0; i < FILECACHE_SIZE; i++)
+	{
+		if (fileCache[i].f && fileCache[i].writing)
+			fflush(fileCache[i].f);
+	}
+
 	// uint8 path[4] = {'?', FOLDERCHAR, '?', 0};
 	// path[0] = filename[0];
 	// path[2] = filename[2];
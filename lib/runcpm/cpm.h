@@ -977,6 +977,9 @@ void _Bdos(void) {
 		   C = 13 (0Dh) : Reset disk system
 		 */
 		case DRV_ALLRESET: {
+#ifdef USE_FILECACHE
+			_sys_flushfiles();  // Close all cached host files
+#endif
 			roVector = 0;       // Make all drives R/W
 			loginVector = 0;
 			dmaAddr = 0x0080;
@@ -1191,6 +1194,9 @@ void _Bdos(void) {
 		   C = 37 (25h) : Reset drive
 		 */
 		case DRV_RESET: {
+#ifdef USE_FILECACHE
+			_sys_flushfiles();
+#endif
 			roVector = roVector & ~DE;
 			break;
 		}
@@ -1180,6 +1180,40 @@ x == (C - 1) & 0xff for IND
 #define INOUTFLAGS_NONZERO(x)                                           \
     INOUTFLAGS((HIGH_REGISTER(BC) & 0xa8) | ((HIGH_REGISTER(BC) == 0) << 6), x)
 
+/*
+	Opcode dispatch
+
+	By default every instruction goes back through the switch at the top of
+	the fetch loop. With Z80_THREADED (GCC/Clang only) every opcode, including
+	the ones following a DD/ED/FD prefix, is also a label in a jump table and
+	each handler jumps straight into the handler of the next instruction.
+*/
+#if defined(Z80_THREADED) && !defined(__GNUC__)
+#undef Z80_THREADED
+#endif
+
+#ifdef Z80_THREADED
+#define Z80_CASE(p, n)  case 0x##n: p##_##n
+#define Z80_DEFAULT(p)  default: p##_default
+#define Z80_DISPATCH(p) goto *z80_##p[RAM_PP(PC)]
+#if defined(DEBUG) || defined(iDEBUG)
+#define Z80_NEXT        continue    /* Debugger hooks run at the top of the loop */
+#else
+#define Z80_NEXT do {                           \
+    if (Status)                                 \
+        goto end_decode;                        \
+    PCX = PC;                                   \
+    INCR(1); /* Add one M1 cycle to refresh counter */ \
+    Z80_DISPATCH(main);                         \
+} while (0)
+#endif
+#else
+#define Z80_CASE(p, n)  case 0x##n
+#define Z80_DEFAULT(p)  default
+#define Z80_DISPATCH(p)
+#define Z80_NEXT        break
+#endif
+
 static inline void Z80reset(void) {
 	PC = 0;
 	IFF = 0;
@@ -1467,6 +1501,146 @@ static inline void Z80run(void) {
 	uint32 op = 0;
 	uint32 adr = 0;
 
+#ifdef Z80_THREADED
+	/* Handler labels by opcode, unused prefixed opcodes go to the prefix default */
+	static const void* const z80_main[256] = {
+		&&main_00, &&main_01, &&main_02, &&main_03, &&main_04, &&main_05, &&main_06, &&main_07,
+		&&main_08, &&main_09, &&main_0a, &&main_0b, &&main_0c, &&main_0d, &&main_0e, &&main_0f,
+		&&main_10, &&main_11, &&main_12, &&main_13, &&main_14, &&main_15, &&main_16, &&main_17,
+		&&main_18, &&main_19, &&main_1a, &&main_1b, &&main_1c, &&main_1d, &&main_1e, &&main_1f,
+		&&main_20, &&main_21, &&main_22, &&main_23, &&main_24, &&main_25, &&main_26, &&main_27,
+		&&main_28, &&main_29, &&main_2a, &&main_2b, &&main_2c, &&main_2d, &&main_2e, &&main_2f,
+		&&main_30, &&main_31, &&main_32, &&main_33, &&main_34, &&main_35, &&main_36, &&main_37,
+		&&main_38, &&main_39, &&main_3a, &&main_3b, &&main_3c, &&main_3d, &&main_3e, &&main_3f,
+		&&main_40, &&main_41, &&main_42, &&main_43, &&main_44, &&main_45, &&main_46, &&main_47,
+		&&main_48, &&main_49, &&main_4a, &&main_4b, &&main_4c, &&main_4d, &&main_4e, &&main_4f,
+		&&main_50, &&main_51, &&main_52, &&main_53, &&main_54, &&main_55, &&main_56, &&main_57,
+		&&main_58, &&main_59, &&main_5a, &&main_5b, &&main_5c, &&main_5d, &&main_5e, &&main_5f,
+		&&main_60, &&main_61, &&main_62, &&main_63, &&main_64, &&main_65, &&main_66, &&main_67,
+		&&main_68, &&main_69, &&main_6a, &&main_6b, &&main_6c, &&main_6d, &&main_6e, &&main_6f,
+		&&main_70, &&main_71, &&main_72, &&main_73, &&main_74, &&main_75, &&main_76, &&main_77,
+		&&main_78, &&main_79, &&main_7a, &&main_7b, &&main_7c, &&main_7d, &&main_7e, &&main_7f,
+		&&main_80, &&main_81, &&main_82, &&main_83, &&main_84, &&main_85, &&main_86, &&main_87,
+		&&main_88, &&main_89, &&main_8a, &&main_8b, &&main_8c, &&main_8d, &&main_8e, &&main_8f,
+		&&main_90, &&main_91, &&main_92, &&main_93, &&main_94, &&main_95, &&main_96, &&main_97,
+		&&main_98, &&main_99, &&main_9a, &&main_9b, &&main_9c, &&main_9d, &&main_9e, &&main_9f,
+		&&main_a0, &&main_a1, &&main_a2, &&main_a3, &&main_a4, &&main_a5, &&main_a6, &&main_a7,
+		&&main_a8, &&main_a9, &&main_aa, &&main_ab, &&main_ac, &&main_ad, &&main_ae, &&main_af,
+		&&main_b0, &&main_b1, &&main_b2, &&main_b3, &&main_b4, &&main_b5, &&main_b6, &&main_b7,
+		&&main_b8, &&main_b9, &&main_ba, &&main_bb, &&main_bc, &&main_bd, &&main_be, &&main_bf,
+		&&main_c0, &&main_c1, &&main_c2, &&main_c3, &&main_c4, &&main_c5, &&main_c6, &&main_c7,
+		&&main_c8, &&main_c9, &&main_ca, &&main_cb, &&main_cc, &&main_cd, &&main_ce, &&main_cf,
+		&&main_d0, &&main_d1, &&main_d2, &&main_d3, &&main_d4, &&main_d5, &&main_d6, &&main_d7,
+		&&main_d8, &&main_d9, &&main_da, &&main_db, &&main_dc, &&main_dd, &&main_de, &&main_df,
+		&&main_e0, &&main_e1, &&main_e2, &&main_e3, &&main_e4, &&main_e5, &&main_e6, &&main_e7,
+		&&main_e8, &&main_e9, &&main_ea, &&main_eb, &&main_ec, &&main_ed, &&main_ee, &&main_ef,
+		&&main_f0, &&main_f1, &&main_f2, &&main_f3, &&main_f4, &&main_f5, &&main_f6, &&main_f7,
+		&&main_f8, &&main_f9, &&main_fa, &&main_fb, &&main_fc, &&main_fd, &&main_fe, &&main_ff
+	};
+	static const void* const z80_dd[256] = {
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_09, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_19, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_21, &&dd_22, &&dd_23, &&dd_24, &&dd_25, &&dd_26, &&dd_default,
+		&&dd_default, &&dd_29, &&dd_2a, &&dd_2b, &&dd_2c, &&dd_2d, &&dd_2e, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_34, &&dd_35, &&dd_36, &&dd_default,
+		&&dd_default, &&dd_39, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_44, &&dd_45, &&dd_46, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_4c, &&dd_4d, &&dd_4e, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_54, &&dd_55, &&dd_56, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_5c, &&dd_5d, &&dd_5e, &&dd_default,
+		&&dd_60, &&dd_61, &&dd_62, &&dd_63, &&dd_64, &&dd_65, &&dd_66, &&dd_67,
+		&&dd_68, &&dd_69, &&dd_6a, &&dd_6b, &&dd_6c, &&dd_6d, &&dd_6e, &&dd_6f,
+		&&dd_70, &&dd_71, &&dd_72, &&dd_73, &&dd_74, &&dd_75, &&dd_default, &&dd_77,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_7c, &&dd_7d, &&dd_7e, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_84, &&dd_85, &&dd_86, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_8c, &&dd_8d, &&dd_8e, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_94, &&dd_95, &&dd_96, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_9c, &&dd_9d, &&dd_9e, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_a4, &&dd_a5, &&dd_a6, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_ac, &&dd_ad, &&dd_ae, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_b4, &&dd_b5, &&dd_b6, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_bc, &&dd_bd, &&dd_be, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_cb, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_e1, &&dd_default, &&dd_e3, &&dd_default, &&dd_e5, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_e9, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default,
+		&&dd_default, &&dd_f9, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default, &&dd_default
+	};
+	static const void* const z80_ed[256] = {
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_40, &&ed_41, &&ed_42, &&ed_43, &&ed_44, &&ed_45, &&ed_46, &&ed_47,
+		&&ed_48, &&ed_49, &&ed_4a, &&ed_4b, &&ed_4C, &&ed_4d, &&ed_default, &&ed_4f,
+		&&ed_50, &&ed_51, &&ed_52, &&ed_53, &&ed_54, &&ed_55, &&ed_56, &&ed_57,
+		&&ed_58, &&ed_59, &&ed_5a, &&ed_5b, &&ed_5C, &&ed_5D, &&ed_5e, &&ed_5f,
+		&&ed_60, &&ed_61, &&ed_62, &&ed_63, &&ed_64, &&ed_65, &&ed_default, &&ed_67,
+		&&ed_68, &&ed_69, &&ed_6a, &&ed_6b, &&ed_6C, &&ed_6D, &&ed_default, &&ed_6f,
+		&&ed_70, &&ed_71, &&ed_72, &&ed_73, &&ed_74, &&ed_75, &&ed_default, &&ed_default,
+		&&ed_78, &&ed_79, &&ed_7a, &&ed_7b, &&ed_7C, &&ed_7D, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_a0, &&ed_a1, &&ed_a2, &&ed_a3, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_a8, &&ed_a9, &&ed_aa, &&ed_ab, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_b0, &&ed_b1, &&ed_b2, &&ed_b3, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_b8, &&ed_b9, &&ed_ba, &&ed_bb, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default,
+		&&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default, &&ed_default
+	};
+	static const void* const z80_fd[256] = {
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_09, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_19, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_21, &&fd_22, &&fd_23, &&fd_24, &&fd_25, &&fd_26, &&fd_default,
+		&&fd_default, &&fd_29, &&fd_2a, &&fd_2b, &&fd_2c, &&fd_2d, &&fd_2e, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_34, &&fd_35, &&fd_36, &&fd_default,
+		&&fd_default, &&fd_39, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_44, &&fd_45, &&fd_46, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_4c, &&fd_4d, &&fd_4e, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_54, &&fd_55, &&fd_56, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_5c, &&fd_5d, &&fd_5e, &&fd_default,
+		&&fd_60, &&fd_61, &&fd_62, &&fd_63, &&fd_64, &&fd_65, &&fd_66, &&fd_67,
+		&&fd_68, &&fd_69, &&fd_6a, &&fd_6b, &&fd_6c, &&fd_6d, &&fd_6e, &&fd_6f,
+		&&fd_70, &&fd_71, &&fd_72, &&fd_73, &&fd_74, &&fd_75, &&fd_default, &&fd_77,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_7c, &&fd_7d, &&fd_7e, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_84, &&fd_85, &&fd_86, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_8c, &&fd_8d, &&fd_8e, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_94, &&fd_95, &&fd_96, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_9c, &&fd_9d, &&fd_9e, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_a4, &&fd_a5, &&fd_a6, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_ac, &&fd_ad, &&fd_ae, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_b4, &&fd_b5, &&fd_b6, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_bc, &&fd_bd, &&fd_be, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_cb, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_e1, &&fd_default, &&fd_e3, &&fd_default, &&fd_e5, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_e9, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default,
+		&&fd_default, &&fd_f9, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default, &&fd_default
+	};
+#endif
+
 	/* main instruction fetch/decode loop */
 	while (!Status) {	/* loop until Status != 0 */
 
@@ -1507,207 +1681,208 @@ static inline void Z80run(void) {
 		fclose(iLogFile);
 #endif
 
+		Z80_DISPATCH(main);
 		switch (RAM_PP(PC)) {
 
-		case 0x00:      /* NOP */
-			break;
+		Z80_CASE(main, 00):      /* NOP */
+			Z80_NEXT;
 
-		case 0x01:      /* LD BC,nnnn */
+		Z80_CASE(main, 01):      /* LD BC,nnnn */
 			BC = GET_WORD(PC);
 			PC += 2;
-			break;
+			Z80_NEXT;
 
-		case 0x02:      /* LD (BC),A */
+		Z80_CASE(main, 02):      /* LD (BC),A */
 			PUT_BYTE(BC, HIGH_REGISTER(AF));
-			break;
+			Z80_NEXT;
 
-		case 0x03:      /* INC BC */
+		Z80_CASE(main, 03):      /* INC BC */
 			++BC;
-			break;
+			Z80_NEXT;
 
-		case 0x04:      /* INC B */
+		Z80_CASE(main, 04):      /* INC B */
 			BC += 0x100;
 			temp = HIGH_REGISTER(BC);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80); /* SET_PV2 uses temp */
-			break;
+			Z80_NEXT;
 
-		case 0x05:      /* DEC B */
+		Z80_CASE(main, 05):      /* DEC B */
 			BC -= 0x100;
 			temp = HIGH_REGISTER(BC);
 			AF = (AF & ~0xfe) | decTable[temp] | SET_PV2(0x7f); /* SET_PV2 uses temp */
-			break;
+			Z80_NEXT;
 
-		case 0x06:      /* LD B,nn */
+		Z80_CASE(main, 06):      /* LD B,nn */
 			SET_HIGH_REGISTER(BC, RAM_PP(PC));
-			break;
+			Z80_NEXT;
 
-		case 0x07:      /* RLCA */
+		Z80_CASE(main, 07):      /* RLCA */
 			AF = ((AF >> 7) & 0x0128) | ((AF << 1) & ~0x1ff) |
 				(AF & 0xc4) | ((AF >> 15) & 1);
-			break;
+			Z80_NEXT;
 
-		case 0x08:      /* EX AF,AF' */
+		Z80_CASE(main, 08):      /* EX AF,AF' */
 			temp = AF;
 			AF = AF1;
 			AF1 = temp;
-			break;
+			Z80_NEXT;
 
-		case 0x09:      /* ADD HL,BC */
+		Z80_CASE(main, 09):      /* ADD HL,BC */
 			HL &= ADDRMASK;
 			BC &= ADDRMASK;
 			sum = HL + BC;
 			AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(HL ^ BC ^ sum) >> 8];
 			HL = sum;
-			break;
+			Z80_NEXT;
 
-		case 0x0a:      /* LD A,(BC) */
+		Z80_CASE(main, 0a):      /* LD A,(BC) */
 			SET_HIGH_REGISTER(AF, GET_BYTE(BC));
-			break;
+			Z80_NEXT;
 
-		case 0x0b:      /* DEC BC */
+		Z80_CASE(main, 0b):      /* DEC BC */
 			--BC;
-			break;
+			Z80_NEXT;
 
-		case 0x0c:      /* INC C */
+		Z80_CASE(main, 0c):      /* INC C */
 			temp = LOW_REGISTER(BC) + 1;
 			SET_LOW_REGISTER(BC, temp);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80);
-			break;
+			Z80_NEXT;
 
-		case 0x0d:      /* DEC C */
+		Z80_CASE(main, 0d):      /* DEC C */
 			temp = LOW_REGISTER(BC) - 1;
 			SET_LOW_REGISTER(BC, temp);
 			AF = (AF & ~0xfe) | decTable[temp & 0xff] | SET_PV2(0x7f);
-			break;
+			Z80_NEXT;
 
-		case 0x0e:      /* LD C,nn */
+		Z80_CASE(main, 0e):      /* LD C,nn */
 			SET_LOW_REGISTER(BC, RAM_PP(PC));
-			break;
+			Z80_NEXT;
 
-		case 0x0f:      /* RRCA */
+		Z80_CASE(main, 0f):      /* RRCA */
 			AF = (AF & 0xc4) | rrcaTable[HIGH_REGISTER(AF)];
-			break;
+			Z80_NEXT;
 
-		case 0x10:      /* DJNZ dd */
+		Z80_CASE(main, 10):      /* DJNZ dd */
 			if ((BC -= 0x100) & 0xff00)
 				PC += (int8)GET_BYTE(PC) + 1;
 			else
 				++PC;
-			break;
+			Z80_NEXT;
 
-		case 0x11:      /* LD DE,nnnn */
+		Z80_CASE(main, 11):      /* LD DE,nnnn */
 			DE = GET_WORD(PC);
 			PC += 2;
-			break;
+			Z80_NEXT;
 
-		case 0x12:      /* LD (DE),A */
+		Z80_CASE(main, 12):      /* LD (DE),A */
 			PUT_BYTE(DE, HIGH_REGISTER(AF));
-			break;
+			Z80_NEXT;
 
-		case 0x13:      /* INC DE */
+		Z80_CASE(main, 13):      /* INC DE */
 			++DE;
-			break;
+			Z80_NEXT;
 
-		case 0x14:      /* INC D */
+		Z80_CASE(main, 14):      /* INC D */
 			DE += 0x100;
 			temp = HIGH_REGISTER(DE);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80); /* SET_PV2 uses temp */
-			break;
+			Z80_NEXT;
 
-		case 0x15:      /* DEC D */
+		Z80_CASE(main, 15):      /* DEC D */
 			DE -= 0x100;
 			temp = HIGH_REGISTER(DE);
 			AF = (AF & ~0xfe) | decTable[temp] | SET_PV2(0x7f); /* SET_PV2 uses temp */
-			break;
+			Z80_NEXT;
 
-		case 0x16:      /* LD D,nn */
+		Z80_CASE(main, 16):      /* LD D,nn */
 			SET_HIGH_REGISTER(DE, RAM_PP(PC));
-			break;
+			Z80_NEXT;
 
-		case 0x17:      /* RLA */
+		Z80_CASE(main, 17):      /* RLA */
 			AF = ((AF << 8) & 0x0100) | ((AF >> 7) & 0x28) | ((AF << 1) & ~0x01ff) |
 				(AF & 0xc4) | ((AF >> 15) & 1);
-			break;
+			Z80_NEXT;
 
-		case 0x18:      /* JR dd */
+		Z80_CASE(main, 18):      /* JR dd */
 			PC += (int8)GET_BYTE(PC) + 1;
-			break;
+			Z80_NEXT;
 
-		case 0x19:      /* ADD HL,DE */
+		Z80_CASE(main, 19):      /* ADD HL,DE */
 			HL &= ADDRMASK;
 			DE &= ADDRMASK;
 			sum = HL + DE;
 			AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(HL ^ DE ^ sum) >> 8];
 			HL = sum;
-			break;
+			Z80_NEXT;
 
-		case 0x1a:      /* LD A,(DE) */
+		Z80_CASE(main, 1a):      /* LD A,(DE) */
 			SET_HIGH_REGISTER(AF, GET_BYTE(DE));
-			break;
+			Z80_NEXT;
 
-		case 0x1b:      /* DEC DE */
+		Z80_CASE(main, 1b):      /* DEC DE */
 			--DE;
-			break;
+			Z80_NEXT;
 
-		case 0x1c:      /* INC E */
+		Z80_CASE(main, 1c):      /* INC E */
 			temp = LOW_REGISTER(DE) + 1;
 			SET_LOW_REGISTER(DE, temp);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80);
-			break;
+			Z80_NEXT;
 
-		case 0x1d:      /* DEC E */
+		Z80_CASE(main, 1d):      /* DEC E */
 			temp = LOW_REGISTER(DE) - 1;
 			SET_LOW_REGISTER(DE, temp);
 			AF = (AF & ~0xfe) | decTable[temp & 0xff] | SET_PV2(0x7f);
-			break;
+			Z80_NEXT;
 
-		case 0x1e:      /* LD E,nn */
+		Z80_CASE(main, 1e):      /* LD E,nn */
 			SET_LOW_REGISTER(DE, RAM_PP(PC));
-			break;
+			Z80_NEXT;
 
-		case 0x1f:      /* RRA */
+		Z80_CASE(main, 1f):      /* RRA */
 			AF = ((AF & 1) << 15) | (AF & 0xc4) | rraTable[HIGH_REGISTER(AF)];
-			break;
+			Z80_NEXT;
 
-		case 0x20:      /* JR NZ,dd */
+		Z80_CASE(main, 20):      /* JR NZ,dd */
 			if (TSTFLAG(Z))
 				++PC;
 			else
 				PC += (int8)GET_BYTE(PC) + 1;
-			break;
+			Z80_NEXT;
 
-		case 0x21:      /* LD HL,nnnn */
+		Z80_CASE(main, 21):      /* LD HL,nnnn */
 			HL = GET_WORD(PC);
 			PC += 2;
-			break;
+			Z80_NEXT;
 
-		case 0x22:      /* LD (nnnn),HL */
+		Z80_CASE(main, 22):      /* LD (nnnn),HL */
 			temp = GET_WORD(PC);
 			PUT_WORD(temp, HL);
 			PC += 2;
-			break;
+			Z80_NEXT;
 
-		case 0x23:      /* INC HL */
+		Z80_CASE(main, 23):      /* INC HL */
 			++HL;
-			break;
+			Z80_NEXT;
 
-		case 0x24:      /* INC H */
+		Z80_CASE(main, 24):      /* INC H */
 			HL += 0x100;
 			temp = HIGH_REGISTER(HL);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80); /* SET_PV2 uses temp */
-			break;
+			Z80_NEXT;
 
-		case 0x25:      /* DEC H */
+		Z80_CASE(main, 25):      /* DEC H */
 			HL -= 0x100;
 			temp = HIGH_REGISTER(HL);
 			AF = (AF & ~0xfe) | decTable[temp] | SET_PV2(0x7f); /* SET_PV2 uses temp */
-			break;
+			Z80_NEXT;
 
-		case 0x26:      /* LD H,nn */
+		Z80_CASE(main, 26):      /* LD H,nn */
 			SET_HIGH_REGISTER(HL, RAM_PP(PC));
-			break;
+			Z80_NEXT;
 
-		case 0x27:      /* DAA */
+		Z80_CASE(main, 27):      /* DAA */
 			acu = HIGH_REGISTER(AF);
 			temp = LOW_DIGIT(acu);
 			cbits = TSTFLAG(C);
@@ -1730,350 +1905,350 @@ static inline void Z80run(void) {
 					acu += 0x60;   /* adjust high digit */
 			}
 			AF = (AF & 0x12) | rrdrldTable[acu & 0xff] | ((acu >> 8) & 1) | cbits;
-			break;
+			Z80_NEXT;
 
-		case 0x28:      /* JR Z,dd */
+		Z80_CASE(main, 28):      /* JR Z,dd */
 			if (TSTFLAG(Z))
 				PC += (int8)GET_BYTE(PC) + 1;
 			else
 				++PC;
-			break;
+			Z80_NEXT;
 
-		case 0x29:      /* ADD HL,HL */
+		Z80_CASE(main, 29):      /* ADD HL,HL */
 			HL &= ADDRMASK;
 			sum = HL + HL;
 			AF = (AF & ~0x3b) | cbitsDup16Table[sum >> 8];
 			HL = sum;
-			break;
+			Z80_NEXT;
 
-		case 0x2a:      /* LD HL,(nnnn) */
+		Z80_CASE(main, 2a):      /* LD HL,(nnnn) */
 			temp = GET_WORD(PC);
 			HL = GET_WORD(temp);
 			PC += 2;
-			break;
+			Z80_NEXT;
 
-		case 0x2b:      /* DEC HL */
+		Z80_CASE(main, 2b):      /* DEC HL */
 			--HL;
-			break;
+			Z80_NEXT;
 
-		case 0x2c:      /* INC L */
+		Z80_CASE(main, 2c):      /* INC L */
 			temp = LOW_REGISTER(HL) + 1;
 			SET_LOW_REGISTER(HL, temp);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80);
-			break;
+			Z80_NEXT;
 
-		case 0x2d:      /* DEC L */
+		Z80_CASE(main, 2d):      /* DEC L */
 			temp = LOW_REGISTER(HL) - 1;
 			SET_LOW_REGISTER(HL, temp);
 			AF = (AF & ~0xfe) | decTable[temp & 0xff] | SET_PV2(0x7f);
-			break;
+			Z80_NEXT;
 
-		case 0x2e:      /* LD L,nn */
+		Z80_CASE(main, 2e):      /* LD L,nn */
 			SET_LOW_REGISTER(HL, RAM_PP(PC));
-			break;
+			Z80_NEXT;
 
-		case 0x2f:      /* CPL */
+		Z80_CASE(main, 2f):      /* CPL */
 			AF = (~AF & ~0xff) | (AF & 0xc5) | ((~AF >> 8) & 0x28) | 0x12;
-			break;
+			Z80_NEXT;
 
-		case 0x30:      /* JR NC,dd */
+		Z80_CASE(main, 30):      /* JR NC,dd */
 			if (TSTFLAG(C))
 				++PC;
 			else
 				PC += (int8)GET_BYTE(PC) + 1;
-			break;
+			Z80_NEXT;
 
-		case 0x31:      /* LD SP,nnnn */
+		Z80_CASE(main, 31):      /* LD SP,nnnn */
 			SP = GET_WORD(PC);
 			PC += 2;
-			break;
+			Z80_NEXT;
 
-		case 0x32:      /* LD (nnnn),A */
+		Z80_CASE(main, 32):      /* LD (nnnn),A */
 			temp = GET_WORD(PC);
 			PUT_BYTE(temp, HIGH_REGISTER(AF));
 			PC += 2;
-			break;
+			Z80_NEXT;
 
-		case 0x33:      /* INC SP */
+		Z80_CASE(main, 33):      /* INC SP */
 			++SP;
-			break;
+			Z80_NEXT;
 
-		case 0x34:      /* INC (HL) */
+		Z80_CASE(main, 34):      /* INC (HL) */
 			temp = GET_BYTE(HL) + 1;
 			PUT_BYTE(HL, temp);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80);
-			break;
+			Z80_NEXT;
 
-		case 0x35:      /* DEC (HL) */
+		Z80_CASE(main, 35):      /* DEC (HL) */
 			temp = GET_BYTE(HL) - 1;
 			PUT_BYTE(HL, temp);
 			AF = (AF & ~0xfe) | decTable[temp & 0xff] | SET_PV2(0x7f);
-			break;
+			Z80_NEXT;
 
-		case 0x36:      /* LD (HL),nn */
+		Z80_CASE(main, 36):      /* LD (HL),nn */
 			PUT_BYTE(HL, RAM_PP(PC));
-			break;
+			Z80_NEXT;
 
-		case 0x37:      /* SCF */
+		Z80_CASE(main, 37):      /* SCF */
 			AF = (AF & ~0x3b) | ((AF >> 8) & 0x28) | 1;
-			break;
+			Z80_NEXT;
 
-		case 0x38:      /* JR C,dd */
+		Z80_CASE(main, 38):      /* JR C,dd */
 			if (TSTFLAG(C))
 				PC += (int8)GET_BYTE(PC) + 1;
 			else
 				++PC;
-			break;
+			Z80_NEXT;
 
-		case 0x39:      /* ADD HL,SP */
+		Z80_CASE(main, 39):      /* ADD HL,SP */
 			HL &= ADDRMASK;
 			SP &= ADDRMASK;
 			sum = HL + SP;
 			AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(HL ^ SP ^ sum) >> 8];
 			HL = sum;
-			break;
+			Z80_NEXT;
 
-		case 0x3a:      /* LD A,(nnnn) */
+		Z80_CASE(main, 3a):      /* LD A,(nnnn) */
 			temp = GET_WORD(PC);
 			SET_HIGH_REGISTER(AF, GET_BYTE(temp));
 			PC += 2;
-			break;
+			Z80_NEXT;
 
-		case 0x3b:      /* DEC SP */
+		Z80_CASE(main, 3b):      /* DEC SP */
 			--SP;
-			break;
+			Z80_NEXT;
 
-		case 0x3c:      /* INC A */
+		Z80_CASE(main, 3c):      /* INC A */
 			AF += 0x100;
 			temp = HIGH_REGISTER(AF);
 			AF = (AF & ~0xfe) | incTable[temp] | SET_PV2(0x80); /* SET_PV2 uses temp */
-			break;
+			Z80_NEXT;
 
-		case 0x3d:      /* DEC A */
+		Z80_CASE(main, 3d):      /* DEC A */
 			AF -= 0x100;
 			temp = HIGH_REGISTER(AF);
 			AF = (AF & ~0xfe) | decTable[temp] | SET_PV2(0x7f); /* SET_PV2 uses temp */
-			break;
+			Z80_NEXT;
 
-		case 0x3e:      /* LD A,nn */
+		Z80_CASE(main, 3e):      /* LD A,nn */
 			SET_HIGH_REGISTER(AF, RAM_PP(PC));
-			break;
+			Z80_NEXT;
 
-		case 0x3f:      /* CCF */
+		Z80_CASE(main, 3f):      /* CCF */
 			AF = (AF & ~0x3b) | ((AF >> 8) & 0x28) | ((AF & 1) << 4) | (~AF & 1);
-			break;
+			Z80_NEXT;
 
-		case 0x40:      /* LD B,B */
-			break;
+		Z80_CASE(main, 40):      /* LD B,B */
+			Z80_NEXT;
 
-		case 0x41:      /* LD B,C */
+		Z80_CASE(main, 41):      /* LD B,C */
 			BC = (BC & 0xff) | ((BC & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x42:      /* LD B,D */
+		Z80_CASE(main, 42):      /* LD B,D */
 			BC = (BC & 0xff) | (DE & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x43:      /* LD B,E */
+		Z80_CASE(main, 43):      /* LD B,E */
 			BC = (BC & 0xff) | ((DE & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x44:      /* LD B,H */
+		Z80_CASE(main, 44):      /* LD B,H */
 			BC = (BC & 0xff) | (HL & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x45:      /* LD B,L */
+		Z80_CASE(main, 45):      /* LD B,L */
 			BC = (BC & 0xff) | ((HL & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x46:      /* LD B,(HL) */
+		Z80_CASE(main, 46):      /* LD B,(HL) */
 			SET_HIGH_REGISTER(BC, GET_BYTE(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x47:      /* LD B,A */
+		Z80_CASE(main, 47):      /* LD B,A */
 			BC = (BC & 0xff) | (AF & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x48:      /* LD C,B */
+		Z80_CASE(main, 48):      /* LD C,B */
 			BC = (BC & ~0xff) | ((BC >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x49:      /* LD C,C */
-			break;
+		Z80_CASE(main, 49):      /* LD C,C */
+			Z80_NEXT;
 
-		case 0x4a:      /* LD C,D */
+		Z80_CASE(main, 4a):      /* LD C,D */
 			BC = (BC & ~0xff) | ((DE >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x4b:      /* LD C,E */
+		Z80_CASE(main, 4b):      /* LD C,E */
 			BC = (BC & ~0xff) | (DE & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x4c:      /* LD C,H */
+		Z80_CASE(main, 4c):      /* LD C,H */
 			BC = (BC & ~0xff) | ((HL >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x4d:      /* LD C,L */
+		Z80_CASE(main, 4d):      /* LD C,L */
 			BC = (BC & ~0xff) | (HL & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x4e:      /* LD C,(HL) */
+		Z80_CASE(main, 4e):      /* LD C,(HL) */
 			SET_LOW_REGISTER(BC, GET_BYTE(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x4f:      /* LD C,A */
+		Z80_CASE(main, 4f):      /* LD C,A */
 			BC = (BC & ~0xff) | ((AF >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x50:      /* LD D,B */
+		Z80_CASE(main, 50):      /* LD D,B */
 			DE = (DE & 0xff) | (BC & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x51:      /* LD D,C */
+		Z80_CASE(main, 51):      /* LD D,C */
 			DE = (DE & 0xff) | ((BC & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x52:      /* LD D,D */
-			break;
+		Z80_CASE(main, 52):      /* LD D,D */
+			Z80_NEXT;
 
-		case 0x53:      /* LD D,E */
+		Z80_CASE(main, 53):      /* LD D,E */
 			DE = (DE & 0xff) | ((DE & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x54:      /* LD D,H */
+		Z80_CASE(main, 54):      /* LD D,H */
 			DE = (DE & 0xff) | (HL & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x55:      /* LD D,L */
+		Z80_CASE(main, 55):      /* LD D,L */
 			DE = (DE & 0xff) | ((HL & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x56:      /* LD D,(HL) */
+		Z80_CASE(main, 56):      /* LD D,(HL) */
 			SET_HIGH_REGISTER(DE, GET_BYTE(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x57:      /* LD D,A */
+		Z80_CASE(main, 57):      /* LD D,A */
 			DE = (DE & 0xff) | (AF & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x58:      /* LD E,B */
+		Z80_CASE(main, 58):      /* LD E,B */
 			DE = (DE & ~0xff) | ((BC >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x59:      /* LD E,C */
+		Z80_CASE(main, 59):      /* LD E,C */
 			DE = (DE & ~0xff) | (BC & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x5a:      /* LD E,D */
+		Z80_CASE(main, 5a):      /* LD E,D */
 			DE = (DE & ~0xff) | ((DE >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x5b:      /* LD E,E */
-			break;
+		Z80_CASE(main, 5b):      /* LD E,E */
+			Z80_NEXT;
 
-		case 0x5c:      /* LD E,H */
+		Z80_CASE(main, 5c):      /* LD E,H */
 			DE = (DE & ~0xff) | ((HL >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x5d:      /* LD E,L */
+		Z80_CASE(main, 5d):      /* LD E,L */
 			DE = (DE & ~0xff) | (HL & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x5e:      /* LD E,(HL) */
+		Z80_CASE(main, 5e):      /* LD E,(HL) */
 			SET_LOW_REGISTER(DE, GET_BYTE(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x5f:      /* LD E,A */
+		Z80_CASE(main, 5f):      /* LD E,A */
 			DE = (DE & ~0xff) | ((AF >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x60:      /* LD H,B */
+		Z80_CASE(main, 60):      /* LD H,B */
 			HL = (HL & 0xff) | (BC & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x61:      /* LD H,C */
+		Z80_CASE(main, 61):      /* LD H,C */
 			HL = (HL & 0xff) | ((BC & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x62:      /* LD H,D */
+		Z80_CASE(main, 62):      /* LD H,D */
 			HL = (HL & 0xff) | (DE & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x63:      /* LD H,E */
+		Z80_CASE(main, 63):      /* LD H,E */
 			HL = (HL & 0xff) | ((DE & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x64:      /* LD H,H */
-			break;
+		Z80_CASE(main, 64):      /* LD H,H */
+			Z80_NEXT;
 
-		case 0x65:      /* LD H,L */
+		Z80_CASE(main, 65):      /* LD H,L */
 			HL = (HL & 0xff) | ((HL & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x66:      /* LD H,(HL) */
+		Z80_CASE(main, 66):      /* LD H,(HL) */
 			SET_HIGH_REGISTER(HL, GET_BYTE(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x67:      /* LD H,A */
+		Z80_CASE(main, 67):      /* LD H,A */
 			HL = (HL & 0xff) | (AF & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x68:      /* LD L,B */
+		Z80_CASE(main, 68):      /* LD L,B */
 			HL = (HL & ~0xff) | ((BC >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x69:      /* LD L,C */
+		Z80_CASE(main, 69):      /* LD L,C */
 			HL = (HL & ~0xff) | (BC & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x6a:      /* LD L,D */
+		Z80_CASE(main, 6a):      /* LD L,D */
 			HL = (HL & ~0xff) | ((DE >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x6b:      /* LD L,E */
+		Z80_CASE(main, 6b):      /* LD L,E */
 			HL = (HL & ~0xff) | (DE & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x6c:      /* LD L,H */
+		Z80_CASE(main, 6c):      /* LD L,H */
 			HL = (HL & ~0xff) | ((HL >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x6d:      /* LD L,L */
-			break;
+		Z80_CASE(main, 6d):      /* LD L,L */
+			Z80_NEXT;
 
-		case 0x6e:      /* LD L,(HL) */
+		Z80_CASE(main, 6e):      /* LD L,(HL) */
 			SET_LOW_REGISTER(HL, GET_BYTE(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x6f:      /* LD L,A */
+		Z80_CASE(main, 6f):      /* LD L,A */
 			HL = (HL & ~0xff) | ((AF >> 8) & 0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x70:      /* LD (HL),B */
+		Z80_CASE(main, 70):      /* LD (HL),B */
 			PUT_BYTE(HL, HIGH_REGISTER(BC));
-			break;
+			Z80_NEXT;
 
-		case 0x71:      /* LD (HL),C */
+		Z80_CASE(main, 71):      /* LD (HL),C */
 			PUT_BYTE(HL, LOW_REGISTER(BC));
-			break;
+			Z80_NEXT;
 
-		case 0x72:      /* LD (HL),D */
+		Z80_CASE(main, 72):      /* LD (HL),D */
 			PUT_BYTE(HL, HIGH_REGISTER(DE));
-			break;
+			Z80_NEXT;
 
-		case 0x73:      /* LD (HL),E */
+		Z80_CASE(main, 73):      /* LD (HL),E */
 			PUT_BYTE(HL, LOW_REGISTER(DE));
-			break;
+			Z80_NEXT;
 
-		case 0x74:      /* LD (HL),H */
+		Z80_CASE(main, 74):      /* LD (HL),H */
 			PUT_BYTE(HL, HIGH_REGISTER(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x75:      /* LD (HL),L */
+		Z80_CASE(main, 75):      /* LD (HL),L */
 			PUT_BYTE(HL, LOW_REGISTER(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x76:      /* HALT */
+		Z80_CASE(main, 76):      /* HALT */
 #ifdef DEBUG
 			_puts("\r\n::CPU HALTED::");	// A halt is a good indicator of broken code
 			_puts("Press any key...");
@@ -2081,383 +2256,383 @@ static inline void Z80run(void) {
 #endif
 			--PC;
 			goto end_decode;
-			break;
+			Z80_NEXT;
 
-		case 0x77:      /* LD (HL),A */
+		Z80_CASE(main, 77):      /* LD (HL),A */
 			PUT_BYTE(HL, HIGH_REGISTER(AF));
-			break;
+			Z80_NEXT;
 
-		case 0x78:      /* LD A,B */
+		Z80_CASE(main, 78):      /* LD A,B */
 			AF = (AF & 0xff) | (BC & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x79:      /* LD A,C */
+		Z80_CASE(main, 79):      /* LD A,C */
 			AF = (AF & 0xff) | ((BC & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x7a:      /* LD A,D */
+		Z80_CASE(main, 7a):      /* LD A,D */
 			AF = (AF & 0xff) | (DE & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x7b:      /* LD A,E */
+		Z80_CASE(main, 7b):      /* LD A,E */
 			AF = (AF & 0xff) | ((DE & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x7c:      /* LD A,H */
+		Z80_CASE(main, 7c):      /* LD A,H */
 			AF = (AF & 0xff) | (HL & ~0xff);
-			break;
+			Z80_NEXT;
 
-		case 0x7d:      /* LD A,L */
+		Z80_CASE(main, 7d):      /* LD A,L */
 			AF = (AF & 0xff) | ((HL & 0xff) << 8);
-			break;
+			Z80_NEXT;
 
-		case 0x7e:      /* LD A,(HL) */
+		Z80_CASE(main, 7e):      /* LD A,(HL) */
 			SET_HIGH_REGISTER(AF, GET_BYTE(HL));
-			break;
+			Z80_NEXT;
 
-		case 0x7f:      /* LD A,A */
-			break;
+		Z80_CASE(main, 7f):      /* LD A,A */
+			Z80_NEXT;
 
-		case 0x80:      /* ADD A,B */
+		Z80_CASE(main, 80):      /* ADD A,B */
 			temp = HIGH_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x81:      /* ADD A,C */
+		Z80_CASE(main, 81):      /* ADD A,C */
 			temp = LOW_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x82:      /* ADD A,D */
+		Z80_CASE(main, 82):      /* ADD A,D */
 			temp = HIGH_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x83:      /* ADD A,E */
+		Z80_CASE(main, 83):      /* ADD A,E */
 			temp = LOW_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x84:      /* ADD A,H */
+		Z80_CASE(main, 84):      /* ADD A,H */
 			temp = HIGH_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x85:      /* ADD A,L */
+		Z80_CASE(main, 85):      /* ADD A,L */
 			temp = LOW_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x86:      /* ADD A,(HL) */
+		Z80_CASE(main, 86):      /* ADD A,(HL) */
 			temp = GET_BYTE(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x87:      /* ADD A,A */
+		Z80_CASE(main, 87):      /* ADD A,A */
 			cbits = 2 * HIGH_REGISTER(AF);
 			AF = cbitsDup8Table[cbits] | (SET_PVS(cbits));
-			break;
+			Z80_NEXT;
 
-		case 0x88:      /* ADC A,B */
+		Z80_CASE(main, 88):      /* ADC A,B */
 			temp = HIGH_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x89:      /* ADC A,C */
+		Z80_CASE(main, 89):      /* ADC A,C */
 			temp = LOW_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x8a:      /* ADC A,D */
+		Z80_CASE(main, 8a):      /* ADC A,D */
 			temp = HIGH_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x8b:      /* ADC A,E */
+		Z80_CASE(main, 8b):      /* ADC A,E */
 			temp = LOW_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x8c:      /* ADC A,H */
+		Z80_CASE(main, 8c):      /* ADC A,H */
 			temp = HIGH_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x8d:      /* ADC A,L */
+		Z80_CASE(main, 8d):      /* ADC A,L */
 			temp = LOW_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x8e:      /* ADC A,(HL) */
+		Z80_CASE(main, 8e):      /* ADC A,(HL) */
 			temp = GET_BYTE(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x8f:      /* ADC A,A */
+		Z80_CASE(main, 8f):      /* ADC A,A */
 			cbits = 2 * HIGH_REGISTER(AF) + TSTFLAG(C);
 			AF = cbitsDup8Table[cbits] | (SET_PVS(cbits));
-			break;
+			Z80_NEXT;
 
-		case 0x90:      /* SUB B */
+		Z80_CASE(main, 90):      /* SUB B */
 			temp = HIGH_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x91:      /* SUB C */
+		Z80_CASE(main, 91):      /* SUB C */
 			temp = LOW_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x92:      /* SUB D */
+		Z80_CASE(main, 92):      /* SUB D */
 			temp = HIGH_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x93:      /* SUB E */
+		Z80_CASE(main, 93):      /* SUB E */
 			temp = LOW_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x94:      /* SUB H */
+		Z80_CASE(main, 94):      /* SUB H */
 			temp = HIGH_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x95:      /* SUB L */
+		Z80_CASE(main, 95):      /* SUB L */
 			temp = LOW_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x96:      /* SUB (HL) */
+		Z80_CASE(main, 96):      /* SUB (HL) */
 			temp = GET_BYTE(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x97:      /* SUB A */
+		Z80_CASE(main, 97):      /* SUB A */
 			AF = 0x42;
-			break;
+			Z80_NEXT;
 
-		case 0x98:      /* SBC A,B */
+		Z80_CASE(main, 98):      /* SBC A,B */
 			temp = HIGH_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x99:      /* SBC A,C */
+		Z80_CASE(main, 99):      /* SBC A,C */
 			temp = LOW_REGISTER(BC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x9a:      /* SBC A,D */
+		Z80_CASE(main, 9a):      /* SBC A,D */
 			temp = HIGH_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x9b:      /* SBC A,E */
+		Z80_CASE(main, 9b):      /* SBC A,E */
 			temp = LOW_REGISTER(DE);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x9c:      /* SBC A,H */
+		Z80_CASE(main, 9c):      /* SBC A,H */
 			temp = HIGH_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x9d:      /* SBC A,L */
+		Z80_CASE(main, 9d):      /* SBC A,L */
 			temp = LOW_REGISTER(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x9e:      /* SBC A,(HL) */
+		Z80_CASE(main, 9e):      /* SBC A,(HL) */
 			temp = GET_BYTE(HL);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0x9f:      /* SBC A,A */
+		Z80_CASE(main, 9f):      /* SBC A,A */
 			cbits = -TSTFLAG(C);
 			AF = subTable[cbits & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PVS(cbits));
-			break;
+			Z80_NEXT;
 
-		case 0xa0:      /* AND B */
+		Z80_CASE(main, a0):      /* AND B */
 			AF = andTable[((AF & BC) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa1:      /* AND C */
+		Z80_CASE(main, a1):      /* AND C */
 			AF = andTable[((AF >> 8)& BC) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa2:      /* AND D */
+		Z80_CASE(main, a2):      /* AND D */
 			AF = andTable[((AF & DE) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa3:      /* AND E */
+		Z80_CASE(main, a3):      /* AND E */
 			AF = andTable[((AF >> 8)& DE) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa4:      /* AND H */
+		Z80_CASE(main, a4):      /* AND H */
 			AF = andTable[((AF & HL) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa5:      /* AND L */
+		Z80_CASE(main, a5):      /* AND L */
 			AF = andTable[((AF >> 8)& HL) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa6:      /* AND (HL) */
+		Z80_CASE(main, a6):      /* AND (HL) */
 			AF = andTable[((AF >> 8)& GET_BYTE(HL)) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa7:      /* AND A */
+		Z80_CASE(main, a7):      /* AND A */
 			AF = andTable[(AF >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa8:      /* XOR B */
+		Z80_CASE(main, a8):      /* XOR B */
 			AF = xororTable[((AF ^ BC) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xa9:      /* XOR C */
+		Z80_CASE(main, a9):      /* XOR C */
 			AF = xororTable[((AF >> 8) ^ BC) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xaa:      /* XOR D */
+		Z80_CASE(main, aa):      /* XOR D */
 			AF = xororTable[((AF ^ DE) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xab:      /* XOR E */
+		Z80_CASE(main, ab):      /* XOR E */
 			AF = xororTable[((AF >> 8) ^ DE) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xac:      /* XOR H */
+		Z80_CASE(main, ac):      /* XOR H */
 			AF = xororTable[((AF ^ HL) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xad:      /* XOR L */
+		Z80_CASE(main, ad):      /* XOR L */
 			AF = xororTable[((AF >> 8) ^ HL) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xae:      /* XOR (HL) */
+		Z80_CASE(main, ae):      /* XOR (HL) */
 			AF = xororTable[((AF >> 8) ^ GET_BYTE(HL)) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xaf:      /* XOR A */
+		Z80_CASE(main, af):      /* XOR A */
 			AF = 0x44;
-			break;
+			Z80_NEXT;
 
-		case 0xb0:      /* OR B */
+		Z80_CASE(main, b0):      /* OR B */
 			AF = xororTable[((AF | BC) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xb1:      /* OR C */
+		Z80_CASE(main, b1):      /* OR C */
 			AF = xororTable[((AF >> 8) | BC) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xb2:      /* OR D */
+		Z80_CASE(main, b2):      /* OR D */
 			AF = xororTable[((AF | DE) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xb3:      /* OR E */
+		Z80_CASE(main, b3):      /* OR E */
 			AF = xororTable[((AF >> 8) | DE) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xb4:      /* OR H */
+		Z80_CASE(main, b4):      /* OR H */
 			AF = xororTable[((AF | HL) >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xb5:      /* OR L */
+		Z80_CASE(main, b5):      /* OR L */
 			AF = xororTable[((AF >> 8) | HL) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xb6:      /* OR (HL) */
+		Z80_CASE(main, b6):      /* OR (HL) */
 			AF = xororTable[((AF >> 8) | GET_BYTE(HL)) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xb7:      /* OR A */
+		Z80_CASE(main, b7):      /* OR A */
 			AF = xororTable[(AF >> 8) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xb8:      /* CP B */
+		Z80_CASE(main, b8):      /* CP B */
 			temp = HIGH_REGISTER(BC);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2465,9 +2640,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			Z80_NEXT;
 
-		case 0xb9:      /* CP C */
+		Z80_CASE(main, b9):      /* CP C */
 			temp = LOW_REGISTER(BC);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2475,9 +2650,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			Z80_NEXT;
 
-		case 0xba:      /* CP D */
+		Z80_CASE(main, ba):      /* CP D */
 			temp = HIGH_REGISTER(DE);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2485,9 +2660,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			Z80_NEXT;
 
-		case 0xbb:      /* CP E */
+		Z80_CASE(main, bb):      /* CP E */
 			temp = LOW_REGISTER(DE);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2495,9 +2670,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			Z80_NEXT;
 
-		case 0xbc:      /* CP H */
+		Z80_CASE(main, bc):      /* CP H */
 			temp = HIGH_REGISTER(HL);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2505,9 +2680,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			Z80_NEXT;
 
-		case 0xbd:      /* CP L */
+		Z80_CASE(main, bd):      /* CP L */
 			temp = LOW_REGISTER(HL);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2515,9 +2690,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			Z80_NEXT;
 
-		case 0xbe:      /* CP (HL) */
+		Z80_CASE(main, be):      /* CP (HL) */
 			temp = GET_BYTE(HL);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -2525,64 +2700,64 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			Z80_NEXT;
 
-		case 0xbf:      /* CP A */
+		Z80_CASE(main, bf):      /* CP A */
 			SET_LOW_REGISTER(AF, (HIGH_REGISTER(AF) & 0x28) | 0x42);
-			break;
+			Z80_NEXT;
 
-		case 0xc0:      /* RET NZ */
+		Z80_CASE(main, c0):      /* RET NZ */
 			if (!(TSTFLAG(Z)))
 				POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xc1:      /* POP BC */
+		Z80_CASE(main, c1):      /* POP BC */
 			POP(BC);
-			break;
+			Z80_NEXT;
 
-		case 0xc2:      /* JP NZ,nnnn */
+		Z80_CASE(main, c2):      /* JP NZ,nnnn */
 			JPC(!TSTFLAG(Z));
-			break;
+			Z80_NEXT;
 
-		case 0xc3:      /* JP nnnn */
+		Z80_CASE(main, c3):      /* JP nnnn */
 			JPC(1);
-			break;
+			Z80_NEXT;
 
-		case 0xc4:      /* CALL NZ,nnnn */
+		Z80_CASE(main, c4):      /* CALL NZ,nnnn */
 			CALLC(!TSTFLAG(Z));
-			break;
+			Z80_NEXT;
 
-		case 0xc5:      /* PUSH BC */
+		Z80_CASE(main, c5):      /* PUSH BC */
 			PUSH(BC);
-			break;
+			Z80_NEXT;
 
-		case 0xc6:      /* ADD A,nn */
+		Z80_CASE(main, c6):      /* ADD A,nn */
 			temp = RAM_PP(PC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp;
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0xc7:      /* RST 0 */
+		Z80_CASE(main, c7):      /* RST 0 */
 			PUSH(PC);
 			PC = 0;
-			break;
+			Z80_NEXT;
 
-		case 0xc8:      /* RET Z */
+		Z80_CASE(main, c8):      /* RET Z */
 			if (TSTFLAG(Z))
 				POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xc9:      /* RET */
+		Z80_CASE(main, c9):      /* RET */
 			POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xca:      /* JP Z,nnnn */
+		Z80_CASE(main, ca):      /* JP Z,nnnn */
 			JPC(TSTFLAG(Z));
-			break;
+			Z80_NEXT;
 
-		case 0xcb:      /* CB prefix */
+		Z80_CASE(main, cb):      /* CB prefix */
 			INCR(1); /* Add one M1 cycle to refresh counter */
 			adr = HL;
 			switch ((op = GET_BYTE(PC)) & 7) {
@@ -2727,73 +2902,73 @@ static inline void Z80run(void) {
 				SET_HIGH_REGISTER(AF, temp);
 				break;
 			}
-			break;
+			Z80_NEXT;
 
-		case 0xcc:      /* CALL Z,nnnn */
+		Z80_CASE(main, cc):      /* CALL Z,nnnn */
 			CALLC(TSTFLAG(Z));
-			break;
+			Z80_NEXT;
 
-		case 0xcd:      /* CALL nnnn */
+		Z80_CASE(main, cd):      /* CALL nnnn */
 			CALLC(1);
-			break;
+			Z80_NEXT;
 
-		case 0xce:      /* ADC A,nn */
+		Z80_CASE(main, ce):      /* ADC A,nn */
 			temp = RAM_PP(PC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu + temp + TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = addTable[sum] | cbitsTable[cbits] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0xcf:      /* RST 8 */
+		Z80_CASE(main, cf):      /* RST 8 */
 			PUSH(PC);
 			PC = 8;
-			break;
+			Z80_NEXT;
 
-		case 0xd0:      /* RET NC */
+		Z80_CASE(main, d0):      /* RET NC */
 			if (!(TSTFLAG(C)))
 				POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xd1:      /* POP DE */
+		Z80_CASE(main, d1):      /* POP DE */
 			POP(DE);
-			break;
+			Z80_NEXT;
 
-		case 0xd2:      /* JP NC,nnnn */
+		Z80_CASE(main, d2):      /* JP NC,nnnn */
 			JPC(!TSTFLAG(C));
-			break;
+			Z80_NEXT;
 
-		case 0xd3:      /* OUT (nn),A */
+		Z80_CASE(main, d3):      /* OUT (nn),A */
 			cpu_out(RAM_PP(PC), HIGH_REGISTER(AF));
-			break;
+			Z80_NEXT;
 
-		case 0xd4:      /* CALL NC,nnnn */
+		Z80_CASE(main, d4):      /* CALL NC,nnnn */
 			CALLC(!TSTFLAG(C));
-			break;
+			Z80_NEXT;
 
-		case 0xd5:      /* PUSH DE */
+		Z80_CASE(main, d5):      /* PUSH DE */
 			PUSH(DE);
-			break;
+			Z80_NEXT;
 
-		case 0xd6:      /* SUB nn */
+		Z80_CASE(main, d6):      /* SUB nn */
 			temp = RAM_PP(PC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp;
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0xd7:      /* RST 10H */
+		Z80_CASE(main, d7):      /* RST 10H */
 			PUSH(PC);
 			PC = 0x10;
-			break;
+			Z80_NEXT;
 
-		case 0xd8:      /* RET C */
+		Z80_CASE(main, d8):      /* RET C */
 			if (TSTFLAG(C))
 				POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xd9:      /* EXX */
+		Z80_CASE(main, d9):      /* EXX */
 			temp = BC;
 			BC = BC1;
 			BC1 = temp;
@@ -2803,431 +2978,432 @@ static inline void Z80run(void) {
 			temp = HL;
 			HL = HL1;
 			HL1 = temp;
-			break;
+			Z80_NEXT;
 
-		case 0xda:      /* JP C,nnnn */
+		Z80_CASE(main, da):      /* JP C,nnnn */
 			JPC(TSTFLAG(C));
-			break;
+			Z80_NEXT;
 
-		case 0xdb:      /* IN A,(nn) */
+		Z80_CASE(main, db):      /* IN A,(nn) */
 			SET_HIGH_REGISTER(AF, cpu_in(RAM_PP(PC)));
-			break;
+			Z80_NEXT;
 
-		case 0xdc:      /* CALL C,nnnn */
+		Z80_CASE(main, dc):      /* CALL C,nnnn */
 			CALLC(TSTFLAG(C));
-			break;
+			Z80_NEXT;
 
-		case 0xdd:      /* DD prefix */
+		Z80_CASE(main, dd):      /* DD prefix */
 			INCR(1); /* Add one M1 cycle to refresh counter */
+			Z80_DISPATCH(dd);
 			switch (RAM_PP(PC)) {
 
-			case 0x09:      /* ADD IX,BC */
+			Z80_CASE(dd, 09):      /* ADD IX,BC */
 				IX &= ADDRMASK;
 				BC &= ADDRMASK;
 				sum = IX + BC;
 				AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(IX ^ BC ^ sum) >> 8];
 				IX = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x19:      /* ADD IX,DE */
+			Z80_CASE(dd, 19):      /* ADD IX,DE */
 				IX &= ADDRMASK;
 				DE &= ADDRMASK;
 				sum = IX + DE;
 				AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(IX ^ DE ^ sum) >> 8];
 				IX = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x21:      /* LD IX,nnnn */
+			Z80_CASE(dd, 21):      /* LD IX,nnnn */
 				IX = GET_WORD(PC);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x22:      /* LD (nnnn),IX */
+			Z80_CASE(dd, 22):      /* LD (nnnn),IX */
 				temp = GET_WORD(PC);
 				PUT_WORD(temp, IX);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x23:      /* INC IX */
+			Z80_CASE(dd, 23):      /* INC IX */
 				++IX;
-				break;
+				Z80_NEXT;
 
-			case 0x24:      /* INC IXH */
+			Z80_CASE(dd, 24):      /* INC IXH */
 				IX += 0x100;
 				AF = (AF & ~0xfe) | incZ80Table[HIGH_REGISTER(IX)];
-				break;
+				Z80_NEXT;
 
-			case 0x25:      /* DEC IXH */
+			Z80_CASE(dd, 25):      /* DEC IXH */
 				IX -= 0x100;
 				AF = (AF & ~0xfe) | decZ80Table[HIGH_REGISTER(IX)];
-				break;
+				Z80_NEXT;
 
-			case 0x26:      /* LD IXH,nn */
+			Z80_CASE(dd, 26):      /* LD IXH,nn */
 				SET_HIGH_REGISTER(IX, RAM_PP(PC));
-				break;
+				Z80_NEXT;
 
-			case 0x29:      /* ADD IX,IX */
+			Z80_CASE(dd, 29):      /* ADD IX,IX */
 				IX &= ADDRMASK;
 				sum = IX + IX;
 				AF = (AF & ~0x3b) | cbitsDup16Table[sum >> 8];
 				IX = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x2a:      /* LD IX,(nnnn) */
+			Z80_CASE(dd, 2a):      /* LD IX,(nnnn) */
 				temp = GET_WORD(PC);
 				IX = GET_WORD(temp);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x2b:      /* DEC IX */
+			Z80_CASE(dd, 2b):      /* DEC IX */
 				--IX;
-				break;
+				Z80_NEXT;
 
-			case 0x2c:      /* INC IXL */
+			Z80_CASE(dd, 2c):      /* INC IXL */
 				temp = LOW_REGISTER(IX) + 1;
 				SET_LOW_REGISTER(IX, temp);
 				AF = (AF & ~0xfe) | incZ80Table[temp];
-				break;
+				Z80_NEXT;
 
-			case 0x2d:      /* DEC IXL */
+			Z80_CASE(dd, 2d):      /* DEC IXL */
 				temp = LOW_REGISTER(IX) - 1;
 				SET_LOW_REGISTER(IX, temp);
 				AF = (AF & ~0xfe) | decZ80Table[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x2e:      /* LD IXL,nn */
+			Z80_CASE(dd, 2e):      /* LD IXL,nn */
 				SET_LOW_REGISTER(IX, RAM_PP(PC));
-				break;
+				Z80_NEXT;
 
-			case 0x34:      /* INC (IX+dd) */
+			Z80_CASE(dd, 34):      /* INC (IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr) + 1;
 				PUT_BYTE(adr, temp);
 				AF = (AF & ~0xfe) | incZ80Table[temp];
-				break;
+				Z80_NEXT;
 
-			case 0x35:      /* DEC (IX+dd) */
+			Z80_CASE(dd, 35):      /* DEC (IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr) - 1;
 				PUT_BYTE(adr, temp);
 				AF = (AF & ~0xfe) | decZ80Table[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x36:      /* LD (IX+dd),nn */
+			Z80_CASE(dd, 36):      /* LD (IX+dd),nn */
 				adr = IX + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, RAM_PP(PC));
-				break;
+				Z80_NEXT;
 
-			case 0x39:      /* ADD IX,SP */
+			Z80_CASE(dd, 39):      /* ADD IX,SP */
 				IX &= ADDRMASK;
 				SP &= ADDRMASK;
 				sum = IX + SP;
 				AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(IX ^ SP ^ sum) >> 8];
 				IX = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x44:      /* LD B,IXH */
+			Z80_CASE(dd, 44):      /* LD B,IXH */
 				SET_HIGH_REGISTER(BC, HIGH_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x45:      /* LD B,IXL */
+			Z80_CASE(dd, 45):      /* LD B,IXL */
 				SET_HIGH_REGISTER(BC, LOW_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x46:      /* LD B,(IX+dd) */
+			Z80_CASE(dd, 46):      /* LD B,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				SET_HIGH_REGISTER(BC, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x4c:      /* LD C,IXH */
+			Z80_CASE(dd, 4c):      /* LD C,IXH */
 				SET_LOW_REGISTER(BC, HIGH_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x4d:      /* LD C,IXL */
+			Z80_CASE(dd, 4d):      /* LD C,IXL */
 				SET_LOW_REGISTER(BC, LOW_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x4e:      /* LD C,(IX+dd) */
+			Z80_CASE(dd, 4e):      /* LD C,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				SET_LOW_REGISTER(BC, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x54:      /* LD D,IXH */
+			Z80_CASE(dd, 54):      /* LD D,IXH */
 				SET_HIGH_REGISTER(DE, HIGH_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x55:      /* LD D,IXL */
+			Z80_CASE(dd, 55):      /* LD D,IXL */
 				SET_HIGH_REGISTER(DE, LOW_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x56:      /* LD D,(IX+dd) */
+			Z80_CASE(dd, 56):      /* LD D,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				SET_HIGH_REGISTER(DE, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x5c:      /* LD E,IXH */
+			Z80_CASE(dd, 5c):      /* LD E,IXH */
 				SET_LOW_REGISTER(DE, HIGH_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x5d:      /* LD E,IXL */
+			Z80_CASE(dd, 5d):      /* LD E,IXL */
 				SET_LOW_REGISTER(DE, LOW_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x5e:      /* LD E,(IX+dd) */
+			Z80_CASE(dd, 5e):      /* LD E,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				SET_LOW_REGISTER(DE, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x60:      /* LD IXH,B */
+			Z80_CASE(dd, 60):      /* LD IXH,B */
 				SET_HIGH_REGISTER(IX, HIGH_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x61:      /* LD IXH,C */
+			Z80_CASE(dd, 61):      /* LD IXH,C */
 				SET_HIGH_REGISTER(IX, LOW_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x62:      /* LD IXH,D */
+			Z80_CASE(dd, 62):      /* LD IXH,D */
 				SET_HIGH_REGISTER(IX, HIGH_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x63:      /* LD IXH,E */
+			Z80_CASE(dd, 63):      /* LD IXH,E */
 				SET_HIGH_REGISTER(IX, LOW_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x64:      /* LD IXH,IXH */
-				break;
+			Z80_CASE(dd, 64):      /* LD IXH,IXH */
+				Z80_NEXT;
 
-			case 0x65:      /* LD IXH,IXL */
+			Z80_CASE(dd, 65):      /* LD IXH,IXL */
 				SET_HIGH_REGISTER(IX, LOW_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x66:      /* LD H,(IX+dd) */
+			Z80_CASE(dd, 66):      /* LD H,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				SET_HIGH_REGISTER(HL, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x67:      /* LD IXH,A */
+			Z80_CASE(dd, 67):      /* LD IXH,A */
 				SET_HIGH_REGISTER(IX, HIGH_REGISTER(AF));
-				break;
+				Z80_NEXT;
 
-			case 0x68:      /* LD IXL,B */
+			Z80_CASE(dd, 68):      /* LD IXL,B */
 				SET_LOW_REGISTER(IX, HIGH_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x69:      /* LD IXL,C */
+			Z80_CASE(dd, 69):      /* LD IXL,C */
 				SET_LOW_REGISTER(IX, LOW_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x6a:      /* LD IXL,D */
+			Z80_CASE(dd, 6a):      /* LD IXL,D */
 				SET_LOW_REGISTER(IX, HIGH_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x6b:      /* LD IXL,E */
+			Z80_CASE(dd, 6b):      /* LD IXL,E */
 				SET_LOW_REGISTER(IX, LOW_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x6c:      /* LD IXL,IXH */
+			Z80_CASE(dd, 6c):      /* LD IXL,IXH */
 				SET_LOW_REGISTER(IX, HIGH_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x6d:      /* LD IXL,IXL */
-				break;
+			Z80_CASE(dd, 6d):      /* LD IXL,IXL */
+				Z80_NEXT;
 
-			case 0x6e:      /* LD L,(IX+dd) */
+			Z80_CASE(dd, 6e):      /* LD L,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				SET_LOW_REGISTER(HL, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x6f:      /* LD IXL,A */
+			Z80_CASE(dd, 6f):      /* LD IXL,A */
 				SET_LOW_REGISTER(IX, HIGH_REGISTER(AF));
-				break;
+				Z80_NEXT;
 
-			case 0x70:      /* LD (IX+dd),B */
+			Z80_CASE(dd, 70):      /* LD (IX+dd),B */
 				adr = IX + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, HIGH_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x71:      /* LD (IX+dd),C */
+			Z80_CASE(dd, 71):      /* LD (IX+dd),C */
 				adr = IX + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, LOW_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x72:      /* LD (IX+dd),D */
+			Z80_CASE(dd, 72):      /* LD (IX+dd),D */
 				adr = IX + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, HIGH_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x73:      /* LD (IX+dd),E */
+			Z80_CASE(dd, 73):      /* LD (IX+dd),E */
 				adr = IX + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, LOW_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x74:      /* LD (IX+dd),H */
+			Z80_CASE(dd, 74):      /* LD (IX+dd),H */
 				adr = IX + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, HIGH_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0x75:      /* LD (IX+dd),L */
+			Z80_CASE(dd, 75):      /* LD (IX+dd),L */
 				adr = IX + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, LOW_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0x77:      /* LD (IX+dd),A */
+			Z80_CASE(dd, 77):      /* LD (IX+dd),A */
 				adr = IX + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, HIGH_REGISTER(AF));
-				break;
+				Z80_NEXT;
 
-			case 0x7c:      /* LD A,IXH */
+			Z80_CASE(dd, 7c):      /* LD A,IXH */
 				SET_HIGH_REGISTER(AF, HIGH_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x7d:      /* LD A,IXL */
+			Z80_CASE(dd, 7d):      /* LD A,IXL */
 				SET_HIGH_REGISTER(AF, LOW_REGISTER(IX));
-				break;
+				Z80_NEXT;
 
-			case 0x7e:      /* LD A,(IX+dd) */
+			Z80_CASE(dd, 7e):      /* LD A,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				SET_HIGH_REGISTER(AF, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x84:      /* ADD A,IXH */
+			Z80_CASE(dd, 84):      /* ADD A,IXH */
 				temp = HIGH_REGISTER(IX);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp;
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x85:      /* ADD A,IXL */
+			Z80_CASE(dd, 85):      /* ADD A,IXL */
 				temp = LOW_REGISTER(IX);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp;
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x86:      /* ADD A,(IX+dd) */
+			Z80_CASE(dd, 86):      /* ADD A,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp;
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x8c:      /* ADC A,IXH */
+			Z80_CASE(dd, 8c):      /* ADC A,IXH */
 				temp = HIGH_REGISTER(IX);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp + TSTFLAG(C);
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x8d:      /* ADC A,IXL */
+			Z80_CASE(dd, 8d):      /* ADC A,IXL */
 				temp = LOW_REGISTER(IX);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp + TSTFLAG(C);
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x8e:      /* ADC A,(IX+dd) */
+			Z80_CASE(dd, 8e):      /* ADC A,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp + TSTFLAG(C);
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x96:      /* SUB (IX+dd) */
+			Z80_CASE(dd, 96):      /* SUB (IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp;
 				AF = addTable[sum & 0xff] | cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0x94:      /* SUB IXH */
+			Z80_CASE(dd, 94):      /* SUB IXH */
 				SETFLAG(C, 0);/* fall through, a bit less efficient but smaller code */
 
-			case 0x9c:      /* SBC A,IXH */
+			Z80_CASE(dd, 9c):      /* SBC A,IXH */
 				temp = HIGH_REGISTER(IX);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp - TSTFLAG(C);
 				AF = addTable[sum & 0xff] | cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0x95:      /* SUB IXL */
+			Z80_CASE(dd, 95):      /* SUB IXL */
 				SETFLAG(C, 0);/* fall through, a bit less efficient but smaller code */
 
-			case 0x9d:      /* SBC A,IXL */
+			Z80_CASE(dd, 9d):      /* SBC A,IXL */
 				temp = LOW_REGISTER(IX);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp - TSTFLAG(C);
 				AF = addTable[sum & 0xff] | cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0x9e:      /* SBC A,(IX+dd) */
+			Z80_CASE(dd, 9e):      /* SBC A,(IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp - TSTFLAG(C);
 				AF = addTable[sum & 0xff] | cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0xa4:      /* AND IXH */
+			Z80_CASE(dd, a4):      /* AND IXH */
 				AF = andTable[((AF & IX) >> 8) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xa5:      /* AND IXL */
+			Z80_CASE(dd, a5):      /* AND IXL */
 				AF = andTable[((AF >> 8)& IX) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xa6:      /* AND (IX+dd) */
+			Z80_CASE(dd, a6):      /* AND (IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				AF = andTable[((AF >> 8)& GET_BYTE(adr)) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xac:      /* XOR IXH */
+			Z80_CASE(dd, ac):      /* XOR IXH */
 				AF = xororTable[((AF ^ IX) >> 8) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xad:      /* XOR IXL */
+			Z80_CASE(dd, ad):      /* XOR IXL */
 				AF = xororTable[((AF >> 8) ^ IX) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xae:      /* XOR (IX+dd) */
+			Z80_CASE(dd, ae):      /* XOR (IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				AF = xororTable[((AF >> 8) ^ GET_BYTE(adr)) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xb4:      /* OR IXH */
+			Z80_CASE(dd, b4):      /* OR IXH */
 				AF = xororTable[((AF | IX) >> 8) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xb5:      /* OR IXL */
+			Z80_CASE(dd, b5):      /* OR IXL */
 				AF = xororTable[((AF >> 8) | IX) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xb6:      /* OR (IX+dd) */
+			Z80_CASE(dd, b6):      /* OR (IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				AF = xororTable[((AF >> 8) | GET_BYTE(adr)) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xbc:      /* CP IXH */
+			Z80_CASE(dd, bc):      /* CP IXH */
 				temp = HIGH_REGISTER(IX);
 				AF = (AF & ~0x28) | (temp & 0x28);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp;
 				AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 					cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0xbd:      /* CP IXL */
+			Z80_CASE(dd, bd):      /* CP IXL */
 				temp = LOW_REGISTER(IX);
 				AF = (AF & ~0x28) | (temp & 0x28);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp;
 				AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 					cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0xbe:      /* CP (IX+dd) */
+			Z80_CASE(dd, be):      /* CP (IX+dd) */
 				adr = IX + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				AF = (AF & ~0x28) | (temp & 0x28);
@@ -3235,9 +3411,9 @@ static inline void Z80run(void) {
 				sum = acu - temp;
 				AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 					cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0xcb:      /* CB prefix */
+			Z80_CASE(dd, cb):      /* CB prefix */
 				adr = IX + (int8)RAM_PP(PC);
 				switch ((op = GET_BYTE(PC)) & 7) {
 
@@ -3381,403 +3557,404 @@ static inline void Z80run(void) {
 					SET_HIGH_REGISTER(AF, temp);
 					break;
 				}
-				break;
+				Z80_NEXT;
 
-			case 0xe1:      /* POP IX */
+			Z80_CASE(dd, e1):      /* POP IX */
 				POP(IX);
-				break;
+				Z80_NEXT;
 
-			case 0xe3:      /* EX (SP),IX */
+			Z80_CASE(dd, e3):      /* EX (SP),IX */
 				temp = IX;
 				POP(IX);
 				PUSH(temp);
-				break;
+				Z80_NEXT;
 
-			case 0xe5:      /* PUSH IX */
+			Z80_CASE(dd, e5):      /* PUSH IX */
 				PUSH(IX);
-				break;
+				Z80_NEXT;
 
-			case 0xe9:      /* JP (IX) */
+			Z80_CASE(dd, e9):      /* JP (IX) */
 				PC = IX;
-				break;
+				Z80_NEXT;
 
-			case 0xf9:      /* LD SP,IX */
+			Z80_CASE(dd, f9):      /* LD SP,IX */
 				SP = IX;
-				break;
+				Z80_NEXT;
 
-			default:                /* ignore DD */
+			Z80_DEFAULT(dd):                /* ignore DD */
 				--PC;
 			}
-			break;
+			Z80_NEXT;
 
-		case 0xde:          /* SBC A,nn */
+		Z80_CASE(main, de):          /* SBC A,nn */
 			temp = RAM_PP(PC);
 			acu = HIGH_REGISTER(AF);
 			sum = acu - temp - TSTFLAG(C);
 			cbits = acu ^ temp ^ sum;
 			AF = subTable[sum & 0xff] | cbitsTable[cbits & 0x1ff] | (SET_PV);
-			break;
+			Z80_NEXT;
 
-		case 0xdf:      /* RST 18H */
+		Z80_CASE(main, df):      /* RST 18H */
 			PUSH(PC);
 			PC = 0x18;
-			break;
+			Z80_NEXT;
 
-		case 0xe0:      /* RET PO */
+		Z80_CASE(main, e0):      /* RET PO */
 			if (!(TSTFLAG(P)))
 				POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xe1:      /* POP HL */
+		Z80_CASE(main, e1):      /* POP HL */
 			POP(HL);
-			break;
+			Z80_NEXT;
 
-		case 0xe2:      /* JP PO,nnnn */
+		Z80_CASE(main, e2):      /* JP PO,nnnn */
 			JPC(!TSTFLAG(P));
-			break;
+			Z80_NEXT;
 
-		case 0xe3:      /* EX (SP),HL */
+		Z80_CASE(main, e3):      /* EX (SP),HL */
 			temp = HL;
 			POP(HL);
 			PUSH(temp);
-			break;
+			Z80_NEXT;
 
-		case 0xe4:      /* CALL PO,nnnn */
+		Z80_CASE(main, e4):      /* CALL PO,nnnn */
 			CALLC(!TSTFLAG(P));
-			break;
+			Z80_NEXT;
 
-		case 0xe5:      /* PUSH HL */
+		Z80_CASE(main, e5):      /* PUSH HL */
 			PUSH(HL);
-			break;
+			Z80_NEXT;
 
-		case 0xe6:      /* AND nn */
+		Z80_CASE(main, e6):      /* AND nn */
 			AF = andTable[((AF >> 8)& RAM_PP(PC)) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xe7:      /* RST 20H */
+		Z80_CASE(main, e7):      /* RST 20H */
 			PUSH(PC);
 			PC = 0x20;
-			break;
+			Z80_NEXT;
 
-		case 0xe8:      /* RET PE */
+		Z80_CASE(main, e8):      /* RET PE */
 			if (TSTFLAG(P))
 				POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xe9:      /* JP (HL) */
+		Z80_CASE(main, e9):      /* JP (HL) */
 			PC = HL;
-			break;
+			Z80_NEXT;
 
-		case 0xea:      /* JP PE,nnnn */
+		Z80_CASE(main, ea):      /* JP PE,nnnn */
 			JPC(TSTFLAG(P));
-			break;
+			Z80_NEXT;
 
-		case 0xeb:      /* EX DE,HL */
+		Z80_CASE(main, eb):      /* EX DE,HL */
 			temp = HL;
 			HL = DE;
 			DE = temp;
-			break;
+			Z80_NEXT;
 
-		case 0xec:      /* CALL PE,nnnn */
+		Z80_CASE(main, ec):      /* CALL PE,nnnn */
 			CALLC(TSTFLAG(P));
-			break;
+			Z80_NEXT;
 
-		case 0xed:      /* ED prefix */
+		Z80_CASE(main, ed):      /* ED prefix */
 			INCR(1); /* Add one M1 cycle to refresh counter */
+			Z80_DISPATCH(ed);
 			switch (RAM_PP(PC)) {
 
-			case 0x40:      /* IN B,(C) */
+			Z80_CASE(ed, 40):      /* IN B,(C) */
 				temp = cpu_in(LOW_REGISTER(BC));
 				SET_HIGH_REGISTER(BC, temp);
 				AF = (AF & ~0xfe) | rotateShiftTable[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x41:      /* OUT (C),B */
+			Z80_CASE(ed, 41):      /* OUT (C),B */
 				cpu_out(LOW_REGISTER(BC), HIGH_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x42:      /* SBC HL,BC */
+			Z80_CASE(ed, 42):      /* SBC HL,BC */
 				HL &= ADDRMASK;
 				BC &= ADDRMASK;
 				sum = HL - BC - TSTFLAG(C);
 				AF = (AF & ~0xff) | ((sum >> 8) & 0xa8) | (((sum & ADDRMASK) == 0) << 6) |
 					cbits2Z80Table[((HL ^ BC ^ sum) >> 8) & 0x1ff];
 				HL = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x43:      /* LD (nnnn),BC */
+			Z80_CASE(ed, 43):      /* LD (nnnn),BC */
 				temp = GET_WORD(PC);
 				PUT_WORD(temp, BC);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x44:      /* NEG */
+			Z80_CASE(ed, 44):      /* NEG */
 
-			case 0x4C:      /* NEG, unofficial */
+			Z80_CASE(ed, 4C):      /* NEG, unofficial */
 
-			case 0x54:      /* NEG, unofficial */
+			Z80_CASE(ed, 54):      /* NEG, unofficial */
 
-			case 0x5C:      /* NEG, unofficial */
+			Z80_CASE(ed, 5C):      /* NEG, unofficial */
 
-			case 0x64:      /* NEG, unofficial */
+			Z80_CASE(ed, 64):      /* NEG, unofficial */
 
-			case 0x6C:      /* NEG, unofficial */
+			Z80_CASE(ed, 6C):      /* NEG, unofficial */
 
-			case 0x74:      /* NEG, unofficial */
+			Z80_CASE(ed, 74):      /* NEG, unofficial */
 
-			case 0x7C:      /* NEG, unofficial */
+			Z80_CASE(ed, 7C):      /* NEG, unofficial */
 				temp = HIGH_REGISTER(AF);
 				AF = ((~(AF & 0xff00) + 1) & 0xff00); /* AF = (-(AF & 0xff00) & 0xff00); */
 				AF |= ((AF >> 8) & 0xa8) | (((AF & 0xff00) == 0) << 6) | negTable[temp];
-				break;
+				Z80_NEXT;
 
-			case 0x45:      /* RETN */
+			Z80_CASE(ed, 45):      /* RETN */
 
-			case 0x55:      /* RETN, unofficial */
+			Z80_CASE(ed, 55):      /* RETN, unofficial */
 
-			case 0x5D:      /* RETN, unofficial */
+			Z80_CASE(ed, 5D):      /* RETN, unofficial */
 
-			case 0x65:      /* RETN, unofficial */
+			Z80_CASE(ed, 65):      /* RETN, unofficial */
 
-			case 0x6D:      /* RETN, unofficial */
+			Z80_CASE(ed, 6D):      /* RETN, unofficial */
 
-			case 0x75:      /* RETN, unofficial */
+			Z80_CASE(ed, 75):      /* RETN, unofficial */
 
-			case 0x7D:      /* RETN, unofficial */
+			Z80_CASE(ed, 7D):      /* RETN, unofficial */
 				IFF |= IFF >> 1;
 				POP(PC);
-				break;
+				Z80_NEXT;
 
-			case 0x46:      /* IM 0 */
+			Z80_CASE(ed, 46):      /* IM 0 */
 							/* interrupt mode 0 */
-				break;
+				Z80_NEXT;
 
-			case 0x47:      /* LD I,A */
+			Z80_CASE(ed, 47):      /* LD I,A */
 				IR = (IR & 0xff) | (AF & ~0xff);
-				break;
+				Z80_NEXT;
 
-			case 0x48:      /* IN C,(C) */
+			Z80_CASE(ed, 48):      /* IN C,(C) */
 				temp = cpu_in(LOW_REGISTER(BC));
 				SET_LOW_REGISTER(BC, temp);
 				AF = (AF & ~0xfe) | rotateShiftTable[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x49:      /* OUT (C),C */
+			Z80_CASE(ed, 49):      /* OUT (C),C */
 				cpu_out(LOW_REGISTER(BC), LOW_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x4a:      /* ADC HL,BC */
+			Z80_CASE(ed, 4a):      /* ADC HL,BC */
 				HL &= ADDRMASK;
 				BC &= ADDRMASK;
 				sum = HL + BC + TSTFLAG(C);
 				AF = (AF & ~0xff) | ((sum >> 8) & 0xa8) | (((sum & ADDRMASK) == 0) << 6) |
 					cbitsZ80Table[(HL ^ BC ^ sum) >> 8];
 				HL = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x4b:      /* LD BC,(nnnn) */
+			Z80_CASE(ed, 4b):      /* LD BC,(nnnn) */
 				temp = GET_WORD(PC);
 				BC = GET_WORD(temp);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x4d:      /* RETI */
+			Z80_CASE(ed, 4d):      /* RETI */
 				IFF |= IFF >> 1;
 				POP(PC);
-				break;
+				Z80_NEXT;
 
-			case 0x4f:      /* LD R,A */
+			Z80_CASE(ed, 4f):      /* LD R,A */
 				IR = (IR & ~0xff) | ((AF >> 8) & 0xff);
-				break;
+				Z80_NEXT;
 
-			case 0x50:      /* IN D,(C) */
+			Z80_CASE(ed, 50):      /* IN D,(C) */
 				temp = cpu_in(LOW_REGISTER(BC));
 				SET_HIGH_REGISTER(DE, temp);
 				AF = (AF & ~0xfe) | rotateShiftTable[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x51:      /* OUT (C),D */
+			Z80_CASE(ed, 51):      /* OUT (C),D */
 				cpu_out(LOW_REGISTER(BC), HIGH_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x52:      /* SBC HL,DE */
+			Z80_CASE(ed, 52):      /* SBC HL,DE */
 				HL &= ADDRMASK;
 				DE &= ADDRMASK;
 				sum = HL - DE - TSTFLAG(C);
 				AF = (AF & ~0xff) | ((sum >> 8) & 0xa8) | (((sum & ADDRMASK) == 0) << 6) |
 					cbits2Z80Table[((HL ^ DE ^ sum) >> 8) & 0x1ff];
 				HL = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x53:      /* LD (nnnn),DE */
+			Z80_CASE(ed, 53):      /* LD (nnnn),DE */
 				temp = GET_WORD(PC);
 				PUT_WORD(temp, DE);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x56:      /* IM 1 */
+			Z80_CASE(ed, 56):      /* IM 1 */
 							/* interrupt mode 1 */
-				break;
+				Z80_NEXT;
 
-			case 0x57:      /* LD A,I */
+			Z80_CASE(ed, 57):      /* LD A,I */
 				AF = (AF & 0x29) | (IR & ~0xff) | ((IR >> 8) & 0x80) | (((IR & ~0xff) == 0) << 6) | ((IFF & 2) << 1);
-				break;
+				Z80_NEXT;
 
-			case 0x58:      /* IN E,(C) */
+			Z80_CASE(ed, 58):      /* IN E,(C) */
 				temp = cpu_in(LOW_REGISTER(BC));
 				SET_LOW_REGISTER(DE, temp);
 				AF = (AF & ~0xfe) | rotateShiftTable[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x59:      /* OUT (C),E */
+			Z80_CASE(ed, 59):      /* OUT (C),E */
 				cpu_out(LOW_REGISTER(BC), LOW_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x5a:      /* ADC HL,DE */
+			Z80_CASE(ed, 5a):      /* ADC HL,DE */
 				HL &= ADDRMASK;
 				DE &= ADDRMASK;
 				sum = HL + DE + TSTFLAG(C);
 				AF = (AF & ~0xff) | ((sum >> 8) & 0xa8) | (((sum & ADDRMASK) == 0) << 6) |
 					cbitsZ80Table[(HL ^ DE ^ sum) >> 8];
 				HL = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x5b:      /* LD DE,(nnnn) */
+			Z80_CASE(ed, 5b):      /* LD DE,(nnnn) */
 				temp = GET_WORD(PC);
 				DE = GET_WORD(temp);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x5e:      /* IM 2 */
+			Z80_CASE(ed, 5e):      /* IM 2 */
 							/* interrupt mode 2 */
-				break;
+				Z80_NEXT;
 
-			case 0x5f:      /* LD A,R */
+			Z80_CASE(ed, 5f):      /* LD A,R */
 				AF = (AF & 0x29) | ((IR & 0xff) << 8) | (IR & 0x80) |
 					(((IR & 0xff) == 0) << 6) | ((IFF & 2) << 1);
-				break;
+				Z80_NEXT;
 
-			case 0x60:      /* IN H,(C) */
+			Z80_CASE(ed, 60):      /* IN H,(C) */
 				temp = cpu_in(LOW_REGISTER(BC));
 				SET_HIGH_REGISTER(HL, temp);
 				AF = (AF & ~0xfe) | rotateShiftTable[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x61:      /* OUT (C),H */
+			Z80_CASE(ed, 61):      /* OUT (C),H */
 				cpu_out(LOW_REGISTER(BC), HIGH_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0x62:      /* SBC HL,HL */
+			Z80_CASE(ed, 62):      /* SBC HL,HL */
 				HL &= ADDRMASK;
 				sum = HL - HL - TSTFLAG(C);
 				AF = (AF & ~0xff) | (((sum & ADDRMASK) == 0) << 6) |
 					cbits2Z80DupTable[(sum >> 8) & 0x1ff];
 				HL = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x63:      /* LD (nnnn),HL */
+			Z80_CASE(ed, 63):      /* LD (nnnn),HL */
 				temp = GET_WORD(PC);
 				PUT_WORD(temp, HL);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x67:      /* RRD */
+			Z80_CASE(ed, 67):      /* RRD */
 				temp = GET_BYTE(HL);
 				acu = HIGH_REGISTER(AF);
 				PUT_BYTE(HL, HIGH_DIGIT(temp) | (LOW_DIGIT(acu) << 4));
 				AF = rrdrldTable[(acu & 0xf0) | LOW_DIGIT(temp)] | (AF & 1);
-				break;
+				Z80_NEXT;
 
-			case 0x68:      /* IN L,(C) */
+			Z80_CASE(ed, 68):      /* IN L,(C) */
 				temp = cpu_in(LOW_REGISTER(BC));
 				SET_LOW_REGISTER(HL, temp);
 				AF = (AF & ~0xfe) | rotateShiftTable[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x69:      /* OUT (C),L */
+			Z80_CASE(ed, 69):      /* OUT (C),L */
 				cpu_out(LOW_REGISTER(BC), LOW_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0x6a:      /* ADC HL,HL */
+			Z80_CASE(ed, 6a):      /* ADC HL,HL */
 				HL &= ADDRMASK;
 				sum = HL + HL + TSTFLAG(C);
 				AF = (AF & ~0xff) | (((sum & ADDRMASK) == 0) << 6) |
 					cbitsZ80DupTable[sum >> 8];
 				HL = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x6b:      /* LD HL,(nnnn) */
+			Z80_CASE(ed, 6b):      /* LD HL,(nnnn) */
 				temp = GET_WORD(PC);
 				HL = GET_WORD(temp);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x6f:      /* RLD */
+			Z80_CASE(ed, 6f):      /* RLD */
 				temp = GET_BYTE(HL);
 				acu = HIGH_REGISTER(AF);
 				PUT_BYTE(HL, (LOW_DIGIT(temp) << 4) | LOW_DIGIT(acu));
 				AF = rrdrldTable[(acu & 0xf0) | HIGH_DIGIT(temp)] | (AF & 1);
-				break;
+				Z80_NEXT;
 
-			case 0x70:      /* IN (C) */
+			Z80_CASE(ed, 70):      /* IN (C) */
 				temp = cpu_in(LOW_REGISTER(BC));
 				SET_LOW_REGISTER(temp, temp);
 				AF = (AF & ~0xfe) | rotateShiftTable[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x71:      /* OUT (C),0 */
+			Z80_CASE(ed, 71):      /* OUT (C),0 */
 				cpu_out(LOW_REGISTER(BC), 0);
-				break;
+				Z80_NEXT;
 
-			case 0x72:      /* SBC HL,SP */
+			Z80_CASE(ed, 72):      /* SBC HL,SP */
 				HL &= ADDRMASK;
 				SP &= ADDRMASK;
 				sum = HL - SP - TSTFLAG(C);
 				AF = (AF & ~0xff) | ((sum >> 8) & 0xa8) | (((sum & ADDRMASK) == 0) << 6) |
 					cbits2Z80Table[((HL ^ SP ^ sum) >> 8) & 0x1ff];
 				HL = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x73:      /* LD (nnnn),SP */
+			Z80_CASE(ed, 73):      /* LD (nnnn),SP */
 				temp = GET_WORD(PC);
 				PUT_WORD(temp, SP);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x78:      /* IN A,(C) */
+			Z80_CASE(ed, 78):      /* IN A,(C) */
 				temp = cpu_in(LOW_REGISTER(BC));
 				SET_HIGH_REGISTER(AF, temp);
 				AF = (AF & ~0xfe) | rotateShiftTable[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x79:      /* OUT (C),A */
+			Z80_CASE(ed, 79):      /* OUT (C),A */
 				cpu_out(LOW_REGISTER(BC), HIGH_REGISTER(AF));
-				break;
+				Z80_NEXT;
 
-			case 0x7a:      /* ADC HL,SP */
+			Z80_CASE(ed, 7a):      /* ADC HL,SP */
 				HL &= ADDRMASK;
 				SP &= ADDRMASK;
 				sum = HL + SP + TSTFLAG(C);
 				AF = (AF & ~0xff) | ((sum >> 8) & 0xa8) | (((sum & ADDRMASK) == 0) << 6) |
 					cbitsZ80Table[(HL ^ SP ^ sum) >> 8];
 				HL = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x7b:      /* LD SP,(nnnn) */
+			Z80_CASE(ed, 7b):      /* LD SP,(nnnn) */
 				temp = GET_WORD(PC);
 				SP = GET_WORD(temp);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0xa0:      /* LDI */
+			Z80_CASE(ed, a0):      /* LDI */
 				acu = RAM_PP(HL);
 				PUT_BYTE_PP(DE, acu);
 				acu += HIGH_REGISTER(AF);
 				AF = (AF & ~0x3e) | (acu & 8) | ((acu & 2) << 4) |
 					(((--BC & ADDRMASK) != 0) << 2);
-				break;
+				Z80_NEXT;
 
-			case 0xa1:      /* CPI */
+			Z80_CASE(ed, a1):      /* CPI */
 				acu = HIGH_REGISTER(AF);
 				temp = RAM_PP(HL);
 				sum = acu - temp;
@@ -3788,7 +3965,7 @@ static inline void Z80run(void) {
 					((--BC & ADDRMASK) != 0) << 2 | 2;
 				if ((sum & 15) == 8 && (cbits & 16) != 0)
 					AF &= ~8;
-				break;
+				Z80_NEXT;
 
 				/*  SF, ZF, YF, XF flags are affected by decreasing register B, as in DEC B.
 				NF flag A is copy of bit 7 of the value read from or written to an I/O port.
@@ -3797,14 +3974,14 @@ static inline void Z80run(void) {
 				C - 1 if it's IND/INDR. So, first of all INI/INIR:
 				HF and CF Both set if ((HL) + ((C + 1) & 255) > 255)
 				PF The parity of (((HL) + ((C + 1) & 255)) & 7) xor B)                      */
-			case 0xa2:      /* INI */
+			Z80_CASE(ed, a2):      /* INI */
 				acu = cpu_in(LOW_REGISTER(BC));
 				PUT_BYTE(HL, acu);
 				++HL;
 				temp = HIGH_REGISTER(BC);
 				BC -= 0x100;
 				INOUTFLAGS_NONZERO((LOW_REGISTER(BC) + 1) & 0xff);
-				break;
+				Z80_NEXT;
 
 				/*  SF, ZF, YF, XF flags are affected by decreasing register B, as in DEC B.
 				NF flag A is copy of bit 7 of the value read from or written to an I/O port.
@@ -3814,24 +3991,24 @@ static inline void Z80run(void) {
 				flags is set like the parity of k bitwise and'ed with 7, bitwise xor'ed with B.
 				HF and CF Both set if ((HL) + L > 255)
 				PF The parity of ((((HL) + L) & 7) xor B)                                       */
-			case 0xa3:      /* OUTI */
+			Z80_CASE(ed, a3):      /* OUTI */
 				acu = GET_BYTE(HL);
 				cpu_out(LOW_REGISTER(BC), acu);
 				++HL;
 				temp = HIGH_REGISTER(BC);
 				BC -= 0x100;
 				INOUTFLAGS_NONZERO(LOW_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0xa8:      /* LDD */
+			Z80_CASE(ed, a8):      /* LDD */
 				acu = RAM_MM(HL);
 				PUT_BYTE_MM(DE, acu);
 				acu += HIGH_REGISTER(AF);
 				AF = (AF & ~0x3e) | (acu & 8) | ((acu & 2) << 4) |
 					(((--BC & ADDRMASK) != 0) << 2);
-				break;
+				Z80_NEXT;
 
-			case 0xa9:      /* CPD */
+			Z80_CASE(ed, a9):      /* CPD */
 				acu = HIGH_REGISTER(AF);
 				temp = RAM_MM(HL);
 				sum = acu - temp;
@@ -3842,7 +4019,7 @@ static inline void Z80run(void) {
 					((--BC & ADDRMASK) != 0) << 2 | 2;
 				if ((sum & 15) == 8 && (cbits & 16) != 0)
 					AF &= ~8;
-				break;
+				Z80_NEXT;
 
 				/*  SF, ZF, YF, XF flags are affected by decreasing register B, as in DEC B.
 				NF flag A is copy of bit 7 of the value read from or written to an I/O port.
@@ -3851,25 +4028,25 @@ static inline void Z80run(void) {
 				C - 1 if it's IND/INDR. And last IND/INDR:
 				HF and CF Both set if ((HL) + ((C - 1) & 255) > 255)
 				PF The parity of (((HL) + ((C - 1) & 255)) & 7) xor B)                      */
-			case 0xaa:      /* IND */
+			Z80_CASE(ed, aa):      /* IND */
 				acu = cpu_in(LOW_REGISTER(BC));
 				PUT_BYTE(HL, acu);
 				--HL;
 				temp = HIGH_REGISTER(BC);
 				BC -= 0x100;
 				INOUTFLAGS_NONZERO((LOW_REGISTER(BC) - 1) & 0xff);
-				break;
+				Z80_NEXT;
 
-			case 0xab:      /* OUTD */
+			Z80_CASE(ed, ab):      /* OUTD */
 				acu = GET_BYTE(HL);
 				cpu_out(LOW_REGISTER(BC), acu);
 				--HL;
 				temp = HIGH_REGISTER(BC);
 				BC -= 0x100;
 				INOUTFLAGS_NONZERO(LOW_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0xb0:      /* LDIR */
+			Z80_CASE(ed, b0):      /* LDIR */
 				BC &= ADDRMASK;
 				if (BC == 0)
 					BC = 0x10000;
@@ -3880,9 +4057,9 @@ static inline void Z80run(void) {
 				} while (--BC);
 				acu += HIGH_REGISTER(AF);
 				AF = (AF & ~0x3e) | (acu & 8) | ((acu & 2) << 4);
-				break;
+				Z80_NEXT;
 
-			case 0xb1:      /* CPIR */
+			Z80_CASE(ed, b1):      /* CPIR */
 				acu = HIGH_REGISTER(AF);
 				BC &= ADDRMASK;
 				if (BC == 0)
@@ -3900,9 +4077,9 @@ static inline void Z80run(void) {
 					op << 2 | 2;
 				if ((sum & 15) == 8 && (cbits & 16) != 0)
 					AF &= ~8;
-				break;
+				Z80_NEXT;
 
-			case 0xb2:      /* INIR */
+			Z80_CASE(ed, b2):      /* INIR */
 				temp = HIGH_REGISTER(BC);
 				if (temp == 0)
 					temp = 0x100;
@@ -3915,9 +4092,9 @@ static inline void Z80run(void) {
 				temp = HIGH_REGISTER(BC);
 				SET_HIGH_REGISTER(BC, 0);
 				INOUTFLAGS_ZERO((LOW_REGISTER(BC) + 1) & 0xff);
-				break;
+				Z80_NEXT;
 
-			case 0xb3:      /* OTIR */
+			Z80_CASE(ed, b3):      /* OTIR */
 				temp = HIGH_REGISTER(BC);
 				if (temp == 0)
 					temp = 0x100;
@@ -3930,9 +4107,9 @@ static inline void Z80run(void) {
 				temp = HIGH_REGISTER(BC);
 				SET_HIGH_REGISTER(BC, 0);
 				INOUTFLAGS_ZERO(LOW_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0xb8:      /* LDDR */
+			Z80_CASE(ed, b8):      /* LDDR */
 				BC &= ADDRMASK;
 				if (BC == 0)
 					BC = 0x10000;
@@ -3943,9 +4120,9 @@ static inline void Z80run(void) {
 				} while (--BC);
 				acu += HIGH_REGISTER(AF);
 				AF = (AF & ~0x3e) | (acu & 8) | ((acu & 2) << 4);
-				break;
+				Z80_NEXT;
 
-			case 0xb9:      /* CPDR */
+			Z80_CASE(ed, b9):      /* CPDR */
 				acu = HIGH_REGISTER(AF);
 				BC &= ADDRMASK;
 				if (BC == 0)
@@ -3963,9 +4140,9 @@ static inline void Z80run(void) {
 					op << 2 | 2;
 				if ((sum & 15) == 8 && (cbits & 16) != 0)
 					AF &= ~8;
-				break;
+				Z80_NEXT;
 
-			case 0xba:      /* INDR */
+			Z80_CASE(ed, ba):      /* INDR */
 				temp = HIGH_REGISTER(BC);
 				if (temp == 0)
 					temp = 0x100;
@@ -3978,9 +4155,9 @@ static inline void Z80run(void) {
 				temp = HIGH_REGISTER(BC);
 				SET_HIGH_REGISTER(BC, 0);
 				INOUTFLAGS_ZERO((LOW_REGISTER(BC) - 1) & 0xff);
-				break;
+				Z80_NEXT;
 
-			case 0xbb:      /* OTDR */
+			Z80_CASE(ed, bb):      /* OTDR */
 				temp = HIGH_REGISTER(BC);
 				if (temp == 0)
 					temp = 0x100;
@@ -3993,488 +4170,489 @@ static inline void Z80run(void) {
 				temp = HIGH_REGISTER(BC);
 				SET_HIGH_REGISTER(BC, 0);
 				INOUTFLAGS_ZERO(LOW_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			default:    /* ignore ED and following byte */
-				break;
+			Z80_DEFAULT(ed):    /* ignore ED and following byte */
+				Z80_NEXT;
 			}
-			break;
+			Z80_NEXT;
 
-		case 0xee:      /* XOR nn */
+		Z80_CASE(main, ee):      /* XOR nn */
 			AF = xororTable[((AF >> 8) ^ RAM_PP(PC)) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xef:      /* RST 28H */
+		Z80_CASE(main, ef):      /* RST 28H */
 			PUSH(PC);
 			PC = 0x28;
-			break;
+			Z80_NEXT;
 
-		case 0xf0:      /* RET P */
+		Z80_CASE(main, f0):      /* RET P */
 			if (!(TSTFLAG(S)))
 				POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xf1:      /* POP AF */
+		Z80_CASE(main, f1):      /* POP AF */
 			POP(AF);
-			break;
+			Z80_NEXT;
 
-		case 0xf2:      /* JP P,nnnn */
+		Z80_CASE(main, f2):      /* JP P,nnnn */
 			JPC(!TSTFLAG(S));
-			break;
+			Z80_NEXT;
 
-		case 0xf3:      /* DI */
+		Z80_CASE(main, f3):      /* DI */
 			IFF = 0;
-			break;
+			Z80_NEXT;
 
-		case 0xf4:      /* CALL P,nnnn */
+		Z80_CASE(main, f4):      /* CALL P,nnnn */
 			CALLC(!TSTFLAG(S));
-			break;
+			Z80_NEXT;
 
-		case 0xf5:      /* PUSH AF */
+		Z80_CASE(main, f5):      /* PUSH AF */
 			PUSH(AF);
-			break;
+			Z80_NEXT;
 
-		case 0xf6:      /* OR nn */
+		Z80_CASE(main, f6):      /* OR nn */
 			AF = xororTable[((AF >> 8) | RAM_PP(PC)) & 0xff];
-			break;
+			Z80_NEXT;
 
-		case 0xf7:      /* RST 30H */
+		Z80_CASE(main, f7):      /* RST 30H */
 			PUSH(PC);
 			PC = 0x30;
-			break;
+			Z80_NEXT;
 
-		case 0xf8:      /* RET M */
+		Z80_CASE(main, f8):      /* RET M */
 			if (TSTFLAG(S))
 				POP(PC);
-			break;
+			Z80_NEXT;
 
-		case 0xf9:      /* LD SP,HL */
+		Z80_CASE(main, f9):      /* LD SP,HL */
 			SP = HL;
-			break;
+			Z80_NEXT;
 
-		case 0xfa:      /* JP M,nnnn */
+		Z80_CASE(main, fa):      /* JP M,nnnn */
 			JPC(TSTFLAG(S));
-			break;
+			Z80_NEXT;
 
-		case 0xfb:      /* EI */
+		Z80_CASE(main, fb):      /* EI */
 			IFF = 3;
-			break;
+			Z80_NEXT;
 
-		case 0xfc:      /* CALL M,nnnn */
+		Z80_CASE(main, fc):      /* CALL M,nnnn */
 			CALLC(TSTFLAG(S));
-			break;
+			Z80_NEXT;
 
-		case 0xfd:      /* FD prefix */
+		Z80_CASE(main, fd):      /* FD prefix */
 			INCR(1); /* Add one M1 cycle to refresh counter */
+			Z80_DISPATCH(fd);
 			switch (RAM_PP(PC)) {
 
-			case 0x09:      /* ADD IY,BC */
+			Z80_CASE(fd, 09):      /* ADD IY,BC */
 				IY &= ADDRMASK;
 				BC &= ADDRMASK;
 				sum = IY + BC;
 				AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(IY ^ BC ^ sum) >> 8];
 				IY = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x19:      /* ADD IY,DE */
+			Z80_CASE(fd, 19):      /* ADD IY,DE */
 				IY &= ADDRMASK;
 				DE &= ADDRMASK;
 				sum = IY + DE;
 				AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(IY ^ DE ^ sum) >> 8];
 				IY = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x21:      /* LD IY,nnnn */
+			Z80_CASE(fd, 21):      /* LD IY,nnnn */
 				IY = GET_WORD(PC);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x22:      /* LD (nnnn),IY */
+			Z80_CASE(fd, 22):      /* LD (nnnn),IY */
 				temp = GET_WORD(PC);
 				PUT_WORD(temp, IY);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x23:      /* INC IY */
+			Z80_CASE(fd, 23):      /* INC IY */
 				++IY;
-				break;
+				Z80_NEXT;
 
-			case 0x24:      /* INC IYH */
+			Z80_CASE(fd, 24):      /* INC IYH */
 				IY += 0x100;
 				AF = (AF & ~0xfe) | incZ80Table[HIGH_REGISTER(IY)];
-				break;
+				Z80_NEXT;
 
-			case 0x25:      /* DEC IYH */
+			Z80_CASE(fd, 25):      /* DEC IYH */
 				IY -= 0x100;
 				AF = (AF & ~0xfe) | decZ80Table[HIGH_REGISTER(IY)];
-				break;
+				Z80_NEXT;
 
-			case 0x26:      /* LD IYH,nn */
+			Z80_CASE(fd, 26):      /* LD IYH,nn */
 				SET_HIGH_REGISTER(IY, RAM_PP(PC));
-				break;
+				Z80_NEXT;
 
-			case 0x29:      /* ADD IY,IY */
+			Z80_CASE(fd, 29):      /* ADD IY,IY */
 				IY &= ADDRMASK;
 				sum = IY + IY;
 				AF = (AF & ~0x3b) | cbitsDup16Table[sum >> 8];
 				IY = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x2a:      /* LD IY,(nnnn) */
+			Z80_CASE(fd, 2a):      /* LD IY,(nnnn) */
 				temp = GET_WORD(PC);
 				IY = GET_WORD(temp);
 				PC += 2;
-				break;
+				Z80_NEXT;
 
-			case 0x2b:      /* DEC IY */
+			Z80_CASE(fd, 2b):      /* DEC IY */
 				--IY;
-				break;
+				Z80_NEXT;
 
-			case 0x2c:      /* INC IYL */
+			Z80_CASE(fd, 2c):      /* INC IYL */
 				temp = LOW_REGISTER(IY) + 1;
 				SET_LOW_REGISTER(IY, temp);
 				AF = (AF & ~0xfe) | incZ80Table[temp];
-				break;
+				Z80_NEXT;
 
-			case 0x2d:      /* DEC IYL */
+			Z80_CASE(fd, 2d):      /* DEC IYL */
 				temp = LOW_REGISTER(IY) - 1;
 				SET_LOW_REGISTER(IY, temp);
 				AF = (AF & ~0xfe) | decZ80Table[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x2e:      /* LD IYL,nn */
+			Z80_CASE(fd, 2e):      /* LD IYL,nn */
 				SET_LOW_REGISTER(IY, RAM_PP(PC));
-				break;
+				Z80_NEXT;
 
-			case 0x34:      /* INC (IY+dd) */
+			Z80_CASE(fd, 34):      /* INC (IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr) + 1;
 				PUT_BYTE(adr, temp);
 				AF = (AF & ~0xfe) | incZ80Table[temp];
-				break;
+				Z80_NEXT;
 
-			case 0x35:      /* DEC (IY+dd) */
+			Z80_CASE(fd, 35):      /* DEC (IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr) - 1;
 				PUT_BYTE(adr, temp);
 				AF = (AF & ~0xfe) | decZ80Table[temp & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0x36:      /* LD (IY+dd),nn */
+			Z80_CASE(fd, 36):      /* LD (IY+dd),nn */
 				adr = IY + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, RAM_PP(PC));
-				break;
+				Z80_NEXT;
 
-			case 0x39:      /* ADD IY,SP */
+			Z80_CASE(fd, 39):      /* ADD IY,SP */
 				IY &= ADDRMASK;
 				SP &= ADDRMASK;
 				sum = IY + SP;
 				AF = (AF & ~0x3b) | ((sum >> 8) & 0x28) | cbitsTable[(IY ^ SP ^ sum) >> 8];
 				IY = sum;
-				break;
+				Z80_NEXT;
 
-			case 0x44:      /* LD B,IYH */
+			Z80_CASE(fd, 44):      /* LD B,IYH */
 				SET_HIGH_REGISTER(BC, HIGH_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x45:      /* LD B,IYL */
+			Z80_CASE(fd, 45):      /* LD B,IYL */
 				SET_HIGH_REGISTER(BC, LOW_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x46:      /* LD B,(IY+dd) */
+			Z80_CASE(fd, 46):      /* LD B,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				SET_HIGH_REGISTER(BC, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x4c:      /* LD C,IYH */
+			Z80_CASE(fd, 4c):      /* LD C,IYH */
 				SET_LOW_REGISTER(BC, HIGH_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x4d:      /* LD C,IYL */
+			Z80_CASE(fd, 4d):      /* LD C,IYL */
 				SET_LOW_REGISTER(BC, LOW_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x4e:      /* LD C,(IY+dd) */
+			Z80_CASE(fd, 4e):      /* LD C,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				SET_LOW_REGISTER(BC, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x54:      /* LD D,IYH */
+			Z80_CASE(fd, 54):      /* LD D,IYH */
 				SET_HIGH_REGISTER(DE, HIGH_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x55:      /* LD D,IYL */
+			Z80_CASE(fd, 55):      /* LD D,IYL */
 				SET_HIGH_REGISTER(DE, LOW_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x56:      /* LD D,(IY+dd) */
+			Z80_CASE(fd, 56):      /* LD D,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				SET_HIGH_REGISTER(DE, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x5c:      /* LD E,IYH */
+			Z80_CASE(fd, 5c):      /* LD E,IYH */
 				SET_LOW_REGISTER(DE, HIGH_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x5d:      /* LD E,IYL */
+			Z80_CASE(fd, 5d):      /* LD E,IYL */
 				SET_LOW_REGISTER(DE, LOW_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x5e:      /* LD E,(IY+dd) */
+			Z80_CASE(fd, 5e):      /* LD E,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				SET_LOW_REGISTER(DE, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x60:      /* LD IYH,B */
+			Z80_CASE(fd, 60):      /* LD IYH,B */
 				SET_HIGH_REGISTER(IY, HIGH_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x61:      /* LD IYH,C */
+			Z80_CASE(fd, 61):      /* LD IYH,C */
 				SET_HIGH_REGISTER(IY, LOW_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x62:      /* LD IYH,D */
+			Z80_CASE(fd, 62):      /* LD IYH,D */
 				SET_HIGH_REGISTER(IY, HIGH_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x63:      /* LD IYH,E */
+			Z80_CASE(fd, 63):      /* LD IYH,E */
 				SET_HIGH_REGISTER(IY, LOW_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x64:      /* LD IYH,IYH */
-				break;
+			Z80_CASE(fd, 64):      /* LD IYH,IYH */
+				Z80_NEXT;
 
-			case 0x65:      /* LD IYH,IYL */
+			Z80_CASE(fd, 65):      /* LD IYH,IYL */
 				SET_HIGH_REGISTER(IY, LOW_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x66:      /* LD H,(IY+dd) */
+			Z80_CASE(fd, 66):      /* LD H,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				SET_HIGH_REGISTER(HL, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x67:      /* LD IYH,A */
+			Z80_CASE(fd, 67):      /* LD IYH,A */
 				SET_HIGH_REGISTER(IY, HIGH_REGISTER(AF));
-				break;
+				Z80_NEXT;
 
-			case 0x68:      /* LD IYL,B */
+			Z80_CASE(fd, 68):      /* LD IYL,B */
 				SET_LOW_REGISTER(IY, HIGH_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x69:      /* LD IYL,C */
+			Z80_CASE(fd, 69):      /* LD IYL,C */
 				SET_LOW_REGISTER(IY, LOW_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x6a:      /* LD IYL,D */
+			Z80_CASE(fd, 6a):      /* LD IYL,D */
 				SET_LOW_REGISTER(IY, HIGH_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x6b:      /* LD IYL,E */
+			Z80_CASE(fd, 6b):      /* LD IYL,E */
 				SET_LOW_REGISTER(IY, LOW_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x6c:      /* LD IYL,IYH */
+			Z80_CASE(fd, 6c):      /* LD IYL,IYH */
 				SET_LOW_REGISTER(IY, HIGH_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x6d:      /* LD IYL,IYL */
-				break;
+			Z80_CASE(fd, 6d):      /* LD IYL,IYL */
+				Z80_NEXT;
 
-			case 0x6e:      /* LD L,(IY+dd) */
+			Z80_CASE(fd, 6e):      /* LD L,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				SET_LOW_REGISTER(HL, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x6f:      /* LD IYL,A */
+			Z80_CASE(fd, 6f):      /* LD IYL,A */
 				SET_LOW_REGISTER(IY, HIGH_REGISTER(AF));
-				break;
+				Z80_NEXT;
 
-			case 0x70:      /* LD (IY+dd),B */
+			Z80_CASE(fd, 70):      /* LD (IY+dd),B */
 				adr = IY + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, HIGH_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x71:      /* LD (IY+dd),C */
+			Z80_CASE(fd, 71):      /* LD (IY+dd),C */
 				adr = IY + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, LOW_REGISTER(BC));
-				break;
+				Z80_NEXT;
 
-			case 0x72:      /* LD (IY+dd),D */
+			Z80_CASE(fd, 72):      /* LD (IY+dd),D */
 				adr = IY + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, HIGH_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x73:      /* LD (IY+dd),E */
+			Z80_CASE(fd, 73):      /* LD (IY+dd),E */
 				adr = IY + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, LOW_REGISTER(DE));
-				break;
+				Z80_NEXT;
 
-			case 0x74:      /* LD (IY+dd),H */
+			Z80_CASE(fd, 74):      /* LD (IY+dd),H */
 				adr = IY + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, HIGH_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0x75:      /* LD (IY+dd),L */
+			Z80_CASE(fd, 75):      /* LD (IY+dd),L */
 				adr = IY + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, LOW_REGISTER(HL));
-				break;
+				Z80_NEXT;
 
-			case 0x77:      /* LD (IY+dd),A */
+			Z80_CASE(fd, 77):      /* LD (IY+dd),A */
 				adr = IY + (int8)RAM_PP(PC);
 				PUT_BYTE(adr, HIGH_REGISTER(AF));
-				break;
+				Z80_NEXT;
 
-			case 0x7c:      /* LD A,IYH */
+			Z80_CASE(fd, 7c):      /* LD A,IYH */
 				SET_HIGH_REGISTER(AF, HIGH_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x7d:      /* LD A,IYL */
+			Z80_CASE(fd, 7d):      /* LD A,IYL */
 				SET_HIGH_REGISTER(AF, LOW_REGISTER(IY));
-				break;
+				Z80_NEXT;
 
-			case 0x7e:      /* LD A,(IY+dd) */
+			Z80_CASE(fd, 7e):      /* LD A,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				SET_HIGH_REGISTER(AF, GET_BYTE(adr));
-				break;
+				Z80_NEXT;
 
-			case 0x84:      /* ADD A,IYH */
+			Z80_CASE(fd, 84):      /* ADD A,IYH */
 				temp = HIGH_REGISTER(IY);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp;
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x85:      /* ADD A,IYL */
+			Z80_CASE(fd, 85):      /* ADD A,IYL */
 				temp = LOW_REGISTER(IY);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp;
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x86:      /* ADD A,(IY+dd) */
+			Z80_CASE(fd, 86):      /* ADD A,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp;
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x8c:      /* ADC A,IYH */
+			Z80_CASE(fd, 8c):      /* ADC A,IYH */
 				temp = HIGH_REGISTER(IY);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp + TSTFLAG(C);
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x8d:      /* ADC A,IYL */
+			Z80_CASE(fd, 8d):      /* ADC A,IYL */
 				temp = LOW_REGISTER(IY);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp + TSTFLAG(C);
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x8e:      /* ADC A,(IY+dd) */
+			Z80_CASE(fd, 8e):      /* ADC A,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				acu = HIGH_REGISTER(AF);
 				sum = acu + temp + TSTFLAG(C);
 				AF = addTable[sum] | cbitsZ80Table[acu ^ temp ^ sum];
-				break;
+				Z80_NEXT;
 
-			case 0x96:      /* SUB (IY+dd) */
+			Z80_CASE(fd, 96):      /* SUB (IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp;
 				AF = addTable[sum & 0xff] | cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0x94:      /* SUB IYH */
+			Z80_CASE(fd, 94):      /* SUB IYH */
 				SETFLAG(C, 0);/* fall through, a bit less efficient but smaller code */
 
-			case 0x9c:      /* SBC A,IYH */
+			Z80_CASE(fd, 9c):      /* SBC A,IYH */
 				temp = HIGH_REGISTER(IY);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp - TSTFLAG(C);
 				AF = addTable[sum & 0xff] | cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0x95:      /* SUB IYL */
+			Z80_CASE(fd, 95):      /* SUB IYL */
 				SETFLAG(C, 0);/* fall through, a bit less efficient but smaller code */
 
-			case 0x9d:      /* SBC A,IYL */
+			Z80_CASE(fd, 9d):      /* SBC A,IYL */
 				temp = LOW_REGISTER(IY);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp - TSTFLAG(C);
 				AF = addTable[sum & 0xff] | cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0x9e:      /* SBC A,(IY+dd) */
+			Z80_CASE(fd, 9e):      /* SBC A,(IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp - TSTFLAG(C);
 				AF = addTable[sum & 0xff] | cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0xa4:      /* AND IYH */
+			Z80_CASE(fd, a4):      /* AND IYH */
 				AF = andTable[((AF & IY) >> 8) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xa5:      /* AND IYL */
+			Z80_CASE(fd, a5):      /* AND IYL */
 				AF = andTable[((AF >> 8)& IY) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xa6:      /* AND (IY+dd) */
+			Z80_CASE(fd, a6):      /* AND (IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				AF = andTable[((AF >> 8)& GET_BYTE(adr)) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xac:      /* XOR IYH */
+			Z80_CASE(fd, ac):      /* XOR IYH */
 				AF = xororTable[((AF ^ IY) >> 8) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xad:      /* XOR IYL */
+			Z80_CASE(fd, ad):      /* XOR IYL */
 				AF = xororTable[((AF >> 8) ^ IY) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xae:      /* XOR (IY+dd) */
+			Z80_CASE(fd, ae):      /* XOR (IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				AF = xororTable[((AF >> 8) ^ GET_BYTE(adr)) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xb4:      /* OR IYH */
+			Z80_CASE(fd, b4):      /* OR IYH */
 				AF = xororTable[((AF | IY) >> 8) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xb5:      /* OR IYL */
+			Z80_CASE(fd, b5):      /* OR IYL */
 				AF = xororTable[((AF >> 8) | IY) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xb6:      /* OR (IY+dd) */
+			Z80_CASE(fd, b6):      /* OR (IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				AF = xororTable[((AF >> 8) | GET_BYTE(adr)) & 0xff];
-				break;
+				Z80_NEXT;
 
-			case 0xbc:      /* CP IYH */
+			Z80_CASE(fd, bc):      /* CP IYH */
 				temp = HIGH_REGISTER(IY);
 				AF = (AF & ~0x28) | (temp & 0x28);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp;
 				AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 					cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0xbd:      /* CP IYL */
+			Z80_CASE(fd, bd):      /* CP IYL */
 				temp = LOW_REGISTER(IY);
 				AF = (AF & ~0x28) | (temp & 0x28);
 				acu = HIGH_REGISTER(AF);
 				sum = acu - temp;
 				AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 					cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0xbe:      /* CP (IY+dd) */
+			Z80_CASE(fd, be):      /* CP (IY+dd) */
 				adr = IY + (int8)RAM_PP(PC);
 				temp = GET_BYTE(adr);
 				AF = (AF & ~0x28) | (temp & 0x28);
@@ -4482,9 +4660,9 @@ static inline void Z80run(void) {
 				sum = acu - temp;
 				AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 					cbits2Z80Table[(acu ^ temp ^ sum) & 0x1ff];
-				break;
+				Z80_NEXT;
 
-			case 0xcb:      /* CB prefix */
+			Z80_CASE(fd, cb):      /* CB prefix */
 				adr = IY + (int8)RAM_PP(PC);
 				switch ((op = GET_BYTE(PC)) & 7) {
 
@@ -4628,36 +4806,36 @@ static inline void Z80run(void) {
 					SET_HIGH_REGISTER(AF, temp);
 					break;
 				}
-				break;
+				Z80_NEXT;
 
-			case 0xe1:      /* POP IY */
+			Z80_CASE(fd, e1):      /* POP IY */
 				POP(IY);
-				break;
+				Z80_NEXT;
 
-			case 0xe3:      /* EX (SP),IY */
+			Z80_CASE(fd, e3):      /* EX (SP),IY */
 				temp = IY;
 				POP(IY);
 				PUSH(temp);
-				break;
+				Z80_NEXT;
 
-			case 0xe5:      /* PUSH IY */
+			Z80_CASE(fd, e5):      /* PUSH IY */
 				PUSH(IY);
-				break;
+				Z80_NEXT;
 
-			case 0xe9:      /* JP (IY) */
+			Z80_CASE(fd, e9):      /* JP (IY) */
 				PC = IY;
-				break;
+				Z80_NEXT;
 
-			case 0xf9:      /* LD SP,IY */
+			Z80_CASE(fd, f9):      /* LD SP,IY */
 				SP = IY;
-				break;
+				Z80_NEXT;
 
-			default:            /* ignore FD */
+			Z80_DEFAULT(fd):            /* ignore FD */
 				--PC;
 			}
-			break;
+			Z80_NEXT;
 
-		case 0xfe:      /* CP nn */
+		Z80_CASE(main, fe):      /* CP nn */
 			temp = RAM_PP(PC);
 			AF = (AF & ~0x28) | (temp & 0x28);
 			acu = HIGH_REGISTER(AF);
@@ -4665,9 +4843,9 @@ static inline void Z80run(void) {
 			cbits = acu ^ temp ^ sum;
 			AF = (AF & ~0xff) | cpTable[sum & 0xff] | (temp & 0x28) |
 				(SET_PV) | cbits2Table[cbits & 0x1ff];
-			break;
+			Z80_NEXT;
 
-		case 0xff:      /* RST 38H */
+		Z80_CASE(main, ff):      /* RST 38H */
 			PUSH(PC);
 			PC = 0x38;
 		}
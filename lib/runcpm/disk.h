@@ -310,6 +310,10 @@ uint8 _CloseFile(uint16 fcbaddr) {
 	uint8 result = 0xff;
 
 	if (!_SelectDisk(F->dr)) {
+#ifdef USE_FILECACHE
+		_FCBtoHostname(fcbaddr, &filename[0]);
+		_sys_closefile(&filename[0]);		// Flush and release the host file
+#endif
 		if (!(F->s2 & 0x80)) {					// if file is modified
 			if (!RW) {
 				_FCBtoHostname(fcbaddr, &filename[0]);
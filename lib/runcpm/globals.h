@@ -9,6 +9,9 @@
 /* Definition for enabling incrementing the R register for each M1 cycle */
 #define DO_INCR
 
+/* Definition for dispatching Z80 opcodes through computed goto jump tables instead of a switch (GCC only) */
+//#define Z80_THREADED
+
 /* Definitions for enabling PUN: and LST: devices */
 //#define USE_PUN	// The pun.txt and lst.txt files will appear on drive A: user 0
 //#define USE_LST
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 
 #include "render.h"
+#include "sam.h"
 #include "RenderTabs.h"
 
 #include "samdebug.h"
@@ -48,6 +49,7 @@ unsigned char trans(unsigned char mem39212, unsigned char mem39213);
 // contains the final soundbuffer
 extern int bufferpos;
 extern char *buffer;
+extern int bufferMask;
 
 //timetable for more accurate c64 simulation
 int timetable[5][5] =
@@ -69,8 +71,9 @@ void Output8BitAry(int index, unsigned char ary[5])
     for (k = 0; k < 5; k++)
     {
         // printf("%d %d\r\n", bufferpos,k);
-        buffer[bufferpos / 50 + k] = ary[k];
+        buffer[(bufferpos / 50 + k) & bufferMask] = ary[k];
     }
+    FlushOutput(0);
 }
 void Output8Bit(int index, unsigned char A)
 {
@@ -976,14 +979,16 @@ void Render()
                 X = 26;
                 // mem[54296] = X;
                 bufferpos += 150;
-                buffer[bufferpos / 50] = (X & 15) * 16;
+                buffer[(bufferpos / 50) & bufferMask] = (X & 15) * 16;
+                FlushOutput(0);
             }
             else
             {
                 //mem[54296] = 6;
                 X = 6;
                 bufferpos += 150;
-                buffer[bufferpos / 50] = (X & 15) * 16;
+                buffer[(bufferpos / 50) & bufferMask] = (X & 15) * 16;
+                FlushOutput(0);
             }
 
             for (X = wait2; X > 0; X--)
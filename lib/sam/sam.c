@@ -46,6 +46,13 @@ unsigned char phonemeLengthOutput[60]; //tab47416
 // contains the final soundbuffer
 int bufferpos = 0;
 char *buffer = NULL;
+int bufferMask = -1;    // Sample index mask, SAM_RING_SIZE - 1 when streaming
+
+// streaming output
+static SamOutputFn output = NULL;
+static void *outputCtx = NULL;
+static int outputPos = 0;   // Samples handed to the output so far
+static char ring[SAM_RING_SIZE];
 
 void SetInput(char *_input)
 {
@@ -63,10 +70,40 @@ void SetPitch(unsigned char _pitch) { pitch = _pitch; }
 void SetMouth(unsigned char _mouth) { mouth = _mouth; }
 void SetThroat(unsigned char _throat) { throat = _throat; }
 void EnableSingmode() { singmode = 1; }
+void SetSingmode(int _singmode) { singmode = _singmode; }
 char *GetBuffer() { return buffer; }
 int GetBufferLength() { return bufferpos; }
 void FreeBuffer() { free(buffer); }
 
+void SetOutput(SamOutputFn _output, void *_ctx)
+{
+    output = _output;
+    outputCtx = _ctx;
+}
+
+// Hand every sample the renderer can no longer overwrite to the output.
+// The renderer writes a few samples ahead of bufferpos, so only the ones
+// before it are final until the utterance is done.
+void FlushOutput(int final)
+{
+    if (output == NULL)
+        return;
+
+    int end = bufferpos / 50;
+    while (end - outputPos >= SAM_FRAME_SIZE || (final && end > outputPos))
+    {
+        int start = outputPos & (SAM_RING_SIZE - 1);
+        int count = end - outputPos;
+        if (count > SAM_FRAME_SIZE)
+            count = SAM_FRAME_SIZE;
+        if (count > SAM_RING_SIZE - start)
+            count = SAM_RING_SIZE - start;
+
+        output((unsigned char *)&ring[start], count, outputCtx);
+        outputPos += count;
+    }
+}
+
 void Init();
 int Parser1();
 void Parser2();
@@ -97,10 +134,22 @@ void Init()
     SetMouthThroat(mouth, throat);
 
     bufferpos = 0;
-    // TODO, check for free the memory, 10 seconds of output should be more than enough
-    //buffer = (char*)ps_malloc(22050 * 5);
-    // switch to ESP-IDF equivalent
-    buffer = (char *)heap_caps_malloc(22050 * 10, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    outputPos = 0;
+    if (output != NULL)
+    {
+        // Streaming, the ring is reused for every utterance
+        buffer = ring;
+        bufferMask = SAM_RING_SIZE - 1;
+        memset(ring, 0, sizeof(ring));
+    }
+    else
+    {
+        // TODO, check for free the memory, 10 seconds of output should be more than enough
+        //buffer = (char*)ps_malloc(22050 * 5);
+        // switch to ESP-IDF equivalent
+        buffer = (char *)heap_caps_malloc(22050 * 10, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        bufferMask = -1;
+    }
     /*
     Due to a technical limitation, the maximum statically allocated DRAM usage is 160KB. 
     The remaining 160KB (for a total of 320KB of DRAM) can only be allocated at runtime as heap.
@@ -183,6 +232,7 @@ int SAMMain()
     }
 
     PrepareOutput();
+    FlushOutput(1);
 
     return 1;
 }
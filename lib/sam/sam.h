@@ -12,8 +12,19 @@ extern "C"
     void SetMouth(unsigned char _mouth);
     void SetThroat(unsigned char _throat);
     void EnableSingmode();
+    void SetSingmode(int _singmode);
     void EnableDebug();
 
+    // Streaming output. Once an output is set SAMMain() renders into a small
+    // ring buffer and hands the samples over in frames as soon as they are
+    // final, instead of rendering the whole utterance into one big buffer.
+    #define SAM_RING_SIZE   2048    // Power of two, must hold a frame plus write-ahead
+    #define SAM_FRAME_SIZE  256     // Samples per output call (~12ms at 22050Hz)
+
+    typedef void (*SamOutputFn)(unsigned char *samples, int count, void *ctx);
+    void SetOutput(SamOutputFn _output, void *_ctx);
+    void FlushOutput(int final);
+
     int SAMMain();
 
     char *GetBuffer();
@@ -3,6 +3,7 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/timers.h>
+#include <freertos/stream_buffer.h>
 #include <driver/gpio.h>
 #ifndef CONFIG_IDF_TARGET_ESP32S3
 #include <driver/dac.h>
@@ -20,11 +21,8 @@ int debug = 0;
 
 #ifndef ESP_PLATFORM
 
-void WriteWav(char *filename, char *buffer, int bufferlength)
+static void WriteWavHeader(FILE *file, unsigned int bufferlength)
 {
-    FILE *file = fopen(filename, "wb");
-    if (file == NULL)
-        return;
     //RIFF header
     fwrite("RIFF", 4, 1, file);
     unsigned int filesize = bufferlength + 12 + 16 + 8 - 8;
@@ -50,10 +48,24 @@ void WriteWav(char *filename, char *buffer, int bufferlength)
     //data chunk
     fwrite("data", 4, 1, file);
     fwrite(&bufferlength, 4, 1, file);
+}
+
+void WriteWav(char *filename, char *buffer, int bufferlength)
+{
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+        return;
+
+    WriteWavHeader(file, bufferlength);
     fwrite(buffer, bufferlength, 1, file);
 
     fclose(file);
 }
+
+static void WavOutput(unsigned char *samples, int count, void *ctx)
+{
+    fwrite(samples, count, 1, (FILE *)ctx);
+}
 #endif // NOT ESP_PLATFORM
 
 void PrintUsage()
@@ -157,46 +169,144 @@ void OutputSound()
 
 void OutputSound()
 {
-#ifdef ESP_PLATFORM
-#ifndef CONFIG_IDF_TARGET_ESP32S3
-    int n = GetBufferLength() / 50;
-    char *s = GetBuffer();
+    // Nothing to play it on, the ESP32 streams to the DAC from sam_say()
+}
+
+#endif
 
-    //fnSystem.dac_output_enable(SystemManager::dac_channel_t::DAC_CHANNEL_1);
-    //fnSystem.dac_output_voltage(SystemManager::dac_channel_t::DAC_CHANNEL_1, 100);
+#if defined(ESP_PLATFORM) && !defined(CONFIG_IDF_TARGET_ESP32S3)
 
-    dac_output_enable(DAC_CHANNEL_1);
+// Rendered frames wait here until the DAC task plays them, the renderer
+// blocks once it gets this far ahead of playback
+#define SAM_STREAM_SIZE 4096
+#define SAM_DAC_IDLE_MS 100
+
+static StreamBufferHandle_t sam_stream = nullptr;
+
+static void sam_dac_task(void *arg)
+{
+    uint8_t frame[SAM_FRAME_SIZE];
+    bool enabled = false;
 
-    for (int i = 0; i < n; i++)
+    while (true)
     {
-        //dacWrite(DAC1, s[i]);
-        // fnSystem.dac_write(PIN_DAC1, s[i]);
-        dac_output_voltage(DAC_CHANNEL_1, s[i]);
-        //delayMicroseconds(40);
-        fnSystem.delay_microseconds(40);
+        size_t n = xStreamBufferReceive(sam_stream, frame, sizeof(frame),
+                                        enabled ? pdMS_TO_TICKS(SAM_DAC_IDLE_MS) : portMAX_DELAY);
+        if (n == 0)
+        {
+            // Nothing more to say
+            dac_output_disable(DAC_CHANNEL_1);
+            enabled = false;
+            continue;
+        }
+
+        if (!enabled)
+        {
+            dac_output_enable(DAC_CHANNEL_1);
+            enabled = true;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            dac_output_voltage(DAC_CHANNEL_1, frame[i]);
+            fnSystem.delay_microseconds(40);
+        }
     }
+}
 
-    //fnSystem.dac_output_disable(SystemManager::dac_channel_t::DAC_CHANNEL_1);
-    dac_output_disable(DAC_CHANNEL_1);
+static void DacOutput(unsigned char *samples, int count, void *ctx)
+{
+    xStreamBufferSend(sam_stream, samples, count, portMAX_DELAY);
+}
 
-    FreeBuffer();
 #endif
+
+int sam_say(const SamVoice &voice, const char *text, const char *wavfilename)
+{
+#if defined(ESP_PLATFORM) && defined(CONFIG_IDF_TARGET_ESP32S3)
+    // No DAC to play it on
+    return 0;
 #endif
-}
 
+    SetSpeed(voice.speed);
+    SetPitch(voice.pitch);
+    SetMouth(voice.mouth);
+    SetThroat(voice.throat);
+    SetSingmode(voice.sing);
+
+    memset(input, 0, sizeof(input));
+    strlcpy(input, text, sizeof(input) - 1);
+
+    for (int i = 0; input[i] != 0; i++)
+        input[i] = toupper((int)input[i]);
+
+    if (debug)
+    {
+        if (voice.phonetic)
+            printf("phonetic input: %s\r\n", input);
+        else
+            printf("text input: %s\r\n", input);
+    }
+
+    if (!voice.phonetic)
+    {
+        strlcat(input, "[", sizeof(input) - strlen(input));
+        if (!TextToPhonemes((unsigned char *)input))
+            return 1;
+        if (debug)
+            printf("phonetic input: %s\r\n", input);
+    }
+    else
+        strlcat(input, "\x9b", sizeof(input) - strlen(input));
+
+#if defined(ESP_PLATFORM) && !defined(CONFIG_IDF_TARGET_ESP32S3)
+    if (sam_stream == nullptr)
+    {
+        sam_stream = xStreamBufferCreate(SAM_STREAM_SIZE, 1);
+        xTaskCreatePinnedToCore(sam_dac_task, "sam_dac_task", 2048, NULL, 5, NULL, 0);
+    }
+    SetOutput(DacOutput, nullptr);
+#elif !defined(ESP_PLATFORM)
+    FILE *wav = nullptr;
+    if (wavfilename != nullptr)
+    {
+        wav = fopen(wavfilename, "wb");
+        if (wav == nullptr)
+            return 1;
+
+        // Sizes are filled in once the length is known
+        WriteWavHeader(wav, 0);
+        SetOutput(WavOutput, wav);
+    }
 #endif
 
-int sam(int argc, char **argv)
-{
-    int i;
-    int phonetic = 0;
+    int result = SAMMain() ? 0 : 1;
 
-#ifndef ESP_PLATFORM
-    char *wavfilename = NULL;
+#if !defined(ESP_PLATFORM)
+    if (wav != nullptr)
+    {
+        unsigned int length = ftell(wav) - 44;
+        rewind(wav);
+        WriteWavHeader(wav, length);
+        fclose(wav);
+        SetOutput(nullptr, nullptr);
+    }
+    else if (result == 0)
+        OutputSound();
 #endif
 
-    for (i = 0; i < 256; i++)
-        input[i] = 0;
+    if (result)
+        PrintUsage();
+
+    return result;
+}
+
+int sam(int argc, char **argv)
+{
+    int i;
+    SamVoice voice;
+    char text[256] = { 0 };
+    const char *wavfilename = nullptr;
 
     if (argc <= 1)
     {
@@ -209,28 +319,26 @@ int sam(int argc, char **argv)
     {
         if (argv[i][0] != '-')
         {
-            strlcat(input, argv[i], 255);
-            strlcat(input, " ", 255);
+            strlcat(text, argv[i], 255);
+            strlcat(text, " ", 255);
         }
         else
         {
 
             if (strcmp(&argv[i][1], "wav") == 0)
             {
-#ifndef ESP_PLATFORM
                 wavfilename = argv[i + 1];
-#endif
                 i++;
             }
             else
 
                 if (strcmp(&argv[i][1], "sing") == 0)
             {
-                EnableSingmode();
+                voice.sing = true;
             }
             else if (strcmp(&argv[i][1], "phonetic") == 0)
             {
-                phonetic = 1;
+                voice.phonetic = true;
             }
             else if (strcmp(&argv[i][1], "debug") == 0)
             {
@@ -238,22 +346,22 @@ int sam(int argc, char **argv)
             }
             else if (strcmp(&argv[i][1], "pitch") == 0)
             {
-                SetPitch(atoi(argv[i + 1]));
+                voice.pitch = atoi(argv[i + 1]);
                 i++;
             }
             else if (strcmp(&argv[i][1], "speed") == 0)
             {
-                SetSpeed(atoi(argv[i + 1]));
+                voice.speed = atoi(argv[i + 1]);
                 i++;
             }
             else if (strcmp(&argv[i][1], "mouth") == 0)
             {
-                SetMouth(atoi(argv[i + 1]));
+                voice.mouth = atoi(argv[i + 1]);
                 i++;
             }
             else if (strcmp(&argv[i][1], "throat") == 0)
             {
-                SetThroat(atoi(argv[i + 1]));
+                voice.throat = atoi(argv[i + 1]);
                 i++;
             }
             else
@@ -266,33 +374,6 @@ int sam(int argc, char **argv)
         i++;
     } //while
 
-    // printf("arg parsing done\r\n");
-
-    for (i = 0; input[i] != 0; i++)
-        input[i] = toupper((int)input[i]);
-
-    if (debug)
-    {
-        if (phonetic)
-            printf("phonetic input: %s\r\n", input);
-        else
-            printf("text input: %s\r\n", input);
-    }
-
-    if (!phonetic)
-    {
-        strlcat(input, "[", sizeof(input) - strlen(input));
-        // printf("TextToPhonemes\r\n");
-        if (!TextToPhonemes((unsigned char *)input))
-            return 1;
-        if (debug)
-            printf("phonetic input: %s\r\n", input);
-    }
-    else
-        strlcat(input, "\x9b", sizeof(input) - strlen(input));
-
-        // printf("done phonetic processing\r\n");
-
 #ifdef USESDL
     if (SDL_Init(SDL_INIT_AUDIO) < 0)
     {
@@ -302,25 +383,5 @@ int sam(int argc, char **argv)
     atexit(SDL_Quit);
 #endif
 
-#ifndef __cplusplus
-    SetInput(input);
-#endif
-
-    // printf("right before SAMMain");
-
-    if (!SAMMain())
-    {
-        PrintUsage();
-        return 1;
-    }
-    // printf("right after SAMMain");
-
-#ifndef ESP_PLATFORM
-    if (wavfilename != NULL)
-        WriteWav(wavfilename, GetBuffer(), GetBufferLength() / 50);
-    else
-#endif // ESP_PLATFORM
-        OutputSound();
-
-    return 0;
+    return sam_say(voice, text, wavfilename);
 }
@@ -33,4 +33,19 @@ void OutputSound();
 void OutputSound();
 #endif
 
+// Synthesizer settings, kept by the caller and reused for every utterance
+struct SamVoice
+{
+    unsigned char speed = 72;
+    unsigned char pitch = 64;
+    unsigned char mouth = 128;
+    unsigned char throat = 128;
+    bool sing = false;
+    bool phonetic = false;
+};
+
+// Render text (or phonemes) and stream it to the DAC while it is rendered.
+// Host builds write it to wavfilename instead.
+int sam_say(const SamVoice &voice, const char *text, const char *wavfilename = nullptr);
+
 int sam(int argc, char **argv);
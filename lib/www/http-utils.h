@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+
+#include <esp_heap_caps.h>
+
+#define http_POOL_BUFF_SIZE  8192 // Size of each pooled send buffer
+#define http_POOL_BUFF_COUNT 2    // Buffers kept around between requests, in PSRAM
+
+// The httpd task handles one request at a time, so a couple of buffers
+// that live for the life of the server are enough to avoid a malloc/free
+// pair per request. They are only kept in PSRAM. Boards without it (or
+// when the pool is exhausted) get a buffer from the heap that is freed
+// again on release, so no internal RAM is held between requests.
+struct http_buffer_pool {
+        char *buffers[http_POOL_BUFF_COUNT] = { nullptr };
+        bool in_use[http_POOL_BUFF_COUNT] = { false };
+};
+
+inline http_buffer_pool &http_pool() {
+        static http_buffer_pool pool;
+        return pool;
+}
+
+inline char *http_buffer_acquire() {
+        http_buffer_pool &pool = http_pool();
+
+        for (int i = 0; i < http_POOL_BUFF_COUNT; i++) {
+                if (pool.in_use[i])
+                        continue;
+
+                if (pool.buffers[i] == nullptr)
+                        pool.buffers[i] = (char *) heap_caps_malloc(http_POOL_BUFF_SIZE, MALLOC_CAP_SPIRAM);
+
+                if (pool.buffers[i] == nullptr)
+                        break;
+
+                pool.in_use[i] = true;
+                return pool.buffers[i];
+        }
+
+        return (char *) malloc(http_POOL_BUFF_SIZE);
+}
+
+inline void http_buffer_release(char *buf) {
+        http_buffer_pool &pool = http_pool();
+
+        for (int i = 0; i < http_POOL_BUFF_COUNT; i++) {
+                if (pool.buffers[i] == buf) {
+                        pool.in_use[i] = false;
+                        return;
+                }
+        }
+
+        free(buf);
+}
+
+// Strong validator built from size and modification time.
+// st_ino is not stable (or even set) on FAT/SPIFFS, so it can't be used.
+inline std::string http_etag(time_t mtime, size_t size) {
+        char tmp[40];
+        snprintf(tmp, sizeof(tmp), "\"%lx-%lx\"", (unsigned long) mtime, (unsigned long) size);
+        return tmp;
+}
+
+inline std::string http_etag(const struct stat &sb) {
+        return http_etag(sb.st_mtime, sb.st_size);
+}
+
+// Check an If-None-Match header value against our ETag
+inline bool http_etag_matches(const std::string &if_none_match, const std::string &etag) {
+        if (if_none_match.empty())
+                return false;
+
+        if (if_none_match == "*")
+                return true;
+
+        size_t pos = 0;
+        while (pos < if_none_match.length()) {
+                size_t end = if_none_match.find(',', pos);
+                if (end == std::string::npos)
+                        end = if_none_match.length();
+
+                std::string tag = if_none_match.substr(pos, end - pos);
+                size_t first = tag.find_first_not_of(' ');
+                size_t last = tag.find_last_not_of(' ');
+                if (first != std::string::npos) {
+                        tag = tag.substr(first, last - first + 1);
+
+                        // weak comparison is fine for GET
+                        if (tag.compare(0, 2, "W/") == 0)
+                                tag = tag.substr(2);
+
+                        if (tag == etag)
+                                return true;
+                }
+
+                pos = end + 1;
+        }
+
+        return false;
+}
+
+enum http_range_result {
+        http_range_none = 0,     // no (usable) Range header, send the whole file
+        http_range_ok,           // start/length describe the requested slice
+        http_range_unsatisfiable // range is outside of the file
+};
+
+// Parse a single "bytes=" range. Multiple ranges are answered with the
+// whole file, which RFC 7233 allows.
+inline http_range_result http_parse_range(const std::string &range, size_t size, size_t &start, size_t &length) {
+        if (range.compare(0, 6, "bytes=") != 0)
+                return http_range_none;
+
+        std::string spec = range.substr(6);
+        if (spec.find(',') != std::string::npos)
+                return http_range_none;
+
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos)
+                return http_range_none;
+
+        std::string first = spec.substr(0, dash);
+        std::string last = spec.substr(dash + 1);
+        char *endp;
+
+        if (first.empty()) {
+                // suffix range: last N bytes
+                if (last.empty())
+                        return http_range_none;
+
+                unsigned long suffix = strtoul(last.c_str(), &endp, 10);
+                if (*endp != '\0')
+                        return http_range_none;
+                if (suffix == 0 || size == 0)
+                        return http_range_unsatisfiable;
+                if (suffix > size)
+                        suffix = size;
+
+                start = size - suffix;
+                length = suffix;
+                return http_range_ok;
+        }
+
+        unsigned long from = strtoul(first.c_str(), &endp, 10);
+        if (*endp != '\0')
+                return http_range_none;
+        if (from >= size)
+                return http_range_unsatisfiable;
+
+        unsigned long to = size - 1;
+        if (!last.empty()) {
+                to = strtoul(last.c_str(), &endp, 10);
+                if (*endp != '\0' || to < from)
+                        return http_range_none;
+                if (to >= size)
+                        to = size - 1;
+        }
+
+        start = from;
+        length = to - from + 1;
+        return http_range_ok;
+}
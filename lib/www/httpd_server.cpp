@@ -24,6 +24,7 @@
 #include "fnFsSD.h"
 
 #include "template.h"
+#include "http-utils.h"
 
 #define MIN(a, b) \
     ({ __typeof__ (a) _a = (a); \
@@ -341,6 +342,19 @@ void cHttpdServer::set_file_content_type(httpd_req_t *req, const char *filepath)
     }
 }
 
+// Return the value of a request header, or an empty string
+std::string cHttpdServer::get_header(httpd_req_t *req, const char *name)
+{
+    size_t len = httpd_req_get_hdr_value_len(req, name);
+    if (len == 0)
+        return "";
+
+    std::string value;
+    value.resize(len);
+    httpd_req_get_hdr_value_str(req, name, &value[0], len + 1);
+    return value;
+}
+
 // Send content of given file out to client
 void cHttpdServer::send_file(httpd_req_t *req, const char *filename)
 {
@@ -371,6 +385,35 @@ void cHttpdServer::send_file(httpd_req_t *req, const char *filename)
     {
         // auto istream = file->meatStream();
 
+        // Let the browser revalidate static files instead of downloading them again.
+        // The server only keeps a pointer to the header value, it has to last
+        // until the response is sent
+        std::string etag;
+        struct stat sb;
+        if (fstat(fileno(file), &sb) == 0)
+        {
+            etag = http_etag(sb);
+            if (http_etag_matches(get_header(req, "If-None-Match"), etag))
+            {
+                fclose(file);
+                httpd_resp_set_status(req, "304 Not Modified");
+                httpd_resp_send(req, NULL, 0);
+                return;
+            }
+        }
+
+        char *buf = http_buffer_acquire();
+        if (buf == nullptr)
+        {
+            Debug_println("No buffer to send file");
+            fclose(file);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, MSG_ERR_OUT_OF_MEMORY);
+            return;
+        }
+
+        if (!etag.empty())
+            httpd_resp_set_hdr(req, "ETag", etag.c_str());
+
         // Set the response content type
         set_file_content_type(req, fpath.c_str());
         // Set the expected length of the content
@@ -380,16 +423,15 @@ void cHttpdServer::send_file(httpd_req_t *req, const char *filename)
         httpd_resp_set_hdr(req, "Content-Length", hdrval);
 
         // Send the file content out in chunks
-        char *buf = (char *)malloc(http_SEND_BUFF_SIZE);
         size_t count = 0;
         do
         {
-            // count = istream->read( (uint8_t *)buf, http_SEND_BUFF_SIZE );
-            count = fread(buf, 1, http_SEND_BUFF_SIZE, file);
+            // count = istream->read( (uint8_t *)buf, http_POOL_BUFF_SIZE );
+            count = fread(buf, 1, http_POOL_BUFF_SIZE, file);
             httpd_resp_send_chunk(req, buf, count);
         } while (count > 0);
         fclose(file);
-        free(buf);
+        http_buffer_release(buf);
     }
 }
 
@@ -419,24 +461,21 @@ void cHttpdServer::send_file_parsed(httpd_req_t *req, const char *filename)
 
         // Set the response content type
         set_file_content_type(req, filename);
-        // We're going to load the whole thing into memory, so watch out for big files!
-        //size_t sz = istream->size() + 1;
-        size_t sz = FileSystem::filesize(file) + 1;
-        char *buf = (char *)calloc(sz, 1);
-        if (buf == NULL)
+
+        // Pages are compiled into literal spans and tags the first time
+        // they're served; after that we only copy spans and fill in tags
+        const compiled_template *tpl = get_template(file, filename);
+        if (tpl == nullptr)
         {
-            Debug_printf("Couldn't allocate %u bytes to load file contents!\r\n", sz);
+            Debug_printf("Couldn't compile template '%s'\r\n", filename);
             err = http_err_memory;
         }
         else
         {
-            // istream->read( (uint8_t *)buf, sz );
-            fread(buf, 1, sz, file);
-            std::string contents(buf);
-            free(buf);
-            contents = parse_contents(contents);
-
-            httpd_resp_send(req, contents.c_str(), contents.length());
+            render_template(file, *tpl, [](void *ctx, const char *buf, size_t len) {
+                return httpd_resp_send_chunk((httpd_req_t *)ctx, buf, len) == ESP_OK;
+            }, req);
+            httpd_resp_send_chunk(req, NULL, 0);
         }
         fclose(file);
     }
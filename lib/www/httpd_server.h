@@ -6,7 +6,6 @@
 #include "fnFS.h"
 
 #define http_FILE_ROOT "/.www/"
-#define http_SEND_BUFF_SIZE 512 // Used when sending files in chunks
 #define http_RECV_BUFF_SIZE 512 // Used when receiving POST data from client
 
 #define MSG_ERR_OPENING_FILE     "Error opening file"
@@ -37,6 +36,7 @@ private:
     static char * get_extension(const char *filename);
     static const char *find_mimetype_str(const char *extension);
     static void set_file_content_type(httpd_req_t *req, const char *filepath);
+    static std::string get_header(httpd_req_t *req, const char *name);
     static void send_file(httpd_req_t *req, const char *filename);
     static void send_file_parsed(httpd_req_t *req, const char *filename);
     static void return_http_error(httpd_req_t *req, http_err errnum);
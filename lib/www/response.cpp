@@ -1,11 +1,18 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <algorithm>
 
 #include "response.h"
+#include "http-utils.h"
 
 using namespace WebDav;
 
+Response::~Response() {
+        if (buffer)
+                http_buffer_release(buffer);
+}
+
 void Response::setDavHeaders() {
         setHeader("DAV", "1");
         setHeader("Allow", "PROPFIND,OPTIONS,DELETE,COPY,MOVE,HEAD,POST,PUT,GET");
@@ -22,6 +29,66 @@ void Response::setHeader(std::string header, size_t value) {
 }
 
 void Response::flushHeaders() {
+        // Handlers that stream a body flush early; don't add the headers twice
+        if (flushed)
+                return;
+        flushed = true;
+
         for (const auto &h: headers)
                 writeHeader(h.first.c_str(), h.second.c_str());
 }
+
+bool Response::write(const char *buf, size_t len) {
+        if (failed)
+                return false;
+
+        if (!buffer) {
+                buffer = http_buffer_acquire();
+                if (!buffer)
+                        return sendChunk(buf, len);
+        }
+
+        while (len > 0) {
+                size_t n = std::min(len, (size_t) http_POOL_BUFF_SIZE - buffered);
+                memcpy(buffer + buffered, buf, n);
+                buffered += n;
+                buf += n;
+                len -= n;
+
+                if (buffered == http_POOL_BUFF_SIZE && !flushBuffer())
+                        return false;
+        }
+
+        return true;
+}
+
+bool Response::writeEscaped(const char *buf) {
+        const char *start = buf;
+
+        for (; *buf; buf++) {
+                const char *entity = nullptr;
+
+                switch (*buf) {
+                case '&': entity = "&amp;"; break;
+                case '<': entity = "&lt;"; break;
+                case '>': entity = "&gt;"; break;
+                case '"': entity = "&quot;"; break;
+                default: continue;
+                }
+
+                if (!write(start, buf - start) || !write(entity))
+                        return false;
+                start = buf + 1;
+        }
+
+        return write(start, buf - start);
+}
+
+bool Response::flushBuffer() {
+        if (buffered == 0)
+                return true;
+
+        size_t len = buffered;
+        buffered = 0;
+        return sendChunk(buffer, len);
+}
@@ -12,7 +12,9 @@
 #define HTTPD_200      "200 OK"                     /*!< HTTP Response 200 */
 #define HTTPD_201      "201 Created"
 #define HTTPD_204      "204 No Content"             /*!< HTTP Response 204 */
+#define HTTPD_206      "206 Partial Content"
 #define HTTPD_207      "207 Multi-Status"           /*!< HTTP Response 207 */
+#define HTTPD_304      "304 Not Modified"
 #define HTTPD_400      "400 Bad Request"            /*!< HTTP Response 400 */
 #define HTTPD_403      "403 Forbidden"
 #define HTTPD_404      "404 Not Found"              /*!< HTTP Response 404 */
@@ -21,6 +23,7 @@
 #define HTTPD_409      "409 Conflict"
 #define HTTPD_412      "412 Precondition Failed"
 #define HTTPD_415      "415 Unspported Media Type"
+#define HTTPD_416      "416 Range Not Satisfiable"
 #define HTTPD_500      "500 Internal Server Error"  /*!< HTTP Response 500 */
 #define HTTPD_501      "501 Not Implemented"
 #define HTTPD_507      "507 Insufficient Storage"
@@ -28,15 +31,6 @@
 namespace WebDav
 {
 
-    class MultiStatusResponse
-    {
-    public:
-        std::string href;
-        std::string status;
-        std::map<std::string, std::string> props;
-        bool isCollection;
-    };
-
     class Response
     {
     public:
@@ -44,7 +38,7 @@ namespace WebDav
             req = httpd_req;
             setDavHeaders();
         }
-        ~Response() {}
+        ~Response();
 
         void setDavHeaders();
         void setHeader(std::string header, std::string value);
@@ -66,9 +60,15 @@ namespace WebDav
                 case 204:
                     status = HTTPD_204;
                     break;
+                case 206:
+                    status = HTTPD_206;
+                    break;
                 case 207:
                     status = HTTPD_207;
                     break;
+                case 304:
+                    status = HTTPD_304;
+                    break;
                 case 400:
                     status = HTTPD_400;
                     break;
@@ -93,6 +93,9 @@ namespace WebDav
                 case 415:
                     status = HTTPD_415;
                     break;
+                case 416:
+                    status = HTTPD_416;
+                    break;
                 case 500:
                     status = HTTPD_500;
                     break;
@@ -119,17 +122,32 @@ namespace WebDav
         {
             chunked = true;
 
+            // Once a send failed the client is gone, nothing more goes out
+            if (failed)
+                return false;
+
             if (len == -1)
                 len = strlen(buf);
 
-            return httpd_resp_send_chunk(req, buf, len) == ESP_OK;
+            failed = (httpd_resp_send_chunk(req, buf, len) != ESP_OK);
+            return !failed;
         }
 
         void closeChunk()
         {
-            httpd_resp_send_chunk(req, NULL, 0);
+            flushBuffer();
+            if (!failed)
+                httpd_resp_send_chunk(req, NULL, 0);
         }
 
+        // Buffered body output, sent as one chunk whenever the buffer fills up
+        bool write(const char *buf, size_t len);
+        bool write(const char *buf) { return write(buf, strlen(buf)); }
+        bool write(const std::string &s) { return write(s.data(), s.length()); }
+        bool writeEscaped(const char *buf);
+        bool flushBuffer();
+        bool error() { return failed; }
+
         void closeBody()
         {
             if (!chunked)
@@ -143,7 +161,12 @@ private:
         }
 
         httpd_req_t *req;
-        bool chunked;
+        bool chunked = false;
+        bool flushed = false;
+        bool failed = false;
+
+        char *buffer = nullptr;
+        size_t buffered = 0;
 
         std::map<std::string, std::string> headers;
     };
@@ -1,7 +1,10 @@
 
 #include "template.h"
 
+#include <algorithm>
+#include <map>
 #include <sstream>
+#include <sys/stat.h>
 
 #include "../../include/debug.h"
 
@@ -14,6 +17,8 @@
 #include "fnWiFi.h"
 #include "ssdp.h"
 
+#include "string_utils.h"
+
 
 bool is_parsable(const char *extension)
 {
@@ -31,156 +36,355 @@ bool is_parsable(const char *extension)
 }
 
 
-// Look for anything between {{ and }} tags
-// And send that to a routine that looks for suitable substitutions
-// Returns string with subtitutions in place
-std::string parse_contents(const std::string &contents)
-{
-    //Debug_printv("parsing");
-    std::stringstream ss;
-    uint pos = 0, x, y;
-    do
-    {
-        x = contents.find("{{", pos);
-        if (x == std::string::npos)
-        {
-            ss << contents.substr(pos);
-            break;
-        }
-        // Found opening tag, now find ending
-        y = contents.find("}}", x + 2);
-        if (y == std::string::npos)
-        {
-            ss << contents.substr(pos);
-            break;
-        }
-        // Now we have starting and ending tags
-        if (x > 0)
-            ss << contents.substr(pos, x - pos);
-        ss << substitute_tag(contents.substr(x + 2, y - x - 2));
-        pos = y + 2;
-    } while (true);
-
-    return ss.str();
-}
-
-long uptime_seconds()
+enum template_tagids
 {
-    return fnSystem.get_uptime() / 1000000;
-}
+    DEVICE_HOSTNAME = 0,
+    DEVICE_VERSION,
+    DEVICE_IPADDRESS,
+    DEVICE_IPMASK,
+    DEVICE_IPGATEWAY,
+    DEVICE_IPDNS,
+    DEVICE_WIFISSID,
+    DEVICE_WIFIBSSID,
+    DEVICE_WIFIMAC,
+    DEVICE_WIFIDETAIL,
+    DEVICE_SPIFFS_SIZE,
+    DEVICE_SPIFFS_USED,
+    DEVICE_SD_SIZE,
+    DEVICE_SD_USED,
+    DEVICE_UPTIME_STRING,
+    DEVICE_UPTIME,
+    DEVICE_CURRENTTIME,
+    DEVICE_TIMEZONE,
+    DEVICE_ROTATION_SOUNDS,
+    DEVICE_UDPSTREAM_HOST,
+    DEVICE_HEAPSIZE,
+    DEVICE_SYSSDK,
+    DEVICE_SYSCPUREV,
+    DEVICE_SIOVOLTS,
+    DEVICE_SIO_HSINDEX,
+    DEVICE_SIO_HSBAUD,
+    DEVICE_PRINTER1_MODEL,
+    DEVICE_PRINTER1_PORT,
+    DEVICE_PLAY_RECORD,
+    DEVICE_PULLDOWN,
+    DEVICE_CASSETTE_ENABLED,
+    DEVICE_CONFIG_ENABLED,
+    DEVICE_STATUS_WAIT_ENABLED,
+    DEVICE_BOOT_MODE,
+    DEVICE_PRINTER_ENABLED,
+    DEVICE_MODEM_ENABLED,
+    DEVICE_MODEM_SNIFFER_ENABLED,
+    DEVICE_DRIVE1HOST,
+    DEVICE_DRIVE2HOST,
+    DEVICE_DRIVE3HOST,
+    DEVICE_DRIVE4HOST,
+    DEVICE_DRIVE5HOST,
+    DEVICE_DRIVE6HOST,
+    DEVICE_DRIVE7HOST,
+    DEVICE_DRIVE8HOST,
+    DEVICE_DRIVE1MOUNT,
+    DEVICE_DRIVE2MOUNT,
+    DEVICE_DRIVE3MOUNT,
+    DEVICE_DRIVE4MOUNT,
+    DEVICE_DRIVE5MOUNT,
+    DEVICE_DRIVE6MOUNT,
+    DEVICE_DRIVE7MOUNT,
+    DEVICE_DRIVE8MOUNT,
+    DEVICE_HOST1,
+    DEVICE_HOST2,
+    DEVICE_HOST3,
+    DEVICE_HOST4,
+    DEVICE_HOST5,
+    DEVICE_HOST6,
+    DEVICE_HOST7,
+    DEVICE_HOST8,
+    DEVICE_DRIVE1,
+    DEVICE_DRIVE2,
+    DEVICE_DRIVE3,
+    DEVICE_DRIVE4,
+    DEVICE_DRIVE5,
+    DEVICE_DRIVE6,
+    DEVICE_DRIVE7,
+    DEVICE_DRIVE8,
+    DEVICE_HOST1PREFIX,
+    DEVICE_HOST2PREFIX,
+    DEVICE_HOST3PREFIX,
+    DEVICE_HOST4PREFIX,
+    DEVICE_HOST5PREFIX,
+    DEVICE_HOST6PREFIX,
+    DEVICE_HOST7PREFIX,
+    DEVICE_HOST8PREFIX,
+    DEVICE_ERRMSG,
+    DEVICE_HARDWARE_VER,
+    DEVICE_PRINTER_LIST,
+    DEVICE_UUID,
+    DEVICE_LASTTAG
+};
 
-std::string format_uptime()
+// Map a tag name to its id through a hash switch instead of comparing
+// against every known tag name in turn
+int template_tag_id(const std::string &tag)
 {
-    int64_t ms = fnSystem.get_uptime();
-    long s = ms / 1000000;
+    int tagid = DEVICE_LASTTAG;
 
-    int m = s / 60;
-    int h = m / 60;
-    int d = h / 24;
+    switch (hash_djb2a(tag))
+    {
+    case "DEVICE_HOSTNAME"_sh:
+        tagid = DEVICE_HOSTNAME;
+        break;
+    case "DEVICE_VERSION"_sh:
+        tagid = DEVICE_VERSION;
+        break;
+    case "DEVICE_IPADDRESS"_sh:
+        tagid = DEVICE_IPADDRESS;
+        break;
+    case "DEVICE_IPMASK"_sh:
+        tagid = DEVICE_IPMASK;
+        break;
+    case "DEVICE_IPGATEWAY"_sh:
+        tagid = DEVICE_IPGATEWAY;
+        break;
+    case "DEVICE_IPDNS"_sh:
+        tagid = DEVICE_IPDNS;
+        break;
+    case "DEVICE_WIFISSID"_sh:
+        tagid = DEVICE_WIFISSID;
+        break;
+    case "DEVICE_WIFIBSSID"_sh:
+        tagid = DEVICE_WIFIBSSID;
+        break;
+    case "DEVICE_WIFIMAC"_sh:
+        tagid = DEVICE_WIFIMAC;
+        break;
+    case "DEVICE_WIFIDETAIL"_sh:
+        tagid = DEVICE_WIFIDETAIL;
+        break;
+    case "DEVICE_SPIFFS_SIZE"_sh:
+        tagid = DEVICE_SPIFFS_SIZE;
+        break;
+    case "DEVICE_SPIFFS_USED"_sh:
+        tagid = DEVICE_SPIFFS_USED;
+        break;
+    case "DEVICE_SD_SIZE"_sh:
+        tagid = DEVICE_SD_SIZE;
+        break;
+    case "DEVICE_SD_USED"_sh:
+        tagid = DEVICE_SD_USED;
+        break;
+    case "DEVICE_UPTIME_STRING"_sh:
+        tagid = DEVICE_UPTIME_STRING;
+        break;
+    case "DEVICE_UPTIME"_sh:
+        tagid = DEVICE_UPTIME;
+        break;
+    case "DEVICE_CURRENTTIME"_sh:
+        tagid = DEVICE_CURRENTTIME;
+        break;
+    case "DEVICE_TIMEZONE"_sh:
+        tagid = DEVICE_TIMEZONE;
+        break;
+    case "DEVICE_ROTATION_SOUNDS"_sh:
+        tagid = DEVICE_ROTATION_SOUNDS;
+        break;
+    case "DEVICE_UDPSTREAM_HOST"_sh:
+        tagid = DEVICE_UDPSTREAM_HOST;
+        break;
+    case "DEVICE_HEAPSIZE"_sh:
+        tagid = DEVICE_HEAPSIZE;
+        break;
+    case "DEVICE_SYSSDK"_sh:
+        tagid = DEVICE_SYSSDK;
+        break;
+    case "DEVICE_SYSCPUREV"_sh:
+        tagid = DEVICE_SYSCPUREV;
+        break;
+    case "DEVICE_SIOVOLTS"_sh:
+        tagid = DEVICE_SIOVOLTS;
+        break;
+    case "DEVICE_SIO_HSINDEX"_sh:
+        tagid = DEVICE_SIO_HSINDEX;
+        break;
+    case "DEVICE_SIO_HSBAUD"_sh:
+        tagid = DEVICE_SIO_HSBAUD;
+        break;
+    case "DEVICE_PRINTER1_MODEL"_sh:
+        tagid = DEVICE_PRINTER1_MODEL;
+        break;
+    case "DEVICE_PRINTER1_PORT"_sh:
+        tagid = DEVICE_PRINTER1_PORT;
+        break;
+    case "DEVICE_PLAY_RECORD"_sh:
+        tagid = DEVICE_PLAY_RECORD;
+        break;
+    case "DEVICE_PULLDOWN"_sh:
+        tagid = DEVICE_PULLDOWN;
+        break;
+    case "DEVICE_CASSETTE_ENABLED"_sh:
+        tagid = DEVICE_CASSETTE_ENABLED;
+        break;
+    case "DEVICE_CONFIG_ENABLED"_sh:
+        tagid = DEVICE_CONFIG_ENABLED;
+        break;
+    case "DEVICE_STATUS_WAIT_ENABLED"_sh:
+        tagid = DEVICE_STATUS_WAIT_ENABLED;
+        break;
+    case "DEVICE_BOOT_MODE"_sh:
+        tagid = DEVICE_BOOT_MODE;
+        break;
+    case "DEVICE_PRINTER_ENABLED"_sh:
+        tagid = DEVICE_PRINTER_ENABLED;
+        break;
+    case "DEVICE_MODEM_ENABLED"_sh:
+        tagid = DEVICE_MODEM_ENABLED;
+        break;
+    case "DEVICE_MODEM_SNIFFER_ENABLED"_sh:
+        tagid = DEVICE_MODEM_SNIFFER_ENABLED;
+        break;
+    case "DEVICE_DRIVE1HOST"_sh:
+        tagid = DEVICE_DRIVE1HOST;
+        break;
+    case "DEVICE_DRIVE2HOST"_sh:
+        tagid = DEVICE_DRIVE2HOST;
+        break;
+    case "DEVICE_DRIVE3HOST"_sh:
+        tagid = DEVICE_DRIVE3HOST;
+        break;
+    case "DEVICE_DRIVE4HOST"_sh:
+        tagid = DEVICE_DRIVE4HOST;
+        break;
+    case "DEVICE_DRIVE5HOST"_sh:
+        tagid = DEVICE_DRIVE5HOST;
+        break;
+    case "DEVICE_DRIVE6HOST"_sh:
+        tagid = DEVICE_DRIVE6HOST;
+        break;
+    case "DEVICE_DRIVE7HOST"_sh:
+        tagid = DEVICE_DRIVE7HOST;
+        break;
+    case "DEVICE_DRIVE8HOST"_sh:
+        tagid = DEVICE_DRIVE8HOST;
+        break;
+    case "DEVICE_DRIVE1MOUNT"_sh:
+        tagid = DEVICE_DRIVE1MOUNT;
+        break;
+    case "DEVICE_DRIVE2MOUNT"_sh:
+        tagid = DEVICE_DRIVE2MOUNT;
+        break;
+    case "DEVICE_DRIVE3MOUNT"_sh:
+        tagid = DEVICE_DRIVE3MOUNT;
+        break;
+    case "DEVICE_DRIVE4MOUNT"_sh:
+        tagid = DEVICE_DRIVE4MOUNT;
+        break;
+    case "DEVICE_DRIVE5MOUNT"_sh:
+        tagid = DEVICE_DRIVE5MOUNT;
+        break;
+    case "DEVICE_DRIVE6MOUNT"_sh:
+        tagid = DEVICE_DRIVE6MOUNT;
+        break;
+    case "DEVICE_DRIVE7MOUNT"_sh:
+        tagid = DEVICE_DRIVE7MOUNT;
+        break;
+    case "DEVICE_DRIVE8MOUNT"_sh:
+        tagid = DEVICE_DRIVE8MOUNT;
+        break;
+    case "DEVICE_HOST1"_sh:
+        tagid = DEVICE_HOST1;
+        break;
+    case "DEVICE_HOST2"_sh:
+        tagid = DEVICE_HOST2;
+        break;
+    case "DEVICE_HOST3"_sh:
+        tagid = DEVICE_HOST3;
+        break;
+    case "DEVICE_HOST4"_sh:
+        tagid = DEVICE_HOST4;
+        break;
+    case "DEVICE_HOST5"_sh:
+        tagid = DEVICE_HOST5;
+        break;
+    case "DEVICE_HOST6"_sh:
+        tagid = DEVICE_HOST6;
+        break;
+    case "DEVICE_HOST7"_sh:
+        tagid = DEVICE_HOST7;
+        break;
+    case "DEVICE_HOST8"_sh:
+        tagid = DEVICE_HOST8;
+        break;
+    case "DEVICE_DRIVE1"_sh:
+        tagid = DEVICE_DRIVE1;
+        break;
+    case "DEVICE_DRIVE2"_sh:
+        tagid = DEVICE_DRIVE2;
+        break;
+    case "DEVICE_DRIVE3"_sh:
+        tagid = DEVICE_DRIVE3;
+        break;
+    case "DEVICE_DRIVE4"_sh:
+        tagid = DEVICE_DRIVE4;
+        break;
+    case "DEVICE_DRIVE5"_sh:
+        tagid = DEVICE_DRIVE5;
+        break;
+    case "DEVICE_DRIVE6"_sh:
+        tagid = DEVICE_DRIVE6;
+        break;
+    case "DEVICE_DRIVE7"_sh:
+        tagid = DEVICE_DRIVE7;
+        break;
+    case "DEVICE_DRIVE8"_sh:
+        tagid = DEVICE_DRIVE8;
+        break;
+    case "DEVICE_HOST1PREFIX"_sh:
+        tagid = DEVICE_HOST1PREFIX;
+        break;
+    case "DEVICE_HOST2PREFIX"_sh:
+        tagid = DEVICE_HOST2PREFIX;
+        break;
+    case "DEVICE_HOST3PREFIX"_sh:
+        tagid = DEVICE_HOST3PREFIX;
+        break;
+    case "DEVICE_HOST4PREFIX"_sh:
+        tagid = DEVICE_HOST4PREFIX;
+        break;
+    case "DEVICE_HOST5PREFIX"_sh:
+        tagid = DEVICE_HOST5PREFIX;
+        break;
+    case "DEVICE_HOST6PREFIX"_sh:
+        tagid = DEVICE_HOST6PREFIX;
+        break;
+    case "DEVICE_HOST7PREFIX"_sh:
+        tagid = DEVICE_HOST7PREFIX;
+        break;
+    case "DEVICE_HOST8PREFIX"_sh:
+        tagid = DEVICE_HOST8PREFIX;
+        break;
+    case "DEVICE_ERRMSG"_sh:
+        tagid = DEVICE_ERRMSG;
+        break;
+    case "DEVICE_HARDWARE_VER"_sh:
+        tagid = DEVICE_HARDWARE_VER;
+        break;
+    case "DEVICE_PRINTER_LIST"_sh:
+        tagid = DEVICE_PRINTER_LIST;
+        break;
+    case "DEVICE_UUID"_sh:
+        tagid = DEVICE_UUID;
+        break;
+    }
 
-    std::stringstream resultstream;
-    if (d)
-        resultstream << d << " days, ";
-    if (h % 24)
-        resultstream << (h % 24) << " hours, ";
-    if (m % 60)
-        resultstream << (m % 60) << " minutes, ";
-    if (s % 60)
-        resultstream << (s % 60) << " seconds";
+    // Guard against hash collisions with unknown tags
+    if (tagid != DEVICE_LASTTAG && tag.compare(template_tag_name(tagid)) != 0)
+        tagid = DEVICE_LASTTAG;
 
-    return resultstream.str();
+    return tagid;
 }
 
-
-const std::string substitute_tag(const std::string &tag)
+const char *template_tag_name(int tagid)
 {
-    enum tagids
-    {
-        DEVICE_HOSTNAME = 0,
-        DEVICE_VERSION,
-        DEVICE_IPADDRESS,
-        DEVICE_IPMASK,
-        DEVICE_IPGATEWAY,
-        DEVICE_IPDNS,
-        DEVICE_WIFISSID,
-        DEVICE_WIFIBSSID,
-        DEVICE_WIFIMAC,
-        DEVICE_WIFIDETAIL,
-        DEVICE_SPIFFS_SIZE,
-        DEVICE_SPIFFS_USED,
-        DEVICE_SD_SIZE,
-        DEVICE_SD_USED,
-        DEVICE_UPTIME_STRING,
-        DEVICE_UPTIME,
-        DEVICE_CURRENTTIME,
-        DEVICE_TIMEZONE,
-        DEVICE_ROTATION_SOUNDS,
-        DEVICE_UDPSTREAM_HOST,
-        DEVICE_HEAPSIZE,
-        DEVICE_SYSSDK,
-        DEVICE_SYSCPUREV,
-        DEVICE_SIOVOLTS,
-        DEVICE_SIO_HSINDEX,
-        DEVICE_SIO_HSBAUD,
-        DEVICE_PRINTER1_MODEL,
-        DEVICE_PRINTER1_PORT,
-        DEVICE_PLAY_RECORD,
-        DEVICE_PULLDOWN,
-        DEVICE_CASSETTE_ENABLED,
-        DEVICE_CONFIG_ENABLED,
-        DEVICE_STATUS_WAIT_ENABLED,
-        DEVICE_BOOT_MODE,
-        DEVICE_PRINTER_ENABLED,
-        DEVICE_MODEM_ENABLED,
-        DEVICE_MODEM_SNIFFER_ENABLED,
-        DEVICE_DRIVE1HOST,
-        DEVICE_DRIVE2HOST,
-        DEVICE_DRIVE3HOST,
-        DEVICE_DRIVE4HOST,
-        DEVICE_DRIVE5HOST,
-        DEVICE_DRIVE6HOST,
-        DEVICE_DRIVE7HOST,
-        DEVICE_DRIVE8HOST,
-        DEVICE_DRIVE1MOUNT,
-        DEVICE_DRIVE2MOUNT,
-        DEVICE_DRIVE3MOUNT,
-        DEVICE_DRIVE4MOUNT,
-        DEVICE_DRIVE5MOUNT,
-        DEVICE_DRIVE6MOUNT,
-        DEVICE_DRIVE7MOUNT,
-        DEVICE_DRIVE8MOUNT,
-        DEVICE_HOST1,
-        DEVICE_HOST2,
-        DEVICE_HOST3,
-        DEVICE_HOST4,
-        DEVICE_HOST5,
-        DEVICE_HOST6,
-        DEVICE_HOST7,
-        DEVICE_HOST8,
-        DEVICE_DRIVE1,
-        DEVICE_DRIVE2,
-        DEVICE_DRIVE3,
-        DEVICE_DRIVE4,
-        DEVICE_DRIVE5,
-        DEVICE_DRIVE6,
-        DEVICE_DRIVE7,
-        DEVICE_DRIVE8,
-        DEVICE_HOST1PREFIX,
-        DEVICE_HOST2PREFIX,
-        DEVICE_HOST3PREFIX,
-        DEVICE_HOST4PREFIX,
-        DEVICE_HOST5PREFIX,
-        DEVICE_HOST6PREFIX,
-        DEVICE_HOST7PREFIX,
-        DEVICE_HOST8PREFIX,
-        DEVICE_ERRMSG,
-        DEVICE_HARDWARE_VER,
-        DEVICE_PRINTER_LIST,
-        DEVICE_UUID,
-        DEVICE_LASTTAG
-    };
-
-    const char *tagids[DEVICE_LASTTAG] =
+    static const char *tagnames[DEVICE_LASTTAG] =
     {
         "DEVICE_HOSTNAME",
         "DEVICE_VERSION",
@@ -265,21 +469,174 @@ const std::string substitute_tag(const std::string &tag)
         "DEVICE_UUID"
     };
 
-    std::stringstream resultstream;
+    if (tagid < 0 || tagid >= DEVICE_LASTTAG)
+        return "";
 
-#ifdef DEBUG
-    // Debug_printf("Substituting tag '%s'\r\n", tag.c_str());
-#endif
+    return tagnames[tagid];
+}
 
-    int tagid;
-    for (tagid = 0; tagid < DEVICE_LASTTAG; tagid++)
+// Scan the file once for anything between {{ and }} tags and remember
+// where the literal spans and tags are, so later requests don't have to
+// parse the page again
+static bool compile_template(FILE *file, compiled_template &tpl)
+{
+    std::string contents;
+    contents.resize(tpl.size);
+    fseek(file, 0, SEEK_SET);
+    if (fread(&contents[0], 1, tpl.size, file) != tpl.size)
+        return false;
+
+    tpl.segments.clear();
+
+    size_t pos = 0, x, y;
+    do
     {
-        if (0 == tag.compare(tagids[tagid]))
-        {
+        x = contents.find("{{", pos);
+        if (x == std::string::npos)
             break;
+        // Found opening tag, now find ending
+        y = contents.find("}}", x + 2);
+        if (y == std::string::npos)
+            break;
+        // Now we have starting and ending tags
+        if (x > pos)
+            tpl.segments.push_back({pos, x - pos, -1});
+
+        int tagid = template_tag_id(contents.substr(x + 2, y - x - 2));
+        if (tagid == DEVICE_LASTTAG)
+            // Unknown tags are replaced by their name
+            tpl.segments.push_back({x + 2, y - x - 2, -1});
+        else
+            tpl.segments.push_back({x, y + 2 - x, tagid});
+
+        pos = y + 2;
+    } while (true);
+
+    if (pos < tpl.size)
+        tpl.segments.push_back({pos, tpl.size - pos, -1});
+
+    return true;
+}
+
+// Compiled templates, keyed by file name
+static std::map<std::string, compiled_template> template_cache;
+
+const compiled_template *get_template(FILE *file, const char *filename)
+{
+    struct stat sb;
+    if (fstat(fileno(file), &sb) != 0)
+        return nullptr;
+
+    compiled_template &tpl = template_cache[filename];
+
+    // Recompile if the file was replaced since we last looked at it
+    if (tpl.size != (size_t)sb.st_size || tpl.mtime != sb.st_mtime || tpl.segments.empty())
+    {
+        tpl.size = sb.st_size;
+        tpl.mtime = sb.st_mtime;
+        if (!compile_template(file, tpl))
+        {
+            template_cache.erase(filename);
+            return nullptr;
+        }
+        Debug_printv("compiled [%s] segments[%d]", filename, tpl.segments.size());
+    }
+
+    return &tpl;
+}
+
+// Render a compiled template, handing the output to send() in chunks of
+// roughly TEMPLATE_CHUNK_SIZE bytes
+bool render_template(FILE *file, const compiled_template &tpl, template_send_fn send, void *ctx)
+{
+    std::string out;
+    out.reserve(TEMPLATE_CHUNK_SIZE + 256);
+
+    for (const auto &seg : tpl.segments)
+    {
+        if (seg.tagid < 0)
+        {
+            // Copy the literal span from the file straight into the chunk
+            fseek(file, seg.offset, SEEK_SET);
+            size_t remaining = seg.length;
+            while (remaining > 0)
+            {
+                size_t room = TEMPLATE_CHUNK_SIZE - std::min(out.size(), (size_t)TEMPLATE_CHUNK_SIZE);
+                if (room == 0)
+                {
+                    if (!send(ctx, out.data(), out.size()))
+                        return false;
+                    out.clear();
+                    continue;
+                }
+
+                size_t n = std::min(remaining, room);
+                size_t start = out.size();
+                out.resize(start + n);
+                n = fread(&out[start], 1, n, file);
+                out.resize(start + n);
+                if (n == 0)
+                    break;
+                remaining -= n;
+            }
+        }
+        else
+        {
+            substitute_tag(seg.tagid, out);
+        }
+
+        if (out.size() >= TEMPLATE_CHUNK_SIZE)
+        {
+            if (!send(ctx, out.data(), out.size()))
+                return false;
+            out.clear();
         }
     }
 
+    if (!out.empty())
+        return send(ctx, out.data(), out.size());
+
+    return true;
+}
+
+long uptime_seconds()
+{
+    return fnSystem.get_uptime() / 1000000;
+}
+
+std::string format_uptime()
+{
+    int64_t ms = fnSystem.get_uptime();
+    long s = ms / 1000000;
+
+    int m = s / 60;
+    int h = m / 60;
+    int d = h / 24;
+
+    std::stringstream resultstream;
+    if (d)
+        resultstream << d << " days, ";
+    if (h % 24)
+        resultstream << (h % 24) << " hours, ";
+    if (m % 60)
+        resultstream << (m % 60) << " minutes, ";
+    if (s % 60)
+        resultstream << (s % 60) << " seconds";
+
+    return resultstream.str();
+}
+
+
+
+// Append the value for a tag straight to the output
+void substitute_tag(int tagid, std::string &out)
+{
+    template_writer resultstream(out);
+
+#ifdef DEBUG
+    // Debug_printf("Substituting tag '%s'\r\n", template_tag_name(tagid));
+#endif
+
     int drive_slot, host_slot;
     char disk_id;
 
@@ -548,11 +905,17 @@ const std::string substitute_tag(const std::string &tag)
         // }
         break;
     default:
-        resultstream << tag;
         break;
     }
-#ifdef DEBUG
-    // Debug_printf("Substitution result: \"%s\"\r\n", resultstream.str().c_str());
-#endif
-    return resultstream.str();
+}
+
+const std::string substitute_tag(const std::string &tag)
+{
+    int tagid = template_tag_id(tag);
+    if (tagid == DEVICE_LASTTAG)
+        return tag;
+
+    std::string result;
+    substitute_tag(tagid, result);
+    return result;
 }
@@ -1,15 +1,74 @@
-
 #ifndef HTTP_TEMPLATES_H
 #define HTTP_TEMPLATES_H
 
+#include <stdio.h>
+#include <time.h>
+
 #include <string>
+#include <type_traits>
+#include <vector>
+
+#define TEMPLATE_CHUNK_SIZE 1024 // Rendered output is sent in chunks of about this size
+
+// A template is compiled once into spans of the source file.
+// tagid < 0 marks a literal span to copy, otherwise the span is a {{tag}}.
+struct template_segment
+{
+    size_t offset;
+    size_t length;
+    int tagid;
+};
+
+struct compiled_template
+{
+    size_t size = 0;
+    time_t mtime = 0;
+    std::vector<template_segment> segments;
+};
+
+// Appends tag values straight to the output buffer
+class template_writer
+{
+public:
+    template_writer(std::string &out) : _out(out) {};
+
+    template_writer &operator<<(const std::string &s) { _out += s; return *this; }
+    template_writer &operator<<(const char *s) { _out += s; return *this; }
+    template_writer &operator<<(char c) { _out += c; return *this; }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value, template_writer &>::type
+    operator<<(T v)
+    {
+        if (std::is_floating_point<T>::value)
+        {
+            char tmp[24];
+            snprintf(tmp, sizeof(tmp), "%g", (double)v);
+            _out += tmp;
+        }
+        else
+            _out += std::to_string(v);
+        return *this;
+    }
+
+private:
+    std::string &_out;
+};
+
+typedef bool (*template_send_fn)(void *ctx, const char *buf, size_t len);
 
 std::string format_uptime();
 long uptime_seconds();
 
+int template_tag_id(const std::string &tag);
+const char *template_tag_name(int tagid);
+
+void substitute_tag(int tagid, std::string &out);
 const std::string substitute_tag(const std::string &tag);
 
-std::string parse_contents(const std::string &contents);
+const compiled_template *get_template(FILE *file, const char *filename);
+bool render_template(FILE *file, const compiled_template &tpl, template_send_fn send, void *ctx);
+
 bool is_parsable(const char *extension);
 
-#endif // HTTP_TEMPLATES_H
\ No newline at end of file
+#endif // HTTP_TEMPLATES_H
@@ -11,8 +11,11 @@
 #include <sys/stat.h>
 #include <cctype>
 #include <iomanip>
+#include <time.h>
 
+#include "fnFS.h"
 #include "file-utils.h"
+#include "http-utils.h"
 #include "string_utils.h"
 
 using namespace WebDav;
@@ -52,81 +55,179 @@ std::string Server::formatTime(time_t t)
     return std::string(buf);
 }
 
-static void xmlElement(std::ostringstream &s, const char *name, const char *value)
+bool Server::sendPropEntry(Response &resp, const std::string &path, const PropInfo &info)
 {
-    s << "<" << name << ">" << value << "</" << name << ">\r\n";
+    // Written straight into the response buffer; entries are batched into
+    // one chunk until the buffer fills up. False once a send failed
+    resp.write("<response>\r\n<href>");
+    resp.write(pathToURI(path));
+    resp.write("</href>\r\n<propstat><prop>\r\n<creationdate>");
+    resp.write(formatTime(info.ctime));
+    resp.write("</creationdate>\r\n<displayname>");
+    resp.writeEscaped(basename(path.c_str()));
+    resp.write("</displayname>\r\n");
+
+    if (!info.isDir)
+    {
+        char tmp[16];
+        snprintf(tmp, sizeof(tmp), "%u", (unsigned)info.size);
+        resp.write("<getcontentlength>");
+        resp.write(tmp);
+        resp.write("</getcontentlength>\r\n<getcontenttype>application/binary</getcontenttype>\r\n<getetag>");
+        resp.writeEscaped(http_etag(info.mtime, info.size).c_str());
+        resp.write("</getetag>\r\n");
+    }
+
+    resp.write("<getlastmodified>");
+    resp.write(formatTime(info.mtime));
+    resp.write("</getlastmodified>\r\n<resourcetype>");
+    if (info.isDir)
+        resp.write("<collection/>");
+    return resp.write("</resourcetype>\r\n</prop>\r\n<status>HTTP/1.1 200 OK</status>\r\n</propstat></response>\r\n");
 }
 
-void Server::sendMultiStatusResponse(Response &resp, MultiStatusResponse &msr)
+// Stops as soon as the callback returns false, and returns false then
+bool Server::forEachEntry(const std::string &path, std::function<bool(const PropInfo &)> callback)
 {
-    std::ostringstream s;
+    time_t now = time(nullptr);
+    uint32_t changes = FileSystem::changes;
 
-    s << "<response>\r\n";
-    xmlElement(s, "href", msr.href.c_str());
-    s << "<propstat><prop>\r\n";
+    for (auto &c : propCache)
+    {
+        if (c.path == path && c.changes == changes && now - c.stamp <= WEBDAV_PROP_CACHE_TTL)
+        {
+            for (const auto &info : c.entries)
+            {
+                if (!callback(info))
+                    return false;
+            }
+            return true;
+        }
+    }
 
-    for (const auto &p : msr.props)
-        xmlElement(s, p.first.c_str(), p.second.c_str());
+    DIR *dir = opendir(path.c_str());
+    if (!dir)
+        return true;
 
-    xmlElement(s, "resourcetype", msr.isCollection ? "<collection/>" : "");
+    // Only keep listings small enough to be worth the memory; big folders
+    // are streamed straight from readdir
+    PropCacheEntry fresh;
+    bool cacheable = true;
 
-    s << "</prop>\r\n";
-    xmlElement(s, "status", msr.status.c_str());
+    struct dirent *de;
+    while ((de = readdir(dir)))
+    {
+        if (strcmp(de->d_name, ".") == 0 ||
+            strcmp(de->d_name, "..") == 0)
+            continue;
 
-    s << "</propstat></response>\r\n";
+        std::string rpath = path + "/" + de->d_name;
 
-    resp.sendChunk(s.str().c_str());
-}
+        struct stat sb;
+        if (stat(rpath.c_str(), &sb) < 0)
+            continue;
 
-int Server::sendPropResponse(Response &resp, std::string path, int recurse)
-{
-    struct stat sb;
-    int ret = stat(path.c_str(), &sb);
-    if (ret < 0)
-        return -errno;
+        PropInfo info;
+        info.name = de->d_name;
+        info.isDir = ((sb.st_mode & S_IFMT) == S_IFDIR);
+        info.size = sb.st_size;
+        info.mtime = sb.st_mtime;
+        info.ctime = sb.st_ctime;
+
+        if (!callback(info))
+        {
+            closedir(dir);
+            return false;
+        }
 
-    std::string uri = pathToURI(path);
-    // printf("%s() path >%s< uri >%s<\r\n", __func__, path.c_str(), uri.c_str());
+        if (cacheable)
+        {
+            if (fresh.entries.size() < WEBDAV_PROP_CACHE_MAX_ENTRIES)
+                fresh.entries.push_back(info);
+            else
+            {
+                cacheable = false;
+                fresh.entries.clear();
+                fresh.entries.shrink_to_fit();
+            }
+        }
+    }
 
-    MultiStatusResponse r;
+    closedir(dir);
 
-    r.href = uri,
-    r.status = "HTTP/1.1 200 OK",
+    if (cacheable)
+    {
+        fresh.path = path;
+        fresh.stamp = now;
+        fresh.changes = changes;
+
+        // drop any stale copy, then the oldest listing if we're full
+        propCache.remove_if([&path](const PropCacheEntry &c) { return c.path == path; });
+        if (propCache.size() >= WEBDAV_PROP_CACHE_DIRS)
+            propCache.pop_back();
+        propCache.push_front(std::move(fresh));
+    }
 
-    r.props["creationdate"] = formatTime(sb.st_ctime);
-    r.props["getlastmodified"] = formatTime(sb.st_mtime);
-    r.props["displayname"] = basename(path.c_str());
+    return true;
+}
 
-    r.isCollection = ((sb.st_mode & S_IFMT) == S_IFDIR);
+void Server::invalidatePropCache()
+{
+    propCache.clear();
+}
 
-    if (!r.isCollection)
+int Server::sendPropResponse(Response &resp, std::string path, int recurse)
+{
+    PropInfo info;
+
+    struct stat sb;
+    int ret = stat(path.c_str(), &sb);
+    if (ret == 0)
     {
-        r.props["getcontentlength"] = std::to_string(sb.st_size);
-        r.props["getcontenttype"] = "application/binary";
-        r.props["getetag"] = std::to_string(sb.st_ino);
+        info.isDir = ((sb.st_mode & S_IFMT) == S_IFDIR);
+        info.size = sb.st_size;
+        info.mtime = sb.st_mtime;
+        info.ctime = sb.st_ctime;
+    }
+    else if (path == rootPath)
+    {
+        // the mount point itself can't be stat'ed on the VFS
+        info.isDir = true;
+    }
+    else
+    {
+        return -errno;
     }
 
-    sendMultiStatusResponse(resp, r);
+    if (!sendPropEntry(resp, path, info))
+        return -EIO;
 
-    if (r.isCollection && recurse > 0)
+    if (!info.isDir || recurse <= 0)
+        return 0;
+
+    // Walk the tree with an explicit list of pending directories instead of
+    // recursing, so Depth: infinity doesn't keep a DIR handle and a stack
+    // frame open per level
+    std::vector<std::pair<std::string, int>> pending;
+    pending.push_back(std::make_pair(path, recurse));
+
+    while (!pending.empty())
     {
-        DIR *dir = opendir(path.c_str());
-        if (dir)
-        {
-            struct dirent *de;
+        std::string dir = pending.back().first;
+        int depth = pending.back().second;
+        pending.pop_back();
 
-            while ((de = readdir(dir)))
-            {
-                if (strcmp(de->d_name, ".") == 0 ||
-                    strcmp(de->d_name, "..") == 0)
-                    continue;
+        bool sent = forEachEntry(dir, [&](const PropInfo &entry) {
+            std::string rpath = dir + "/" + entry.name;
+            if (entry.isDir && depth > 1)
+                pending.push_back(std::make_pair(rpath, depth - 1));
 
-                std::string rpath = path + "/" + de->d_name;
-                sendPropResponse(resp, rpath, recurse - 1);
-            }
+            return sendPropEntry(resp, rpath, entry);
+        });
 
-            closedir(dir);
-        }
+        // The client is gone, stop walking the tree
+        if (!sent)
+            return -EIO;
     }
 
     return 0;
@@ -135,6 +236,8 @@ int Server::sendPropResponse(Response &resp, std::string path, int recurse)
 // http entry points
 int Server::doCopy(Request &req, Response &resp)
 {
+    invalidatePropCache();
+
     if (req.getDestination().empty())
         return 400;
 
@@ -178,6 +281,8 @@ int Server::doCopy(Request &req, Response &resp)
 
 int Server::doDelete(Request &req, Response &resp)
 {
+    invalidatePropCache();
+
     if (req.getDepth() != Request::DEPTH_INFINITY)
         return 400;
 
@@ -195,23 +300,60 @@ int Server::doGet(Request &req, Response &resp)
     if (ret < 0)
         return 404;
 
+    std::string etag = http_etag(sb);
+    resp.setHeader("ETag", etag);
+    resp.setHeader("Last-Modified", formatTime(sb.st_mtime));
+    resp.setHeader("Accept-Ranges", "bytes");
+
+    if (http_etag_matches(req.getHeader("If-None-Match"), etag))
+        return 304;
+
+    size_t start = 0;
+    size_t length = sb.st_size;
+    int status = 200;
+
+    switch (http_parse_range(req.getHeader("Range"), sb.st_size, start, length))
+    {
+    case http_range_unsatisfiable:
+        resp.setHeader("Content-Range", "bytes */" + std::to_string(sb.st_size));
+        return 416;
+
+    case http_range_ok:
+        resp.setHeader("Content-Range", mstr::format("bytes %u-%u/%u", start, start + length - 1, (size_t)sb.st_size));
+        status = 206;
+        break;
+
+    default:
+        break;
+    }
+
     FILE *f = fopen(req.getPath().c_str(), "r");
     if (!f)
         return 500;
 
-    resp.setHeader("Content-Length", sb.st_size);
-    resp.setHeader("ETag", sb.st_ino);
-    resp.setHeader("Last-Modified", formatTime(sb.st_mtime));
-    // resp.flush();
+    if (start && fseek(f, start, SEEK_SET) != 0)
+    {
+        fclose(f);
+        return 500;
+    }
+
+    // Status and headers have to be set before the first chunk goes out
+    resp.setStatus(status);
+    resp.flushHeaders();
 
     ret = 0;
 
-    const int chunkSize = 8192;
-    char *chunk = (char *)malloc(chunkSize);
+    char *chunk = http_buffer_acquire();
+    if (!chunk)
+    {
+        fclose(f);
+        return 500;
+    }
 
-    for (;;)
+    size_t remaining = length;
+    while (remaining > 0)
     {
-        size_t r = fread(chunk, 1, chunkSize, f);
+        size_t r = fread(chunk, 1, std::min(remaining, (size_t)http_POOL_BUFF_SIZE), f);
         if (r <= 0)
             break;
 
@@ -220,14 +362,16 @@ int Server::doGet(Request &req, Response &resp)
             ret = -1;
             break;
         }
+
+        remaining -= r;
     }
 
-    free(chunk);
+    http_buffer_release(chunk);
     fclose(f);
     resp.closeChunk();
 
     if (ret == 0)
-        return 200;
+        return status;
 
     return 500;
 }
@@ -240,8 +384,9 @@ int Server::doHead(Request &req, Response &resp)
         return 404;
 
     resp.setHeader("Content-Length", sb.st_size);
-    resp.setHeader("ETag", sb.st_ino);
+    resp.setHeader("ETag", http_etag(sb));
     resp.setHeader("Last-Modified", formatTime(sb.st_mtime));
+    resp.setHeader("Accept-Ranges", "bytes");
 
     return 200;
 }
@@ -253,6 +398,8 @@ int Server::doLock(Request &req, Response &resp)
 
 int Server::doMkcol(Request &req, Response &resp)
 {
+    invalidatePropCache();
+
     if (req.getContentLength() != 0)
         return 415;
 
@@ -275,6 +422,8 @@ int Server::doMkcol(Request &req, Response &resp)
 
 int Server::doMove(Request &req, Response &resp)
 {
+    invalidatePropCache();
+
     if (req.getDestination().empty())
         return 400;
 
@@ -344,11 +493,16 @@ int Server::doPropfind(Request &req, Response &resp)
     resp.setContentType("text/xml; charset=\"utf-8\"");
     resp.flushHeaders();
 
-    resp.sendChunk("<?xml version=\"1.0\" encoding=\"utf-8\" ?>\r\n");
-    resp.sendChunk("<multistatus xmlns=\"DAV:\">\r\n");
+    resp.write("<?xml version=\"1.0\" encoding=\"utf-8\" ?>\r\n");
+    resp.write("<multistatus xmlns=\"DAV:\">\r\n");
 
     sendPropResponse(resp, req.getPath(), recurse);
-    resp.sendChunk("</multistatus>\r\n");
+    if (resp.error())
+    {
+        Debug_printv("send failed");
+        return 500;
+    }
+    resp.write("</multistatus>\r\n");
     resp.closeChunk();
 
     return 207;
@@ -366,6 +520,8 @@ int Server::doProppatch(Request &req, Response &resp)
 
 int Server::doPut(Request &req, Response &resp)
 {
+    invalidatePropCache();
+
     bool exists = access(req.getPath().c_str(), R_OK) == 0;
     FILE *f = fopen(req.getPath().c_str(), "w");
     if (!f)
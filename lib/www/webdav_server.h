@@ -1,8 +1,16 @@
 #pragma once
 
+#include <functional>
+#include <list>
+#include <vector>
+
 #include "request.h"
 #include "response.h"
 
+#define WEBDAV_PROP_CACHE_DIRS        4   // Directory listings kept for PROPFIND
+#define WEBDAV_PROP_CACHE_MAX_ENTRIES 256 // Larger directories are not cached
+#define WEBDAV_PROP_CACHE_TTL         10  // Seconds before a listing is re-read
+
 namespace WebDav {
 
 class Server {
@@ -29,9 +37,31 @@ public:
 private:
         std::string rootPath, rootURI;
 
+        struct PropInfo {
+                std::string name;
+                bool isDir = false;
+                size_t size = 0;
+                time_t mtime = 0;
+                time_t ctime = 0;
+        };
+
+        struct PropCacheEntry {
+                std::string path;
+                time_t stamp = 0;
+                uint32_t changes = 0;   // FileSystem::changes when listed
+                std::vector<PropInfo> entries;
+        };
+
+        // Recently listed directories, most recent first. Cleared by any
+        // request that changes the tree, and out of date as soon as
+        // anything else writes to local storage.
+        std::list<PropCacheEntry> propCache;
+
         std::string formatTime(time_t t);
         int sendPropResponse(Response &resp, std::string path, int recurse);
-        void sendMultiStatusResponse(Response &resp, MultiStatusResponse &msr);
+        bool sendPropEntry(Response &resp, const std::string &path, const PropInfo &info);
+        bool forEachEntry(const std::string &path, std::function<bool(const PropInfo &)> callback);
+        void invalidatePropCache();
 };
 
 } // namespace
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 #include <dirent.h>
 #include <sys/stat.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <ArduinoJson.h>
 //#include <archive_cpp.h>
 //#include <archive.h>
@@ -18,6 +21,7 @@
 #include "ml_tests.h"
 #include "meat_io.h"
 #include "meat_buffer.h"
+#include "meat_copy.h"
 //#include "iec_host.h"
 //#include "make_unique.h"
 #include "basic_config.h"
@@ -175,16 +179,31 @@ void testRecursiveDir(MFile* file, std::string indent) {
 }
 
 void testCopy(MFile* srcFile, MFile* dstFile) {
-    // testHeader("Copy file to destination");
+    testHeader("Copy file to destination");
 
-    // Debug_printf("FROM:%s\nTO:%s\r\n", srcFile->url.c_str(), dstFile->url.c_str());
+    Debug_printf("FROM:%s\nTO:%s\r\n", srcFile->url.c_str(), dstFile->url.c_str());
 
-    // if(dstFile->exists()) {
-    //     bool result = dstFile->remove();
-    //     Debug_printf("FSTEST: %s existed, delete reult: %d\r\n", dstFile->path.c_str(), result);
-    // }
+    if(dstFile->exists()) {
+        bool result = dstFile->remove();
+        Debug_printf("FSTEST: %s existed, delete reult: %d\r\n", dstFile->path.c_str(), result);
+    }
 
-    // srcFile->copyTo(dstFile);
+    std::shared_ptr<MStream> istream(srcFile->meatStream());
+    std::shared_ptr<MStream> ostream(dstFile->createStream());
+    if(istream == nullptr || ostream == nullptr || !ostream->isOpen()) {
+        Debug_printf("FSTEST: couldn't open streams\r\n");
+        return;
+    }
+
+    MCopy copy({ istream }, ostream);
+    uint64_t start = esp_timer_get_time();
+    copy.start();
+    while(!copy.done())
+        vTaskDelay(pdMS_TO_TICKS(10));
+    uint64_t elapsed = esp_timer_get_time() - start;
+
+    Debug_printf("FSTEST: %d bytes in %lluus, %.2f MB/s, failed[%d]\r\n", copy.copied(), elapsed,
+        elapsed ? (double)copy.copied() / elapsed : 0, copy.failed());
 }
 
 void dumpParts(std::vector<std::string> v) {
@@ -743,5 +762,9 @@ void runTestsSuite() {
     //testRedirect();
     //testStrings();
 
+    // Copy engine, flash to SD and HTTP to SD
+    // testCopy(MFSOwner::File("/.sys/README"), MFSOwner::File("/sd/README.copy"));
+    // testCopy(MFSOwner::File("https://c64.meatloaf.cc/geckos-c64.d64"), MFSOwner::File("/sd/geckos-c64.copy"));
+
     Debug_println("*** All tests finished ***");
 }